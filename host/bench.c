@@ -0,0 +1,691 @@
+/*
+    File        : bench.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Host benchmark harness for the PsiFS protocol stack. This
+                  runs the unmodified link, multiplexor, server and cache
+                  layers against a scripted device over a simulated serial
+                  line, and reports the throughput and latency of read,
+                  write, directory listing and backup workloads.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include clib header files
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Include project header files
+#include "cache.h"
+#include "err.h"
+#include "link.h"
+#include "server.h"
+#include "sim.h"
+#include "stats.h"
+
+// Default benchmark parameters
+#define BENCH_DEFAULT_BAUD (115200)
+#define BENCH_DEFAULT_LATENCY (0)
+#define BENCH_DEFAULT_BER (0.0)
+#define BENCH_DEFAULT_SEED (1)
+#define BENCH_DEFAULT_SIZE (256)
+#define BENCH_DEFAULT_COUNT (10)
+#define BENCH_BLOCK (4096)
+#define BENCH_DIR ":C.$.Bench"
+#define BENCH_FILE BENCH_DIR ".File"
+#define BENCH_ROOT ":C.$"
+#define BENCH_DIR_ENTRIES (16)
+
+// Simulated time allowed for the link to be established
+#define BENCH_TIMEOUT_CONNECT (60 * 100 * SIM_TIME_CS)
+
+// Latency histogram with power of two buckets in milliseconds
+#define BENCH_BUCKETS (16)
+#define BENCH_TIME_MS (1000)
+
+// Statistics for a single workload
+typedef struct
+{
+    const char *name;
+    bits ops;
+    bits bytes;
+    sim_time start;
+    sim_time elapsed;
+    bits frames;
+    bits retries;
+    bits histogram[BENCH_BUCKETS];
+} bench_workload;
+
+/*
+    Parameters  : workload      - The workload to start.
+                  name          - The name of the workload.
+    Returns     : void
+    Description : Reset the statistics and start timing a workload.
+*/
+static void bench_start(bench_workload *workload, const char *name)
+{
+    // Reset the statistics
+    memset(workload, 0, sizeof(*workload));
+    workload->name = name;
+
+    // Record the starting point
+    workload->frames = stats_rx_frame + stats_tx_frame;
+    workload->retries = stats_rx_retry_frame + stats_tx_retry_frame;
+    workload->start = sim_now();
+}
+
+/*
+    Parameters  : workload      - The workload being timed.
+                  start         - The time at which the operation started.
+                  bytes         - The number of bytes transferred.
+    Returns     : void
+    Description : Record the completion of a single operation.
+*/
+static void bench_op(bench_workload *workload, sim_time start, bits bytes)
+{
+    sim_time latency = (sim_now() - start) / BENCH_TIME_MS;
+    bits bucket = 0;
+
+    // Choose the histogram bucket
+    while ((bucket < BENCH_BUCKETS - 1) && ((1ULL << bucket) <= latency))
+    {
+        bucket++;
+    }
+
+    // Update the statistics
+    workload->ops++;
+    workload->bytes += bytes;
+    workload->histogram[bucket]++;
+}
+
+/*
+    Parameters  : workload      - The workload to end.
+    Returns     : void
+    Description : Stop timing a workload and display the results.
+*/
+static void bench_end(bench_workload *workload)
+{
+    double seconds;
+    bits i;
+
+    // Calculate the totals
+    workload->elapsed = sim_now() - workload->start;
+    workload->frames = stats_rx_frame + stats_tx_frame - workload->frames;
+    workload->retries = stats_rx_retry_frame + stats_tx_retry_frame
+                        - workload->retries;
+    seconds = workload->elapsed / (100.0 * SIM_TIME_CS);
+
+    // Display the summary
+    printf("%s: %u operations, %u bytes in %.2fs\n", workload->name,
+           workload->ops, workload->bytes, seconds);
+    if (workload->elapsed)
+    {
+        printf("    %.0f bytes/s, %.1f frames/s, ",
+               workload->bytes / seconds, workload->frames / seconds);
+    }
+    else printf("    ");
+    printf("%u frames, %u retries\n", workload->frames, workload->retries);
+
+    // Display the latency histogram
+    for (i = 0; i < BENCH_BUCKETS; i++)
+    {
+        if (workload->histogram[i])
+        {
+            if (!i) printf("    <1ms");
+            else if (i < BENCH_BUCKETS - 1)
+            {
+                printf("    %u-%ums", 1 << (i - 1), (1 << i) - 1);
+            }
+            else printf("    >=%ums", 1 << (i - 1));
+            printf(": %u\n", workload->histogram[i]);
+        }
+    }
+}
+
+/*
+    Parameters  : cmd           - The operation to perform.
+                  reply         - Block to receive the response.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform a cache operation, waiting for it to complete.
+*/
+static os_error *bench_cache(const cache_cmd *cmd, cache_reply *reply)
+{
+    // Perform the operation without escape checks
+    return cache_fore(cmd, reply, FALSE);
+}
+
+/*
+    Parameters  : path          - The name of the file to open.
+                  mode          - The mode in which to open the file.
+                  handle        - Variable to receive the handle.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Open a file on the remote device.
+*/
+static os_error *bench_open(const char *path, fs_mode mode,
+                            fs_handle *handle)
+{
+    os_error *err;
+    cache_cmd cmd;
+    cache_reply reply;
+
+    // Open the file
+    cmd.op = CACHE_OPEN;
+    strcpy(cmd.data.open.path, path);
+    cmd.data.open.mode = mode;
+    cmd.data.open.handle = 1;
+    err = bench_cache(&cmd, &reply);
+    *handle = !err ? reply.open.handle : FS_NONE;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : handle        - The handle of the file to close.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Close a file on the remote device.
+*/
+static os_error *bench_close(fs_handle handle)
+{
+    cache_cmd cmd;
+    cache_reply reply;
+
+    // Close the file
+    cmd.op = CACHE_CLOSE;
+    cmd.data.close.handle = handle;
+    return bench_cache(&cmd, &reply);
+}
+
+/*
+    Parameters  : handle        - The handle of the file to read.
+                  offset        - Offset of the first byte to read.
+                  buffer        - Buffer to receive the data.
+                  length        - Number of bytes to read.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read from a file on the remote device.
+*/
+static os_error *bench_read_block(fs_handle handle, bits offset,
+                                  byte *buffer, bits length)
+{
+    cache_cmd cmd;
+    cache_reply reply;
+
+    // Read the data
+    cmd.op = CACHE_READ;
+    cmd.data.read.handle = handle;
+    cmd.data.read.offset = offset;
+    cmd.data.read.length = length;
+    cmd.data.read.buffer = buffer;
+    return bench_cache(&cmd, &reply);
+}
+
+/*
+    Parameters  : path          - The name of the file to write.
+                  buffer        - Buffer to use for the data.
+                  size          - The total number of bytes to write.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Time writing a file in fixed size blocks.
+*/
+static os_error *bench_write(const char *path, byte *buffer, bits size)
+{
+    os_error *err;
+    bench_workload workload;
+    fs_handle handle = FS_NONE;
+    bits offset = 0;
+
+    // Open the file
+    bench_start(&workload, "Write");
+    err = bench_open(path, FS_MODE_OUT, &handle);
+
+    // Write the data
+    while (!err && (offset < size))
+    {
+        bits length = MIN(BENCH_BLOCK, size - offset);
+        sim_time start = sim_now();
+        cache_cmd cmd;
+        cache_reply reply;
+        bits i;
+
+        for (i = 0; i < length; i++) buffer[i] = (offset + i) & 0xff;
+        cmd.op = CACHE_WRITE;
+        cmd.data.write.handle = handle;
+        cmd.data.write.offset = offset;
+        cmd.data.write.length = length;
+        cmd.data.write.buffer = buffer;
+        err = bench_cache(&cmd, &reply);
+        if (!err) bench_op(&workload, start, length);
+        offset += length;
+    }
+
+    // Close the file
+    if (handle != FS_NONE)
+    {
+        os_error *err2 = bench_close(handle);
+        if (!err) err = err2;
+    }
+    if (!err) bench_end(&workload);
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : path          - The name of the file to read.
+                  buffer        - Buffer to use for the data.
+                  size          - The total number of bytes to read.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Time reading a file in fixed size blocks, checking that the
+                  data matches that written.
+*/
+static os_error *bench_read(const char *path, byte *buffer, bits size)
+{
+    os_error *err;
+    bench_workload workload;
+    fs_handle handle = FS_NONE;
+    bits offset = 0;
+    bits mismatch = 0;
+
+    // Open the file
+    bench_start(&workload, "Read");
+    err = bench_open(path, FS_MODE_IN, &handle);
+
+    // Read the data
+    while (!err && (offset < size))
+    {
+        bits length = MIN(BENCH_BLOCK, size - offset);
+        sim_time start = sim_now();
+        bits i;
+
+        err = bench_read_block(handle, offset, buffer, length);
+        if (!err)
+        {
+            bench_op(&workload, start, length);
+            for (i = 0; i < length; i++)
+            {
+                if (buffer[i] != ((offset + i) & 0xff)) mismatch++;
+            }
+        }
+        offset += length;
+    }
+
+    // Close the file
+    if (handle != FS_NONE)
+    {
+        os_error *err2 = bench_close(handle);
+        if (!err) err = err2;
+    }
+    if (!err)
+    {
+        bench_end(&workload);
+        if (mismatch) printf("    %u bytes did not match\n", mismatch);
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : start         - The time at which the link was started.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Wait for the link to be established and the internal drive
+                  of the device to become available.
+*/
+static os_error *bench_connect(sim_time start)
+{
+    os_error *err = NULL;
+    psifs_drive_status status = 0;
+
+    // Poll the link until the drive is present or the timeout expires
+    while (!err && !(status & psifs_DRIVE_STATUS_PRESENT))
+    {
+        if (start + BENCH_TIMEOUT_CONNECT < sim_now()) err = &err_not_found;
+        else err = link_poll(FALSE);
+        if (!err && cache_drive_status('C', &status, NULL, NULL)) status = 0;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : workload      - The workload being timed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Close and re-establish the link, discarding everything
+                  cached about the device. The time and any frames exchanged
+                  are excluded from the workload statistics.
+*/
+static os_error *bench_reconnect(bench_workload *workload)
+{
+    os_error *err;
+    sim_time start = sim_now();
+    bits frames = stats_rx_frame + stats_tx_frame;
+    bits retries = stats_rx_retry_frame + stats_tx_retry_frame;
+
+    // Restart the link and wait for the device
+    err = link_disable(FALSE);
+    if (!err) err = link_enable_link();
+    if (!err) err = bench_connect(sim_now());
+
+    // Exclude the reconnection from the statistics
+    workload->start += sim_now() - start;
+    workload->frames += stats_rx_frame + stats_tx_frame - frames;
+    workload->retries += stats_rx_retry_frame + stats_tx_retry_frame
+                         - retries;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : path          - The directory to list.
+                  count         - The number of times to list it.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Time repeated complete listings of a directory. The link
+                  is re-established before each listing to discard the
+                  cached listing, so every listing is read from the device.
+*/
+static os_error *bench_list(const char *path, bits count)
+{
+    os_error *err = NULL;
+    bench_workload workload;
+    static fs_info buffer[BENCH_DIR_ENTRIES];
+    bits entries = 0;
+
+    // List the directory the required number of times
+    bench_start(&workload, "Directory listing");
+    while (!err && count--)
+    {
+        sim_time start;
+        int offset = 0;
+
+        // Reconnect to discard any cached listing
+        err = bench_reconnect(&workload);
+        start = sim_now();
+
+        // Read all of the entries
+        while (!err && (offset != -1))
+        {
+            cache_cmd cmd;
+            cache_reply reply;
+
+            cmd.op = CACHE_ENUMERATE;
+            strcpy(cmd.data.enumerate.path, path);
+            *cmd.data.enumerate.match = '\0';
+            cmd.data.enumerate.offset = offset;
+            cmd.data.enumerate.buffer = buffer;
+            cmd.data.enumerate.size = BENCH_DIR_ENTRIES;
+            err = bench_cache(&cmd, &reply);
+            if (!err)
+            {
+                offset = reply.enumerate.offset;
+                entries += reply.enumerate.read;
+            }
+        }
+        if (!err) bench_op(&workload, start, 0);
+    }
+    if (!err)
+    {
+        bench_end(&workload);
+        printf("    %u entries read from %s\n", entries, path);
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : workload      - The workload being timed.
+                  path          - The directory to copy.
+                  buffer        - Buffer to use for the data.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read every file within a directory, recursing into any
+                  subdirectories. Each file read is a single operation.
+*/
+static os_error *bench_backup_dir(bench_workload *workload, const char *path,
+                                  byte *buffer)
+{
+    os_error *err = NULL;
+    fs_info info[BENCH_DIR_ENTRIES];
+    int offset = 0;
+
+    // Process each batch of directory entries
+    while (!err && (offset != -1))
+    {
+        cache_cmd cmd;
+        cache_reply reply;
+        bits i;
+
+        // Read the next batch of entries
+        cmd.op = CACHE_ENUMERATE;
+        strcpy(cmd.data.enumerate.path, path);
+        *cmd.data.enumerate.match = '\0';
+        cmd.data.enumerate.offset = offset;
+        cmd.data.enumerate.buffer = info;
+        cmd.data.enumerate.size = BENCH_DIR_ENTRIES;
+        err = bench_cache(&cmd, &reply);
+        if (!err) offset = reply.enumerate.offset;
+
+        // Copy each object
+        for (i = 0; !err && (i < reply.enumerate.read); i++)
+        {
+            fs_pathname name;
+
+            if (sizeof(name) <= snprintf(name, sizeof(name), "%s.%s",
+                                         path, info[i].name))
+            {
+                err = &err_bad_name;
+            }
+            if (!err && (info[i].obj_type == fileswitch_IS_DIR))
+            {
+                err = bench_backup_dir(workload, name, buffer);
+            }
+            else if (!err)
+            {
+                sim_time start = sim_now();
+                fs_handle handle = FS_NONE;
+                bits done = 0;
+
+                err = bench_open(name, FS_MODE_IN, &handle);
+                while (!err && (done < info[i].size))
+                {
+                    bits length = MIN(BENCH_BLOCK, info[i].size - done);
+
+                    err = bench_read_block(handle, done, buffer, length);
+                    done += length;
+                }
+                if (handle != FS_NONE)
+                {
+                    os_error *err2 = bench_close(handle);
+                    if (!err) err = err2;
+                }
+                if (!err) bench_op(workload, start, info[i].size);
+            }
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : path          - The directory to back up.
+                  buffer        - Buffer to use for the data.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Time reading every file on a drive, as a backup would.
+*/
+static os_error *bench_backup(const char *path, byte *buffer)
+{
+    os_error *err;
+    bench_workload workload;
+
+    // Copy the whole directory tree
+    bench_start(&workload, "Backup");
+    err = bench_backup_dir(&workload, path, buffer);
+    if (!err) bench_end(&workload);
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : path          - The name of the object to delete.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Delete an object on the remote device.
+*/
+static os_error *bench_remove(const char *path)
+{
+    cache_cmd cmd;
+    cache_reply reply;
+
+    // Delete the object
+    cmd.op = CACHE_REMOVE;
+    strcpy(cmd.data.remove.path, path);
+    return bench_cache(&cmd, &reply);
+}
+
+/*
+    Parameters  : name          - The name of the program.
+    Returns     : void
+    Description : Describe the command line options.
+*/
+static void bench_usage(const char *name)
+{
+    // Display the options
+    fprintf(stderr,
+            "Usage: %s [-b baud] [-l latency_ms] [-e bit_error_rate]\n"
+            "       [-r seed] [-s script] [-k size_kb] [-n count] [-d dir]\n",
+            name);
+}
+
+/*
+    Parameters  : argc          - Number of command line arguments.
+                  argv          - The command line arguments.
+    Returns     : int           - The exit status.
+    Description : Run the benchmark.
+*/
+int main(int argc, char *argv[])
+{
+    os_error *err = NULL;
+    bits baud = BENCH_DEFAULT_BAUD;
+    double latency = BENCH_DEFAULT_LATENCY;
+    double ber = BENCH_DEFAULT_BER;
+    bits seed = BENCH_DEFAULT_SEED;
+    const char *script = NULL;
+    const char *dir = BENCH_DIR;
+    bits size = BENCH_DEFAULT_SIZE;
+    bits count = BENCH_DEFAULT_COUNT;
+    byte *buffer;
+    const sim_stats *line;
+    const server_stats *device;
+    int opt;
+
+    // Parse the command line
+    while ((opt = getopt(argc, argv, "b:l:e:r:s:k:n:d:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': baud = strtoul(optarg, NULL, 10); break;
+            case 'l': latency = strtod(optarg, NULL); break;
+            case 'e': ber = strtod(optarg, NULL); break;
+            case 'r': seed = strtoul(optarg, NULL, 10); break;
+            case 's': script = optarg; break;
+            case 'k': size = strtoul(optarg, NULL, 10); break;
+            case 'n': count = strtoul(optarg, NULL, 10); break;
+            case 'd': dir = optarg; break;
+            case 'h': bench_usage(argv[0]); return EXIT_SUCCESS;
+            default: bench_usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if ((optind != argc) || !baud || !size || (latency < 0)
+        || (sizeof(fs_pathname) <= strlen(dir))
+        || (ber < 0) || (1 <= ber))
+    {
+        bench_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("Line: %u baud, %.1fms latency, bit error rate %g, seed %u\n",
+           baud, latency, ber, seed);
+    fflush(stdout);
+
+    // Configure the line and the device
+    sim_configure(baud, (sim_time) (latency * BENCH_TIME_MS), ber, seed);
+    err = server_start(script);
+
+    // Start the protocol stack and wait for the device
+    buffer = (byte *) malloc(BENCH_BLOCK);
+    if (!err && !buffer) err = &err_buffer;
+    if (!err) err = link_initialise();
+    if (!err) err = link_configure("Simulated", 0, baud, "", FALSE);
+    if (!err) err = link_enable_link();
+    if (!err) err = bench_connect(sim_now());
+    if (!err)
+    {
+        printf("Connected after %.2fs\n", sim_now() / (100.0 * SIM_TIME_CS));
+    }
+
+    // Run each of the workloads
+    if (!err)
+    {
+        cache_cmd cmd;
+        cache_reply reply;
+
+        cmd.op = CACHE_MKDIR;
+        strcpy(cmd.data.mkdir.path, BENCH_DIR);
+        err = bench_cache(&cmd, &reply);
+    }
+    if (!err) err = bench_write(BENCH_FILE, buffer, size * 1024);
+    if (!err) err = bench_read(BENCH_FILE, buffer, size * 1024);
+    if (!err) err = bench_list(dir, count);
+    if (!err) err = bench_backup(BENCH_ROOT, buffer);
+    if (!err) err = bench_remove(BENCH_FILE);
+
+    // Display the line and device statistics
+    line = sim_read_stats(SIM_END_HOST);
+    printf("Host to device: %u bytes, %u corrupted, %u overruns\n",
+           line->sent, line->corrupted, line->overruns);
+    line = sim_read_stats(SIM_END_DEVICE);
+    printf("Device to host: %u bytes, %u corrupted, %u overruns\n",
+           line->sent, line->corrupted, line->overruns);
+    device = server_read_stats();
+    printf("Device: %u frames received (%u bad, %u out of sequence), "
+           "%u sent (%u retries), %u operations (%u unsupported)\n",
+           device->rx_frames, device->rx_bad_frames,
+           device->rx_out_of_sequence, device->tx_frames, device->tx_retries,
+           device->ops, device->unsupported);
+
+    // Shut down the protocol stack
+    if (!err) err = link_disable(TRUE);
+    if (buffer) free(buffer);
+
+    // Report any error produced
+    fflush(stdout);
+    if (err) fprintf(stderr, "Error: %s\n", err->errmess);
+    return err ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,474 @@
+/*
+    File        : blockdrive.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Fake block driver for the host benchmark harness. This
+                  provides the same interface as the real block driver
+                  veneers, but connects the host end of the simulated serial
+                  line. Polling the driver also polls the simulated device,
+                  and advances the simulated clock once neither end of the
+                  line is making progress.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include header file for this module
+#include "blockdrive.h"
+
+// Include clib header files
+#include <string.h>
+
+// Include project header files
+#include "err.h"
+#include "server.h"
+#include "sim.h"
+
+// The name of the only driver available
+#define BLOCKDRIVE_SIM_NAME "Simulated"
+
+// The driver details
+static blockdrive_layout blockdrive_sim;
+
+// The current settings
+static blockdrive_control blockdrive_sim_control;
+static blockdrive_format blockdrive_sim_format;
+static blockdrive_flow blockdrive_sim_flow;
+static bits blockdrive_sim_baud;
+
+// Has the host end of the line been used since the last poll
+static bool blockdrive_sim_used;
+
+/*
+    Parameters  : context       - Set to 0 for the first call and preserve
+                                  between successive calls.
+                  name          - Buffer to receive the next block driver name.
+                  size          - Size of the buffer.
+                  found         - Variable to receive whether a block driver
+                                  was found.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Enumerate the available block drivers.
+*/
+os_error *blockdrive_enumerate(int *context, char *name, size_t size,
+                               bool *found)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if (!context || !name || !found) err = &err_bad_parms;
+    else if (*context)
+    {
+        // Only a single driver is available
+        *found = FALSE;
+    }
+    else if (size <= strlen(BLOCKDRIVE_SIM_NAME)) err = &err_buffer;
+    else
+    {
+        // Return the simulated driver
+        strcpy(name, BLOCKDRIVE_SIM_NAME);
+        *found = TRUE;
+        *context = 1;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : name          - The name of the block driver to load.
+                  driver        - Variable to receive the driver handle.
+                  ports         - Variable to receive the number of ports
+                                  available.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Load the specified block driver. Only the simulated driver
+                  is available.
+*/
+os_error *blockdrive_load(const char *name, blockdrive_driver *driver,
+                          bits *ports)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if (!name || !driver || !ports) err = &err_bad_parms;
+    else if (strcmp(name, BLOCKDRIVE_SIM_NAME)) err = &err_block_driver;
+    else
+    {
+        // Describe the driver
+        memset(&blockdrive_sim, 0, sizeof(blockdrive_sim));
+        strcpy(blockdrive_sim.information, "Simulated serial line");
+        strcpy(blockdrive_sim.manufacturer, "PsiFS");
+        blockdrive_sim.version = 100;
+        blockdrive_sim.flags = BLOCKDRIVE_FLAGS_BLOCK_OPERATIONS
+                               | BLOCKDRIVE_FLAGS_REQUIRES_POLL;
+        blockdrive_sim.port = BLOCKDRIVE_PORT_NONE;
+
+        // Return the details
+        *driver = &blockdrive_sim;
+        *ports = 1;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : void
+    Description : Deallocate the block of memory used by the specified block
+                  driver. This does not close down the driver first.
+*/
+void blockdrive_unload(blockdrive_driver driver)
+{
+    // No action required
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  value     - The byte to send.
+    Returns     : bool      - Was the byte inserted into the transmit queue.
+    Description : Insert a byte into the transmit queue.
+*/
+bool blockdrive_put_byte(blockdrive_driver driver, byte value)
+{
+    // Pass the byte to the line
+    return blockdrive_put_block(driver, &value, 1) == 1;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  value     - Variable to receive the byte read.
+    Returns     : bool      - Was a byte available.
+    Description : Remove a byte from the receive queue.
+*/
+bool blockdrive_get_byte(blockdrive_driver driver, byte *value)
+{
+    // Read a byte from the line
+    return blockdrive_get_block(driver, value, 1) == 1;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  block     - Pointer to block containing the bytes to transmit.
+                  bytes     - Number of bytes to insert.
+    Returns     : bits      - The number of bytes successfully inserted.
+    Description : Insert a block of bytes into the transmit queue.
+*/
+bits blockdrive_put_block(blockdrive_driver driver, const byte *block,
+                          size_t bytes)
+{
+    bits used;
+
+    // Pass the bytes to the line
+    used = sim_put(SIM_END_HOST, block, bytes);
+    if (used) blockdrive_sim_used = TRUE;
+
+    // Return the number of bytes accepted
+    return used;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  block     - Pointer to block to hold the received bytes.
+                  bytes     - Maximum number of bytes to place in the buffer.
+    Returns     : bits      - Number of bytes placed in the buffer.
+    Description : Remove a block of bytes from the receive queue.
+*/
+bits blockdrive_get_block(blockdrive_driver driver, byte *block, size_t bytes)
+{
+    bits used;
+
+    // Read bytes from the line
+    used = sim_get(SIM_END_HOST, block, bytes);
+    if (used) blockdrive_sim_used = TRUE;
+
+    // Return the number of bytes read
+    return used;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : bits      - Number of bytes free in the transmit buffer.
+    Description : Check the available space in the transmit buffer.
+*/
+bits blockdrive_check_tx(blockdrive_driver driver)
+{
+    // Return the free space on the line
+    return sim_check_tx(SIM_END_HOST);
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : bits      - Number of bytes used in the receive buffer.
+    Description : Check the number of bytes in the receive buffer. The
+                  simulated line does not support this, so it always
+                  reports an empty buffer.
+*/
+bits blockdrive_check_rx(blockdrive_driver driver)
+{
+    // Not supported
+    return 0;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : void
+    Description : Flush the transmit buffer and hardware FIFO (if applicable).
+*/
+void blockdrive_flush_tx(blockdrive_driver driver)
+{
+    // Flush the line
+    sim_flush(SIM_END_HOST);
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : void
+    Description : Flush the receive buffer and hardware FIFO (if applicable).
+*/
+void blockdrive_flush_rx(blockdrive_driver driver)
+{
+    // The line is flushed in both directions with the transmit buffer
+}
+
+/*
+    Parameters  : driver                - The handle of the block driver.
+    Returns     : blockdrive_control    - The current state of the control
+                                          lines.
+    Description : Read the control line settings.
+*/
+blockdrive_control blockdrive_control_read(blockdrive_driver driver)
+{
+    // Return the last value written
+    return blockdrive_sim_control;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  control   - The new control line settings.
+    Returns     : void
+    Description : Set the state of the control lines.
+*/
+void blockdrive_control_write(blockdrive_driver driver,
+                              blockdrive_control control)
+{
+    // Store the new value
+    blockdrive_sim_control = control;
+}
+
+/*
+    Parameters  : driver            - The handle of the block driver.
+    Returns     : blockdrive_modem  - The current state of the modem control
+                                      lines.
+    Description : Read the modem control line status. The simulated device
+                  is always present.
+*/
+blockdrive_modem blockdrive_modem_read(blockdrive_driver driver)
+{
+    // Device always present and ready
+    return BLOCKDRIVE_MODEM_CTS | BLOCKDRIVE_MODEM_DSR | BLOCKDRIVE_MODEM_DCD;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : blockdrive_errors - The receive errors seen.
+    Description : Read the receive errors seen since the last call of this
+                  function. Corruption on the simulated line is not detected
+                  by the driver.
+*/
+blockdrive_errors blockdrive_errors_read(blockdrive_driver driver)
+{
+    // No errors reported
+    return 0;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  time      - The length of the break in centiseconds.
+    Returns     : void
+    Description : Send a break. This function does not return until the break
+                  has been sent.
+*/
+void blockdrive_break(blockdrive_driver driver, bits time)
+{
+    // Breaks are not simulated
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  value     - Variable to receive the byte read.
+    Returns     : bool  - Was a byte available.
+    Description : Read the next byte from the receive queue, leaving it in the
+                  buffer. The simulated line does not support this.
+*/
+bool blockdrive_examine_byte(blockdrive_driver driver, byte *value)
+{
+    // Not supported
+    return FALSE;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : bits      - The current transmit speed.
+    Description : Read the current transmit baud rate.
+*/
+bits blockdrive_tx_speed_read(blockdrive_driver driver)
+{
+    // Return the line speed
+    return blockdrive_sim_baud;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  speed     - The new transmit speed.
+    Returns     : void
+    Description : Set a new transmit baud rate. The simulated line always
+                  uses the same speed in both directions.
+*/
+void blockdrive_tx_speed_write(blockdrive_driver driver, bits speed)
+{
+    // Set the line speed
+    blockdrive_sim_baud = speed;
+    sim_set_baud(speed);
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : bits  - The current receive speed.
+    Description : Read the current receive baud rate.
+*/
+bits blockdrive_rx_speed_read(blockdrive_driver driver)
+{
+    // Return the line speed
+    return blockdrive_sim_baud;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  speed     - The new receive speed.
+    Returns     : void
+    Description : Set a new receive baud rate. The simulated line always
+                  uses the same speed in both directions.
+*/
+void blockdrive_rx_speed_write(blockdrive_driver driver, bits speed)
+{
+    // Set the line speed
+    blockdrive_tx_speed_write(driver, speed);
+}
+
+/*
+    Parameters  : driver            - The handle of the block driver.
+    Returns     : blockdrive_format - The word format.
+    Description : Read the current word format.
+*/
+blockdrive_format blockdrive_word_format_read(blockdrive_driver driver)
+{
+    // Return the last value written
+    return blockdrive_sim_format;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  format    - The required word format.
+    Returns     : void
+    Description : Set a new word format. The simulated line always uses
+                  8 data bits, no parity and 1 stop bit.
+*/
+void blockdrive_word_format_write(blockdrive_driver driver,
+                                  blockdrive_format format)
+{
+    // Store the new value
+    blockdrive_sim_format = format;
+}
+
+/*
+    Parameters  : driver            - The handle of the block driver.
+    Returns     : blockdrive_flow   - The current flow control method.
+    Description : Read the current flow control method.
+*/
+blockdrive_flow blockdrive_flow_control_read(blockdrive_driver driver)
+{
+    // Return the last value written
+    return blockdrive_sim_flow;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  method    - The required flow control method.
+    Returns     : void
+    Description : Set a new flow control method. Flow control is not
+                  simulated.
+*/
+void blockdrive_flow_control_write(blockdrive_driver driver,
+                                   blockdrive_flow method)
+{
+    // Store the new value
+    blockdrive_sim_flow = method;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+                  port      - The port number to use.
+                  options   - Any driver specific options.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Initialise the block driver.
+*/
+os_error *blockdrive_initialise(blockdrive_driver driver, bits port,
+                                const char *options)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if (!driver || port) err = &err_bad_parms;
+    else
+    {
+        // Store the port number
+        driver->port = port;
+        blockdrive_sim_used = TRUE;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : void
+    Description : Close down the block driver.
+*/
+void blockdrive_close_down(blockdrive_driver driver)
+{
+    // Clear the port number
+    driver->port = BLOCKDRIVE_PORT_NONE;
+}
+
+/*
+    Parameters  : driver    - The handle of the block driver.
+    Returns     : void
+    Description : Poll the block driver. This polls the simulated device, and
+                  advances the clock if neither end of the line has made any
+                  progress since the previous poll.
+*/
+void blockdrive_poll(blockdrive_driver driver)
+{
+    // Poll the simulated device
+    if (server_poll()) blockdrive_sim_used = TRUE;
+
+    // Advance the clock if idle
+    if (!blockdrive_sim_used) sim_advance(server_next_event());
+    blockdrive_sim_used = FALSE;
+}
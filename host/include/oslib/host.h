@@ -0,0 +1,228 @@
+/*
+    File        : host.h
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : The subset of the OSLib definitions required to build the
+                  protocol stack for the host benchmark harness. Each of the
+                  OSLib header files used by the stack includes this file.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Only include header file once
+#ifndef OSLIB_HOST_H
+#define OSLIB_HOST_H
+
+// Include clib header files
+#include <stddef.h>
+
+// Basic types
+typedef unsigned int bits;
+typedef unsigned char byte;
+typedef int osbool;
+#ifndef __cplusplus
+typedef osbool bool;
+#endif
+#ifndef TRUE
+#define TRUE (1)
+#endif
+#ifndef FALSE
+#define FALSE (0)
+#endif
+#define SKIP (0)
+#define NONE (-1)
+
+// Useful macros
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif
+#define ALIGN(n) (((n) + 3) & ~3)
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+#define BOOL(x) ((x) != 0)
+
+// Operating system types
+typedef struct
+{
+    bits errnum;
+    char errmess[252];
+} os_error;
+typedef int os_t;
+typedef bits os_fw;
+typedef byte os_date_and_time[5];
+typedef bits os_colour;
+typedef struct
+{
+    int x;
+    int y;
+} os_coord;
+typedef struct
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} os_box;
+
+// File switch types
+typedef bits fileswitch_attr;
+#define fileswitch_ATTR_OWNER_READ ((fileswitch_attr) 0x01u)
+#define fileswitch_ATTR_OWNER_WRITE ((fileswitch_attr) 0x02u)
+#define fileswitch_ATTR_OWNER_LOCKED ((fileswitch_attr) 0x08u)
+#define fileswitch_ATTR_WORLD_READ ((fileswitch_attr) 0x10u)
+#define fileswitch_ATTR_WORLD_WRITE ((fileswitch_attr) 0x20u)
+typedef bits fileswitch_object_type;
+#define fileswitch_NOT_FOUND ((fileswitch_object_type) 0x0u)
+#define fileswitch_IS_FILE ((fileswitch_object_type) 0x1u)
+#define fileswitch_IS_DIR ((fileswitch_object_type) 0x2u)
+#define fileswitch_IS_IMAGE ((fileswitch_object_type) 0x3u)
+typedef bits fileswitch_fs_no;
+typedef bits fileswitch_fs_info;
+#define fileswitch_HAS_EXTRA_FLAGS ((fileswitch_fs_info) 0x80000000u)
+#define fileswitch_SUPPORTS_IMAGE ((fileswitch_fs_info) 0x00800000u)
+#define fileswitch_NEEDS_FLUSH ((fileswitch_fs_info) 0x00400000u)
+#define fileswitch_NO_LOAD_ENTRY ((fileswitch_fs_info) 0x00080000u)
+#define fileswitch_NO_SAVE_ENTRY ((fileswitch_fs_info) 0x00040000u)
+typedef bits fileswitch_fs_extra_info;
+
+// Object information returned by OS_GBPB
+#define osgbpb_INFO(N) \
+    struct \
+    { \
+        bits load_addr; \
+        bits exec_addr; \
+        int size; \
+        fileswitch_attr attr; \
+        fileswitch_object_type obj_type; \
+        char name[N]; \
+    }
+
+// File types
+#define osfile_FILE_TYPE_SHIFT (8)
+#define osfile_TYPE_DATA (0xffdu)
+#define osfile_TYPE_UNTYPED (0x1000u)
+
+// Open file flags
+#define osfind_NO_PATH (0x03u)
+#define osfind_ERROR_IF_DIR (0x04u)
+#define osfind_ERROR_IF_ABSENT (0x08u)
+
+// Wipe flags
+#define osfscontrol_WIPE_RECURSE (0x01u)
+#define osfscontrol_WIPE_FORCE (0x02u)
+
+// Read the real time clock (padded so that it can be copied as a date_riscos)
+#define oswordreadclock_OP_UTC (3)
+typedef union
+{
+    byte op;
+    os_date_and_time utc;
+    bits words[2];
+} oswordreadclock_utc_block;
+
+// Wimp task handles
+typedef struct wimp_t_ *wimp_t;
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/*
+    Parameters  : t             - Variable to receive the time.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the number of centiseconds since the harness started.
+*/
+os_error *xos_read_monotonic_time(os_t *t);
+
+/*
+    Parameters  : block         - Block to receive the time.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the simulated real time clock.
+*/
+os_error *xoswordreadclock_utc(oswordreadclock_utc_block *block);
+
+/*
+    Parameters  : name          - The name of the timezone.
+                  offset        - Variable to receive the offset from UTC.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the current timezone, which is always UTC.
+*/
+os_error *xterritory_read_current_time_zone(char const **name, int *offset);
+
+/*
+    Parameters  : extension     - The file extension.
+                  file_type     - Variable to receive the file type.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Convert a file extension to a file type. No mappings are
+                  available, so this always fails.
+*/
+os_error *xmimemaptranslate_extension_to_filetype(char const *extension,
+                                                  bits *file_type);
+
+/*
+    Parameters  : name          - The file type name.
+                  file_type     - Variable to receive the file type.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Convert a file type name or number to a file type. Only
+                  hexadecimal numbers are recognised.
+*/
+os_error *xosfscontrol_file_type_from_string(char const *name,
+                                             bits *file_type);
+
+/*
+    Parameters  : file_type     - The file type.
+                  name1         - Variable to receive the first half of the
+                                  name.
+                  name2         - Variable to receive the second half of the
+                                  name.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the name of a file type, which is always its number.
+*/
+os_error *xosfscontrol_read_file_type(bits file_type, bits *name1,
+                                      bits *name2);
+
+/*
+    Parameters  : The same as the OSLib equivalents.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Local file operations are not available in the harness, so
+                  these all fail.
+*/
+os_error *xosfile_create_dir(char const *name, int entries);
+os_error *xosfind_openinw(bits flags, char const *name, char const *path,
+                          os_fw *file);
+os_error *xosfind_openoutw(bits flags, char const *name, char const *path,
+                           os_fw *file);
+os_error *xosfind_closew(os_fw file);
+os_error *xosgbpb_readw(os_fw file, byte *data, int size, int *unread);
+os_error *xosgbpb_writew(os_fw file, byte const *data, int size,
+                         int *unwritten);
+os_error *xosfscontrol_wipe(char const *name, bits flags, bits date_lo,
+                            bits date_hi, bits date_lo_end, bits date_hi_end);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -0,0 +1,2 @@
+// Host harness replacement for the OSLib mimemap.h header
+#include "oslib/host.h"
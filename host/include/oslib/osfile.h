@@ -0,0 +1,2 @@
+// Host harness replacement for the OSLib osfile.h header
+#include "oslib/host.h"
@@ -0,0 +1,235 @@
+/*
+    File        : psifs.h
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : The subset of the PsiFS SWI interface definitions required
+                  by the host benchmark harness. These match the values in
+                  psifs.swi, from which the RISC OS build generates the full
+                  header.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+    
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+    
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Only include header file once
+#ifndef PSIFS_H
+#define PSIFS_H
+
+// Include oslib header files
+#include "oslib/types.h"
+#include "oslib/os.h"
+#include "oslib/fileswitch.h"
+
+// Error numbers
+#define error_PSIFS_NO_DRIVER            (0x815900)
+#define error_PSIFS_BLOCK_DRIVER         (0x815901)
+#define error_PSIFS_DRIVER_SIZE          (0x815902)
+#define error_PSIFS_DRIVER_FULL          (0x815903)
+#define error_PSIFS_LINK_BUSY            (0x815908)
+#define error_PSIFS_NO_LINK              (0x815910)
+#define error_PSIFS_NO_FRAME             (0x815911)
+#define error_PSIFS_NO_CONNECT           (0x815912)
+#define error_PSIFS_NO_MUX               (0x815913)
+#define error_PSIFS_NOT_CONNECTED        (0x815914)
+#define error_PSIFS_NOT_POLL             (0x815915)
+#define error_PSIFS_CONNECTION_BUSY      (0x815916)
+#define error_PSIFS_CHAN_EXISTS          (0x815917)
+#define error_PSIFS_MUX_FULL             (0x815918)
+#define error_PSIFS_SVR_NONE             (0x815919)
+#define error_PSIFS_SVR_CLOSED           (0x81591a)
+#define error_PSIFS_SVR_TIME             (0x81591b)
+#define error_PSIFS_BAD_BUFFER           (0x81591c)
+#define error_PSIFS_BUFFER_FULL          (0x81591d)
+#define error_PSIFS_BUFFER_END           (0x81591e)
+#define error_PSIFS_BAD_FRAME_STATE      (0x815920)
+#define error_PSIFS_BAD_CONNECT_STATE    (0x815921)
+#define error_PSIFS_BAD_NCP_EVENT        (0x815922)
+#define error_PSIFS_BAD_NCP_OP           (0x815923)
+#define error_PSIFS_NCP_LEN              (0x815924)
+#define error_PSIFS_NCP_TOO_MANY         (0x815925)
+#define error_PSIFS_BAD_RFSV_OP          (0x815928)
+#define error_PSIFS_NOT_RFSV_REPLY       (0x815929)
+#define error_PSIFS_BAD_RFSV_REPLY       (0x81592a)
+#define error_PSIFS_RFSV_LEN             (0x81592b)
+#define error_PSIFS_RFSV_STR             (0x81592c)
+#define error_PSIFS_RFSV_TOO_MANY        (0x81592d)
+#define error_PSIFS_BAD_UNIFIED_OP       (0x81592e)
+#define error_PSIFS_BAD_CACHE_OP         (0x81592f)
+#define error_PSIFS_TIMEOUT              (0x815930)
+#define error_PSIFS_COMMS                (0x815931)
+#define error_PSIFS_CACHE_INACTIVE       (0x815932)
+#define error_PSIFS_CACHE_BUSY           (0x815933)
+#define error_PSIFS_NOT_LINK_REPLY       (0x815938)
+#define error_PSIFS_BAD_LINK_REPLY       (0x815939)
+#define error_PSIFS_LINK_LEN             (0x81593a)
+#define error_PSIFS_BAD_UID              (0x815940)
+#define error_PSIFS_BAD_EXT              (0x815941)
+#define error_PSIFS_BAD_UPLOAD_OP        (0x815948)
+#define error_PSIFS_BAD_ASYNC_HANDLE     (0x815950)
+#define error_PSIFS_BAD_ASYNC_OP         (0x815951)
+#define error_PSIFS_BAD_ASYNC_STATE      (0x815952)
+#define error_PSIFS_BAD_TAR_CHECKSUM     (0x815960)
+#define error_PSIFS_BAD_TAR_HEADER       (0x815961)
+#define error_PSIFS_TAR_EOF              (0x815962)
+#define error_PSIFS_BAD_TAR_OP           (0x815963)
+#define error_PSIFS_REMOTE_UNKNOWN       (0x815980)
+#define error_PSIFS_REMOTE_GENERAL       (0x815981)
+#define error_PSIFS_REMOTE_OS            (0x815982)
+#define error_PSIFS_REMOTE_NOT_SUP       (0x815983)
+#define error_PSIFS_REMOTE_IN_USE        (0x815984)
+#define error_PSIFS_REMOTE_NO_MEMORY     (0x815985)
+#define error_PSIFS_REMOTE_FS            (0x815986)
+#define error_PSIFS_REMOTE_NOT_READY     (0x815987)
+#define error_PSIFS_REMOTE_CANCEL        (0x815988)
+#define error_PSIFS_REMOTE_DISCON        (0x815989)
+#define error_PSIFS_REMOTE_NO_CON        (0x81598a)
+#define error_PSIFS_REMOTE_ABORT         (0x81598b)
+#define error_PSIFS_REMOTE_POWER         (0x81598c)
+#define error_PSIFS_KILL_CLIENTS         (0x815990)
+#define error_PSIFS_BAD_INTERCEPT_HANDLE (0x8159a0)
+#define error_PSIFS_BAD_INTERCEPT_TYPE   (0x8159a1)
+#define error_PSIFS_BAD_INTERCEPT_MSG    (0x8159a2)
+#define error_PSIFS_INTERCEPT_DIED       (0x8159a3)
+#define error_PSIFS_BAD_INTERCEPT_STATE  (0x8159a4)
+#define error_PSIFS_INTERCEPT_RUN        (0x8159a5)
+#define error_PSIFS_LANG_UNKNOWN         (0x8159b0)
+#define error_PSIFS_TOO_MANY_LANG        (0x8159b1)
+#define error_PSIFS_SIS_WRITE_OUTSIDE    (0x8159b8)
+#define error_PSIFS_SIS_READ_OUTSIDE     (0x8159b9)
+#define error_PSIFS_BAD_SIS_HEADER       (0x8159ba)
+#define error_PSIFS_BAD_SIS_TYPE         (0x8159bb)
+#define error_PSIFS_BAD_SIS_CHECKSUM     (0x8159bc)
+#define error_PSIFS_CLIPBOARD_NOT_ACTIVE (0x8159c0)
+#define error_PSIFS_CLIPBOARD_NOT_SYNC   (0x8159c1)
+#define error_PSIFS_CLIPBOARD_STATE      (0x8159c2)
+#define error_PSIFS_PRINT_JOB_NO_PAGE    (0x8159d0)
+#define error_PSIFS_EOF                  (0x19a02)
+#define error_PSIFS_EXT_ESCAPE           (0x19a11)
+#define error_PSIFS_CANT_DEL_CSD         (0x19a96)
+#define error_PSIFS_CANT_DEL_LIB         (0x19a97)
+#define error_PSIFS_BAD_DISC             (0x19a9a)
+#define error_PSIFS_TOO_MANY_DISCS       (0x19a9b)
+#define error_PSIFS_BAD_UP               (0x19a9d)
+#define error_PSIFS_AMBIG_DISC           (0x19a9e)
+#define error_PSIFS_NOT_REF_DISC         (0x19a9f)
+#define error_PSIFS_IN_USE               (0x19aa0)
+#define error_PSIFS_BAD_PARMS            (0x19aa1)
+#define error_PSIFS_CANT_DEL_URD         (0x19aa2)
+#define error_PSIFS_BUFFER               (0x19aa5)
+#define error_PSIFS_WORKSPACE            (0x19aa6)
+#define error_PSIFS_MULTIPLE_CLOSE       (0x19aa7)
+#define error_PSIFS_BAD_DRIVE            (0x19aac)
+#define error_PSIFS_BAD_RENAME           (0x19ab0)
+#define error_PSIFS_DIR_FULL             (0x19ab3)
+#define error_PSIFS_DIR_NOT_EMPTY        (0x19ab4)
+#define error_PSIFS_OUTSIDE              (0x19ab7)
+#define error_PSIFS_ACCESS               (0x19abd)
+#define error_PSIFS_TOO_MANY_OPEN        (0x19ac0)
+#define error_PSIFS_OPEN                 (0x19ac2)
+#define error_PSIFS_LOCKED               (0x19ac3)
+#define error_PSIFS_EXISTS               (0x19ac4)
+#define error_PSIFS_TYPES                (0x19ac5)
+#define error_PSIFS_DISC_FULL            (0x19ac6)
+#define error_PSIFS_DISC                 (0x19ac7)
+#define error_PSIFS_WRITE_PROT           (0x19ac9)
+#define error_PSIFS_DATA_LOST            (0x19aca)
+#define error_PSIFS_BAD_NAME             (0x19acc)
+#define error_PSIFS_BAD_ATT              (0x19acf)
+#define error_PSIFS_DRIVE_EMPTY          (0x19ad3)
+#define error_PSIFS_DISC_NOT_FOUND       (0x19ad4)
+#define error_PSIFS_DISC_NOT_PRESENT     (0x19ad5)
+#define error_PSIFS_NOT_FOUND            (0x19ad6)
+#define error_PSIFS_CHANNEL              (0x19ade)
+#define error_PSIFS_NOT_SUPPORTED        (0x19af8)
+#define error_PSIFS_FS_WRITE_ONLY        (0x19afa)
+#define error_PSIFS_FS_READ_ONLY         (0x19afc)
+#define error_PSIFS_WILD_CARDS           (0x19afd)
+#define error_PSIFS_BAD_COM              (0x19afe)
+
+// Filing system number
+#define psifs_FS_NUMBER_PSIFS ((fileswitch_fs_no) 154)
+
+// Mask for changes of interest
+typedef bits psifs_mask;
+#define psifs_MASK_MODE ((psifs_mask) 0x00000001u)
+#define psifs_MASK_BLOCK_DRIVER ((psifs_mask) 0x00000002u)
+#define psifs_MASK_STATS_BYTES ((psifs_mask) 0x00000010u)
+#define psifs_MASK_LINK_CONFIG ((psifs_mask) 0x00000100u)
+#define psifs_MASK_LINK_STATUS ((psifs_mask) 0x00000200u)
+#define psifs_MASK_LINK_DRIVES ((psifs_mask) 0x00000400u)
+#define psifs_MASK_LINK_ASYNC_END ((psifs_mask) 0x00001000u)
+#define psifs_MASK_LINK_ASYNC_STATE ((psifs_mask) 0x00002000u)
+#define psifs_MASK_PRINTER_CONFIG ((psifs_mask) 0x00010000u)
+#define psifs_MASK_INTERCEPT_STATUS ((psifs_mask) 0x00100000u)
+#define psifs_MASK_CLIPBOARD_STATUS ((psifs_mask) 0x00200000u)
+#define psifs_MASK_PRINT_JOB_STATUS ((psifs_mask) 0x00400000u)
+
+// Modes of operation
+typedef bits psifs_mode;
+#define psifs_MODE_INACTIVE ((psifs_mode) 0x00u)
+#define psifs_MODE_LINK ((psifs_mode) 0x01u)
+#define psifs_MODE_PRINTER ((psifs_mode) 0x02u)
+
+// A drive letter
+typedef byte psifs_drive;
+
+// Machine type
+typedef bits psifs_machine_type;
+#define psifs_MACHINE_TYPE_UNKNOWN ((psifs_machine_type) 0x00u)
+#define psifs_MACHINE_TYPE_PC ((psifs_machine_type) 0x01u)
+#define psifs_MACHINE_TYPE_MC ((psifs_machine_type) 0x02u)
+#define psifs_MACHINE_TYPE_HC ((psifs_machine_type) 0x03u)
+#define psifs_MACHINE_TYPE_S3 ((psifs_machine_type) 0x04u)
+#define psifs_MACHINE_TYPE_S3A ((psifs_machine_type) 0x05u)
+#define psifs_MACHINE_TYPE_WORKABOUT ((psifs_machine_type) 0x06u)
+#define psifs_MACHINE_TYPE_SIENNA ((psifs_machine_type) 0x07u)
+#define psifs_MACHINE_TYPE_S3C ((psifs_machine_type) 0x08u)
+#define psifs_MACHINE_TYPE_S5 ((psifs_machine_type) 0x20u)
+#define psifs_MACHINE_TYPE_WINC ((psifs_machine_type) 0x21u)
+
+// Language
+typedef bits psifs_language;
+#define psifs_LANGUAGE_UNKNOWN ((psifs_language) 0xffffffffu)
+#define psifs_LANGUAGE_TEST ((psifs_language) 0x00u)
+#define psifs_LANGUAGE_UK_ENGLISH ((psifs_language) 0x01u)
+
+// Remote drive status
+typedef bits psifs_drive_status;
+#define psifs_DRIVE_STATUS_PRESENT ((psifs_drive_status) 0x00000001u)
+#define psifs_DRIVE_STATUS_ROM ((psifs_drive_status) 0x00000100u)
+
+// Remote drive unique identifier
+typedef bits psifs_drive_id;
+
+// Battery status
+typedef bits psifs_battery_status;
+#define psifs_BATTERY_STATUS_DEAD ((psifs_battery_status) 0u)
+#define psifs_BATTERY_STATUS_VERY_LOW ((psifs_battery_status) 1u)
+#define psifs_BATTERY_STATUS_LOW ((psifs_battery_status) 2u)
+#define psifs_BATTERY_STATUS_GOOD ((psifs_battery_status) 3u)
+
+// Character set
+typedef bits psifs_character_set;
+#define psifs_LATIN1 ((psifs_character_set) 0u)
+#define psifs_WINDOWS_ANSI ((psifs_character_set) 1u)
+#define psifs_CODE_PAGE_850 ((psifs_character_set) 2u)
+
+// Translation table between two character sets
+typedef struct
+{
+    char mapping[256];
+} psifs_translation_table;
+
+#endif
@@ -0,0 +1,503 @@
+/*
+    File        : link.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Serial link management for the host benchmark harness. This
+                  follows the module implementation, but without the system
+                  variables, semaphores or support for other block driver
+                  related modules.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include header file for this module
+#include "link.h"
+
+// Include clib header files
+#include <stdio.h>
+
+// Include oslib header files
+#include "oslib/macros.h"
+
+// Include project header files
+#include "blockdrive.h"
+#include "ctrl.h"
+#include "err.h"
+#include "escape.h"
+#include "mem.h"
+#include "pollword.h"
+#include "stats.h"
+#include "user.h"
+#include "util.h"
+
+// Other serial link configuration
+#define LINK_WORD_FORMAT (BLOCKDRIVE_FORMAT_BITS_8 \
+                          | BLOCKDRIVE_FORMAT_STOP_1 \
+                          | BLOCKDRIVE_FORMAT_PARITY_DISABLED \
+                          | BLOCKDRIVE_FORMAT_PARITY_TYPE_ODD)
+#define LINK_FLOW_CONTROL (BLOCKDRIVE_FLOW_HARDWARE)
+#define LINK_CONTROL_INACTIVE (0)
+#define LINK_CONTROL_ACTIVE (BLOCKDRIVE_CONTROL_DTR \
+                             | BLOCKDRIVE_CONTROL_RTS)
+
+// Maximum number of bits transmitted per byte
+#define LINK_MAX_BITS (8 + 1 + 2)
+
+// Timeout in centiseconds for polled operations
+#define LINK_TIMEOUT_POLL (20)
+
+// Timeout in centiseconds for the transmitter to become idle
+#define LINK_TIMEOUT_IDLE (500)
+
+// Buffer size for drivers that support block operations
+#define LINK_BLOCK_SIZE (512)
+
+// The current configuration
+char *link_driver_name = NULL;
+bits link_driver_port = 0;
+bits link_driver_baud = 0;
+char *link_driver_options = NULL;
+bool link_driver_autobaud = FALSE;
+
+// The active baud rate
+bits link_driver_active_baud = 0;
+
+// Is a serial driver active
+bool link_active = FALSE;
+static blockdrive_driver link_driver = BLOCKDRIVE_DRIVER_NONE;
+
+// The current data rate if active
+static bits link_cps;
+
+// Flag to prevent reentrant use of the serial link
+static bool link_claimed = FALSE;
+
+/*
+    Parameters  : bytes - Number of bytes to transmit.
+    Returns     : bits  - Number of centi-seconds required, rounded up.
+    Description : Calculate the number of centi-seconds required to transmit or
+                  receive the specified number of bytes.
+*/
+bits link_time(bits bytes)
+{
+    // Return the result
+    return link_active ? ((bytes * 100) / link_cps) + 1 : 0;
+}
+
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Wait for the serial transmitter to become idle.
+*/
+static os_error *link_wait_idle(void)
+{
+    os_error *err = NULL;
+    os_t timeout = util_time() + LINK_TIMEOUT_IDLE;
+    bits free = 0;
+    bits prev = 1;
+
+    // Wait until the buffer status does not change
+    while (!err && (free != prev) && ((util_time() - timeout) < 0))
+    {
+        os_t end;
+
+        // Delay for another character to be transmitted
+        end = util_time() + link_time(1);
+        while (!err && ((util_time() - end) < 0)) err = link_poll(TRUE);
+
+        // Check the number of free buffer entries
+        prev = free;
+        free = blockdrive_check_tx(link_driver);
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Initialise the serial link.
+*/
+os_error *link_initialise(void)
+{
+    os_error *err = NULL;
+
+    // Reset the statistics
+    stats_reset();
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Shut down any active serial link.
+*/
+os_error *link_finalise(void)
+{
+    os_error *err = NULL;
+
+    // Unload any active blockdriver
+    err = link_disable(FALSE);
+
+    // Release any claimed memory
+    if (!err)
+    {
+        if (link_driver_name) MEM_FREE(link_driver_name);
+        if (link_driver_options) MEM_FREE(link_driver_options);
+        link_driver_name = NULL;
+        link_driver_options = NULL;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : changed       - Variable to receive whether the baud rate
+                                  was changed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Try the next available baud rate if automatic baud rate
+                  identification selected. The simulated line only supports
+                  the configured baud rate, so this never changes it.
+*/
+os_error *link_next_baud(bool *changed)
+{
+    os_error *err = NULL;
+
+    // The baud rate is never changed
+    if (changed) *changed = FALSE;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Attempt to load and initialise the configured block driver.
+*/
+static os_error *link_load(void)
+{
+    os_error *err = NULL;
+    bits ports;
+
+    // Attempt to load the configured driver
+    err = blockdrive_load(link_driver_name, &link_driver, &ports);
+
+    // Attempt to initialise the configured port
+    if (!err && (ports <= link_driver_port)) err = &err_block_driver;
+    if (!err)
+    {
+        err = blockdrive_initialise(link_driver, link_driver_port,
+                                    link_driver_options);
+    }
+
+    // Configure and flush the block driver if successful
+    if (!err)
+    {
+        // Configure the block driver
+        blockdrive_word_format_write(link_driver, LINK_WORD_FORMAT);
+        blockdrive_flow_control_write(link_driver, LINK_FLOW_CONTROL);
+
+        // Set the baud rate
+        link_driver_active_baud = link_driver_baud;
+        blockdrive_tx_speed_write(link_driver, link_driver_active_baud);
+        blockdrive_rx_speed_write(link_driver, link_driver_active_baud);
+        blockdrive_control_write(link_driver, LINK_CONTROL_ACTIVE);
+        link_cps = link_driver_active_baud / LINK_MAX_BITS;
+
+        // Flush any pending input and output
+        blockdrive_flush_tx(link_driver);
+        blockdrive_flush_rx(link_driver);
+    }
+
+    // Set the status if successul or unload the block driver otherwise
+    if (!err) link_active = TRUE;
+    else if (link_driver != BLOCKDRIVE_DRIVER_NONE)
+    {
+        blockdrive_unload(link_driver);
+        link_driver = BLOCKDRIVE_DRIVER_NONE;
+    }
+
+    // Reset the statistics if successful
+    if (!err) stats_reset();
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Unload any loaded block driver.
+*/
+static void link_unload(void)
+{
+    // No action unless block driver loaded
+    if (link_active)
+    {
+        // Close down the driver
+        blockdrive_control_write(link_driver, LINK_CONTROL_INACTIVE);
+        blockdrive_close_down(link_driver);
+        blockdrive_unload(link_driver);
+
+        // Set the status
+        link_active = FALSE;
+        link_driver = BLOCKDRIVE_DRIVER_NONE;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Enable the block driver for a remote link.
+*/
+os_error *link_enable_link(void)
+{
+    os_error *err = NULL;
+
+    // Load and configure the block driver if necessary
+    if (!link_active) err = link_load();
+
+    // Start the remote link user
+    if (!err)
+    {
+        err = user_start_link();
+        if (err) link_unload();
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : print         - The name of the device to write to, or NULL
+                                  to use the default.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Enable the block driver for a printer mirror. This is not
+                  supported by the harness.
+*/
+os_error *link_enable_print(const char *print)
+{
+    // Printer mirror not supported
+    return &err_block_driver;
+}
+
+/*
+    Parameters  : now           - Should any active block driver be unloaded
+                                  immediately.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Disable the block driver if already active.
+                  This will normally attempt a tidy shutdown, but may be forced
+                  to terminate immediately.
+*/
+os_error *link_disable(bool now)
+{
+    os_error *err = NULL;
+
+    // No action required unless the block driver is active
+    if (link_active)
+    {
+        // Terminate the user of the block driver
+        err = user_end(now);
+
+        // If necessary wait for transmit to complete
+        if (!err && !now) err = link_wait_idle();
+
+        // Unload the block driver
+        if (!err) link_unload();
+
+        // Clear the active baud rate value if successful
+        if (!err) link_driver_active_baud = 0;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : name          - The name of the block driver to use.
+                  port          - The port number.
+                  baud          - The baud rate.
+                  options       - Any other options.
+                  autobaud      - Automatic baud rate identification mode.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Set new serial link settings.
+*/
+os_error *link_configure(const char *name, bits port, bits baud,
+                         const char *options, bool autobaud)
+{
+    os_error *err = NULL;
+
+    // It is an error if a block driver is active
+    if (link_active) err = &err_link_busy;
+
+    // Set the internal copy of the settings (careful if preserving)
+    if (!err)
+    {
+        if (name != link_driver_name)
+        {
+            if (link_driver_name) MEM_FREE(link_driver_name);
+            link_driver_name = ctrl_strdup(name);
+        }
+        link_driver_port = port;
+        link_driver_baud = baud;
+        if (options != link_driver_options)
+        {
+            if (link_driver_options) MEM_FREE(link_driver_options);
+            link_driver_options = ctrl_strdup(options);
+        }
+        link_driver_autobaud = autobaud;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : escape        - Should escape conditions be checked for.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform any polled operations required with respect to the
+                  link.
+*/
+os_error *link_poll(bool escape)
+{
+    os_error *err = NULL;
+
+    // Check for an escape condition
+    err = escape_check();
+
+    // Attempt to claim the link
+    if (!err && !link_claimed)
+    {
+        bool first = TRUE;
+        bool more = TRUE;
+        int timeout = util_time() + LINK_TIMEOUT_POLL;
+
+        // Keep polling until no more actions
+        link_claimed = TRUE;
+        while (!err && link_active && more && ((util_time() - timeout) < 0))
+        {
+            static byte rx[LINK_BLOCK_SIZE];
+            static byte tx[LINK_BLOCK_SIZE];
+            bits rx_size;
+            bits tx_size;
+            bool dsr;
+
+            // Poll the block driver
+            blockdrive_poll(link_driver);
+            dsr = blockdrive_modem_read(link_driver) & BLOCKDRIVE_MODEM_DSR;
+
+            // Read any received bytes
+            rx_size = blockdrive_get_block(link_driver, rx, sizeof(rx));
+            stats_rx_bytes += rx_size;
+
+            // Poll the user of the block driver
+            tx_size = MIN(blockdrive_check_tx(link_driver), sizeof(tx));
+            err = user_poll_block(dsr, rx, rx_size, tx, &tx_size, first);
+            first = FALSE;
+
+            // Transmit any returned bytes
+            if (!err && tx_size)
+            {
+                if (blockdrive_put_block(link_driver, tx, tx_size) != tx_size)
+                {
+                    err = &err_driver_full;
+                }
+                stats_tx_bytes += tx_size;
+            }
+            more = rx_size || tx_size;
+
+            // Update any relevant pollwords
+            if (!err && more) err = pollword_update(psifs_MASK_STATS_BYTES);
+        }
+
+        // Release the link
+        link_claimed = FALSE;
+    }
+
+    // Disconnect the link if required
+    if (!err && !escape && link_active && user_check_disconnect())
+    {
+        err = link_disable(FALSE);
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : bool          - Should verbose information be output.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : List the current settings and status.
+*/
+os_error *link_list_settings(bool verbose)
+{
+    os_error *err = NULL;
+
+    // Summarise the activity status
+    if (link_active)
+    {
+        printf("Block driver '%s' active at %u baud.\n",
+               link_driver_name, link_driver_active_baud);
+        printf("%u bytes received, %u bytes transmitted.\n",
+               stats_rx_bytes, stats_tx_bytes);
+        if (verbose) err = user_status();
+    }
+    else printf("Block driver disabled.\n");
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : bool          - Should verbose information be output.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : List the available block drivers.
+*/
+os_error *link_list_drivers(bool verbose)
+{
+    os_error *err = NULL;
+    int context = 0;
+    char name[20];
+    bool found;
+
+    // List all of the drivers
+    err = blockdrive_enumerate(&context, name, sizeof(name), &found);
+    while (!err && found)
+    {
+        printf("%s\n", name);
+        err = blockdrive_enumerate(&context, name, sizeof(name), &found);
+    }
+
+    // Return any error produced
+    return err;
+}
@@ -0,0 +1,210 @@
+/*
+    File        : oslib.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Implementations of the OSLib functions used by the protocol
+                  stack for the host benchmark harness. Times are read from
+                  the simulated clock, and local file operations fail.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include clib header files
+#include <stdlib.h>
+
+// Include oslib header files
+#include "oslib/os.h"
+#include "oslib/osword.h"
+
+// Include project header files
+#include "err.h"
+#include "sim.h"
+
+// The real time clock at the start of each run: 1-Jan-2026 in centiseconds
+#define OSLIB_CLOCK_START (397621440000ULL)
+
+/*
+    Parameters  : t             - Variable to receive the time.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the number of centiseconds since the harness started.
+*/
+os_error *xos_read_monotonic_time(os_t *t)
+{
+    // Read the simulated clock
+    if (t) *t = (os_t) (sim_now() / SIM_TIME_CS);
+
+    // No error possible
+    return NULL;
+}
+
+/*
+    Parameters  : block         - Block to receive the time.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the simulated real time clock.
+*/
+os_error *xoswordreadclock_utc(oswordreadclock_utc_block *block)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if (!block) err = &err_bad_parms;
+    else
+    {
+        unsigned long long cs = OSLIB_CLOCK_START + sim_now() / SIM_TIME_CS;
+        bits i;
+
+        // Store the five byte time, least significant byte first
+        for (i = 0; i < sizeof(block->utc); i++)
+        {
+            block->utc[i] = (byte) (cs >> (8 * i));
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : name          - The name of the timezone.
+                  offset        - Variable to receive the offset from UTC.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the current timezone, which is always UTC.
+*/
+os_error *xterritory_read_current_time_zone(char const **name, int *offset)
+{
+    // Always UTC
+    if (name) *name = "UTC";
+    if (offset) *offset = 0;
+
+    // No error possible
+    return NULL;
+}
+
+/*
+    Parameters  : extension     - The file extension.
+                  file_type     - Variable to receive the file type.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Convert a file extension to a file type. No mappings are
+                  available, so this always fails.
+*/
+os_error *xmimemaptranslate_extension_to_filetype(char const *extension,
+                                                  bits *file_type)
+{
+    // No mappings available
+    return &err_not_found;
+}
+
+/*
+    Parameters  : name          - The file type name.
+                  file_type     - Variable to receive the file type.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Convert a file type name or number to a file type. Only
+                  hexadecimal numbers are recognised.
+*/
+os_error *xosfscontrol_file_type_from_string(char const *name,
+                                             bits *file_type)
+{
+    os_error *err = NULL;
+    char *end;
+    unsigned long value;
+
+    // Check parameters
+    if (!name || !file_type) err = &err_bad_parms;
+    else
+    {
+        // Attempt to convert the number
+        value = strtoul(name, &end, 16);
+        if ((end == name) || *end || (0xfff < value)) err = &err_not_found;
+        else *file_type = (bits) value;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : file_type     - The file type.
+                  name1         - Variable to receive the first half of the
+                                  name.
+                  name2         - Variable to receive the second half of the
+                                  name.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read the name of a file type, which is always its number.
+*/
+os_error *xosfscontrol_read_file_type(bits file_type, bits *name1,
+                                      bits *name2)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    // Build the name as three hexadecimal digits padded with spaces
+    if (name1)
+    {
+        *name1 = hex[(file_type >> 8) & 0xf]
+                 | hex[(file_type >> 4) & 0xf] << 8
+                 | hex[file_type & 0xf] << 16
+                 | ' ' << 24;
+    }
+    if (name2) *name2 = ' ' | ' ' << 8 | ' ' << 16 | ' ' << 24;
+
+    // No error possible
+    return NULL;
+}
+
+/*
+    Parameters  : The same as the OSLib equivalents.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Local file operations are not available in the harness, so
+                  these all fail.
+*/
+os_error *xosfile_create_dir(char const *name, int entries)
+{
+    return &err_not_found;
+}
+os_error *xosfind_openinw(bits flags, char const *name, char const *path,
+                          os_fw *file)
+{
+    return &err_not_found;
+}
+os_error *xosfind_openoutw(bits flags, char const *name, char const *path,
+                           os_fw *file)
+{
+    return &err_not_found;
+}
+os_error *xosfind_closew(os_fw file)
+{
+    return &err_not_found;
+}
+os_error *xosgbpb_readw(os_fw file, byte *data, int size, int *unread)
+{
+    return &err_not_found;
+}
+os_error *xosgbpb_writew(os_fw file, byte const *data, int size,
+                         int *unwritten)
+{
+    return &err_not_found;
+}
+os_error *xosfscontrol_wipe(char const *name, bits flags, bits date_lo,
+                            bits date_hi, bits date_lo_end, bits date_hi_end)
+{
+    return &err_not_found;
+}
@@ -0,0 +1,391 @@
+/*
+    File        : rlebench.c++
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Host benchmark for the print job bitmap decoder. This
+                  times the run length decoder from ../src against the
+                  previous approach of growing the pixel vector one run at a
+                  time, using synthetic page bitmaps in every display mode.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include clib header files
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Include cpplib header files
+#include <vector>
+
+// Include project header files
+#include "rle.h"
+
+using std::vector;
+
+// Default benchmark parameters
+#define RLEBENCH_DEFAULT_COLUMNS (1240)
+#define RLEBENCH_DEFAULT_ROWS (1754)
+#define RLEBENCH_DEFAULT_COUNT (5)
+#define RLEBENCH_DEFAULT_SEED (1)
+
+// Run markers
+#define RLEBENCH_RUN_MAX (0x80)
+#define RLEBENCH_RUN_MIN (3)
+
+// Time conversion
+#define RLEBENCH_NS_PER_US (1000.0)
+#define RLEBENCH_NS_PER_S (1000000000.0)
+
+// Display modes, in order, with the sizes from printrend_base::get_bpp
+struct rlebench_mode
+{
+    const char *name;
+    bits bpp;
+};
+static const rlebench_mode rlebench_modes[] =
+{
+    {"grey2", 1},
+    {"grey4", 2},
+    {"grey16", 4},
+    {"grey256", 8},
+    {"colour16", 4},
+    {"colour256", 8},
+    {"colour64k", 16},
+    {"colour16m", 24},
+    {"rgb", 32},
+    {"color4k", 16}
+};
+
+// Pseudo-random number generator state
+static bits rlebench_seed;
+
+/*
+    Parameters  : range         - The number of possible values.
+    Returns     : bits          - A pseudo-random value less than range.
+    Description : Generate a repeatable pseudo-random number.
+*/
+static bits rlebench_random(bits range)
+{
+    rlebench_seed = rlebench_seed * 1103515245 + 12345;
+    return (rlebench_seed >> 8) % range;
+}
+
+/*
+    Parameters  : void
+    Returns     : double        - The current time in nanoseconds.
+    Description : Read a monotonic clock for timing the decoders.
+*/
+static double rlebench_now()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * RLEBENCH_NS_PER_S + now.tv_nsec;
+}
+
+/*
+    Parameters  : pixels        - Vector to receive the pixel data.
+                  stride        - Number of bytes in each row.
+                  rows          - Number of rows.
+    Returns     : void
+    Description : Generate a synthetic page bitmap. Most rows are blank
+                  paper, some contain short spans of text-like noise, and a
+                  few contain a graduated fill, giving a mixture of repeated
+                  and literal runs similar to a printed page.
+*/
+static void rlebench_generate(vector<byte> &pixels, bits stride, bits rows)
+{
+    bits y;
+
+    // Start with blank paper
+    pixels.assign(stride * rows, 0xff);
+
+    // Add the content to each row
+    for (y = 0; y < rows; y++)
+    {
+        byte *row = &pixels[y * stride];
+        bits type = rlebench_random(8);
+
+        if (type < 2)
+        {
+            bits spans = 1 + rlebench_random(8);
+
+            // Spans of text
+            while (spans--)
+            {
+                bits start = rlebench_random(stride);
+                bits length = 1 + rlebench_random(stride / 16 + 1);
+                bits x;
+
+                if (stride - start < length) length = stride - start;
+                for (x = start; x < start + length; x++)
+                {
+                    row[x] = rlebench_random(4) ? 0x00 : rlebench_random(256);
+                }
+            }
+        }
+        else if (type == 2)
+        {
+            bits x;
+
+            // A graduated fill
+            for (x = 0; x < stride; x++) row[x] = (x * 7 + y) & 0xff;
+        }
+    }
+}
+
+/*
+    Parameters  : pixels        - The pixel data to encode.
+                  encoded       - Vector to receive the encoded data.
+    Returns     : void
+    Description : Run length encode pixel data in the EPOC print job format.
+                  Runs of at least RLEBENCH_RUN_MIN identical bytes are
+                  stored as a repeated byte and everything else as literals.
+*/
+static void rlebench_encode(const vector<byte> &pixels, vector<byte> &encoded)
+{
+    size_t size = pixels.size();
+    size_t i = 0;
+
+    // Encode all of the pixel data
+    encoded.clear();
+    while (i < size)
+    {
+        size_t run = 1;
+
+        // Measure any run of identical bytes
+        while ((i + run < size) && (run < RLEBENCH_RUN_MAX)
+               && (pixels[i + run] == pixels[i]))
+        {
+            run++;
+        }
+
+        if (RLEBENCH_RUN_MIN <= run)
+        {
+            // A single byte repeated
+            encoded.push_back(run - 1);
+            encoded.push_back(pixels[i]);
+            i += run;
+        }
+        else
+        {
+            size_t start = i;
+            size_t raw = 0;
+
+            // Literal bytes until the next worthwhile run
+            while ((i < size) && (raw < RLEBENCH_RUN_MAX)
+                   && !((i + RLEBENCH_RUN_MIN <= size)
+                        && (pixels[i] == pixels[i + 1])
+                        && (pixels[i] == pixels[i + 2])))
+            {
+                i++;
+                raw++;
+            }
+            encoded.push_back(0x100 - raw);
+            encoded.insert(encoded.end(), pixels.begin() + start,
+                           pixels.begin() + i);
+        }
+    }
+}
+
+/*
+    Parameters  : encoded       - The encoded data.
+                  columns       - Number of pixels in each row.
+                  rows          - Number of rows.
+                  pixels        - Vector to receive the pixel data.
+    Returns     : bool          - Was the encoded data complete.
+    Description : Decode run length encoded data in the same way as the
+                  print job decoder did before the exactly sized buffer was
+                  introduced, reserving a 1bpp sized buffer and then
+                  inserting or resizing for each run.
+*/
+static bool rlebench_decode_old(const vector<byte> &encoded, bits columns,
+                                bits rows, vector<byte> &pixels)
+{
+    bool complete = TRUE;
+    const byte *ptr = &encoded[0];
+    const byte *stop = ptr + encoded.size();
+
+    // Decode the pixel data into a new vector (assume 1bpp for reserved size)
+    vector<byte>().swap(pixels);
+    pixels.reserve((((columns + 7) / 8 + 3) & ~3) * rows);
+    while (ptr < stop)
+    {
+        bits marker = *ptr++;
+        if (marker < 0x80)
+        {
+            if (ptr == stop) complete = FALSE;
+            else pixels.insert(pixels.end(), marker + 1, *ptr++);
+        }
+        else
+        {
+            bits raw = 0x100 - marker;
+            if (size_t(stop - ptr) < raw)
+            {
+                complete = FALSE;
+                raw = stop - ptr;
+            }
+            bits at = pixels.size();
+            pixels.resize(at + raw, 0);
+            memcpy(&pixels[at], ptr, raw);
+            ptr += raw;
+        }
+    }
+
+    // Return whether the data was complete
+    return complete;
+}
+
+/*
+    Parameters  : encoded       - The encoded data.
+                  size          - Size of the decoded pixel data.
+                  pixels        - Vector to receive the pixel data.
+    Returns     : bool          - Was the encoded data complete.
+    Description : Decode run length encoded data as the print job decoder
+                  now does, allocating the exact size once and then using
+                  rle_decode.
+*/
+static bool rlebench_decode_new(const vector<byte> &encoded, size_t size,
+                                vector<byte> &pixels)
+{
+    const byte *ptr = &encoded[0];
+
+    // Decode the pixel data into a new exactly sized vector
+    vector<byte>().swap(pixels);
+    pixels.resize(size, 0);
+    return rle_decode(&ptr, ptr + encoded.size(), size ? &pixels[0] : NULL,
+                      size);
+}
+
+/*
+    Parameters  : mode          - The display mode to benchmark.
+                  columns       - Number of pixels in each row.
+                  rows          - Number of rows.
+                  count         - Number of times to decode the bitmap.
+    Returns     : bool          - Did both decoders reproduce the bitmap.
+    Description : Time both decoders for a synthetic bitmap.
+*/
+static bool rlebench_mode_run(const rlebench_mode &mode, bits columns,
+                              bits rows, bits count)
+{
+    bits stride = ((columns * mode.bpp + 31) / 32) * 4;
+    vector<byte> original;
+    vector<byte> encoded;
+    vector<byte> pixels;
+    bool ok = TRUE;
+    double start;
+    double old_ns;
+    double new_ns;
+    bits i;
+
+    // Construct the bitmap
+    rlebench_generate(original, stride, rows);
+    rlebench_encode(original, encoded);
+
+    // Time the previous decoder
+    start = rlebench_now();
+    for (i = 0; ok && (i < count); i++)
+    {
+        ok = rlebench_decode_old(encoded, columns, rows, pixels);
+    }
+    old_ns = (rlebench_now() - start) / count;
+    if (pixels != original) ok = FALSE;
+
+    // Time the current decoder
+    start = rlebench_now();
+    for (i = 0; ok && (i < count); i++)
+    {
+        ok = rlebench_decode_new(encoded, original.size(), pixels);
+    }
+    new_ns = (rlebench_now() - start) / count;
+    if (pixels != original) ok = FALSE;
+
+    // Display the results
+    printf("%-10s %2ubpp %8.1fKB %8.1fKB %10.1fus %10.1fus %6.2fx%s\n",
+           mode.name, mode.bpp, encoded.size() / 1024.0,
+           original.size() / 1024.0, old_ns / RLEBENCH_NS_PER_US,
+           new_ns / RLEBENCH_NS_PER_US, new_ns ? old_ns / new_ns : 0.0,
+           ok ? "" : " MISMATCH");
+
+    // Return whether the decoded data was correct
+    return ok;
+}
+
+/*
+    Parameters  : name          - The name of the program.
+    Returns     : void
+    Description : Display the command line syntax.
+*/
+static void rlebench_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-c columns] [-r rows] [-n count] "
+                    "[-s seed]\n", name);
+}
+
+/*
+    Parameters  : argc          - Number of command line arguments.
+                  argv          - The command line arguments.
+    Returns     : int           - The exit status.
+    Description : Run the bitmap decoder benchmark.
+*/
+int main(int argc, char *argv[])
+{
+    bits columns = RLEBENCH_DEFAULT_COLUMNS;
+    bits rows = RLEBENCH_DEFAULT_ROWS;
+    bits count = RLEBENCH_DEFAULT_COUNT;
+    bool ok = TRUE;
+    bits i;
+    int opt;
+
+    // Parse the command line
+    rlebench_seed = RLEBENCH_DEFAULT_SEED;
+    while ((opt = getopt(argc, argv, "c:r:n:s:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': columns = strtoul(optarg, NULL, 10); break;
+            case 'r': rows = strtoul(optarg, NULL, 10); break;
+            case 'n': count = strtoul(optarg, NULL, 10); break;
+            case 's': rlebench_seed = strtoul(optarg, NULL, 10); break;
+            case 'h': rlebench_usage(argv[0]); return EXIT_SUCCESS;
+            default: rlebench_usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if ((optind != argc) || !columns || !rows || !count)
+    {
+        rlebench_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("Bitmap: %u x %u pixels, %u decodes per mode\n",
+           columns, rows, count);
+    printf("%-10s %6s %10s %10s %12s %12s %7s\n", "Mode", "Depth",
+           "Encoded", "Decoded", "Old/decode", "New/decode", "Speedup");
+
+    // Benchmark each display mode
+    for (i = 0; i < sizeof(rlebench_modes) / sizeof(rlebench_modes[0]); i++)
+    {
+        if (!rlebench_mode_run(rlebench_modes[i], columns, rows, count))
+        {
+            ok = FALSE;
+        }
+    }
+
+    // Return the status
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,2380 @@
+/*
+    File        : server.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Scripted EPOC device for the host benchmark harness. This
+                  implements the device end of the link, multiplexor, remote
+                  file server (RFSV32) and remote command server (NCP)
+                  protocols, serving an in-memory filing system.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include header file for this module
+#include "server.h"
+
+// Include clib header files
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Include project header files
+#include "crc.h"
+#include "epoc32.h"
+#include "err.h"
+#include "ncp.h"
+#include "rfsv32.h"
+#include "status.h"
+
+// Special characters used in frames
+#define SERVER_FRAME_STX (0x02)
+#define SERVER_FRAME_ETX (0x03)
+#define SERVER_FRAME_EOT (0x04)
+#define SERVER_FRAME_DLE (0x10)
+#define SERVER_FRAME_SYN (0x16)
+
+// Maximum size of the data in a frame
+#define SERVER_FRAME_MAX (2048)
+#define SERVER_FRAME_ENCODED (3 + 2 * (2 + SERVER_FRAME_MAX) + 4)
+
+// Frame types and sequence numbers
+#define SERVER_CONT_ACK (0)
+#define SERVER_CONT_DISC (1)
+#define SERVER_CONT_REQ (2)
+#define SERVER_CONT_DATA (3)
+#define SERVER_SEQ_REQ_REQ (1)
+#define SERVER_SEQ_REQ_CON (4)
+#define SERVER_SEQ_NUM (2048)
+
+// The magic number used for connection requests
+#define SERVER_MAGIC (0x45504f43)
+
+// Interval between connection requests
+#define SERVER_TIMEOUT_REQ (50 * SIM_TIME_CS)
+
+// Default and maximum transmit window sizes
+#define SERVER_DEFAULT_WINDOW (8)
+#define SERVER_MAX_WINDOW (32)
+
+// Default retransmission timeout in centiseconds
+#define SERVER_DEFAULT_TIMEOUT (200)
+
+// Multiplexor frame layout
+#define SERVER_MUX_DEST (0)
+#define SERVER_MUX_SRC (1)
+#define SERVER_MUX_TYPE (2)
+#define SERVER_MUX_DATA (3)
+
+// Multiplexor control frame types
+#define SERVER_MUX_CONNECT_TO_SERVER (0x03)
+#define SERVER_MUX_CONNECT_RESPONSE (0x04)
+#define SERVER_MUX_NCP_INFO (0x06)
+#define SERVER_MUX_CHANNEL_DISCONNECT (0x07)
+#define SERVER_MUX_NCP_END (0x08)
+
+// Multiplexor data frame types
+#define SERVER_MUX_WRITECOMPLETE (0x01)
+#define SERVER_MUX_WRITEPARTIAL (0x02)
+
+// The NCP version reported to the host
+#define SERVER_NCP_VERSION (6)
+
+// Pending control frames
+#define SERVER_CTRL_QUEUE (16)
+#define SERVER_CTRL_MAX (64)
+
+// Channels provided by the device
+#define SERVER_CHANNELS (16)
+#define SERVER_MAX_MESSAGE (8192)
+typedef bits server_service;
+#define SERVER_SERVICE_RFSV32 ((server_service) 0)
+#define SERVER_SERVICE_NCP ((server_service) 1)
+#define SERVER_SERVICE_LINK ((server_service) 2)
+
+// Reply to a LINK server request
+#define SERVER_LINK_RESPONSE (0x01)
+
+// Open file and directory handles
+#define SERVER_HANDLES (64)
+#define SERVER_HANDLE_BASE (0x100)
+
+// Number of directory entries returned by each read
+#define SERVER_DIR_BATCH (16)
+#define SERVER_DIR_ENTRY_MAX (40 + EPOC32_MAX_LEAF_NAME)
+
+// Size of each simulated drive
+#define SERVER_DRIVE_SIZE (16 * 1024 * 1024)
+
+// The device clock at the start of each run in micro-seconds since 1 AD
+#define SERVER_CLOCK_START ((397621440000ULL + 0x57409150e00ULL) * 10000ULL)
+
+// Maximum length of a script line
+#define SERVER_SCRIPT_LINE (256)
+
+// Receiver states
+typedef enum
+{
+    SERVER_RX_SYN,
+    SERVER_RX_DLE,
+    SERVER_RX_STX,
+    SERVER_RX_DATA,
+    SERVER_RX_STUFF,
+    SERVER_RX_CRC_HIGH,
+    SERVER_RX_CRC_LOW
+} server_rx_states;
+
+// Link states
+typedef enum
+{
+    SERVER_LINK_IDLE,
+    SERVER_LINK_DATA
+} server_link_states;
+
+// A message being parsed or built
+typedef struct
+{
+    byte *data;
+    bits size;
+    bits max;
+    bits offset;
+} server_message;
+
+// A transmitted data frame awaiting acknowledgement
+typedef struct
+{
+    bits seq;
+    bool sent;
+    bits size;
+    byte data[SERVER_FRAME_MAX];
+} server_window_entry;
+
+// A pending control frame
+typedef struct
+{
+    bits size;
+    byte data[SERVER_CTRL_MAX];
+} server_ctrl;
+
+// A connected channel
+typedef struct
+{
+    bool used;
+    server_service service;
+    byte client;
+    byte request[SERVER_MAX_MESSAGE];
+    bits request_size;
+    bool request_complete;
+    byte reply[SERVER_MAX_MESSAGE];
+    bits reply_size;
+    bits reply_offset;
+    sim_time reply_time;
+} server_channel;
+
+// A file or directory in the filing system
+typedef struct server_node
+{
+    epoc32_leaf_name name;
+    bool dir;
+    epoc32_file_attributes attributes;
+    bits size;
+    byte *data;
+    bits allocated;
+    epoc32_file_time modified;
+    struct server_node *parent;
+    struct server_node *child;
+    struct server_node *next;
+} server_node;
+
+// A drive
+typedef struct
+{
+    bool present;
+    epoc32_disc_name name;
+    server_node root;
+} server_drive;
+
+// An open file or directory handle
+typedef struct
+{
+    bool used;
+    server_node *node;
+    bits position;
+    epoc32_leaf_name match;
+} server_handle;
+
+// Scripted behaviour
+static bits server_delay;
+static bits server_frame_max;
+static bits server_window_size;
+static bits server_timeout;
+
+// Receiver state
+static server_rx_states server_rx_state;
+static byte server_rx_buffer[2 + SERVER_FRAME_MAX];
+static bits server_rx_size;
+static crc_state server_rx_crc;
+
+// Transmitter state
+static byte server_tx_buffer[SERVER_FRAME_ENCODED];
+static bits server_tx_size;
+static bits server_tx_offset;
+static bool server_tx_data;
+
+// Link state
+static server_link_states server_link_state;
+static sim_time server_req_time;
+static bool server_ack_pending;
+static bits server_seq_rx;
+static bits server_seq_tx;
+
+// Transmit window
+static server_window_entry server_window[SERVER_MAX_WINDOW];
+static bits server_window_head;
+static bits server_window_count;
+static bits server_window_send;
+static sim_time server_retry_time;
+
+// Multiplexor state
+static server_ctrl server_ctrl_queue[SERVER_CTRL_QUEUE];
+static bits server_ctrl_head;
+static bits server_ctrl_count;
+static server_channel server_channels[SERVER_CHANNELS];
+static bits server_channel_next;
+
+// Filing system state
+static server_drive server_drives[EPOC32_DRIVES];
+static server_handle server_handles[SERVER_HANDLES];
+
+// Statistics
+static server_stats server_statistics;
+
+/*
+    Parameters  : msg           - The message to read from.
+                  value         - Variable to receive the value.
+    Returns     : bool          - Was the value read successfully.
+    Description : Read the next byte from a message.
+*/
+static bool server_get_byte(server_message *msg, byte *value)
+{
+    // Check that there is enough data
+    if (msg->size < msg->offset + 1) return FALSE;
+
+    // Read the value
+    *value = msg->data[msg->offset++];
+    return TRUE;
+}
+
+/*
+    Parameters  : msg           - The message to read from.
+                  value         - Variable to receive the value.
+    Returns     : bool          - Was the value read successfully.
+    Description : Read the next 16 bit little-endian value from a message.
+*/
+static bool server_get_word(server_message *msg, bits *value)
+{
+    // Check that there is enough data
+    if (msg->size < msg->offset + 2) return FALSE;
+
+    // Read the value
+    *value = msg->data[msg->offset] | msg->data[msg->offset + 1] << 8;
+    msg->offset += 2;
+    return TRUE;
+}
+
+/*
+    Parameters  : msg           - The message to read from.
+                  value         - Variable to receive the value.
+    Returns     : bool          - Was the value read successfully.
+    Description : Read the next 32 bit little-endian value from a message.
+*/
+static bool server_get_bits(server_message *msg, bits *value)
+{
+    // Check that there is enough data
+    if (msg->size < msg->offset + 4) return FALSE;
+
+    // Read the value
+    *value = msg->data[msg->offset] | msg->data[msg->offset + 1] << 8
+             | msg->data[msg->offset + 2] << 16
+             | (bits) msg->data[msg->offset + 3] << 24;
+    msg->offset += 4;
+    return TRUE;
+}
+
+/*
+    Parameters  : msg           - The message to read from.
+                  value         - Variable to receive the string.
+                  size          - Size of the buffer.
+    Returns     : bool          - Was the value read successfully.
+    Description : Read the next length prefixed string from a message.
+*/
+static bool server_get_des(server_message *msg, char *value, bits size)
+{
+    bits len;
+
+    // Read and check the length
+    if (!server_get_word(msg, &len) || (size <= len)
+        || (msg->size < msg->offset + len))
+    {
+        return FALSE;
+    }
+
+    // Copy the string
+    memcpy(value, &msg->data[msg->offset], len);
+    value[len] = '\0';
+    msg->offset += len;
+    return TRUE;
+}
+
+/*
+    Parameters  : msg           - The message to read from.
+                  value         - Variable to receive the string.
+                  size          - Size of the buffer.
+    Returns     : bool          - Was the value read successfully.
+    Description : Read the next null terminated string from a message.
+*/
+static bool server_get_string(server_message *msg, char *value, bits size)
+{
+    bits len = 0;
+
+    // Copy characters up to the terminator
+    while ((msg->offset + len < msg->size) && msg->data[msg->offset + len])
+    {
+        len++;
+    }
+    if ((msg->size <= msg->offset + len) || (size <= len)) return FALSE;
+    memcpy(value, &msg->data[msg->offset], len);
+    value[len] = '\0';
+    msg->offset += len + 1;
+    return TRUE;
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  data          - The data to add.
+                  size          - Number of bytes to add.
+    Returns     : void
+    Description : Append data to a message, discarding anything that does
+                  not fit.
+*/
+static void server_put_bytes(server_message *msg, const void *data,
+                             bits size)
+{
+    // Copy as much as fits
+    size = MIN(size, msg->max - msg->size);
+    memcpy(&msg->data[msg->size], data, size);
+    msg->size += size;
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  value         - The value to add.
+    Returns     : void
+    Description : Append a byte to a message.
+*/
+static void server_put_byte(server_message *msg, bits value)
+{
+    byte data = (byte) value;
+
+    // Add the value
+    server_put_bytes(msg, &data, 1);
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  value         - The value to add.
+    Returns     : void
+    Description : Append a 16 bit little-endian value to a message.
+*/
+static void server_put_word(server_message *msg, bits value)
+{
+    byte data[2];
+
+    // Add the value
+    data[0] = (byte) value;
+    data[1] = (byte) (value >> 8);
+    server_put_bytes(msg, data, sizeof(data));
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  value         - The value to add.
+    Returns     : void
+    Description : Append a 32 bit little-endian value to a message.
+*/
+static void server_put_bits(server_message *msg, bits value)
+{
+    byte data[4];
+
+    // Add the value
+    data[0] = (byte) value;
+    data[1] = (byte) (value >> 8);
+    data[2] = (byte) (value >> 16);
+    data[3] = (byte) (value >> 24);
+    server_put_bytes(msg, data, sizeof(data));
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  align         - The required alignment.
+    Returns     : void
+    Description : Pad a message to a multiple of the specified size.
+*/
+static void server_put_align(server_message *msg, bits align)
+{
+    // Add zero bytes until aligned
+    while (msg->size % align) server_put_byte(msg, 0);
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  value         - The string to add.
+    Returns     : void
+    Description : Append a length prefixed string to a message.
+*/
+static void server_put_des(server_message *msg, const char *value)
+{
+    bits len = strlen(value);
+
+    // Add the length followed by the characters
+    server_put_word(msg, len);
+    server_put_bytes(msg, value, len);
+}
+
+/*
+    Parameters  : void
+    Returns     : epoc32_file_time  - The current device time.
+    Description : Read the device clock, which follows the simulated clock.
+*/
+static epoc32_file_time server_time(void)
+{
+    unsigned long long now = SERVER_CLOCK_START + sim_now();
+    epoc32_file_time value;
+
+    // Split the time into two words
+    value.low = (bits) now;
+    value.high = (bits) (now >> 32);
+    return value;
+}
+
+/*
+    Parameters  : pattern       - The wildcarded pattern.
+                  name          - The name to check.
+    Returns     : bool          - Does the name match the pattern.
+    Description : Case insensitive wildcard match supporting * and ?.
+*/
+static bool server_match(const char *pattern, const char *name)
+{
+    // Compare characters until the pattern is exhausted
+    while (*pattern)
+    {
+        if (*pattern == '*')
+        {
+            // Try every possible length of match
+            pattern++;
+            do
+            {
+                if (server_match(pattern, name)) return TRUE;
+            } while (*name++);
+            return FALSE;
+        }
+        if (!*name
+            || ((*pattern != '?')
+                && (tolower((unsigned char) *pattern)
+                    != tolower((unsigned char) *name))))
+        {
+            return FALSE;
+        }
+        pattern++;
+        name++;
+    }
+
+    // Only a match if the name is also exhausted
+    return !*name;
+}
+
+/*
+    Parameters  : dir           - The directory to search.
+                  name          - The leaf name to find.
+    Returns     : server_node * - The matching child, or NULL if none.
+    Description : Find a child of a directory.
+*/
+static server_node *server_find_child(server_node *dir, const char *name)
+{
+    server_node *ptr = dir->child;
+
+    // Search the children
+    while (ptr && strcasecmp(ptr->name, name)) ptr = ptr->next;
+    return ptr;
+}
+
+/*
+    Parameters  : dir           - The directory to add to.
+                  name          - The leaf name of the new object.
+                  is_dir        - Should a directory be created.
+    Returns     : server_node * - The new object, or NULL if failed.
+    Description : Create a new file or directory.
+*/
+static server_node *server_create_node(server_node *dir, const char *name,
+                                       bool is_dir)
+{
+    server_node *node;
+    server_node **ptr = &dir->child;
+
+    // Allocate and initialise the new object
+    if (EPOC32_MAX_LEAF_NAME < strlen(name)) return NULL;
+    node = (server_node *) calloc(1, sizeof(server_node));
+    if (!node) return NULL;
+    strcpy(node->name, name);
+    node->dir = is_dir;
+    node->attributes = is_dir ? EPOC32_FILE_DIRECTORY : EPOC32_FILE_ARCHIVE;
+    node->modified = server_time();
+    node->parent = dir;
+
+    // Add to the end of the directory
+    while (*ptr) ptr = &(*ptr)->next;
+    *ptr = node;
+    return node;
+}
+
+/*
+    Parameters  : node          - The object to unlink.
+    Returns     : void
+    Description : Remove an object from its parent directory.
+*/
+static void server_unlink_node(server_node *node)
+{
+    server_node **ptr = &node->parent->child;
+
+    // Find and remove the object
+    while (*ptr && (*ptr != node)) ptr = &(*ptr)->next;
+    if (*ptr) *ptr = node->next;
+    node->next = NULL;
+}
+
+/*
+    Parameters  : node          - The object to delete.
+    Returns     : void
+    Description : Free an object and everything below it.
+*/
+static void server_free_node(server_node *node)
+{
+    // Free any children first
+    while (node->child)
+    {
+        server_node *child = node->child;
+
+        node->child = child->next;
+        server_free_node(child);
+    }
+
+    // Free the object itself
+    free(node->data);
+    free(node);
+}
+
+/*
+    Parameters  : node          - The object to check.
+    Returns     : bool          - Is the object or anything below it open.
+    Description : Check whether an object is in use by an open handle.
+*/
+static bool server_node_open(const server_node *node)
+{
+    bits i;
+
+    // Check every open handle
+    for (i = 0; i < SERVER_HANDLES; i++)
+    {
+        const server_node *ptr = server_handles[i].used
+                                 ? server_handles[i].node : NULL;
+
+        while (ptr && (ptr != node)) ptr = ptr->parent;
+        if (ptr) return TRUE;
+    }
+
+    // Not in use
+    return FALSE;
+}
+
+/*
+    Parameters  : path          - The EPOC style path, e.g. "C:\Dir\File".
+                  dir           - Variable to receive the parent directory.
+                  leaf          - Variable to receive the leaf name, which is
+                                  empty if the path ends with a backslash.
+                  node          - Variable to receive the object, or NULL if
+                                  it does not exist.
+    Returns     : status_code   - The status of the lookup.
+    Description : Resolve a path to an object in the filing system.
+*/
+static status_code server_lookup(const char *path, server_node **dir,
+                                 char *leaf, server_node **node)
+{
+    server_drive *drive;
+    const char *ptr;
+
+    // Check the drive specifier
+    *node = NULL;
+    if (!isalpha((unsigned char) path[0]) || (path[1] != ':')
+        || (path[2] != '\\'))
+    {
+        return STATUS_ERA_BAD_NAME;
+    }
+    drive = &server_drives[toupper((unsigned char) path[0]) - 'A'];
+    if (!drive->present) return STATUS_ERA_NOT_READY;
+    *dir = &drive->root;
+    ptr = path + 3;
+
+    // Follow each directory in the path
+    while (strchr(ptr, '\\'))
+    {
+        const char *end = strchr(ptr, '\\');
+        epoc32_leaf_name name;
+        server_node *child;
+
+        if (EPOC32_MAX_LEAF_NAME < end - ptr) return STATUS_ERA_BAD_NAME;
+        memcpy(name, ptr, end - ptr);
+        name[end - ptr] = '\0';
+        child = server_find_child(*dir, name);
+        if (!child || !child->dir) return STATUS_ERA_PATH_NOT_FOUND;
+        *dir = child;
+        ptr = end + 1;
+    }
+
+    // Find the leaf object
+    if (EPOC32_MAX_LEAF_NAME < strlen(ptr)) return STATUS_ERA_BAD_NAME;
+    strcpy(leaf, ptr);
+    *node = *leaf ? server_find_child(*dir, leaf) : *dir;
+    return *node ? STATUS_ERA_NONE : STATUS_ERA_NOT_FOUND;
+}
+
+/*
+    Parameters  : path          - The EPOC style path of the directory.
+                  node          - Variable to receive the directory.
+    Returns     : status_code   - The status of the operation.
+    Description : Create a directory and any missing parents.
+*/
+static status_code server_mkdir_all(const char *path, server_node **node)
+{
+    server_drive *drive;
+    server_node *dir;
+    const char *ptr;
+    bool created = FALSE;
+
+    // Check the drive specifier
+    if (!isalpha((unsigned char) path[0]) || (path[1] != ':')
+        || (path[2] != '\\'))
+    {
+        return STATUS_ERA_BAD_NAME;
+    }
+    drive = &server_drives[toupper((unsigned char) path[0]) - 'A'];
+    if (!drive->present) return STATUS_ERA_NOT_READY;
+    dir = &drive->root;
+    ptr = path + 3;
+
+    // Create each directory in turn
+    while (*ptr)
+    {
+        const char *end = strchr(ptr, '\\');
+        epoc32_leaf_name name;
+        server_node *child;
+        bits len = end ? (bits) (end - ptr) : strlen(ptr);
+
+        if (EPOC32_MAX_LEAF_NAME < len) return STATUS_ERA_BAD_NAME;
+        memcpy(name, ptr, len);
+        name[len] = '\0';
+        if (*name)
+        {
+            child = server_find_child(dir, name);
+            if (child && !child->dir) return STATUS_ERA_ALREADY_EXISTS;
+            if (!child)
+            {
+                child = server_create_node(dir, name, TRUE);
+                if (!child) return STATUS_ERA_NO_MEMORY;
+                created = TRUE;
+            }
+            else created = FALSE;
+            dir = child;
+        }
+        ptr += len;
+        if (*ptr) ptr++;
+    }
+
+    // Return the directory
+    if (node) *node = dir;
+    return created ? STATUS_ERA_NONE : STATUS_ERA_ALREADY_EXISTS;
+}
+
+/*
+    Parameters  : node          - The file to resize.
+                  size          - The required size.
+    Returns     : status_code   - The status of the operation.
+    Description : Change the size of a file, storing its contents explicitly.
+*/
+static status_code server_resize(server_node *node, bits size)
+{
+    // Store generated contents before they are modified
+    if (!node->data)
+    {
+        bits i;
+
+        node->allocated = MAX(size, node->size);
+        node->data = (byte *) malloc(MAX(node->allocated, 1));
+        if (!node->data) return STATUS_ERA_NO_MEMORY;
+        for (i = 0; i < node->size; i++) node->data[i] = i & 0xff;
+    }
+
+    // Extend the buffer if required
+    if (node->allocated < size)
+    {
+        bits allocated = MAX(size, node->allocated * 2);
+        byte *data = (byte *) realloc(node->data, allocated);
+
+        if (!data) return STATUS_ERA_NO_MEMORY;
+        node->data = data;
+        node->allocated = allocated;
+    }
+
+    // Zero any extension
+    if (node->size < size)
+    {
+        memset(node->data + node->size, 0, size - node->size);
+    }
+    node->size = size;
+    node->modified = server_time();
+    return STATUS_ERA_NONE;
+}
+
+/*
+    Parameters  : node          - The file to read.
+                  offset        - Offset of the first byte.
+                  size          - Number of bytes to read.
+                  msg           - The message to add the data to.
+    Returns     : void
+    Description : Read data from a file. Files created by the script contain
+                  the same pattern written by the benchmark.
+*/
+static void server_read(const server_node *node, bits offset, bits size,
+                        server_message *msg)
+{
+    // Copy stored contents or generate the pattern
+    if (node->data) server_put_bytes(msg, node->data + offset, size);
+    else
+    {
+        bits i;
+
+        for (i = 0; i < size; i++) server_put_byte(msg, (offset + i) & 0xff);
+    }
+}
+
+/*
+    Parameters  : msg           - The message to add to.
+                  node          - The object to describe.
+    Returns     : void
+    Description : Append a TEntry description of an object, aligned to four
+                  bytes from the start of the reply.
+*/
+static void server_put_entry(server_message *msg, const server_node *node)
+{
+    // Add the fixed fields
+    server_put_align(msg, 4);
+    server_put_bits(msg, 0);
+    server_put_bits(msg, node->attributes);
+    server_put_bits(msg, node->dir ? 0 : node->size);
+    server_put_bits(msg, node->modified.low);
+    server_put_bits(msg, node->modified.high);
+    server_put_bits(msg, 0);
+    server_put_bits(msg, 0);
+    server_put_bits(msg, 0);
+
+    // Add the name
+    server_put_bits(msg, strlen(node->name));
+    server_put_bytes(msg, node->name, strlen(node->name));
+}
+
+/*
+    Parameters  : handle        - The handle value.
+    Returns     : server_handle *   - The handle details, or NULL if invalid.
+    Description : Convert a handle value to its details.
+*/
+static server_handle *server_find_handle(bits handle)
+{
+    bits index = handle - SERVER_HANDLE_BASE;
+
+    // Check that the handle is valid
+    if ((SERVER_HANDLES <= index) || !server_handles[index].used) return NULL;
+    return &server_handles[index];
+}
+
+/*
+    Parameters  : node          - The object to open.
+                  handle        - Variable to receive the handle value.
+    Returns     : status_code   - The status of the operation.
+    Description : Allocate a new handle.
+*/
+static status_code server_open_handle(server_node *node, bits *handle)
+{
+    bits i;
+
+    // Find a free handle
+    for (i = 0; i < SERVER_HANDLES; i++)
+    {
+        if (!server_handles[i].used)
+        {
+            memset(&server_handles[i], 0, sizeof(server_handles[i]));
+            server_handles[i].used = TRUE;
+            server_handles[i].node = node;
+            *handle = SERVER_HANDLE_BASE + i;
+            return STATUS_ERA_NONE;
+        }
+    }
+
+    // No handles available
+    return STATUS_ERA_IN_USE;
+}
+
+/*
+    Parameters  : op            - The operation code.
+                  req           - The request parameters.
+                  reply         - The message to add any reply data to.
+    Returns     : status_code   - The status of the operation.
+    Description : Perform a remote file server operation.
+*/
+static status_code server_rfsv32_op(bits op, server_message *req,
+                                    server_message *reply)
+{
+    status_code status = STATUS_ERA_NONE;
+    epoc32_leaf_name leaf;
+    char path[SERVER_SCRIPT_LINE];
+    char dest[SERVER_SCRIPT_LINE];
+    server_handle *handle;
+    server_node *dir;
+    server_node *node;
+    bits value;
+    bits value2;
+
+    // Action depends on the operation
+    switch (op)
+    {
+        case RFSV32_REQ_CLOSE_HANDLE:
+            // Close a file or directory handle
+            if (!server_get_bits(req, &value)) status = STATUS_ERA_ARGUMENT;
+            else if (!(handle = server_find_handle(value)))
+            {
+                status = STATUS_ERA_BAD_HANDLE;
+            }
+            else handle->used = FALSE;
+            break;
+
+        case RFSV32_REQ_OPEN_DIR:
+            // Open a directory for reading
+            if (!server_get_bits(req, &value)
+                || !server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (status == STATUS_ERA_NOT_FOUND) status = STATUS_ERA_NONE;
+                if (!status) status = server_open_handle(dir, &value);
+                if (!status)
+                {
+                    strcpy(server_find_handle(value)->match, leaf);
+                    server_put_bits(reply, value);
+                }
+            }
+            break;
+
+        case RFSV32_REQ_READ_DIR:
+            // Read the next batch of directory entries
+            if (!server_get_bits(req, &value)) status = STATUS_ERA_ARGUMENT;
+            else if (!(handle = server_find_handle(value))
+                     || !handle->node->dir)
+            {
+                status = STATUS_ERA_BAD_HANDLE;
+            }
+            else
+            {
+                bits index = 0;
+                bits count = 0;
+
+                node = handle->node->child;
+                while (node && (count < SERVER_DIR_BATCH)
+                       && (reply->size + SERVER_DIR_ENTRY_MAX <= reply->max))
+                {
+                    if ((handle->position <= index)
+                        && server_match(handle->match, node->name))
+                    {
+                        server_put_entry(reply, node);
+                        handle->position = index + 1;
+                        count++;
+                    }
+                    index++;
+                    node = node->next;
+                }
+                if (!count) status = STATUS_ERA_EOF;
+            }
+            break;
+
+        case RFSV32_REQ_GET_DRIVE_LIST:
+            // List the drives present
+            for (value = 0; value < EPOC32_DRIVES; value++)
+            {
+                server_put_byte(reply, server_drives[value].present
+                                       ? EPOC32_MEDIA_RAM
+                                       : EPOC32_MEDIA_NOT_PRESENT);
+            }
+            break;
+
+        case RFSV32_REQ_VOLUME:
+            // Describe a drive
+            if (!server_get_bits(req, &value) || (EPOC32_DRIVES <= value))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else if (!server_drives[value].present)
+            {
+                status = STATUS_ERA_NOT_READY;
+            }
+            else
+            {
+                server_put_bits(reply, EPOC32_MEDIA_RAM);
+                server_put_bits(reply, EPOC32_BATTERY_GOOD);
+                server_put_bits(reply, EPOC32_DRIVE_LOCAL
+                                       | EPOC32_DRIVE_INTERNAL);
+                server_put_bits(reply, EPOC32_MEDIA_VARIABLE_SIZE);
+                server_put_bits(reply, 0x50534900 + value);
+                server_put_bits(reply, SERVER_DRIVE_SIZE);
+                server_put_bits(reply, 0);
+                server_put_bits(reply, SERVER_DRIVE_SIZE / 2);
+                server_put_bits(reply, 0);
+                server_put_bits(reply, strlen(server_drives[value].name));
+                server_put_bytes(reply, server_drives[value].name,
+                                 strlen(server_drives[value].name));
+            }
+            break;
+
+        case RFSV32_REQ_SET_VOLUME_LABEL:
+            // Rename a drive
+            if (!server_get_bits(req, &value) || (EPOC32_DRIVES <= value)
+                || !server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else if (!server_drives[value].present)
+            {
+                status = STATUS_ERA_NOT_READY;
+            }
+            else if (EPOC32_MAX_DISC_NAME < strlen(path))
+            {
+                status = STATUS_ERA_BAD_NAME;
+            }
+            else strcpy(server_drives[value].name, path);
+            break;
+
+        case RFSV32_REQ_OPEN_FILE:
+        case RFSV32_REQ_CREATE_FILE:
+        case RFSV32_REQ_REPLACE_FILE:
+            // Open, create or replace a file
+            if (!server_get_bits(req, &value)
+                || !server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status && node->dir) status = STATUS_ERA_ACCESS_DENIED;
+                else if (!status && (op == RFSV32_REQ_CREATE_FILE))
+                {
+                    status = STATUS_ERA_ALREADY_EXISTS;
+                }
+                else if ((status == STATUS_ERA_NOT_FOUND)
+                         && (op != RFSV32_REQ_OPEN_FILE))
+                {
+                    node = server_create_node(dir, leaf, FALSE);
+                    status = node ? STATUS_ERA_NONE : STATUS_ERA_NO_MEMORY;
+                }
+                else if (!status && (op == RFSV32_REQ_REPLACE_FILE))
+                {
+                    if (server_node_open(node)) status = STATUS_ERA_IN_USE;
+                    else status = server_resize(node, 0);
+                }
+                if (!status) status = server_open_handle(node, &value);
+                if (!status) server_put_bits(reply, value);
+            }
+            break;
+
+        case RFSV32_REQ_READ_FILE:
+            // Read from a file
+            if (!server_get_bits(req, &value) || !server_get_bits(req, &value2))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else if (!(handle = server_find_handle(value))
+                     || handle->node->dir)
+            {
+                status = STATUS_ERA_BAD_HANDLE;
+            }
+            else
+            {
+                node = handle->node;
+                value2 = MIN(value2, RFSV32_MAX_READ);
+                if (node->size < handle->position) value2 = 0;
+                else value2 = MIN(value2, node->size - handle->position);
+                server_read(node, handle->position, value2, reply);
+                handle->position += value2;
+            }
+            break;
+
+        case RFSV32_REQ_WRITE_FILE:
+            // Write to a file
+            if (!server_get_bits(req, &value)) status = STATUS_ERA_ARGUMENT;
+            else if (!(handle = server_find_handle(value))
+                     || handle->node->dir)
+            {
+                status = STATUS_ERA_BAD_HANDLE;
+            }
+            else
+            {
+                node = handle->node;
+                value2 = req->size - req->offset;
+                if (node->size < handle->position + value2)
+                {
+                    status = server_resize(node, handle->position + value2);
+                }
+                else status = server_resize(node, node->size);
+                if (!status)
+                {
+                    memcpy(node->data + handle->position,
+                           &req->data[req->offset], value2);
+                    handle->position += value2;
+                }
+            }
+            break;
+
+        case RFSV32_REQ_SEEK_FILE:
+            // Change the file pointer
+            {
+                bits sense;
+
+                if (!server_get_bits(req, &value2)
+                    || !server_get_bits(req, &value)
+                    || !server_get_bits(req, &sense))
+                {
+                    status = STATUS_ERA_ARGUMENT;
+                }
+                else if (!(handle = server_find_handle(value))
+                         || handle->node->dir)
+                {
+                    status = STATUS_ERA_BAD_HANDLE;
+                }
+                else
+                {
+                    if (sense == EPOC32_SENSE_CURRENT)
+                    {
+                        value2 += handle->position;
+                    }
+                    else if (sense == EPOC32_SENSE_END)
+                    {
+                        value2 += handle->node->size;
+                    }
+                    else if (sense == EPOC32_SENSE_SENSE)
+                    {
+                        value2 = handle->position;
+                    }
+                    handle->position = value2;
+                    server_put_bits(reply, value2);
+                }
+            }
+            break;
+
+        case RFSV32_REQ_DELETE:
+            // Delete a file
+            if (!server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status && node->dir) status = STATUS_ERA_ACCESS_DENIED;
+                else if (!status && server_node_open(node))
+                {
+                    status = STATUS_ERA_IN_USE;
+                }
+                else if (!status)
+                {
+                    server_unlink_node(node);
+                    server_free_node(node);
+                }
+            }
+            break;
+
+        case RFSV32_REQ_REMOTE_ENTRY:
+            // Describe an object
+            if (!server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status && !node->parent) status = STATUS_ERA_BAD_NAME;
+                if (!status) server_put_entry(reply, node);
+            }
+            break;
+
+        case RFSV32_REQ_FLUSH:
+            // Flush a file
+            if (!server_get_bits(req, &value)) status = STATUS_ERA_ARGUMENT;
+            else if (!server_find_handle(value))
+            {
+                status = STATUS_ERA_BAD_HANDLE;
+            }
+            break;
+
+        case RFSV32_REQ_SET_SIZE:
+            // Change the size of a file
+            if (!server_get_bits(req, &value) || !server_get_bits(req, &value2))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else if (!(handle = server_find_handle(value))
+                     || handle->node->dir)
+            {
+                status = STATUS_ERA_BAD_HANDLE;
+            }
+            else status = server_resize(handle->node, value2);
+            break;
+
+        case RFSV32_REQ_RENAME:
+            // Rename an object
+            if (!server_get_des(req, path, sizeof(path))
+                || !server_get_des(req, dest, sizeof(dest)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                server_node *dest_dir;
+                server_node *dest_node;
+                epoc32_leaf_name dest_leaf;
+
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status && !node->parent) status = STATUS_ERA_BAD_NAME;
+                if (!status)
+                {
+                    status = server_lookup(dest, &dest_dir, dest_leaf,
+                                           &dest_node);
+                    if (!status) status = STATUS_ERA_ALREADY_EXISTS;
+                    else if (status == STATUS_ERA_NOT_FOUND)
+                    {
+                        status = STATUS_ERA_NONE;
+                    }
+                }
+                if (!status && server_node_open(node))
+                {
+                    status = STATUS_ERA_IN_USE;
+                }
+                if (!status)
+                {
+                    server_unlink_node(node);
+                    strcpy(node->name, dest_leaf);
+                    node->parent = dest_dir;
+                    node->next = dest_dir->child;
+                    dest_dir->child = node;
+                }
+            }
+            break;
+
+        case RFSV32_REQ_MK_DIR_ALL:
+            // Create a directory and its parents
+            if (!server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else status = server_mkdir_all(path, NULL);
+            break;
+
+        case RFSV32_REQ_RM_DIR:
+            // Delete an empty directory
+            if (!server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status && !node->dir) status = STATUS_ERA_PATH_NOT_FOUND;
+                else if (!status && (!node->parent || node->child))
+                {
+                    status = STATUS_ERA_IN_USE;
+                }
+                else if (!status && server_node_open(node))
+                {
+                    status = STATUS_ERA_IN_USE;
+                }
+                else if (!status)
+                {
+                    server_unlink_node(node);
+                    server_free_node(node);
+                }
+            }
+            break;
+
+        case RFSV32_REQ_SET_ATT:
+            // Change the attributes of an object
+            if (!server_get_bits(req, &value) || !server_get_bits(req, &value2)
+                || !server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status)
+                {
+                    node->attributes = ((node->attributes | value) & ~value2
+                                        & ~EPOC32_FILE_DIRECTORY)
+                                       | (node->dir
+                                          ? EPOC32_FILE_DIRECTORY : 0);
+                }
+            }
+            break;
+
+        case RFSV32_REQ_ATT:
+            // Read the attributes of an object
+            if (!server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status) server_put_bits(reply, node->attributes);
+            }
+            break;
+
+        case RFSV32_REQ_SET_MODIFIED:
+            // Change the modification time of an object
+            if (!server_get_bits(req, &value) || !server_get_bits(req, &value2)
+                || !server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status)
+                {
+                    node->modified.low = value;
+                    node->modified.high = value2;
+                }
+            }
+            break;
+
+        case RFSV32_REQ_MODIFIED:
+            // Read the modification time of an object
+            if (!server_get_des(req, path, sizeof(path)))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else
+            {
+                status = server_lookup(path, &dir, leaf, &node);
+                if (!status)
+                {
+                    server_put_bits(reply, node->modified.low);
+                    server_put_bits(reply, node->modified.high);
+                }
+            }
+            break;
+
+        case RFSV32_REQ_DRIVE_NAME:
+            // Read the name of a drive
+            if (!server_get_bits(req, &value) || (EPOC32_DRIVES <= value))
+            {
+                status = STATUS_ERA_ARGUMENT;
+            }
+            else if (!server_drives[value].present)
+            {
+                status = STATUS_ERA_NOT_READY;
+            }
+            else server_put_des(reply, server_drives[value].name);
+            break;
+
+        default:
+            // Not a supported operation
+            status = STATUS_ERA_NOT_SUPPORTED;
+            server_statistics.unsupported++;
+            break;
+    }
+
+    // Return the status
+    return status;
+}
+
+/*
+    Parameters  : chan          - The channel that received the request.
+    Returns     : void
+    Description : Handle a remote file server request.
+*/
+static void server_rfsv32(server_channel *chan)
+{
+    server_message req = {chan->request, chan->request_size, 0, 0};
+    server_message reply = {chan->reply, 0, sizeof(chan->reply), 0};
+    bits op;
+    bits id;
+
+    // Decode the header
+    if (server_get_word(&req, &op) && server_get_word(&req, &id))
+    {
+        status_code status;
+
+        // Build the reply header
+        server_put_word(&reply, RFSV32_RESPONSE);
+        server_put_word(&reply, id);
+        server_put_bits(&reply, 0);
+
+        // Perform the operation, discarding any data if it failed
+        status = server_rfsv32_op(op, &req, &reply);
+        if (status)
+        {
+            reply.size = 4;
+            server_put_bits(&reply, (bits) status);
+        }
+        chan->reply_size = reply.size;
+    }
+}
+
+/*
+    Parameters  : chan          - The channel that received the request.
+    Returns     : void
+    Description : Handle a remote command server request.
+*/
+static void server_ncp(server_channel *chan)
+{
+    server_message req = {chan->request, chan->request_size, 0, 0};
+    server_message reply = {chan->reply, 0, sizeof(chan->reply), 0};
+    byte op;
+
+    // Decode the operation
+    if (!server_get_byte(&req, &op)) return;
+    server_put_byte(&reply, STATUS_SIBO_NONE);
+
+    // Action depends on the operation
+    switch (op)
+    {
+        case NCP_GET_MACHINE_INFO:
+            // Describe the machine
+            {
+                epoc32_machine_info info;
+
+                memset(&info, 0, sizeof(info));
+                info.machine_type = psifs_MACHINE_TYPE_S5;
+                info.rom_version.major = 1;
+                info.rom_version.minor = 0;
+                info.rom_version.build = 100;
+                strcpy(info.machine_name, "Simulated");
+                info.display_size.width = 640;
+                info.display_size.height = 240;
+                info.time.home_time = server_time();
+                info.supply.main_status = EPOC32_BATTERY_GOOD;
+                info.supply.main_mv = 3000;
+                info.supply.main_mv_max = 3000;
+                info.supply.backup_status = EPOC32_BATTERY_GOOD;
+                info.supply.backup_mv = 3000;
+                info.supply.backup_mv_max = 3000;
+                info.language = psifs_LANGUAGE_UK_ENGLISH;
+                server_put_bytes(&reply, &info, sizeof(info));
+            }
+            break;
+
+        case NCP_GET_MACHINE_TYPE:
+            // Read the machine type
+            server_put_word(&reply, psifs_MACHINE_TYPE_S5);
+            break;
+
+        case NCP_GET_OWNER_INFO:
+            // Read the owner information
+            server_put_bytes(&reply, "PsiFS", sizeof("PsiFS"));
+            server_put_bytes(&reply, "Host harness", sizeof("Host harness"));
+            break;
+
+        case NCP_GET_UNIQUE_ID:
+            // Read the unique identifier of a drive
+            server_put_bits(&reply, 0x50534946);
+            break;
+
+        case NCP_SET_TIME:
+        case NCP_QUERY_DRIVE:
+            // No action required and no applications running
+            break;
+
+        case NCP_PROG_RUNNING:
+        case NCP_GET_CMD_LINE:
+            // No applications are running
+            reply.size = 0;
+            server_put_byte(&reply, (byte) STATUS_SIBO_FILE_NXIST);
+            break;
+
+        default:
+            // Not a supported operation
+            reply.size = 0;
+            server_put_byte(&reply, (byte) STATUS_SIBO_GEN_NSUP);
+            server_statistics.unsupported++;
+            break;
+    }
+
+    // Queue the reply
+    chan->reply_size = reply.size;
+}
+
+/*
+    Parameters  : chan          - The channel that received the request.
+    Returns     : void
+    Description : Handle a LINK server request. Every server is already
+                  running, so the host is told to use the standard name.
+*/
+static void server_link(server_channel *chan)
+{
+    server_message req = {chan->request, chan->request_size, 0, 0};
+    server_message reply = {chan->reply, 0, sizeof(chan->reply), 0};
+    byte op;
+    bits id;
+
+    // Decode the request and build the reply
+    if (server_get_byte(&req, &op) && server_get_word(&req, &id))
+    {
+        server_put_byte(&reply, SERVER_LINK_RESPONSE);
+        server_put_word(&reply, id);
+        server_put_word(&reply, STATUS_SIBO_NONE);
+        server_put_word(&reply, 0);
+        server_put_byte(&reply, 0);
+        chan->reply_size = reply.size;
+    }
+}
+
+/*
+    Parameters  : src           - The source channel.
+                  type          - The control frame type.
+                  data          - The frame data.
+                  size          - Size of the frame data.
+    Returns     : void
+    Description : Queue a multiplexor control frame.
+*/
+static void server_mux_ctrl(byte src, byte type, const byte *data, bits size)
+{
+    // Discard the frame if the queue is full
+    if (server_ctrl_count < SERVER_CTRL_QUEUE)
+    {
+        server_ctrl *ctrl = &server_ctrl_queue[(server_ctrl_head
+                                                + server_ctrl_count++)
+                                               % SERVER_CTRL_QUEUE];
+
+        // Build the frame
+        size = MIN(size, SERVER_CTRL_MAX - SERVER_MUX_DATA);
+        ctrl->data[SERVER_MUX_DEST] = 0;
+        ctrl->data[SERVER_MUX_SRC] = src;
+        ctrl->data[SERVER_MUX_TYPE] = type;
+        memcpy(&ctrl->data[SERVER_MUX_DATA], data, size);
+        ctrl->size = SERVER_MUX_DATA + size;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Reset the multiplexor, closing all channels.
+*/
+static void server_mux_reset(void)
+{
+    bits i;
+
+    // Discard pending control frames and close all channels
+    server_ctrl_head = 0;
+    server_ctrl_count = 0;
+    for (i = 0; i < SERVER_CHANNELS; i++) server_channels[i].used = FALSE;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Start the multiplexor after a link has been established.
+*/
+static void server_mux_start(void)
+{
+    byte info[5] = {SERVER_NCP_VERSION, 0, 0, 0, 0};
+
+    // Reset the state and announce the NCP version
+    server_mux_reset();
+    server_mux_ctrl(0, SERVER_MUX_NCP_INFO, info, sizeof(info));
+}
+
+/*
+    Parameters  : src           - The host channel.
+                  name          - The name of the server.
+    Returns     : void
+    Description : Handle a request to connect to a server.
+*/
+static void server_mux_connect(byte src, const char *name)
+{
+    byte reply[2] = {src, (byte) STATUS_SIBO_FILE_NXIST};
+    byte chan = 0;
+    server_service service = SERVER_SERVICE_RFSV32;
+    bits i;
+
+    // Identify the service
+    if (!strncmp(name, "SYS$RFSV", 8)) chan = 1;
+    else if (!strncmp(name, "SYS$RPCS", 8))
+    {
+        service = SERVER_SERVICE_NCP;
+        chan = 1;
+    }
+    else if (!strncmp(name, "LINK", 4))
+    {
+        service = SERVER_SERVICE_LINK;
+        chan = 1;
+    }
+
+    // Allocate a channel
+    for (i = 0; chan && (i < SERVER_CHANNELS); i++)
+    {
+        if (!server_channels[i].used)
+        {
+            server_channel *ptr = &server_channels[i];
+
+            memset(ptr, 0, sizeof(*ptr));
+            ptr->used = TRUE;
+            ptr->service = service;
+            ptr->client = src;
+            reply[1] = STATUS_SIBO_NONE;
+            break;
+        }
+    }
+    chan = reply[1] ? 0 : i + 1;
+
+    // Send the response
+    server_mux_ctrl(chan, SERVER_MUX_CONNECT_RESPONSE, reply, sizeof(reply));
+}
+
+/*
+    Parameters  : data          - The frame data.
+                  size          - Size of the frame.
+    Returns     : void
+    Description : Handle a multiplexor frame received from the host.
+*/
+static void server_mux_rx(const byte *data, bits size)
+{
+    byte dest;
+    byte src;
+    byte type;
+
+    // Decode the header
+    if (size < SERVER_MUX_DATA) return;
+    dest = data[SERVER_MUX_DEST];
+    src = data[SERVER_MUX_SRC];
+    type = data[SERVER_MUX_TYPE];
+    data += SERVER_MUX_DATA;
+    size -= SERVER_MUX_DATA;
+
+    // Action depends on the destination
+    if (!dest)
+    {
+        // Control frame
+        if (type == SERVER_MUX_CONNECT_TO_SERVER)
+        {
+            char name[SERVER_CTRL_MAX];
+            server_message msg = {(byte *) data, size, 0, 0};
+
+            if (server_get_string(&msg, name, sizeof(name)))
+            {
+                server_mux_connect(src, name);
+            }
+        }
+        else if ((type == SERVER_MUX_CHANNEL_DISCONNECT) && size
+                 && data[0] && (data[0] <= SERVER_CHANNELS))
+        {
+            server_channels[data[0] - 1].used = FALSE;
+        }
+        else if (type == SERVER_MUX_NCP_END) server_mux_reset();
+    }
+    else if ((dest <= SERVER_CHANNELS) && server_channels[dest - 1].used
+             && ((type == SERVER_MUX_WRITECOMPLETE)
+                 || (type == SERVER_MUX_WRITEPARTIAL)))
+    {
+        server_channel *chan = &server_channels[dest - 1];
+
+        // Data frame, so add to any partial request
+        if (chan->request_complete) chan->request_size = 0;
+        if (chan->request_size + size <= sizeof(chan->request))
+        {
+            memcpy(&chan->request[chan->request_size], data, size);
+            chan->request_size += size;
+        }
+        chan->request_complete = type == SERVER_MUX_WRITECOMPLETE;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Process any complete requests that can be answered.
+*/
+static void server_mux_process(void)
+{
+    bits i;
+
+    // Check every channel
+    for (i = 0; i < SERVER_CHANNELS; i++)
+    {
+        server_channel *chan = &server_channels[i];
+
+        if (chan->used && chan->request_complete && !chan->reply_size)
+        {
+            // Generate the reply
+            if (chan->service == SERVER_SERVICE_RFSV32) server_rfsv32(chan);
+            else if (chan->service == SERVER_SERVICE_NCP) server_ncp(chan);
+            else server_link(chan);
+            chan->request_complete = FALSE;
+            chan->request_size = 0;
+            chan->reply_offset = 0;
+            chan->reply_time = sim_now() + server_delay * SIM_TIME_CS;
+            server_statistics.ops++;
+        }
+    }
+}
+
+/*
+    Parameters  : data          - Buffer to receive the frame.
+                  size          - Variable to receive the frame size.
+    Returns     : bool          - Was a frame produced.
+    Description : Produce the next multiplexor frame to send to the host.
+                  Control frames take priority, and then channels with
+                  replies ready are served in turn.
+*/
+static bool server_mux_tx(byte *data, bits *size)
+{
+    bits i;
+
+    // Send any control frames first
+    if (server_ctrl_count)
+    {
+        server_ctrl *ctrl = &server_ctrl_queue[server_ctrl_head];
+
+        memcpy(data, ctrl->data, ctrl->size);
+        *size = ctrl->size;
+        server_ctrl_head = (server_ctrl_head + 1) % SERVER_CTRL_QUEUE;
+        server_ctrl_count--;
+        return TRUE;
+    }
+
+    // Find the next channel with a reply ready
+    for (i = 0; i < SERVER_CHANNELS; i++)
+    {
+        bits index = (server_channel_next + i) % SERVER_CHANNELS;
+        server_channel *chan = &server_channels[index];
+
+        if (chan->used && chan->reply_size
+            && (chan->reply_time <= sim_now()))
+        {
+            bits chunk = MIN(server_frame_max - SERVER_MUX_DATA,
+                             chan->reply_size - chan->reply_offset);
+
+            // Build the next fragment of the reply
+            data[SERVER_MUX_DEST] = chan->client;
+            data[SERVER_MUX_SRC] = index + 1;
+            memcpy(&data[SERVER_MUX_DATA], &chan->reply[chan->reply_offset],
+                   chunk);
+            *size = SERVER_MUX_DATA + chunk;
+            chan->reply_offset += chunk;
+            if (chan->reply_offset == chan->reply_size)
+            {
+                data[SERVER_MUX_TYPE] = SERVER_MUX_WRITECOMPLETE;
+                chan->reply_size = 0;
+            }
+            else data[SERVER_MUX_TYPE] = SERVER_MUX_WRITEPARTIAL;
+            server_channel_next = index + 1;
+            return TRUE;
+        }
+    }
+
+    // Nothing to send
+    return FALSE;
+}
+
+/*
+    Parameters  : cont          - The frame type.
+                  seq           - The sequence number.
+                  data          - The frame data.
+                  size          - Size of the frame data.
+    Returns     : void
+    Description : Encode a frame into the transmit buffer.
+*/
+static void server_tx_frame(bits cont, bits seq, const byte *data, bits size)
+{
+    byte header[2];
+    bits header_size = 0;
+    crc_state crc;
+    byte *ptr = server_tx_buffer;
+    bits i;
+
+    // Build the header
+    header[header_size++] = cont << 4 | (seq & 0x07) | (seq < 8 ? 0 : 0x08);
+    if (8 <= seq) header[header_size++] = (seq & 0x7f8) >> 3;
+    crc_reset(&crc);
+    crc_update_block(&crc, header, header_size);
+    crc_update_block(&crc, data, size);
+
+    // Encode the frame with stuffing
+    *ptr++ = SERVER_FRAME_SYN;
+    *ptr++ = SERVER_FRAME_DLE;
+    *ptr++ = SERVER_FRAME_STX;
+    for (i = 0; i < header_size + size; i++)
+    {
+        byte value = i < header_size ? header[i] : data[i - header_size];
+
+        if (value == SERVER_FRAME_DLE)
+        {
+            *ptr++ = SERVER_FRAME_DLE;
+            *ptr++ = SERVER_FRAME_DLE;
+        }
+        else if (value == SERVER_FRAME_ETX)
+        {
+            *ptr++ = SERVER_FRAME_DLE;
+            *ptr++ = SERVER_FRAME_EOT;
+        }
+        else *ptr++ = value;
+    }
+    *ptr++ = SERVER_FRAME_DLE;
+    *ptr++ = SERVER_FRAME_ETX;
+    *ptr++ = crc_msb(&crc);
+    *ptr++ = crc_lsb(&crc);
+
+    // Start sending the frame
+    server_tx_size = ptr - server_tx_buffer;
+    server_tx_offset = 0;
+    server_tx_data = cont == SERVER_CONT_DATA;
+    server_statistics.tx_frames++;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Reset the link and discard any unacknowledged frames.
+*/
+static void server_link_reset(void)
+{
+    // Return to the idle state
+    server_link_state = SERVER_LINK_IDLE;
+    server_req_time = sim_now();
+    server_ack_pending = FALSE;
+    server_seq_rx = 0;
+    server_seq_tx = 0;
+    server_window_head = 0;
+    server_window_count = 0;
+    server_window_send = 0;
+    server_retry_time = SIM_TIME_NEVER;
+    server_mux_reset();
+}
+
+/*
+    Parameters  : seq           - The acknowledged sequence number.
+    Returns     : void
+    Description : Remove acknowledged frames from the transmit window.
+*/
+static void server_link_ack(bits seq)
+{
+    bits i;
+
+    // Find the acknowledged frame
+    for (i = 0; i < server_window_count; i++)
+    {
+        const server_window_entry *entry;
+
+        entry = &server_window[(server_window_head + i) % SERVER_MAX_WINDOW];
+        if (entry->sent && (entry->seq == seq))
+        {
+            // Discard this and all earlier frames
+            server_window_head = (server_window_head + i + 1)
+                                 % SERVER_MAX_WINDOW;
+            server_window_count -= i + 1;
+            server_window_send -= MIN(server_window_send, i + 1);
+            server_retry_time = server_window_send
+                                ? sim_now() + server_timeout * SIM_TIME_CS
+                                : SIM_TIME_NEVER;
+            break;
+        }
+    }
+}
+
+/*
+    Parameters  : cont          - The frame type.
+                  seq           - The sequence number.
+                  data          - The frame data.
+                  size          - Size of the frame data.
+    Returns     : void
+    Description : Handle a frame received from the host.
+*/
+static void server_link_rx(bits cont, bits seq, const byte *data, bits size)
+{
+    // Action depends on the frame type
+    switch (cont)
+    {
+        case SERVER_CONT_ACK:
+            // Acknowledgement of data frames
+            if (server_link_state == SERVER_LINK_DATA) server_link_ack(seq);
+            break;
+
+        case SERVER_CONT_DISC:
+            // Host has disconnected
+            server_link_reset();
+            break;
+
+        case SERVER_CONT_REQ:
+            // Connection request
+            if ((seq == SERVER_SEQ_REQ_CON) && (4 <= size)
+                && ((data[0] | data[1] << 8 | data[2] << 16
+                     | (bits) data[3] << 24) != SERVER_MAGIC))
+            {
+                // Confirmation of the request, unless data has been received
+                if ((server_link_state == SERVER_LINK_IDLE)
+                    || !server_seq_rx)
+                {
+                    server_link_reset();
+                    server_link_state = SERVER_LINK_DATA;
+                    server_ack_pending = TRUE;
+                    server_mux_start();
+                }
+                else server_link_reset();
+            }
+            else if ((seq == SERVER_SEQ_REQ_REQ)
+                     && (server_link_state == SERVER_LINK_DATA)
+                     && server_seq_rx)
+            {
+                // The host has restarted
+                server_link_reset();
+            }
+            break;
+
+        case SERVER_CONT_DATA:
+            // Data frame
+            if (server_link_state == SERVER_LINK_DATA)
+            {
+                if (seq == (server_seq_rx + 1) % SERVER_SEQ_NUM)
+                {
+                    server_seq_rx = seq;
+                    server_mux_rx(data, size);
+                }
+                else server_statistics.rx_out_of_sequence++;
+                server_ack_pending = TRUE;
+            }
+            break;
+
+        default:
+            // Ignore other frame types
+            break;
+    }
+}
+
+/*
+    Parameters  : value         - The received character.
+    Returns     : void
+    Description : Update the frame receiver with a single character.
+*/
+static void server_rx_byte(byte value)
+{
+    // Action depends on the receiver state
+    switch (server_rx_state)
+    {
+        case SERVER_RX_SYN:
+            // Waiting for the start of a frame
+            if (value == SERVER_FRAME_SYN) server_rx_state = SERVER_RX_DLE;
+            break;
+
+        case SERVER_RX_DLE:
+            // Expecting DLE
+            if (value == SERVER_FRAME_DLE) server_rx_state = SERVER_RX_STX;
+            else if (value != SERVER_FRAME_SYN)
+            {
+                server_rx_state = SERVER_RX_SYN;
+                server_statistics.rx_bad_frames++;
+            }
+            break;
+
+        case SERVER_RX_STX:
+            // Expecting STX
+            server_rx_size = 0;
+            if (value == SERVER_FRAME_STX) server_rx_state = SERVER_RX_DATA;
+            else
+            {
+                server_rx_state = value == SERVER_FRAME_SYN
+                                  ? SERVER_RX_DLE : SERVER_RX_SYN;
+                server_statistics.rx_bad_frames++;
+            }
+            break;
+
+        case SERVER_RX_DATA:
+        case SERVER_RX_STUFF:
+            // Header or data, possibly stuffed
+            if ((server_rx_state == SERVER_RX_DATA)
+                && (value == SERVER_FRAME_DLE))
+            {
+                server_rx_state = SERVER_RX_STUFF;
+            }
+            else if ((server_rx_state == SERVER_RX_STUFF)
+                     && (value == SERVER_FRAME_ETX))
+            {
+                crc_reset(&server_rx_crc);
+                crc_update_block(&server_rx_crc, server_rx_buffer,
+                                 server_rx_size);
+                server_rx_state = SERVER_RX_CRC_HIGH;
+            }
+            else if (server_rx_size < sizeof(server_rx_buffer))
+            {
+                if ((server_rx_state == SERVER_RX_STUFF)
+                    && (value == SERVER_FRAME_EOT))
+                {
+                    value = SERVER_FRAME_ETX;
+                }
+                server_rx_buffer[server_rx_size++] = value;
+                server_rx_state = SERVER_RX_DATA;
+            }
+            else
+            {
+                server_rx_state = SERVER_RX_SYN;
+                server_statistics.rx_bad_frames++;
+            }
+            break;
+
+        case SERVER_RX_CRC_HIGH:
+            // Expecting the high byte of the CRC
+            if (value == crc_msb(&server_rx_crc))
+            {
+                server_rx_state = SERVER_RX_CRC_LOW;
+            }
+            else
+            {
+                server_rx_state = SERVER_RX_SYN;
+                server_statistics.rx_bad_frames++;
+            }
+            break;
+
+        case SERVER_RX_CRC_LOW:
+            // Expecting the low byte of the CRC
+            server_rx_state = SERVER_RX_SYN;
+            if ((value == crc_lsb(&server_rx_crc)) && server_rx_size)
+            {
+                byte header = server_rx_buffer[0];
+                bits seq = header & 0x07;
+                bits offset = 1;
+
+                // Decode the header and process the frame
+                if (header & 0x08)
+                {
+                    seq |= server_rx_buffer[offset++] << 3;
+                }
+                if (offset <= server_rx_size)
+                {
+                    server_statistics.rx_frames++;
+                    server_link_rx(header >> 4, seq,
+                                   server_rx_buffer + offset,
+                                   server_rx_size - offset);
+                }
+            }
+            else server_statistics.rx_bad_frames++;
+            break;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Start transmitting the next frame if the transmitter is
+                  idle.
+*/
+static void server_tx_next(void)
+{
+    // No action if a frame is still being sent
+    if (server_tx_offset < server_tx_size) return;
+
+    // Acknowledgements take priority
+    if (server_ack_pending)
+    {
+        server_tx_frame(SERVER_CONT_ACK, server_seq_rx, NULL, 0);
+        server_ack_pending = FALSE;
+    }
+    else if (server_link_state == SERVER_LINK_IDLE)
+    {
+        // Periodically request a connection
+        if (server_req_time <= sim_now())
+        {
+            byte magic[4] = {SERVER_MAGIC & 0xff, (SERVER_MAGIC >> 8) & 0xff,
+                             (SERVER_MAGIC >> 16) & 0xff,
+                             (SERVER_MAGIC >> 24) & 0xff};
+
+            server_tx_frame(SERVER_CONT_REQ, SERVER_SEQ_REQ_REQ, magic,
+                            sizeof(magic));
+            server_req_time = sim_now() + SERVER_TIMEOUT_REQ;
+        }
+    }
+    else
+    {
+        server_window_entry *entry;
+
+        // Go back to the oldest frame if the retry timer has expired
+        if (server_window_count && (server_retry_time <= sim_now()))
+        {
+            server_window_send = 0;
+            server_retry_time = SIM_TIME_NEVER;
+        }
+
+        // Add a new frame to the window if possible
+        if ((server_window_send == server_window_count)
+            && (server_window_count < server_window_size))
+        {
+            entry = &server_window[(server_window_head + server_window_count)
+                                   % SERVER_MAX_WINDOW];
+            if (server_mux_tx(entry->data, &entry->size))
+            {
+                server_seq_tx = (server_seq_tx + 1) % SERVER_SEQ_NUM;
+                entry->seq = server_seq_tx;
+                entry->sent = FALSE;
+                server_window_count++;
+            }
+        }
+
+        // Send the next frame from the window
+        if (server_window_send < server_window_count)
+        {
+            entry = &server_window[(server_window_head + server_window_send)
+                                   % SERVER_MAX_WINDOW];
+            if (entry->sent) server_statistics.tx_retries++;
+            entry->sent = TRUE;
+            server_tx_frame(SERVER_CONT_DATA, entry->seq, entry->data,
+                            entry->size);
+            server_window_send++;
+        }
+    }
+}
+
+/*
+    Parameters  : path          - The EPOC style path of the directory.
+                  dir           - Variable to receive the directory.
+    Returns     : status_code   - The status of the operation.
+    Description : Ensure that a directory described by a script exists.
+*/
+static status_code server_script_dir(const char *path, server_node **dir)
+{
+    status_code status;
+
+    // Create the directory if it does not already exist
+    status = server_mkdir_all(path, dir);
+    return status == STATUS_ERA_ALREADY_EXISTS ? STATUS_ERA_NONE : status;
+}
+
+/*
+    Parameters  : path          - The EPOC style path of a file.
+                  dir           - Variable to receive the parent directory.
+                  leaf          - Variable to receive the leaf name.
+    Returns     : status_code   - The status of the operation.
+    Description : Ensure that the parent directory of a file described by a
+                  script exists.
+*/
+static status_code server_script_parent(const char *path, server_node **dir,
+                                        char *leaf)
+{
+    status_code status = STATUS_ERA_BAD_NAME;
+    const char *ptr = strrchr(path, '\\');
+
+    // Split the path into the directory and leaf name
+    if (ptr && ptr[1] && (strlen(ptr + 1) <= EPOC32_MAX_LEAF_NAME)
+        && (ptr - path < SERVER_SCRIPT_LINE))
+    {
+        char parent[SERVER_SCRIPT_LINE];
+
+        memcpy(parent, path, ptr - path + 1);
+        parent[ptr - path + 1] = '\0';
+        status = server_script_dir(parent, dir);
+        if (!status) strcpy(leaf, ptr + 1);
+    }
+
+    // Return the status
+    return status;
+}
+
+/*
+    Parameters  : script        - The name of the script describing the
+                                  device, or NULL for an empty C drive.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Reset the device and build its filing system from the
+                  script.
+*/
+os_error *server_start(const char *script)
+{
+    os_error *err = NULL;
+    bits i;
+
+    // Discard any previous filing system
+    for (i = 0; i < EPOC32_DRIVES; i++)
+    {
+        while (server_drives[i].root.child)
+        {
+            server_node *child = server_drives[i].root.child;
+
+            server_drives[i].root.child = child->next;
+            server_free_node(child);
+        }
+    }
+    memset(server_drives, 0, sizeof(server_drives));
+    memset(server_handles, 0, sizeof(server_handles));
+    memset(&server_statistics, 0, sizeof(server_statistics));
+
+    // Restore the default behaviour
+    server_delay = 0;
+    server_frame_max = SERVER_FRAME_MAX;
+    server_window_size = SERVER_DEFAULT_WINDOW;
+    server_timeout = SERVER_DEFAULT_TIMEOUT;
+
+    // Always provide an internal drive
+    server_drives['C' - 'A'].present = TRUE;
+    strcpy(server_drives['C' - 'A'].name, "Internal");
+    for (i = 0; i < EPOC32_DRIVES; i++)
+    {
+        server_drives[i].root.dir = TRUE;
+        server_drives[i].root.attributes = EPOC32_FILE_DIRECTORY;
+    }
+
+    // Process the script
+    if (script)
+    {
+        FILE *file = fopen(script, "r");
+        char line[SERVER_SCRIPT_LINE];
+        bits number = 0;
+
+        if (!file)
+        {
+            fprintf(stderr, "%s: cannot be read\n", script);
+            err = &err_not_found;
+        }
+        while (!err && fgets(line, sizeof(line), file))
+        {
+            char command[SERVER_SCRIPT_LINE];
+            char arg[SERVER_SCRIPT_LINE];
+            unsigned long value;
+            unsigned long value2;
+            int fields;
+            bool numeric;
+            server_node *dir;
+            server_node *node;
+            epoc32_leaf_name leaf;
+
+            // Split the line into fields
+            number++;
+            if (strchr(line, '#')) *strchr(line, '#') = '\0';
+            fields = sscanf(line, "%s %s %lu %lu", command, arg, &value,
+                            &value2);
+            if (fields <= 0) continue;
+            if (fields == 2)
+            {
+                char *end;
+
+                value = strtoul(arg, &end, 10);
+                numeric = isdigit((unsigned char) *arg) && !*end;
+            }
+            else numeric = FALSE;
+
+            // Action depends on the command
+            if (!strcmp(command, "drive") && (2 <= fields)
+                && isalpha((unsigned char) arg[0]) && !arg[1])
+            {
+                server_drive *drive;
+
+                drive = &server_drives[toupper((unsigned char) arg[0]) - 'A'];
+                drive->present = TRUE;
+                if (sscanf(line, "%*s %*s %11s", drive->name) != 1)
+                {
+                    *drive->name = '\0';
+                }
+            }
+            else if (!strcmp(command, "dir") && (fields == 2))
+            {
+                if (server_mkdir_all(arg, NULL) == STATUS_ERA_NO_MEMORY)
+                {
+                    err = &err_buffer;
+                }
+            }
+            else if (!strcmp(command, "file") && (fields == 3)
+                     && !server_script_parent(arg, &dir, leaf))
+            {
+                node = server_find_child(dir, leaf);
+                if (node)
+                {
+                    fprintf(stderr, "%s:%u: '%s' already exists\n",
+                            script, number, arg);
+                    err = &err_bad_parms;
+                }
+                else if (!(node = server_create_node(dir, leaf, FALSE)))
+                {
+                    err = &err_buffer;
+                }
+                else node->size = value;
+            }
+            else if (!strcmp(command, "files") && (fields == 4)
+                     && !server_script_dir(arg, &dir))
+            {
+                for (i = 0; !err && (i < value); i++)
+                {
+                    sprintf(leaf, "File%03u", i);
+                    node = server_find_child(dir, leaf);
+                    if (!node) node = server_create_node(dir, leaf, FALSE);
+                    if (!node) err = &err_buffer;
+                    else node->size = value2;
+                }
+            }
+            else if (!strcmp(command, "delay") && numeric)
+            {
+                server_delay = value;
+            }
+            else if (!strcmp(command, "frame") && numeric
+                     && (SERVER_MUX_DATA < value)
+                     && (value <= SERVER_FRAME_MAX))
+            {
+                server_frame_max = value;
+            }
+            else if (!strcmp(command, "window") && numeric && value
+                     && (value <= SERVER_MAX_WINDOW))
+            {
+                server_window_size = value;
+            }
+            else if (!strcmp(command, "timeout") && numeric && value)
+            {
+                server_timeout = value;
+            }
+            else
+            {
+                fprintf(stderr, "%s:%u: not recognised\n", script, number);
+                err = &err_bad_parms;
+            }
+        }
+        if (file) fclose(file);
+    }
+
+    // Reset the protocol state
+    server_rx_state = SERVER_RX_SYN;
+    server_tx_size = 0;
+    server_tx_offset = 0;
+    server_link_reset();
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : bool          - Did the device make any progress.
+    Description : Process any data received by the device and transmit any
+                  pending replies. This is called whenever the block driver
+                  is polled.
+*/
+bool server_poll(void)
+{
+    bool progress = FALSE;
+    byte buffer[256];
+    bits size;
+
+    // Process received characters
+    while ((size = sim_get(SIM_END_DEVICE, buffer, sizeof(buffer))) != 0)
+    {
+        bits i;
+
+        for (i = 0; i < size; i++) server_rx_byte(buffer[i]);
+        progress = TRUE;
+    }
+
+    // Generate any replies
+    if (server_link_state == SERVER_LINK_DATA) server_mux_process();
+
+    // Transmit as much as possible
+    for (;;)
+    {
+        server_tx_next();
+        if (server_tx_size <= server_tx_offset) break;
+        size = sim_put(SIM_END_DEVICE, server_tx_buffer + server_tx_offset,
+                       server_tx_size - server_tx_offset);
+        if (!size) break;
+        server_tx_offset += size;
+        progress = TRUE;
+
+        // Start the retry timer once a data frame has been sent
+        if (server_tx_data && (server_tx_size <= server_tx_offset))
+        {
+            server_retry_time = sim_tx_done(SIM_END_DEVICE)
+                                + server_timeout * SIM_TIME_CS;
+        }
+    }
+
+    // Return whether anything happened
+    return progress;
+}
+
+/*
+    Parameters  : void
+    Returns     : sim_time      - The time of the next device timer, or
+                                  SIM_TIME_NEVER if none.
+    Description : Find when the device next needs to be polled.
+*/
+sim_time server_next_event(void)
+{
+    sim_time now = sim_now();
+    sim_time next = SIM_TIME_NEVER;
+    bits i;
+
+    // Only timers in the future are relevant
+    if ((server_link_state == SERVER_LINK_IDLE) && (now < server_req_time))
+    {
+        next = server_req_time;
+    }
+    if (server_window_count && (now < server_retry_time))
+    {
+        next = MIN(next, server_retry_time);
+    }
+    for (i = 0; i < SERVER_CHANNELS; i++)
+    {
+        const server_channel *chan = &server_channels[i];
+
+        if (chan->used && chan->reply_size && (now < chan->reply_time))
+        {
+            next = MIN(next, chan->reply_time);
+        }
+    }
+
+    // Return the earliest time
+    return next;
+}
+
+/*
+    Parameters  : void
+    Returns     : const server_stats *  - The statistics.
+    Description : Read the device statistics.
+*/
+const server_stats *server_read_stats(void)
+{
+    // Return a pointer to the statistics
+    return &server_statistics;
+}
@@ -0,0 +1,90 @@
+/*
+    File        : server.h
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Scripted EPOC device for the host benchmark harness. This
+                  implements the device end of the link, multiplexor, remote
+                  file server (RFSV32) and remote command server (NCP)
+                  protocols, serving an in-memory filing system.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Only include header file once
+#ifndef SERVER_H
+#define SERVER_H
+
+// Include oslib header files
+#include "oslib/os.h"
+
+// Include project header files
+#include "sim.h"
+
+// Statistics for the device
+typedef struct
+{
+    bits rx_frames;
+    bits rx_bad_frames;
+    bits rx_out_of_sequence;
+    bits tx_frames;
+    bits tx_retries;
+    bits ops;
+    bits unsupported;
+} server_stats;
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/*
+    Parameters  : script        - The name of the script describing the
+                                  device, or NULL for an empty C drive.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Reset the device and build its filing system from the
+                  script.
+*/
+os_error *server_start(const char *script);
+
+/*
+    Parameters  : void
+    Returns     : bool          - Did the device make any progress.
+    Description : Process any data received by the device and transmit any
+                  pending replies. This is called whenever the block driver
+                  is polled.
+*/
+bool server_poll(void);
+
+/*
+    Parameters  : void
+    Returns     : sim_time      - The time of the next device timer, or
+                                  SIM_TIME_NEVER if none.
+    Description : Find when the device next needs to be polled.
+*/
+sim_time server_next_event(void);
+
+/*
+    Parameters  : void
+    Returns     : const server_stats *  - The statistics.
+    Description : Read the device statistics.
+*/
+const server_stats *server_read_stats(void);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
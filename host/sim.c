@@ -0,0 +1,349 @@
+/*
+    File        : sim.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Simulated clock and serial line for the host benchmark
+                  harness. Each direction of the line transmits characters
+                  at the configured baud rate, delivers them after a fixed
+                  propagation delay, and may corrupt them at a configured bit
+                  error rate.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include header file for this module
+#include "sim.h"
+
+// Include clib header files
+#include <math.h>
+#include <string.h>
+
+// Bits on the wire for each character: start, 8 data and stop
+#define SIM_BITS_CHAR (10)
+
+// Buffer sizes
+#define SIM_TX_BUFFER (1024)
+#define SIM_RX_BUFFER (4096)
+#define SIM_WIRE_BUFFER (1 << 18)
+
+// A character on its way along the line
+typedef struct
+{
+    byte value;
+    sim_time start;
+    sim_time arrive;
+} sim_char;
+
+// One direction of the line
+typedef struct
+{
+    sim_char wire[SIM_WIRE_BUFFER];
+    bits wire_head;
+    bits wire_tail;
+    sim_time free;
+    byte rx[SIM_RX_BUFFER];
+    bits rx_head;
+    bits rx_tail;
+    sim_stats stats;
+} sim_line;
+static sim_line sim_lines[2];
+
+// The line configuration
+static sim_time sim_char_time;
+static sim_time sim_latency;
+static double sim_char_error;
+
+// The current time
+static sim_time sim_clock;
+
+// State of the error generator
+static unsigned long long sim_random_state;
+
+/*
+    Parameters  : void
+    Returns     : double        - A value in the range 0 to 1.
+    Description : Generate the next pseudo-random number. A fixed algorithm
+                  is used so that runs are repeatable.
+*/
+static double sim_random(void)
+{
+    // Advance an xorshift generator
+    sim_random_state ^= sim_random_state << 13;
+    sim_random_state ^= sim_random_state >> 7;
+    sim_random_state ^= sim_random_state << 17;
+
+    // Return the top 53 bits as a fraction
+    return (sim_random_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+    Parameters  : line          - The line to update.
+    Returns     : void
+    Description : Move any characters that have arrived into the receive
+                  buffer.
+*/
+static void sim_deliver(sim_line *line)
+{
+    // Deliver characters in the order they were sent
+    while ((line->wire_tail != line->wire_head)
+           && (line->wire[line->wire_tail].arrive <= sim_clock))
+    {
+        bits next = (line->rx_head + 1) % SIM_RX_BUFFER;
+
+        // Store the character unless the receive buffer is full
+        if (next != line->rx_tail)
+        {
+            line->rx[line->rx_head] = line->wire[line->wire_tail].value;
+            line->rx_head = next;
+        }
+        else line->stats.overruns++;
+        line->wire_tail = (line->wire_tail + 1) % SIM_WIRE_BUFFER;
+    }
+}
+
+/*
+    Parameters  : line          - The line to check.
+    Returns     : bits          - Number of characters waiting to be sent.
+    Description : Count the characters that have not started being shifted
+                  out. Characters are sent back to back once queued, so this
+                  can be calculated from the time the transmitter frees.
+*/
+static bits sim_waiting(const sim_line *line)
+{
+    sim_time pending;
+
+    // No characters waiting if the transmitter is already free
+    if (line->free <= sim_clock) return 0;
+
+    // Exclude the character currently being sent
+    pending = (line->free - sim_clock + sim_char_time - 1) / sim_char_time;
+    return pending ? pending - 1 : 0;
+}
+
+/*
+    Parameters  : baud          - The line speed in bits per second.
+                  latency       - The one way propagation delay in
+                                  microseconds.
+                  ber           - The probability of each bit being
+                                  corrupted.
+                  seed          - Seed for the error generator.
+    Returns     : void
+    Description : Reset the clock and configure the line.
+*/
+void sim_configure(bits baud, sim_time latency, double ber, bits seed)
+{
+    // Reset the line
+    memset(sim_lines, 0, sizeof(sim_lines));
+    sim_clock = 0;
+
+    // Store the configuration
+    sim_set_baud(baud);
+    sim_latency = latency;
+    sim_char_error = 1.0 - pow(1.0 - ber, 8);
+    sim_random_state = 0x9e3779b97f4a7c15ULL ^ seed;
+}
+
+/*
+    Parameters  : baud          - The line speed in bits per second.
+    Returns     : void
+    Description : Change the line speed, as the block driver would.
+*/
+void sim_set_baud(bits baud)
+{
+    // Calculate the time for each character
+    sim_char_time = baud ? (SIM_BITS_CHAR * 1000000ULL + baud - 1) / baud
+                         : 1;
+}
+
+/*
+    Parameters  : void
+    Returns     : sim_time      - The current simulated time.
+    Description : Read the simulated clock.
+*/
+sim_time sim_now(void)
+{
+    // Return the current time
+    return sim_clock;
+}
+
+/*
+    Parameters  : from          - The end transmitting the data.
+                  data          - The data to transmit.
+                  size          - Number of bytes to transmit.
+    Returns     : bits          - Number of bytes accepted.
+    Description : Add data to the transmit buffer for one end of the line.
+*/
+bits sim_put(sim_end from, const byte *data, bits size)
+{
+    sim_line *line = &sim_lines[from];
+    bits used = 0;
+
+    // Queue as much as fits in the transmit buffer
+    size = MIN(size, sim_check_tx(from));
+    while (used < size)
+    {
+        sim_char *ptr = &line->wire[line->wire_head];
+
+        // Schedule the character after any already queued
+        ptr->value = data[used++];
+        ptr->start = MAX(line->free, sim_clock);
+        line->free = ptr->start + sim_char_time;
+        ptr->arrive = line->free + sim_latency;
+        line->stats.sent++;
+
+        // Corrupt a single bit at the configured error rate
+        if (sim_char_error && (sim_random() < sim_char_error))
+        {
+            ptr->value ^= 1 << (int) (sim_random() * 8);
+            line->stats.corrupted++;
+        }
+
+        // Add the character to the line
+        line->wire_head = (line->wire_head + 1) % SIM_WIRE_BUFFER;
+    }
+
+    // Return the number of bytes accepted
+    return used;
+}
+
+/*
+    Parameters  : to            - The end receiving the data.
+                  data          - Buffer to receive the data.
+                  size          - Size of the buffer.
+    Returns     : bits          - Number of bytes read.
+    Description : Read data that has arrived at one end of the line.
+*/
+bits sim_get(sim_end to, byte *data, bits size)
+{
+    sim_line *line = &sim_lines[!to];
+    bits used = 0;
+
+    // Collect any characters that have arrived
+    sim_deliver(line);
+
+    // Copy as many as possible
+    while ((used < size) && (line->rx_tail != line->rx_head))
+    {
+        data[used++] = line->rx[line->rx_tail];
+        line->rx_tail = (line->rx_tail + 1) % SIM_RX_BUFFER;
+    }
+
+    // Return the number of bytes read
+    return used;
+}
+
+/*
+    Parameters  : from          - The end transmitting the data.
+    Returns     : bits          - Free space in the transmit buffer.
+    Description : Check how much more data can be transmitted immediately.
+*/
+bits sim_check_tx(sim_end from)
+{
+    const sim_line *line = &sim_lines[from];
+    bits waiting = sim_waiting(line);
+    bits wire;
+
+    // Also limit the total number of characters on the wire
+    wire = (line->wire_head + SIM_WIRE_BUFFER - line->wire_tail)
+           % SIM_WIRE_BUFFER;
+    return MIN(SIM_TX_BUFFER - MIN(waiting, SIM_TX_BUFFER),
+               SIM_WIRE_BUFFER - 1 - wire);
+}
+
+/*
+    Parameters  : from          - The end transmitting the data.
+    Returns     : sim_time      - The time at which the last queued
+                                  character will have been sent.
+    Description : Find when the transmitter will become idle.
+*/
+sim_time sim_tx_done(sim_end from)
+{
+    // Never earlier than the current time
+    return MAX(sim_lines[from].free, sim_clock);
+}
+
+/*
+    Parameters  : end           - The end to flush.
+    Returns     : void
+    Description : Discard data waiting to be sent and received at one end of
+                  the line.
+*/
+void sim_flush(sim_end end)
+{
+    sim_line *tx = &sim_lines[end];
+    sim_line *rx = &sim_lines[!end];
+
+    // Discard characters that have not started being sent
+    while (sim_waiting(tx))
+    {
+        tx->wire_head = (tx->wire_head + SIM_WIRE_BUFFER - 1)
+                        % SIM_WIRE_BUFFER;
+        tx->free -= sim_char_time;
+    }
+
+    // Discard received characters
+    sim_deliver(rx);
+    rx->rx_tail = rx->rx_head;
+}
+
+/*
+    Parameters  : from          - The end transmitting the data.
+    Returns     : const sim_stats * - The statistics.
+    Description : Read the statistics for one direction of the line.
+*/
+const sim_stats *sim_read_stats(sim_end from)
+{
+    // Return a pointer to the statistics
+    return &sim_lines[from].stats;
+}
+
+/*
+    Parameters  : limit         - The time of the next event outside the
+                                  line, or SIM_TIME_NEVER if none.
+    Returns     : void
+    Description : Advance the clock to the next event on the line, the
+                  specified limit, or the next centisecond boundary,
+                  whichever is earliest. This is used when neither end of the
+                  line could make progress at the current time.
+*/
+void sim_advance(sim_time limit)
+{
+    sim_time next = (sim_clock / SIM_TIME_CS + 1) * SIM_TIME_CS;
+    sim_end end;
+
+    // Check each direction of the line
+    for (end = SIM_END_HOST; end <= SIM_END_DEVICE; end++)
+    {
+        const sim_line *line = &sim_lines[end];
+
+        // The next character to arrive
+        if (line->wire_tail != line->wire_head)
+        {
+            next = MIN(next, line->wire[line->wire_tail].arrive);
+        }
+
+        // The transmit buffer becoming half empty
+        if (SIM_TX_BUFFER / 2 < sim_waiting(line))
+        {
+            next = MIN(next, line->free
+                             - (SIM_TX_BUFFER / 2 + 1) * sim_char_time);
+        }
+    }
+
+    // Advance the clock without going backwards
+    next = MIN(next, limit);
+    if (sim_clock < next) sim_clock = next;
+}
@@ -0,0 +1,145 @@
+/*
+    File        : sim.h
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Simulated clock and serial line for the host benchmark
+                  harness. Each direction of the line transmits characters
+                  at the configured baud rate, delivers them after a fixed
+                  propagation delay, and may corrupt them at a configured bit
+                  error rate.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Only include header file once
+#ifndef SIM_H
+#define SIM_H
+
+// Include oslib header files
+#include "oslib/os.h"
+
+// Simulated time in microseconds
+typedef unsigned long long sim_time;
+#define SIM_TIME_CS (10000)
+#define SIM_TIME_NEVER ((sim_time) -1)
+
+// The two ends of the line
+typedef bits sim_end;
+#define SIM_END_HOST ((sim_end) 0)
+#define SIM_END_DEVICE ((sim_end) 1)
+
+// Line statistics for one direction
+typedef struct
+{
+    bits sent;
+    bits corrupted;
+    bits overruns;
+} sim_stats;
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/*
+    Parameters  : baud          - The line speed in bits per second.
+                  latency       - The one way propagation delay in
+                                  microseconds.
+                  ber           - The probability of each bit being
+                                  corrupted.
+                  seed          - Seed for the error generator.
+    Returns     : void
+    Description : Reset the clock and configure the line.
+*/
+void sim_configure(bits baud, sim_time latency, double ber, bits seed);
+
+/*
+    Parameters  : baud          - The line speed in bits per second.
+    Returns     : void
+    Description : Change the line speed, as the block driver would.
+*/
+void sim_set_baud(bits baud);
+
+/*
+    Parameters  : void
+    Returns     : sim_time      - The current simulated time.
+    Description : Read the simulated clock.
+*/
+sim_time sim_now(void);
+
+/*
+    Parameters  : from          - The end transmitting the data.
+                  data          - The data to transmit.
+                  size          - Number of bytes to transmit.
+    Returns     : bits          - Number of bytes accepted.
+    Description : Add data to the transmit buffer for one end of the line.
+*/
+bits sim_put(sim_end from, const byte *data, bits size);
+
+/*
+    Parameters  : to            - The end receiving the data.
+                  data          - Buffer to receive the data.
+                  size          - Size of the buffer.
+    Returns     : bits          - Number of bytes read.
+    Description : Read data that has arrived at one end of the line.
+*/
+bits sim_get(sim_end to, byte *data, bits size);
+
+/*
+    Parameters  : from          - The end transmitting the data.
+    Returns     : bits          - Free space in the transmit buffer.
+    Description : Check how much more data can be transmitted immediately.
+*/
+bits sim_check_tx(sim_end from);
+
+/*
+    Parameters  : from          - The end transmitting the data.
+    Returns     : sim_time      - The time at which the last queued
+                                  character will have been sent.
+    Description : Find when the transmitter will become idle.
+*/
+sim_time sim_tx_done(sim_end from);
+
+/*
+    Parameters  : end           - The end to flush.
+    Returns     : void
+    Description : Discard data waiting to be sent and received at one end of
+                  the line.
+*/
+void sim_flush(sim_end end);
+
+/*
+    Parameters  : from          - The end transmitting the data.
+    Returns     : const sim_stats * - The statistics.
+    Description : Read the statistics for one direction of the line.
+*/
+const sim_stats *sim_read_stats(sim_end from);
+
+/*
+    Parameters  : limit         - The time of the next event outside the
+                                  line, or SIM_TIME_NEVER if none.
+    Returns     : void
+    Description : Advance the clock to the next event on the line, the
+                  specified limit, or the next centisecond boundary,
+                  whichever is earliest. This is used when neither end of the
+                  line could make progress at the current time.
+*/
+void sim_advance(sim_time limit);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
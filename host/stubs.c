@@ -0,0 +1,127 @@
+/*
+    File        : stubs.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Minimal replacements for the parts of the PsiFS module that
+                  are not exercised by the host benchmark harness. These
+                  either depend on RISC OS or provide features, such as the
+                  printer mirror or SIBO support, that the simulated device
+                  does not use.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include clib header files
+#include <stdlib.h>
+
+// Include project header files
+#include "err.h"
+#include "escape.h"
+#include "idle.h"
+#include "mem.h"
+#include "ncpfile.h"
+#include "pollword.h"
+#include "print.h"
+#include "rclip.h"
+#include "rfsv16.h"
+#include "sim.h"
+#include "upcall.h"
+#include "upload.h"
+#include "util.h"
+#include "wprt.h"
+
+// Idle disconnection is disabled
+bits idle_disconnect_link = 0;
+bits idle_disconnect_printer = 0;
+bool idle_background_throttle = FALSE;
+
+// The printer mirror is never active
+bool print_active = FALSE;
+fs_pathname print_device = "";
+
+// SIBO devices are not simulated
+share_handle rfsv16_share_handle = SHARE_NONE;
+
+// Memory management maps directly to the C library
+os_error *mem_initialise(void) { return NULL; }
+os_error *mem_finalise(void) { return NULL; }
+os_error *mem_tidy(void) { return NULL; }
+void *mem_malloc(size_t size) { return malloc(size); }
+void *mem_calloc(size_t n, size_t size) { return calloc(n, size); }
+void *mem_realloc(void *ptr, size_t size) { return realloc(ptr, size); }
+void mem_free(void *ptr) { free(ptr); }
+
+// The simulated clock and default options
+os_t util_time(void) { return (os_t) (sim_now() / SIM_TIME_CS); }
+bool util_truncate(void) { return FALSE; }
+
+// Escape conditions are never generated
+os_error *escape_store(escape_config *config) { return NULL; }
+os_error *escape_restore(const escape_config *config) { return NULL; }
+os_error *escape_enable(void) { return NULL; }
+os_error *escape_check(void) { return NULL; }
+
+// There are no clients to notify
+os_error *pollword_update(psifs_mask mask) { return NULL; }
+os_error *upcall_added(const char *path, const fs_info *info) { return NULL; }
+os_error *upcall_removed(const char *path, const fs_info *info)
+{
+    return NULL;
+}
+os_error *upcall_changed(const char *path, const fs_info *info)
+{
+    return NULL;
+}
+
+// Idle detection is disabled
+void idle_start(void) {}
+void idle_end(void) {}
+void idle_kick(void) {}
+bool idle_check_disconnect(bits time) { return FALSE; }
+bool idle_check_throttle(void) { return FALSE; }
+os_error *idle_status(void) { return NULL; }
+
+// The printer mirror is not available
+os_error *print_poll(bool active, int rx, int *tx) { return NULL; }
+os_error *print_start(const char *device) { return &err_block_driver; }
+os_error *print_end(bool now) { return NULL; }
+os_error *print_status(void) { return NULL; }
+
+// Remote printing and clipboard are not used
+os_error *wprt_start(void) { return NULL; }
+os_error *wprt_end(bool now) { return NULL; }
+os_error *wprt_status(void) { return NULL; }
+os_error *rclip_start(void) { return NULL; }
+os_error *rclip_end(bool now) { return NULL; }
+os_error *rclip_status(void) { return NULL; }
+
+// Servers are never uploaded to the device
+os_error *upload_start(bool era) { return NULL; }
+os_error *upload_end(bool now) { return NULL; }
+os_error *upload_status(void) { return NULL; }
+os_error *ncpfile_upload(void *user, share_callback callback)
+{
+    return &err_not_found;
+}
+
+// SIBO remote file services are not available
+os_error *rfsv16_start(void) { return NULL; }
+os_error *rfsv16_end(bool now) { return NULL; }
+os_error *rfsv16_back(const rfsv16_cmd *cmd, rfsv16_reply *reply,
+                      void *user, share_callback callback)
+{
+    return &err_svr_none;
+}
@@ -38,16 +38,36 @@ typedef struct backtree_record
     struct backtree_record *next;
     struct backtree_record *parent;
     struct backtree_record *child;
+    struct backtree_record *last;
+    struct backtree_record *hash;
     fs_info info;
     bool ignore;
 } backtree_record;
 
+// A block of records allocated together
+#define BACKTREE_ARENA_RECORDS (32)
+typedef struct backtree_arena
+{
+    struct backtree_arena *next;
+    bits used;
+    backtree_record record[BACKTREE_ARENA_RECORDS];
+} backtree_arena;
+
+// Size of the hash table
+#define BACKTREE_HASH_INITIAL (64)
+#define BACKTREE_HASH_LOAD (2)
+
 // Handle for a backup tree
 struct backtree_handle
 {
     bits reference;
     backtree_record *root;
+    backtree_record *last;
     backtree_record *next;
+    backtree_arena *arena;
+    backtree_record **hash;
+    bits hash_size;
+    bits records;
 };
 
 // Function prototypes
@@ -130,49 +150,138 @@ static os_error *backtree_find_parent(backtree_handle handle, const char *name,
 
 /*
     Parameters  : handle        - The backup tree handle.
-                  parent        - Pointer to the parent record, or NULL if
-                                  the root directory should be searched.
-                  name          - The name of the file, including the
-                                  sub-directory part of the path.
-                  ptr           - Variable to receive a pointer to the requested
-                                  record, or NULL if it does not exist.
-                  prev          - Variable to receive a pointer to the previous
-                                  record, or NULL if it should be the first
-                                  entry in the directory.
+                  ptr           - The record to add to the hash table.
+    Returns     : void
+    Description : Add a record to the hash table, enlarging the table if it
+                  has become too heavily loaded. The table is left unchanged
+                  if there is insufficient memory to enlarge it.
+*/
+static void backtree_hash_add(backtree_handle handle, backtree_record *ptr)
+{
+    // Enlarge the hash table if necessary
+    if (handle->hash_size * BACKTREE_HASH_LOAD <= handle->records)
+    {
+        bits size = handle->hash_size * 2;
+        backtree_record **hash;
+
+        hash = (backtree_record **) MEM_MALLOC(size * sizeof(*hash));
+        if (hash)
+        {
+            bits i;
+
+            // Move all of the records to the new table
+            for (i = 0; i < size; i++) hash[i] = NULL;
+            for (i = 0; i < handle->hash_size; i++)
+            {
+                while (handle->hash[i])
+                {
+                    backtree_record *move = handle->hash[i];
+                    bits bucket = wildcard_hash(move->info.name) % size;
+                    handle->hash[i] = move->hash;
+                    move->hash = hash[bucket];
+                    hash[bucket] = move;
+                }
+            }
+
+            // Replace the previous table
+            MEM_FREE(handle->hash);
+            handle->hash = hash;
+            handle->hash_size = size;
+        }
+    }
+
+    // Add the record to the appropriate bucket
+    {
+        bits bucket = wildcard_hash(ptr->info.name) % handle->hash_size;
+        ptr->hash = handle->hash[bucket];
+        handle->hash[bucket] = ptr;
+        handle->records++;
+    }
+}
+
+/*
+    Parameters  : handle        - The backup tree handle.
+                  ptr           - Variable to receive a pointer to the new
+                                  record.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Find the record associated with the specified file.
+    Description : Allocate a new record. Records are allocated in blocks and
+                  are only freed when the whole tree is destroyed.
 */
-static os_error *backtree_find_raw(backtree_handle handle,
-                                   backtree_record *parent, const char *name,
-                                   backtree_record **ptr,
-                                   backtree_record **prev)
+static os_error *backtree_alloc(backtree_handle handle, backtree_record **ptr)
 {
     os_error *err = NULL;
 
     // Check function parameters
-    if (!handle || !name || !ptr || !prev) err = &err_bad_parms;
+    if (!handle || !ptr) err = &err_bad_parms;
     else
     {
-        // Start from the first directory entry
-        *prev = NULL;
-        *ptr = parent ? parent->child : handle->root;
-
-        // Attempt to find the required entry
-        while (*ptr && (0 < wildcard_cmp(name, (*ptr)->info.name)))
+        // Allocate another block of records if necessary
+        if (!handle->arena || (handle->arena->used == BACKTREE_ARENA_RECORDS))
         {
-            *prev = *ptr;
-            *ptr = (*ptr)->next;
+            backtree_arena *arena;
+
+            arena = (backtree_arena *) MEM_MALLOC(sizeof(backtree_arena));
+            if (arena)
+            {
+                arena->next = handle->arena;
+                arena->used = 0;
+                handle->arena = arena;
+            }
+            else err = &err_buffer;
         }
 
-        // Clear the current pointer if not found
-        if (*ptr && wildcard_cmp(name, (*ptr)->info.name)) *ptr = NULL;
+        // Use the next record from the current block
+        *ptr = err ? NULL : &handle->arena->record[handle->arena->used++];
     }
 
     // Return any error produced
     return err;
 }
 
+/*
+    Parameters  : handle        - The backup tree handle.
+                  parent        - Pointer to the parent record, or NULL if
+                                  the file is in the root directory.
+                  ptr           - The record to link in.
+    Returns     : void
+    Description : Link a record into its directory, keeping the entries sorted.
+                  Files are usually added in order, so the last entry of the
+                  directory is checked before searching from the start.
+*/
+static void backtree_link(backtree_handle handle, backtree_record *parent,
+                          backtree_record *ptr)
+{
+    backtree_record **first = parent ? &parent->child : &handle->root;
+    backtree_record **last = parent ? &parent->last : &handle->last;
+
+    // Attempt to append the record to the directory
+    if (!*last || (0 < wildcard_cmp(ptr->info.name, (*last)->info.name)))
+    {
+        ptr->next = NULL;
+        if (*last) (*last)->next = ptr;
+        else *first = ptr;
+        *last = ptr;
+    }
+    else
+    {
+        backtree_record *prev = NULL;
+        backtree_record *next = *first;
+
+        // Find the correct position within the directory
+        while (next && (0 < wildcard_cmp(ptr->info.name, next->info.name)))
+        {
+            prev = next;
+            next = next->next;
+        }
+
+        // Insert the record
+        ptr->next = next;
+        if (prev) prev->next = ptr;
+        else *first = ptr;
+    }
+}
+
 /*
     Parameters  : handle        - The backup tree handle.
                   name          - The name of the file, including the
@@ -192,20 +301,11 @@ static os_error *backtree_find(backtree_handle handle, const char *name,
     if (!handle || !name || !ptr) err = &err_bad_parms;
     else
     {
-        backtree_record *parent;
-        backtree_record *prev;
-
-        // Find the parent directory
-        err = backtree_find_parent(handle, name, &parent, FALSE);
-
-        // Find the required entry
-        if (!err) err = backtree_find_raw(handle, parent, name, ptr, &prev);
-
-        // Special case for not found errors
-        if (ERR_EQ(*err, err_not_found))
+        // Search the appropriate hash bucket
+        *ptr = handle->hash[wildcard_hash(name) % handle->hash_size];
+        while (*ptr && wildcard_cmp(name, (*ptr)->info.name))
         {
-            *ptr = NULL;
-            err = NULL;
+            *ptr = (*ptr)->hash;
         }
     }
 
@@ -254,40 +354,23 @@ static os_error *backtree_next(backtree_record *ptr, backtree_record **next)
 }
 
 /*
-    Parameters  : ptr           - The current record.
-                  next          - Variable to receive a pointer to the next
-                                  record, or NULL if no more.
-    Returns     : os_error *    - Pointer to a corresponding error block, or
-                                  NULL if no error.
-    Description : Free the memory associated with the specified backup tree
-                  record, including any siblings or children.
+    Parameters  : handle        - The backup tree handle.
+    Returns     : void
+    Description : Free the memory used by all of the records in the specified
+                  backup tree, and by its hash table.
 */
-static os_error *backtree_free(backtree_record *ptr)
+static void backtree_free(backtree_handle handle)
 {
-    os_error *err = NULL;
-
-    // Check function parameters
-    if (!ptr) err = &err_bad_parms;
-    else
+    // Free all of the blocks of records
+    while (handle->arena)
     {
-        // Loop through all siblings
-        while (!err && ptr)
-        {
-            backtree_record *this = ptr;
-
-            // Advance to the next sibling
-            ptr = ptr->next;
-
-            // Free the memory used by any children
-            if (this->child) err = backtree_free(this->child);
-
-            // Free the memory used by this file record
-            if (!err) MEM_FREE(this);
-        }
+        backtree_arena *arena = handle->arena;
+        handle->arena = arena->next;
+        MEM_FREE(arena);
     }
 
-    // Return any error produced
-    return err;
+    // Free the hash table
+    if (handle->hash) MEM_FREE(handle->hash);
 }
 
 /*
@@ -309,16 +392,12 @@ os_error *backtree_add(backtree_handle handle, const fs_info *info)
     {
         backtree_record *ptr;
         backtree_record *parent;
-        backtree_record *prev;
 
         // Find the parent entry
         err = backtree_find_parent(handle, info->name, &parent, TRUE);
 
         // Attempt to find this entry
-        if (!err)
-        {
-            err = backtree_find_raw(handle, parent, info->name, &ptr, &prev);
-        }
+        if (!err) err = backtree_find(handle, info->name, &ptr);
 
         // If already exists then verify not changing type
         if (!err && ptr && (info->obj_type != ptr->info.obj_type))
@@ -330,32 +409,17 @@ os_error *backtree_add(backtree_handle handle, const fs_info *info)
         if (!err && !ptr)
         {
             // Allocate memory for the new record
-            ptr = (backtree_record *) MEM_MALLOC(sizeof(backtree_record));
-            if (!ptr) err = &err_buffer;
+            err = backtree_alloc(handle, &ptr);
 
             // Link the new record in
             if (!err)
             {
                 ptr->parent = parent;
                 ptr->child = NULL;
-                if (prev)
-                {
-                    // Not first file in directory
-                    ptr->next = prev->next;
-                    prev->next = ptr;
-                }
-                else if (parent)
-                {
-                    // First file in sub-directory
-                    ptr->next = parent->child;
-                    parent->child = ptr;
-                }
-                else
-                {
-                    // First file in root directory
-                    ptr->next = handle->root;
-                    handle->root = ptr;
-                }
+                ptr->last = NULL;
+                ptr->info = *info;
+                backtree_link(handle, parent, ptr);
+                backtree_hash_add(handle, ptr);
             }
         }
 
@@ -601,7 +665,33 @@ os_error *backtree_create(backtree_handle *handle)
         {
             (*handle)->reference = 1;
             (*handle)->root = NULL;
+            (*handle)->last = NULL;
             (*handle)->next = NULL;
+            (*handle)->arena = NULL;
+            (*handle)->hash_size = BACKTREE_HASH_INITIAL;
+            (*handle)->records = 0;
+            (*handle)->hash = (backtree_record **)
+                              MEM_MALLOC(BACKTREE_HASH_INITIAL
+                                         * sizeof(backtree_record *));
+            if (!(*handle)->hash) err = &err_buffer;
+        }
+
+        // Clear the hash table
+        if (!err)
+        {
+            bits i;
+
+            for (i = 0; i < BACKTREE_HASH_INITIAL; i++)
+            {
+                (*handle)->hash[i] = NULL;
+            }
+        }
+
+        // Free the memory if an error
+        if (err && *handle)
+        {
+            MEM_FREE(*handle);
+            *handle = BACKTREE_NONE;
         }
     }
 
@@ -655,7 +745,7 @@ os_error *backtree_destroy(backtree_handle *handle)
         if (!--(*handle)->reference)
         {
             // Free the file records
-            backtree_free((*handle)->root);
+            backtree_free(*handle);
 
             // Free the memory used by the handle
             MEM_FREE(*handle);
@@ -32,6 +32,9 @@
 
 // Include oslib header files
 #include "oslib/osfile.h"
+#include "oslib/osfind.h"
+#include "oslib/osfscontrol.h"
+#include "oslib/osgbpb.h"
 #include "oslib/osword.h"
 
 // Include project header files
@@ -57,6 +60,8 @@ typedef enum
     CACHE_PRIORITY_NONE,
     CACHE_PRIORITY_REFRESH,
     CACHE_PRIORITY_INVALID,
+    CACHE_PRIORITY_AHEAD,
+    CACHE_PRIORITY_BEHIND,
     CACHE_PRIORITY_REQUIRED
 } cache_priority;
 #define CACHE_REFRESH_DELAY (100)
@@ -117,9 +122,19 @@ typedef struct cache_dir
     struct cache_dir *parent;
     struct cache_dir *next;
     struct cache_dir *prev;
+    struct cache_dir *hash_next;
     fs_info info;
     fs_handle open;
     struct
+    {
+        bits index;
+        cache_priority priority;
+        os_t time;
+        cache_priority stale;
+        os_t since;
+        bool list;
+    } queue;
+    struct
     {
         bool active;
         bool required;
@@ -127,10 +142,24 @@ typedef struct cache_dir
         os_error *err;
         os_t refresh;
         struct cache_dir *children;
+        struct cache_dir **hash;
+        bits hash_size;
+        bits entries;
+        bits stale;
+        bits stale_required;
     } dir;
 } cache_dir;
+#define CACHE_DIR_HASH_MIN (16)
+#define CACHE_DIR_HASH_LOAD (2)
+#define CACHE_DIR_BATCH (4)
 //static cache_dir *cache_dir_free = NULL;
 
+// Directory entries waiting to be updated, ordered by priority
+#define CACHE_QUEUE_MIN (64)
+static cache_dir **cache_queue = NULL;
+static bits cache_queue_size = 0;
+static bits cache_queue_used = 0;
+
 // Cached drive details
 #define CACHE_DRIVE_TIMEOUT_ACTIVE (20 * 100)
 #define CACHE_DRIVE_TIMEOUT_INACTIVE (60 * 100)
@@ -142,10 +171,41 @@ typedef struct
 } cache_drive;
 static cache_drive cache_drive_array[26];
 
+// Saved copies of the directory cache
+#define CACHE_STORE_DIR "<PsiFSScrap$Dir>"
+#define CACHE_STORE_SUBDIR "<PsiFSScrap$Dir>.DirCache"
+#define CACHE_STORE_PATH "PsiFSScrap:DirCache."
+#define CACHE_STORE_MAGIC (0x52494443)
+#define CACHE_STORE_VERSION (1)
+#define CACHE_STORE_UNLISTED ((bits) -1)
+typedef struct
+{
+    bits magic;
+    bits version;
+    unified_machine_id id;
+} cache_store_header;
+typedef struct
+{
+    bits drive;
+    psifs_drive_id id;
+    bits entries;
+} cache_store_drive;
+typedef struct
+{
+    bits load_addr;
+    bits exec_addr;
+    bits size;
+    bits attr;
+    bits obj_type;
+    bits entries;
+    bits length;
+} cache_store_entry;
+
 // Pending operations
 typedef enum
 {
     CACHE_PENDING_STATE_INITIAL,
+    CACHE_PENDING_STATE_FLUSH,
     CACHE_PENDING_STATE_DELETE,
     CACHE_PENDING_STATE_OPEN,
     CACHE_PENDING_STATE_CLOSE,
@@ -175,9 +235,21 @@ static bool cache_pending_reply = FALSE;
 
 // Buffer for reading file details
 #define CACHE_BUFFER_SIZE (64)
+#define CACHE_BUFFER_SPARE (16)
 static fs_info *cache_buffer = NULL;
 static bits cache_buffer_size = CACHE_BUFFER_SIZE;
 
+// Read-ahead buffering for sequential reads
+#define CACHE_AHEAD_SIZE (8192)
+#define CACHE_AHEAD_REFILL (CACHE_AHEAD_SIZE / 2)
+static fs_handle cache_next_ahead_handle = FS_NONE;
+
+// Write-behind buffering for small writes
+#define CACHE_BEHIND_SIZE (8192)
+#define CACHE_BEHIND_TIMEOUT (100)
+static fs_handle cache_next_behind_handle = FS_NONE;
+static fs_handle cache_pending_behind_handle = FS_NONE;
+
 // A cached file handle
 typedef struct cache_file
 {
@@ -192,6 +264,23 @@ typedef struct cache_file
     fileswitch_attr attr;
     bits sequential;
     unified_handle handle;
+    struct
+    {
+        byte *buffer;
+        bits offset;
+        bits used;
+        bits next;
+        bool stop;
+    } ahead;
+    struct
+    {
+        byte *buffer;
+        bits offset;
+        bits used;
+        bool resize;
+        os_t timeout;
+        os_error *err;
+    } behind;
 } cache_file;
 //static fs_handle cache_handle_free = NULL;
 static fs_handle cache_handle_active = NULL;
@@ -257,6 +346,271 @@ static os_error *cache_check_sequential(fs_handle handle)
     return err;
 }
 
+/*
+    Parameters  : handle        - The file handle.
+    Returns     : void
+    Description : Discard any data held in the read-ahead buffer for an open
+                  file. The buffer itself is retained for reuse.
+*/
+static void cache_ahead_discard(fs_handle handle)
+{
+    // Mark the buffer as empty
+    handle->ahead.offset = 0;
+    handle->ahead.used = 0;
+    handle->ahead.stop = FALSE;
+}
+
+/*
+    Parameters  : handle        - The file handle.
+    Returns     : void
+    Description : Release the read-ahead buffer for an open file.
+*/
+static void cache_ahead_free(fs_handle handle)
+{
+    // Free any buffer
+    if (handle->ahead.buffer)
+    {
+        MEM_FREE(handle->ahead.buffer);
+        handle->ahead.buffer = NULL;
+    }
+
+    // Ensure that the buffer is not used
+    cache_ahead_discard(handle);
+    if (cache_next_ahead_handle == handle) cache_next_ahead_handle = FS_NONE;
+}
+
+/*
+    Parameters  : handle        - The file handle.
+                  offset        - The file offset to read from.
+                  length        - The number of bytes to read.
+                  buffer        - The buffer to receive the data.
+    Returns     : bool          - Was the data copied from the read-ahead
+                                  buffer.
+    Description : Attempt to satisfy a read from the read-ahead buffer. This
+                  only succeeds if all of the requested data is available.
+*/
+static bool cache_ahead_copy(fs_handle handle, bits offset, bits length,
+                             void *buffer)
+{
+    bool hit = FALSE;
+
+    // Check whether the whole request is buffered
+    if (handle->ahead.buffer && (handle->ahead.offset <= offset)
+        && (offset + length <= handle->ahead.offset + handle->ahead.used))
+    {
+        // Copy the data
+        memcpy(buffer, handle->ahead.buffer + (offset - handle->ahead.offset),
+               length);
+        handle->ahead.next = offset + length;
+        hit = TRUE;
+    }
+
+    // Return whether the request was satisfied
+    return hit;
+}
+
+/*
+    Parameters  : handle        - The file handle.
+    Returns     : void
+    Description : Release the write-behind buffer for an open file. Any data
+                  that has not been flushed is discarded, but any error from
+                  an earlier flush is retained to be reported.
+*/
+static void cache_behind_free(fs_handle handle)
+{
+    // Free any buffer
+    if (handle->behind.buffer)
+    {
+        MEM_FREE(handle->behind.buffer);
+        handle->behind.buffer = NULL;
+    }
+
+    // Ensure that the buffer is not used
+    handle->behind.used = 0;
+    handle->behind.resize = FALSE;
+    if (cache_next_behind_handle == handle) cache_next_behind_handle = FS_NONE;
+    if (cache_pending_behind_handle == handle)
+    {
+        cache_pending_behind_handle = FS_NONE;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : fs_handle     - The first open file with buffered data, or
+                                  FS_NONE if none.
+    Description : Find an open file that has data in its write-behind buffer.
+*/
+static fs_handle cache_behind_dirty(void)
+{
+    fs_handle handle = cache_handle_active;
+
+    // Check each open file in sequence
+    while (handle && !(handle->dir && handle->behind.used))
+    {
+        handle = handle->next;
+    }
+
+    // Return the file found
+    return handle ? handle : FS_NONE;
+}
+
+/*
+    Parameters  : handle        - The file handle.
+                  offset        - The file offset to write at.
+                  length        - The number of bytes to write.
+    Returns     : bool          - Can the data be merged with the write-behind
+                                  buffer.
+    Description : Check whether a write is small enough, and either adjacent
+                  to or overlapping any data already buffered, to be added to
+                  the write-behind buffer.
+*/
+static bool cache_behind_fits(fs_handle handle, bits offset, bits length)
+{
+    // Check the position of the write relative to any buffered data
+    return (length < CACHE_BEHIND_SIZE)
+           && (!handle->behind.used
+               || ((handle->behind.offset <= offset)
+                   && (offset <= handle->behind.offset + handle->behind.used)
+                   && (offset + length
+                       <= handle->behind.offset + CACHE_BEHIND_SIZE)));
+}
+
+/*
+    Parameters  : handle        - The file handle.
+                  offset        - The file offset to write at.
+                  length        - The number of bytes to write.
+                  buffer        - The data to write.
+    Returns     : bool          - Was the data added to the write-behind
+                                  buffer.
+    Description : Attempt to add a write to the write-behind buffer. This fails
+                  if the write cannot be merged with the existing contents, or
+                  if the buffer is currently being flushed.
+*/
+static bool cache_behind_merge(fs_handle handle, bits offset, bits length,
+                               const void *buffer)
+{
+    bool merged = FALSE;
+
+    // Allocate a buffer if required
+    if (!handle->behind.buffer && (length < CACHE_BEHIND_SIZE))
+    {
+        handle->behind.buffer = (byte *) MEM_MALLOC(CACHE_BEHIND_SIZE);
+    }
+
+    // Check whether the data can be merged
+    if (handle->behind.buffer && cache_behind_fits(handle, offset, length)
+        && !(cache_next_active && (cache_next_behind_handle == handle)))
+    {
+        bits end = offset + length;
+
+        // Start a new buffer if currently empty
+        if (!handle->behind.used)
+        {
+            handle->behind.offset = offset;
+            handle->behind.timeout = util_time() + CACHE_BEHIND_TIMEOUT;
+        }
+
+        // Copy the data
+        memcpy(handle->behind.buffer + (offset - handle->behind.offset),
+               buffer, length);
+        handle->behind.used = MAX(handle->behind.used,
+                                  end - handle->behind.offset);
+
+        // Enlarge the file if necessary
+        if (handle->info.allocated < end)
+        {
+            handle->info.extent = end;
+            handle->info.allocated = cache_round_allocated(end);
+            handle->behind.resize = TRUE;
+            cache_check_sequential(handle);
+        }
+
+        // Any read-ahead data is no longer valid
+        cache_ahead_discard(handle);
+        merged = TRUE;
+    }
+
+    // Return whether the data was buffered
+    return merged;
+}
+
+/*
+    Parameters  : handle        - The file handle.
+    Returns     : bool          - Was a command generated.
+    Description : Generate the next command required to flush the write-behind
+                  buffer for an open file.
+*/
+static bool cache_behind_cmd(fs_handle handle)
+{
+    bool cmd = TRUE;
+
+    // Choose the next command
+    if (!handle->behind.used)
+    {
+        // Nothing to flush
+        cmd = FALSE;
+    }
+    else if (handle->behind.resize)
+    {
+        // Set the allocated size of the file
+        cache_next_cmd.op = UNIFIED_SIZE;
+        cache_next_cmd.data.size.handle = handle->handle;
+        cache_next_cmd.data.size.size = handle->info.allocated;
+    }
+    else if (handle->behind.offset != handle->sequential)
+    {
+        // Set the file pointer
+        cache_next_cmd.op = UNIFIED_SEEK;
+        cache_next_cmd.data.seek.handle = handle->handle;
+        cache_next_cmd.data.seek.offset = handle->behind.offset;
+    }
+    else
+    {
+        // Write the buffered data
+        cache_next_cmd.op = UNIFIED_WRITE;
+        cache_next_cmd.data.write.handle = handle->handle;
+        cache_next_cmd.data.write.length = handle->behind.used;
+        cache_next_cmd.data.write.buffer = handle->behind.buffer;
+    }
+
+    // Return whether a command was generated
+    return cmd;
+}
+
+/*
+    Parameters  : handle        - The file handle.
+    Returns     : void
+    Description : Update the write-behind status of an open file after a
+                  successful reply to a command generated by cache_behind_cmd.
+*/
+static void cache_behind_reply(fs_handle handle)
+{
+    // Action depends on the command that was performed
+    switch (cache_next_cmd.op)
+    {
+        case UNIFIED_SIZE:
+            // The file has been enlarged
+            handle->behind.resize = FALSE;
+            break;
+
+        case UNIFIED_SEEK:
+            // The file pointer has been moved
+            handle->sequential = handle->behind.offset;
+            break;
+
+        case UNIFIED_WRITE:
+            // The buffered data has been written
+            handle->sequential += handle->behind.used;
+            handle->behind.used = 0;
+            break;
+
+        default:
+            // No other commands are generated
+            break;
+    }
+}
+
 /*
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -284,6 +638,35 @@ static os_error *cache_buffer_grow(void)
     return err;
 }
 
+/*
+    Parameters  : entries       - The number of directory entries expected.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Ensure that the buffer used for reading directory entries
+                  is allocated and large enough for the specified number of
+                  entries, so that a directory can be read in a single pass.
+*/
+static os_error *cache_buffer_reserve(bits entries)
+{
+    os_error *err = NULL;
+    bits size = cache_buffer_size;
+
+    // Choose the new buffer size
+    while (size < entries) size <<= 1;
+
+    // Reallocate the buffer if necessary
+    if (!cache_buffer || (size != cache_buffer_size))
+    {
+        if (cache_buffer) MEM_FREE(cache_buffer);
+        cache_buffer_size = size;
+        cache_buffer = (fs_info *) MEM_MALLOC(sizeof(fs_info) * cache_buffer_size);
+        if (!cache_buffer) err = &err_buffer;
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -453,67 +836,496 @@ static os_error *cache_dir_name(const cache_dir *dir, const char **path,
             else
             {
                 sprintf(strchr(str, '\0'), "%c",
-                        drive - cache_drive_array + 'A');
+                        (int) (drive - cache_drive_array) + 'A');
             }
         }
-
-        // Add the leaf if not the root of a virtual path
-        if (!err && (dir->parent || !virtual))
+
+        // Add the leaf if not the root of a virtual path
+        if (!err && (dir->parent || !virtual))
+        {
+            if (sizeof(str) <= (strlen(str) + strlen(dir->info.name) + 1))
+            {
+                err = &err_bad_name;
+            }
+            else
+            {
+                sprintf(strchr(str, '\0'), "%c%s",
+                        FS_CHAR_SEPARATOR, dir->info.name);
+            }
+        }
+
+        // Set the result pointer
+        *path = !err ? str : NULL;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : parent        - The parent of the directory to search.
+                  name          - The name to search for.
+                  prev          - Variable to receive a pointer to the entry
+                                  immediately preceding the first one after
+                                  the specified name.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Attempt to find the specified directory entry, and return a
+                  pointer to the requested entry (or the preceding entry if not
+                  found).
+*/
+static os_error *cache_dir_prev(const cache_dir *parent, const char *name,
+                                cache_dir **prev)
+{
+    os_error *err = NULL;
+
+    // Check function parameters
+    if (!parent || !name || !prev) err = &err_bad_parms;
+    else
+    {
+        cache_dir *ptr = parent->dir.children;
+
+        // Search the directory
+        *prev = NULL;
+        while (!err && ptr && (wildcard_cmp(ptr->info.name, name) <= 0))
+        {
+            // Advance to the next entry
+            *prev = ptr;
+            ptr = ptr->next;
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : dir           - The directory to index.
+                  size          - The number of hash buckets to use.
+    Returns     : void
+    Description : Rebuild the hash index for the entries of the specified
+                  directory. The index is discarded if there is insufficient
+                  memory, in which case the entries are searched linearly.
+*/
+static void cache_dir_hash_build(cache_dir *dir, bits size)
+{
+    cache_dir **hash;
+
+    // Allocate the new hash table
+    hash = (cache_dir **) MEM_MALLOC(size * sizeof(cache_dir *));
+    if (hash)
+    {
+        cache_dir *ptr;
+        bits i;
+
+        // Add all of the entries to the new table
+        for (i = 0; i < size; i++) hash[i] = NULL;
+        for (ptr = dir->dir.children; ptr; ptr = ptr->next)
+        {
+            bits bucket = wildcard_hash(ptr->info.name) % size;
+            ptr->hash_next = hash[bucket];
+            hash[bucket] = ptr;
+        }
+    }
+
+    // Replace any previous table
+    if (dir->dir.hash) MEM_FREE(dir->dir.hash);
+    dir->dir.hash = hash;
+    dir->dir.hash_size = hash ? size : 0;
+}
+
+/*
+    Parameters  : parent        - The parent directory.
+                  dir           - The directory entry that has been linked in.
+    Returns     : void
+    Description : Add a new directory entry to the hash index of its parent.
+                  An index is only created once the directory is large enough
+                  to benefit, and is enlarged as the directory grows.
+*/
+static void cache_dir_hash_add(cache_dir *parent, cache_dir *dir)
+{
+    // Count the new entry
+    parent->dir.entries++;
+
+    // Add the entry to the index if appropriate
+    if (parent->dir.hash_size * CACHE_DIR_HASH_LOAD < parent->dir.entries)
+    {
+        // Create or enlarge the index, including the new entry
+        if (CACHE_DIR_HASH_MIN <= parent->dir.entries)
+        {
+            cache_dir_hash_build(parent, parent->dir.hash_size
+                                         ? parent->dir.hash_size * 2
+                                         : CACHE_DIR_HASH_MIN);
+        }
+    }
+    else
+    {
+        bits bucket = wildcard_hash(dir->info.name) % parent->dir.hash_size;
+        dir->hash_next = parent->dir.hash[bucket];
+        parent->dir.hash[bucket] = dir;
+    }
+}
+
+/*
+    Parameters  : parent        - The parent directory.
+                  dir           - The directory entry being unlinked.
+    Returns     : void
+    Description : Remove a directory entry from the hash index of its parent.
+                  The index is freed when the directory becomes empty.
+*/
+static void cache_dir_hash_remove(cache_dir *parent, cache_dir *dir)
+{
+    // Remove the entry from the index
+    if (parent->dir.hash)
+    {
+        cache_dir **ptr;
+
+        ptr = &parent->dir.hash[wildcard_hash(dir->info.name)
+                                % parent->dir.hash_size];
+        while (*ptr && (*ptr != dir)) ptr = &(*ptr)->hash_next;
+        if (*ptr) *ptr = dir->hash_next;
+    }
+
+    // Free the index if the directory is empty
+    if (!--parent->dir.entries && parent->dir.hash)
+    {
+        MEM_FREE(parent->dir.hash);
+        parent->dir.hash = NULL;
+        parent->dir.hash_size = 0;
+    }
+}
+
+/*
+    Parameters  : parent        - The directory to search.
+                  leaf          - The leafname of the entry to find.
+    Returns     : cache_dir *   - Pointer to the entry, or NULL if not found.
+    Description : Find the specified entry within a directory, using the hash
+                  index unless the leafname contains wildcards.
+*/
+static cache_dir *cache_dir_lookup(const cache_dir *parent, const char *leaf)
+{
+    cache_dir *ptr;
+
+    // Use the index if possible
+    if (parent->dir.hash && !strchr(leaf, FS_CHAR_WILD_ANY)
+        && !strchr(leaf, FS_CHAR_WILD_SINGLE))
+    {
+        ptr = parent->dir.hash[wildcard_hash(leaf) % parent->dir.hash_size];
+        while (ptr && wildcard_cmp(ptr->info.name, leaf)) ptr = ptr->hash_next;
+    }
+    else
+    {
+        ptr = parent->dir.children;
+        while (ptr && wildcard_cmp(ptr->info.name, leaf)) ptr = ptr->next;
+    }
+
+    // Return the result
+    return ptr;
+}
+
+/*
+    Parameters  : dir1          - The first directory entry.
+                  dir2          - The second directory entry.
+    Returns     : bool          - Should the first entry be updated before
+                                  the second.
+    Description : Compare the positions of two entries in the update queue.
+*/
+static bool cache_queue_before(const cache_dir *dir1, const cache_dir *dir2)
+{
+    // Higher priorities first, then the earliest time
+    return (dir2->queue.priority < dir1->queue.priority)
+           || ((dir1->queue.priority == dir2->queue.priority)
+               && ((int) (dir1->queue.time - dir2->queue.time) < 0));
+}
+
+/*
+    Parameters  : index         - The position in the queue.
+                  dir           - The directory entry to store.
+    Returns     : void
+    Description : Store a directory entry at the specified queue position.
+*/
+static void cache_queue_set(bits index, cache_dir *dir)
+{
+    // Store the entry and record its position
+    cache_queue[index] = dir;
+    dir->queue.index = index + 1;
+}
+
+/*
+    Parameters  : dir           - The directory entry to reposition.
+    Returns     : void
+    Description : Restore the ordering of the queue after the priority of the
+                  specified entry has changed.
+*/
+static void cache_queue_sift(cache_dir *dir)
+{
+    bits index = dir->queue.index - 1;
+
+    // Move the entry towards the head of the queue if necessary
+    while (index && cache_queue_before(dir, cache_queue[(index - 1) / 2]))
+    {
+        cache_queue_set(index, cache_queue[(index - 1) / 2]);
+        index = (index - 1) / 2;
+    }
+
+    // Move the entry towards the tail of the queue if necessary
+    for (;;)
+    {
+        bits child = index * 2 + 1;
+
+        if ((child + 1 < cache_queue_used)
+            && cache_queue_before(cache_queue[child + 1], cache_queue[child]))
+        {
+            child++;
+        }
+        if ((cache_queue_used <= child)
+            || !cache_queue_before(cache_queue[child], dir))
+        {
+            break;
+        }
+        cache_queue_set(index, cache_queue[child]);
+        index = child;
+    }
+
+    // Store the entry at its final position
+    cache_queue_set(index, dir);
+}
+
+/*
+    Parameters  : dir           - The directory entry to remove.
+    Returns     : void
+    Description : Remove the specified entry from the update queue, if it is
+                  currently queued.
+*/
+static void cache_queue_remove(cache_dir *dir)
+{
+    // No action unless the entry is queued
+    if (dir->queue.index)
+    {
+        cache_dir *last = cache_queue[--cache_queue_used];
+
+        // Replace the entry by the last one in the queue
+        if (last != dir)
+        {
+            cache_queue_set(dir->queue.index - 1, last);
+            cache_queue_sift(last);
+        }
+        dir->queue.index = 0;
+    }
+}
+
+/*
+    Parameters  : dir           - The directory entry to reposition.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Choose the priority of the next update required for the
+                  specified entry, and add, move or remove it within the
+                  update queue as appropriate. This chooses between checking
+                  the details of the object itself and reading the directory
+                  contents, using the same rules as a complete scan of the
+                  directory tree.
+*/
+static os_error *cache_queue_key(cache_dir *dir)
+{
+    os_error *err = NULL;
+
+    // Start with the details of the object itself
+    dir->queue.list = FALSE;
+    if (dir->parent)
+    {
+        dir->queue.priority = dir->queue.stale;
+        dir->queue.time = dir->queue.since;
+    }
+    else dir->queue.priority = CACHE_PRIORITY_NONE;
+
+    // Consider reading the directory contents if it is active
+    if ((dir->info.obj_type == fileswitch_IS_DIR) && dir->dir.active)
+    {
+        cache_priority priority;
+
+        // Choose the priority, including any entries that need updating
+        if (dir->dir.required) priority = CACHE_PRIORITY_REQUIRED;
+        else if (!dir->dir.valid) priority = CACHE_PRIORITY_INVALID;
+        else priority = CACHE_PRIORITY_REFRESH;
+        if (dir->dir.valid && !dir->dir.err
+            && (CACHE_DIR_BATCH <= dir->dir.stale))
+        {
+            if (dir->dir.stale_required) priority = CACHE_PRIORITY_REQUIRED;
+            else if (priority < CACHE_PRIORITY_INVALID)
+            {
+                priority = CACHE_PRIORITY_INVALID;
+            }
+        }
+
+        // Use this if higher priority
+        if ((dir->queue.priority < priority)
+            || ((dir->queue.priority == priority)
+                && ((int) (dir->dir.refresh - dir->queue.time) < 0)))
+        {
+            dir->queue.list = TRUE;
+            dir->queue.priority = priority;
+            dir->queue.time = dir->dir.refresh;
+        }
+    }
+
+    // Update the queue
+    if (dir->queue.priority == CACHE_PRIORITY_NONE) cache_queue_remove(dir);
+    else if (dir->queue.index) cache_queue_sift(dir);
+    else
+    {
+        // Enlarge the queue if necessary
+        if (cache_queue_size <= cache_queue_used)
+        {
+            bits size = cache_queue_size
+                        ? cache_queue_size * 2 : CACHE_QUEUE_MIN;
+            cache_dir **queue;
+
+            queue = (cache_dir **) MEM_REALLOC(cache_queue,
+                                               size * sizeof(cache_dir *));
+            if (!queue) err = &err_buffer;
+            else
+            {
+                cache_queue = queue;
+                cache_queue_size = size;
+            }
+        }
+
+        // Add the entry to the tail of the queue
+        if (!err)
+        {
+            cache_queue_set(cache_queue_used++, dir);
+            cache_queue_sift(dir);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : dir           - The directory entry that has changed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Update the queue after the status of the specified entry has
+                  been changed. This should be called whenever any of the
+                  flags or the refresh time that control background updates
+                  are modified.
+*/
+static os_error *cache_queue_update(cache_dir *dir)
+{
+    os_error *err = NULL;
+    cache_priority stale;
+
+    // Check whether the details of the object itself need updating
+    if (dir->required) stale = CACHE_PRIORITY_REQUIRED;
+    else if (!dir->valid) stale = CACHE_PRIORITY_INVALID;
+    else stale = CACHE_PRIORITY_NONE;
+
+    // Update the parent's count of entries needing updates if changed
+    if (dir->parent && (stale != dir->queue.stale))
+    {
+        if (dir->queue.stale != CACHE_PRIORITY_NONE) dir->parent->dir.stale--;
+        else dir->queue.since = util_time();
+        if (dir->queue.stale == CACHE_PRIORITY_REQUIRED)
+        {
+            dir->parent->dir.stale_required--;
+        }
+        if (stale != CACHE_PRIORITY_NONE) dir->parent->dir.stale++;
+        if (stale == CACHE_PRIORITY_REQUIRED)
         {
-            if (sizeof(str) <= (strlen(str) + strlen(dir->info.name) + 1))
-            {
-                err = &err_bad_name;
-            }
-            else
-            {
-                sprintf(strchr(str, '\0'), "%c%s",
-                        FS_CHAR_SEPARATOR, dir->info.name);
-            }
+            dir->parent->dir.stale_required++;
         }
-
-        // Set the result pointer
-        *path = !err ? str : NULL;
+        dir->queue.stale = stale;
+        err = cache_queue_key(dir->parent);
     }
+    else dir->queue.stale = stale;
+
+    // Reposition this entry
+    if (!err) err = cache_queue_key(dir);
 
     // Return any error produced
     return err;
 }
 
 /*
-    Parameters  : parent        - The parent of the directory to search.
-                  name          - The name to search for.
-                  prev          - Variable to receive a pointer to the entry
-                                  immediately preceding the first one after
-                                  the specified name.
+    Parameters  : dir           - The directory entry that has changed.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Attempt to find the specified directory entry, and return a
-                  pointer to the requested entry (or the preceding entry if not
-                  found).
+    Description : Update the queue for the specified entry and all of its
+                  children. This is required when a directory becomes
+                  readable, since entries below it may have been dropped from
+                  the queue while it was not.
 */
-static os_error *cache_dir_prev(const cache_dir *parent, const char *name,
-                                cache_dir **prev)
+static os_error *cache_queue_update_tree(cache_dir *dir)
 {
-    os_error *err = NULL;
+    os_error *err;
+    cache_dir *child;
 
-    // Check function parameters
-    if (!parent || !name || !prev) err = &err_bad_parms;
-    else
+    // Update this entry
+    err = cache_queue_update(dir);
+
+    // Recursively update any children
+    for (child = dir->dir.children; !err && child; child = child->next)
     {
-        cache_dir *ptr = parent->dir.children;
+        err = cache_queue_update_tree(child);
+    }
 
-        // Search the directory
-        *prev = NULL;
-        while (!err && ptr && (wildcard_cmp(ptr->info.name, name) <= 0))
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : dir           - The directory entry to check.
+    Returns     : bool          - Can the entry currently be updated.
+    Description : Check whether the specified entry is within a drive and
+                  directories whose contents are currently valid.
+*/
+static bool cache_queue_reachable(const cache_dir *dir)
+{
+    bool reachable = TRUE;
+
+    // Check all of the parent directories
+    while (reachable && dir->parent)
+    {
+        dir = dir->parent;
+        reachable = dir->dir.valid && !dir->dir.err;
+    }
+
+    // Check the drive containing the entry
+    if (reachable)
+    {
+        const cache_drive *drive = cache_drive_array;
+
+        while ((drive < cache_drive_array + 26) && (&drive->root != dir))
         {
-            // Advance to the next entry
-            *prev = ptr;
-            ptr = ptr->next;
+            drive++;
         }
+        reachable = (drive < cache_drive_array + 26)
+                    && drive->root.valid && !drive->root.err
+                    && drive->info.present;
     }
 
-    // Return any error produced
-    return err;
+    // Return the result
+    return reachable;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Empty the update queue and free the memory used.
+*/
+static void cache_queue_free(void)
+{
+    // Mark any remaining entries as not queued
+    while (cache_queue_used) cache_queue[--cache_queue_used]->queue.index = 0;
+
+    // Free the memory
+    if (cache_queue)
+    {
+        MEM_FREE(cache_queue);
+        cache_queue = NULL;
+        cache_queue_size = 0;
+    }
 }
 
 /*
@@ -741,14 +1553,7 @@ static os_error *cache_find_dir_entry(const char *path, bool required,
                 err = cache_find_dir(parent, required, &entry, dir);
 
                 // Find the required entry within the directory
-                if (!err && *dir)
-                {
-                    *dir = (*dir)->dir.children;
-                    while (*dir && wildcard_cmp((*dir)->info.name, leaf))
-                    {
-                        (*dir) = (*dir)->next;
-                    }
-                }
+                if (!err && *dir) *dir = cache_dir_lookup(*dir, leaf);
                 else *dir = NULL;
             }
         }
@@ -773,7 +1578,11 @@ static os_error *cache_find_dir_entry(const char *path, bool required,
             {
                 // Directory entry not valid
                 if (valid) *valid = FALSE;
-                if (required) (*dir)->required = TRUE;
+                if (required)
+                {
+                    (*dir)->required = TRUE;
+                    err = cache_queue_update(*dir);
+                }
             }
             else
             {
@@ -842,13 +1651,18 @@ static os_error *cache_find_dir(const char *path, bool required, bool *valid,
                     (*dir)->dir.active = TRUE;
                     (*dir)->dir.required = TRUE;
                     (*dir)->dir.valid = FALSE;
+                    err = cache_queue_update(*dir);
                 }
             }
             else if (!(*dir)->dir.valid)
             {
                 // Subdirectory is not valid
                 if (valid) *valid = FALSE;
-                if (required) (*dir)->dir.required = TRUE;
+                if (required)
+                {
+                    (*dir)->dir.required = TRUE;
+                    err = cache_queue_update(*dir);
+                }
             }
             else if ((*dir)->dir.err)
             {
@@ -876,13 +1690,18 @@ static os_error *cache_find_dir(const char *path, bool required, bool *valid,
                                 child->dir.active = TRUE;
                                 child->dir.required = FALSE;
                                 child->dir.valid = FALSE;
+                                err = cache_queue_update(child);
                             }
                         }
                     }
                     else
                     {
                         if (valid) *valid = FALSE;
-                        if (required) child->required = TRUE;
+                        if (required)
+                        {
+                            child->required = TRUE;
+                            err = cache_queue_update(child);
+                        }
                     }
 
                     // Advance to the next child
@@ -930,7 +1749,20 @@ static os_error *cache_dir_remove(cache_dir *dir)
             err = cache_dir_remove(dir->dir.children);
         }
 
+        // Remove from the update queue
+        cache_queue_remove(dir);
+        if (dir->parent && (dir->queue.stale != CACHE_PRIORITY_NONE))
+        {
+            dir->parent->dir.stale--;
+            if (dir->queue.stale == CACHE_PRIORITY_REQUIRED)
+            {
+                dir->parent->dir.stale_required--;
+            }
+            err = cache_queue_key(dir->parent);
+        }
+
         // Unlink from any siblings or parent
+        if (dir->parent) cache_dir_hash_remove(dir->parent, dir);
         if (dir->next) dir->next->prev = dir->prev;
         if (dir->prev) dir->prev->next = dir->next;
         else if (dir->parent) dir->parent->dir.children = dir->next;
@@ -1004,6 +1836,14 @@ static os_error *cache_dir_add(cache_dir *parent, const fs_info *info,
             ptr->dir.required = FALSE;
             ptr->dir.valid = FALSE;
             ptr->dir.children = NULL;
+            ptr->dir.hash = NULL;
+            ptr->dir.hash_size = 0;
+            ptr->dir.entries = 0;
+            ptr->dir.stale = 0;
+            ptr->dir.stale_required = 0;
+            ptr->dir.refresh = util_time();
+            ptr->queue.index = 0;
+            ptr->queue.stale = CACHE_PRIORITY_NONE;
 
             // Find the entry immediately before this
             err = cache_dir_prev(parent, info->name, &prev);
@@ -1024,6 +1864,7 @@ static os_error *cache_dir_add(cache_dir *parent, const fs_info *info,
                     ptr->next = parent->dir.children;
                     parent->dir.children = ptr;
                 }
+                cache_dir_hash_add(parent, ptr);
             }
 
             // Add back to the free list if any error
@@ -1095,27 +1936,401 @@ static os_error *cache_invalidate_all(void)
         {
             const char *path;
 
-            err = cache_dir_name(&drive->root, &path, TRUE, TRUE);
-            if (!err) err = upcall_removed(path, &drive->root.info);
-        }
+            err = cache_dir_name(&drive->root, &path, TRUE, TRUE);
+            if (!err) err = upcall_removed(path, &drive->root.info);
+        }
+
+        // Invalidate this drive if successful
+        if (!err)
+        {
+            // Invalidate the drive details
+            drive->root.required = FALSE;
+            drive->root.valid = FALSE;
+
+            // Invalidate the root directory details
+            drive->root.dir.active = FALSE;
+            drive->root.dir.required = FALSE;
+            drive->root.dir.valid = FALSE;
+            cache_queue_remove(&drive->root);
+        }
+
+        // Remove any directory entries
+        while (!err && drive->root.dir.children)
+        {
+            err = cache_dir_remove(drive->root.dir.children);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : file          - Handle of the file to write.
+                  data          - The data to write.
+                  size          - The number of bytes to write.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Write data to a saved copy of the directory cache.
+*/
+static os_error *cache_store_write(os_fw file, const void *data, bits size)
+{
+    os_error *err;
+    int unwritten;
+
+    // Attempt to write the data
+    err = xosgbpb_writew(file, (const byte *) data, size, &unwritten);
+    if (!err && unwritten) err = &err_eof;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : file          - Handle of the file to read.
+                  data          - Buffer to receive the data.
+                  size          - The number of bytes to read.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Read data from a saved copy of the directory cache.
+*/
+static os_error *cache_store_read(os_fw file, void *data, bits size)
+{
+    os_error *err;
+    int unread;
+
+    // Attempt to read the data
+    err = xosgbpb_readw(file, (byte *) data, size, &unread);
+    if (!err && unread) err = &err_eof;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : dir           - The directory to check.
+    Returns     : bits          - The number of entries to save, or
+                                  CACHE_STORE_UNLISTED if the directory
+                                  contents should not be saved.
+    Description : Count the directory entries that should be saved.
+*/
+static bits cache_store_count(const cache_dir *dir)
+{
+    bits entries = CACHE_STORE_UNLISTED;
+
+    // Only count entries if the directory listing is valid
+    if ((dir->info.obj_type == fileswitch_IS_DIR) && dir->dir.active
+        && dir->dir.valid && !dir->dir.err)
+    {
+        const cache_dir *ptr;
+
+        entries = 0;
+        for (ptr = dir->dir.children; ptr; ptr = ptr->next)
+        {
+            if (ptr->valid && !ptr->err) entries++;
+        }
+    }
+
+    // Return the result
+    return entries;
+}
+
+/*
+    Parameters  : file          - Handle of the file to write.
+                  dir           - The directory to save.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Save the entries of a directory, and recursively any valid
+                  subdirectory listings. The entries are written in reverse
+                  order so that each can be inserted at the start of the
+                  directory when restored.
+*/
+static os_error *cache_store_save_dir(os_fw file, const cache_dir *dir)
+{
+    os_error *err = NULL;
+    const cache_dir *ptr = dir->dir.children;
+
+    // Find the last entry
+    while (ptr && ptr->next) ptr = ptr->next;
+
+    // Save the entries in reverse order
+    while (!err && ptr)
+    {
+        if (ptr->valid && !ptr->err)
+        {
+            cache_store_entry entry;
+
+            // Write the entry details and name
+            entry.load_addr = ptr->info.load_addr;
+            entry.exec_addr = ptr->info.exec_addr;
+            entry.size = ptr->info.size;
+            entry.attr = ptr->info.attr;
+            entry.obj_type = ptr->info.obj_type;
+            entry.entries = cache_store_count(ptr);
+            entry.length = strlen(ptr->info.name);
+            err = cache_store_write(file, &entry, sizeof(entry));
+            if (!err)
+            {
+                err = cache_store_write(file, ptr->info.name, entry.length);
+            }
+
+            // Save any subdirectory contents
+            if (!err && (entry.entries != CACHE_STORE_UNLISTED))
+            {
+                err = cache_store_save_dir(file, ptr);
+            }
+        }
+
+        // Advance to the previous entry
+        ptr = ptr->prev;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : file          - Handle of the file to read.
+                  dir           - The directory to add the entries to, or
+                                  NULL if they should be skipped.
+                  entries       - The number of entries to read.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Restore the entries of a directory, and recursively any
+                  saved subdirectory listings. Restored listings are marked
+                  as valid but due for an immediate refresh.
+*/
+static os_error *cache_store_load_dir(os_fw file, cache_dir *dir, bits entries)
+{
+    os_error *err = NULL;
+
+    // Read all of the entries
+    while (!err && entries--)
+    {
+        cache_store_entry entry;
+        fs_info info;
+        cache_dir *ptr = NULL;
+
+        // Read the entry details and name
+        err = cache_store_read(file, &entry, sizeof(entry));
+        if (!err && (sizeof(info.name) <= entry.length)) err = &err_bad_name;
+        if (!err) err = cache_store_read(file, info.name, entry.length);
+        if (!err)
+        {
+            info.name[entry.length] = '\0';
+            info.load_addr = entry.load_addr;
+            info.exec_addr = entry.exec_addr;
+            info.size = entry.size;
+            info.attr = entry.attr;
+            info.obj_type = entry.obj_type;
+        }
+
+        // Add the entry to the directory
+        if (!err && dir) err = cache_dir_add(dir, &info, &ptr);
+
+        // Restore any subdirectory contents
+        if (!err && (entry.entries != CACHE_STORE_UNLISTED))
+        {
+            if (ptr)
+            {
+                ptr->dir.active = TRUE;
+                ptr->dir.required = FALSE;
+                ptr->dir.valid = TRUE;
+                ptr->dir.err = NULL;
+                ptr->dir.refresh = util_time();
+                err = cache_queue_update(ptr);
+            }
+            if (!err) err = cache_store_load_dir(file, ptr, entry.entries);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : name          - Variable to receive a pointer to the name.
+    Returns     : void
+    Description : Construct the name of the saved directory cache for the
+                  currently connected machine.
+*/
+static void cache_store_name(const char **name)
+{
+    static fs_pathname path;
+
+    // Construct the name
+    sprintf(path, CACHE_STORE_PATH "M%08X%08X",
+            cache_machine_id.high, cache_machine_id.low);
+
+    // Set the return value
+    *name = path;
+}
+
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Save the directory details for all drives of the connected
+                  machine, so that they can be restored after a reconnection.
+*/
+static os_error *cache_store_save(void)
+{
+    os_error *err = NULL;
+
+    // Only save the details if the machine can be identified
+    if (cache_machine_valid && !cache_machine_err
+        && (cache_machine_id.low || cache_machine_id.high))
+    {
+        const char *name;
+        os_fw file = 0;
+        cache_store_header header;
+        int i;
+
+        DEBUG_PRINTF(("Saving directory cache"))
+
+        // Ensure that the directory exists
+        err = xosfile_create_dir(CACHE_STORE_DIR, 0);
+        if (!err) err = xosfile_create_dir(CACHE_STORE_SUBDIR, 0);
+
+        // Create the file
+        cache_store_name(&name);
+        if (!err) err = xosfind_openoutw(osfind_NO_PATH | osfind_ERROR_IF_DIR,
+                                         name, NULL, &file);
+        if (!err && !file) err = &err_not_found;
+
+        // Write the header
+        if (!err)
+        {
+            header.magic = CACHE_STORE_MAGIC;
+            header.version = CACHE_STORE_VERSION;
+            header.id = cache_machine_id;
+            err = cache_store_write(file, &header, sizeof(header));
+        }
+
+        // Write the details for each drive
+        for (i = 0; !err && (i <= 26); i++)
+        {
+            cache_store_drive drive;
+
+            // Check whether there are any details to save
+            drive.drive = i < 26 ? 'A' + i : 0;
+            drive.entries = CACHE_STORE_UNLISTED;
+            if (drive.drive && cache_drive_array[i].info.present
+                && cache_drive_array[i].root.valid
+                && !cache_drive_array[i].root.err)
+            {
+                drive.id = cache_drive_array[i].info.id;
+                drive.entries = cache_store_count(&cache_drive_array[i].root);
+            }
+
+            // Write the drive details followed by the directory tree
+            if (!drive.drive || (drive.entries != CACHE_STORE_UNLISTED))
+            {
+                err = cache_store_write(file, &drive, sizeof(drive));
+            }
+            if (!err && drive.drive && (drive.entries != CACHE_STORE_UNLISTED))
+            {
+                err = cache_store_save_dir(file, &cache_drive_array[i].root);
+            }
+        }
+
+        // Close the file, and delete it if incomplete
+        if (file) xosfind_closew(file);
+        if (err && file)
+        {
+            xosfscontrol_wipe(name, osfscontrol_WIPE_FORCE, 0, 0, 0, 0);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : drive         - The drive to restore.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Restore any saved directory details for the specified drive
+                  if its root directory has just been activated. The details
+                  are only used if both the machine and drive match.
+*/
+static os_error *cache_store_restore(cache_drive *drive)
+{
+    os_error *err = NULL;
+
+    // Check that the root directory is waiting to be read
+    if (cache_machine_valid && !cache_machine_err
+        && (cache_machine_id.low || cache_machine_id.high)
+        && drive->root.valid && !drive->root.err && drive->info.present
+        && drive->root.dir.active && !drive->root.dir.valid
+        && !drive->root.dir.children)
+    {
+        const char *name;
+        os_fw file;
+        cache_store_header header;
+        cache_store_drive saved;
+        bool found = FALSE;
+
+        // Attempt to open any saved details
+        cache_store_name(&name);
+        err = xosfind_openinw(osfind_NO_PATH | osfind_ERROR_IF_DIR,
+                              name, NULL, &file);
+        if (!err && file)
+        {
+            // Check that the header matches
+            saved.drive = 0;
+            err = cache_store_read(file, &header, sizeof(header));
+            if (!err && (header.magic == CACHE_STORE_MAGIC)
+                && (header.version == CACHE_STORE_VERSION)
+                && (header.id.low == cache_machine_id.low)
+                && (header.id.high == cache_machine_id.high))
+            {
+                // Read the details of the first drive
+                err = cache_store_read(file, &saved, sizeof(saved));
+            }
+
+            // Find the details for this drive
+            while (!err && saved.drive && !found)
+            {
+                found = (saved.drive == 'A' + (drive - cache_drive_array))
+                        && (saved.id == drive->info.id);
+                if (found)
+                {
+                    // Restore the directory tree
+                    err = cache_store_load_dir(file, &drive->root,
+                                               saved.entries);
+                }
+                else
+                {
+                    // Skip over this drive
+                    err = cache_store_load_dir(file, NULL, saved.entries);
+                    if (!err)
+                    {
+                        err = cache_store_read(file, &saved, sizeof(saved));
+                    }
+                }
+            }
+
+            // Close the file
+            xosfind_closew(file);
 
-        // Invalidate this drive if successful
-        if (!err)
-        {
-            // Invalidate the drive details
-            drive->root.required = FALSE;
-            drive->root.valid = FALSE;
+            // Mark the root directory as valid but needing a refresh
+            if (!err && found)
+            {
+                DEBUG_PRINTF(("Restored directory cache for drive '%c'", saved.drive))
 
-            // Invalidate the root directory details
-            drive->root.dir.active = FALSE;
-            drive->root.dir.required = FALSE;
-            drive->root.dir.valid = FALSE;
-        }
+                drive->root.dir.required = FALSE;
+                drive->root.dir.valid = TRUE;
+                drive->root.dir.err = NULL;
+                drive->root.dir.refresh = util_time();
+                err = cache_queue_update(&drive->root);
+            }
 
-        // Remove any directory entries
-        while (!err && drive->root.dir.children)
-        {
-            err = cache_dir_remove(drive->root.dir.children);
+            // Discard any partially restored details
+            while (err && drive->root.dir.children)
+            {
+                cache_dir_remove(drive->root.dir.children);
+            }
         }
     }
 
@@ -1301,6 +2516,10 @@ static os_error *cache_next_dir_update(cache_dir *dir, os_error *err,
             dir->valid = cache_active;
             dir->err = err;
             dir->info = *info;
+
+            // Reschedule any further updates, preserving any earlier error
+            if (err) cache_queue_update(dir);
+            else err = cache_queue_update(dir);
         }
     }
 
@@ -1327,6 +2546,7 @@ static os_error *cache_next_callback(void *user, os_error *err,
     {
         cache_dir *dir = NULL;
         cache_drive *drive = NULL;
+        bool reachable;
 
         // Clear the active flag
         cache_next_active = FALSE;
@@ -1342,6 +2562,8 @@ static os_error *cache_next_callback(void *user, os_error *err,
                 DEBUG_PRINTF(("Drive '%c'", cache_next_cmd.data.drive.drive))
                 DEBUG_ERR(err)
                 drive = &cache_drive_array[cache_next_cmd.data.drive.drive - 'A'];
+                reachable = drive->root.valid && !drive->root.err
+                            && drive->info.present;
                 drive->root.required = FALSE;
                 drive->root.valid = cache_active;
                 drive->root.err = err;
@@ -1370,6 +2592,9 @@ static os_error *cache_next_callback(void *user, os_error *err,
                         drive->root.dir.active = TRUE;
                         drive->root.dir.required = FALSE;
                         drive->root.dir.valid = FALSE;
+
+                        // Restore any saved contents, ignoring any error
+                        cache_store_restore(drive);
                     }
                 }
                 if (!drive->root.valid || drive->root.err
@@ -1387,6 +2612,15 @@ static os_error *cache_next_callback(void *user, os_error *err,
                         err = cache_dir_remove(drive->root.dir.children);
                     }
                 }
+
+                // Reschedule updates, including the contents if now readable
+                if (!err)
+                {
+                    err = !reachable && drive->root.valid && !drive->root.err
+                          && drive->info.present
+                          ? cache_queue_update_tree(&drive->root)
+                          : cache_queue_update(&drive->root);
+                }
                 break;
 
             case UNIFIED_LIST:
@@ -1403,6 +2637,7 @@ static os_error *cache_next_callback(void *user, os_error *err,
                          && dir)
                 {
                     // Update the parent entry details
+                    reachable = dir->dir.valid && !dir->dir.err;
                     dir->dir.required = FALSE;
                     dir->dir.valid = cache_active;
                     dir->dir.err = err;
@@ -1459,6 +2694,14 @@ static os_error *cache_next_callback(void *user, os_error *err,
                             }
                         }
                     }
+
+                    // Reschedule updates, including the contents if now valid
+                    if (err) cache_queue_update(dir);
+                    else if (!reachable && dir->dir.valid && !dir->dir.err)
+                    {
+                        err = cache_queue_update_tree(dir);
+                    }
+                    else err = cache_queue_update(dir);
                 }
                 break;
 
@@ -1479,7 +2722,11 @@ static os_error *cache_next_callback(void *user, os_error *err,
                     else
                     {
                         // Invalidate the parent if an error returned
-                        if (err && dir->parent) dir->parent->valid = FALSE;
+                        if (err && dir->parent)
+                        {
+                            dir->parent->valid = FALSE;
+                            cache_queue_update(dir->parent);
+                        }
 
                         // Update the directory entry details
                         err = cache_next_dir_update(dir, err, &cache_next_reply.info.info);
@@ -1499,6 +2746,13 @@ static os_error *cache_next_callback(void *user, os_error *err,
                     cache_machine_id = cache_next_reply.machine.id;
                     cache_machine_language = cache_next_reply.machine.language;
                     cache_machine_version = cache_next_reply.machine.version;
+
+                    // Restore any saved drive contents, ignoring any error
+                    for (drive = cache_drive_array;
+                         drive < cache_drive_array + 26; drive++)
+                    {
+                        cache_store_restore(drive);
+                    }
                 }
                 break;
 
@@ -1530,6 +2784,54 @@ static os_error *cache_next_callback(void *user, os_error *err,
                 cache_sync_err = err;
                 break;
 
+            case UNIFIED_SIZE:
+            case UNIFIED_SEEK:
+            case UNIFIED_WRITE:
+                // Flush buffered writes to an open file
+                if (cache_next_behind_handle != FS_NONE)
+                {
+                    fs_handle handle = cache_next_behind_handle;
+
+                    cache_next_behind_handle = FS_NONE;
+                    if (err)
+                    {
+                        // Discard the data and report the error later
+                        handle->behind.used = 0;
+                        handle->behind.err = err;
+                        err = NULL;
+                    }
+                    else cache_behind_reply(handle);
+                }
+                else if (!err) err = &err_bad_cache_op;
+                break;
+
+            case UNIFIED_READ:
+                // Read ahead from an open file
+                if (cache_next_ahead_handle != FS_NONE)
+                {
+                    fs_handle handle = cache_next_ahead_handle;
+
+                    cache_next_ahead_handle = FS_NONE;
+                    if (err)
+                    {
+                        // Abandon read-ahead for this file
+                        cache_ahead_discard(handle);
+                        err = NULL;
+                    }
+                    else
+                    {
+                        // Append the data to the buffer
+                        handle->ahead.used += cache_next_reply.read.length;
+                        handle->sequential += cache_next_reply.read.length;
+                        if (cache_next_reply.read.length
+                            < cache_next_cmd.data.read.length)
+                        {
+                            handle->ahead.stop = TRUE;
+                        }
+                    }
+                }
+                break;
+
             default:
                 // Not a supported command
                 if (!err) err = &err_bad_cache_op;
@@ -1721,86 +3023,88 @@ static os_error *cache_next_drive(void)
 }
 
 /*
-    Parameters  : dir           - The directory entry to check.
+    Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Check whether the specified directory (or any subdirectories)
-                  need updating.
+    Description : Check if any open files being read sequentially should have
+                  their read-ahead buffers refilled.
 */
-static os_error *cache_next_dir_recurse(cache_dir *dir)
+static os_error *cache_next_ahead(void)
 {
     os_error *err = NULL;
-    cache_priority priority;
+    fs_handle handle = cache_handle_active;
 
-    // First check the object if it is not the root directory
-    if (dir->parent)
+    // Check each open file in sequence
+    while (handle)
     {
-        // Choose the priority
-        if (dir->required) priority = CACHE_PRIORITY_REQUIRED;
-        else if (!dir->valid) priority = CACHE_PRIORITY_INVALID;
-        else priority = CACHE_PRIORITY_NONE;
+        bits end = handle->ahead.offset + handle->ahead.used;
 
-        // Check if highest priority
-        if (cache_next_compare(priority, cache_next_time))
+        // Only refill if the buffer is being consumed sequentially
+        if (handle->dir && handle->ahead.buffer && handle->ahead.used
+            && !handle->ahead.stop && (handle->sequential == end)
+            && (end < handle->info.extent)
+            && (handle->ahead.offset <= handle->ahead.next)
+            && (handle->ahead.next <= end)
+            && ((end - handle->ahead.next) < CACHE_AHEAD_REFILL)
+            && cache_next_compare(CACHE_PRIORITY_AHEAD, cache_next_time))
         {
-            const char *ptr;
+            bits consumed = handle->ahead.next - handle->ahead.offset;
 
-            // Build a possible command
-            err = cache_dir_name(dir, &ptr, FALSE, FALSE);
-            if (!err && (sizeof(cache_next_cmd.data.info.path) <= strlen(ptr)))
-            {
-                err = &err_bad_name;
-            }
-            if (!err)
+            // Discard the data that has already been read
+            if (consumed)
             {
-                cache_next_cmd.op = UNIFIED_INFO;
-                strcpy(cache_next_cmd.data.info.path, ptr);
+                handle->ahead.used -= consumed;
+                memmove(handle->ahead.buffer,
+                        handle->ahead.buffer + consumed, handle->ahead.used);
+                handle->ahead.offset = handle->ahead.next;
             }
+
+            // Build a possible command to fill the rest of the buffer
+            cache_next_ahead_handle = handle;
+            cache_next_cmd.op = UNIFIED_READ;
+            cache_next_cmd.data.read.handle = handle->handle;
+            cache_next_cmd.data.read.length = MIN(CACHE_AHEAD_SIZE - handle->ahead.used, handle->info.extent - end);
+            cache_next_cmd.data.read.buffer = handle->ahead.buffer + handle->ahead.used;
         }
+
+        // Advance to the next file
+        handle = handle->next;
     }
 
-    // Extra checks if the subdirectory is active
-    if (!err && (dir->info.obj_type == fileswitch_IS_DIR) && dir->dir.active)
-    {
-        // Choose the priority
-        if (dir->dir.required) priority = CACHE_PRIORITY_REQUIRED;
-        else if (!dir->dir.valid) priority = CACHE_PRIORITY_INVALID;
-        else priority = CACHE_PRIORITY_REFRESH;
+    // Return any error produced
+    return err;
+}
 
-        // Check if highest priority
-        if (cache_next_compare(priority, dir->dir.refresh))
-        {
-            const char *ptr;
+/*
+    Parameters  : void
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Check if any open files have write-behind buffers that should
+                  be flushed, either because they are full or because they
+                  have not been written to recently.
+*/
+static os_error *cache_next_behind(void)
+{
+    os_error *err = NULL;
+    fs_handle handle = cache_handle_active;
 
+    // Check each open file in sequence
+    while (handle)
+    {
+        // Only flush if full or the timeout has expired
+        if (handle->dir && handle->behind.used
+            && ((handle->behind.used == CACHE_BEHIND_SIZE)
+                || (0 <= (int) (cache_next_time - handle->behind.timeout)))
+            && cache_next_compare(CACHE_PRIORITY_BEHIND,
+                                  handle->behind.timeout))
+        {
             // Build a possible command
-            err = cache_dir_name(dir, &ptr, FALSE, FALSE);
-            if (!err && (sizeof(cache_next_cmd.data.list.path) <= strlen(ptr)))
-            {
-                err = &err_bad_name;
-            }
-            if (!err && !cache_buffer) err = cache_buffer_grow();
-            if (!err)
-            {
-                cache_next_cmd.op = UNIFIED_LIST;
-                strcpy(cache_next_cmd.data.list.path, ptr);
-                cache_next_cmd.data.list.buffer = cache_buffer;
-                cache_next_cmd.data.list.size = cache_buffer_size;
-            }
+            cache_next_behind_handle = handle;
+            cache_behind_cmd(handle);
         }
 
-        // Recurse through all children if valid
-        if (dir->dir.valid && !dir->dir.err)
-        {
-            dir = dir->dir.children;
-            while (!err && dir)
-            {
-                // Check this entry
-                err = cache_next_dir_recurse(dir);
-
-                // Advance to the next entry
-                dir = dir->next;
-            }
-        }
+        // Advance to the next file
+        handle = handle->next;
     }
 
     // Return any error produced
@@ -1811,22 +3115,73 @@ static os_error *cache_next_dir_recurse(cache_dir *dir)
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Check if any of the directory details need updating.
+    Description : Check if any of the directory details need updating. The
+                  entry at the head of the update queue is used, after
+                  discarding any within directories that cannot currently be
+                  read; those are queued again when the directory is read.
 */
 static os_error *cache_next_dir(void)
 {
     os_error *err = NULL;
-    int i;
+    cache_dir *dir = NULL;
 
-    // Check each drive in sequence
-    for (i = 0; !err && (i < 26); i++)
+    // Find the highest priority entry that can be updated
+    while (!dir && cache_queue_used)
     {
-        cache_drive *drive = &cache_drive_array[i];
+        dir = cache_queue[0];
+        if (!cache_queue_reachable(dir))
+        {
+            cache_queue_remove(dir);
+            dir = NULL;
+        }
+    }
+
+    // Check if highest priority
+    if (dir && cache_next_compare(dir->queue.priority, dir->queue.time))
+    {
+        const char *ptr;
+        bool list = dir->queue.list;
+
+        // List the parent instead if it is covering several entries
+        if (!list && dir->parent->dir.valid && !dir->parent->dir.err
+            && (CACHE_DIR_BATCH <= dir->parent->dir.stale))
+        {
+            dir = dir->parent;
+            list = TRUE;
+        }
 
-        // Check this directory if the drive is valid
-        if (drive->root.valid && !drive->root.err && drive->info.present)
+        // Build the command
+        err = cache_dir_name(dir, &ptr, FALSE, FALSE);
+        if (!list)
+        {
+            if (!err && (sizeof(cache_next_cmd.data.info.path) <= strlen(ptr)))
+            {
+                err = &err_bad_name;
+            }
+            if (!err)
+            {
+                cache_next_cmd.op = UNIFIED_INFO;
+                strcpy(cache_next_cmd.data.info.path, ptr);
+            }
+        }
+        else
         {
-            err = cache_next_dir_recurse(&drive->root);
+            if (!err && (sizeof(cache_next_cmd.data.list.path) <= strlen(ptr)))
+            {
+                err = &err_bad_name;
+            }
+            if (!err)
+            {
+                err = cache_buffer_reserve(dir->dir.entries
+                                           + CACHE_BUFFER_SPARE);
+            }
+            if (!err)
+            {
+                cache_next_cmd.op = UNIFIED_LIST;
+                strcpy(cache_next_cmd.data.list.path, ptr);
+                cache_next_cmd.data.list.buffer = cache_buffer;
+                cache_next_cmd.data.list.size = cache_buffer_size;
+            }
         }
     }
 
@@ -1858,6 +3213,10 @@ static os_error *cache_next_start(void)
     // No action if not connected or already active
     if (cache_active && !cache_next_active)
     {
+        // No file buffer operation selected yet
+        cache_next_ahead_handle = FS_NONE;
+        cache_next_behind_handle = FS_NONE;
+
         // Check whether the time needs to be synchronized
         err = cache_next_sync();
 
@@ -1876,6 +3235,12 @@ static os_error *cache_next_start(void)
         // Check whether the directory details need updating
         if (!err) err = cache_next_dir();
 
+        // Check whether any read-ahead buffers need refilling
+        if (!err) err = cache_next_ahead();
+
+        // Check whether any write-behind buffers need flushing
+        if (!err) err = cache_next_behind();
+
         // Ignore refresh requests if disabled
         if (cache_disable && (cache_next_priority == CACHE_PRIORITY_REFRESH))
         {
@@ -2147,6 +3512,14 @@ static os_error *cache_op_enumerate(cache_pending *op, os_error *err,
         }
         if (!err && *done)
         {
+            static const char any[] = {FS_CHAR_WILD_ANY, '\0'};
+            wildcard_pattern match;
+
+            // Prepare the pattern to match
+            wildcard_compile(*op->cmd->data.enumerate.match
+                             ? op->cmd->data.enumerate.match : any,
+                             &match);
+
             // Start from the first directory entry
             info = info->dir.children;
             op->reply->enumerate.offset = 0;
@@ -2156,12 +3529,8 @@ static os_error *cache_op_enumerate(cache_pending *op, os_error *err,
             while (!err && info && (op->reply->enumerate.read
                                     < op->cmd->data.enumerate.size))
             {
-                const char any[] = {FS_CHAR_WILD_ANY, '\0'};
-
                 // Check if the next entry matches
-                if (!wildcard_cmp(*op->cmd->data.enumerate.match
-                                  ? op->cmd->data.enumerate.match : any,
-                                  info->info.name))
+                if (wildcard_match(&match, info->info.name))
                 {
                     // Copy the entry if required
                     if (op->cmd->data.enumerate.offset
@@ -2319,6 +3688,7 @@ static os_error *cache_op_mkdir(cache_pending *op, os_error *err,
             if (!err)
             {
                 info->valid = FALSE;
+                err = cache_queue_update(info);
                 *done = FALSE;
             }
         }
@@ -2459,6 +3829,7 @@ static os_error *cache_op_remove(cache_pending *op, os_error *err,
             if (!err)
             {
                 info->valid = FALSE;
+                err = cache_queue_update(info);
                 op->state = CACHE_PENDING_STATE_DONE;
                 *done = FALSE;
             }
@@ -2576,6 +3947,11 @@ static os_error *cache_op_rename(cache_pending *op, os_error *err,
                     src->dir.required = FALSE;
                     src->dir.valid = FALSE;
                     src->dir.children = NULL;
+                    src->dir.hash = NULL;
+                    src->dir.hash_size = 0;
+                    src->dir.entries = 0;
+                    src->dir.stale = 0;
+                    src->dir.stale_required = 0;
                     for (ptr = dest->dir.children; ptr; ptr = ptr->next)
                     {
                         ptr->parent = dest;
@@ -2584,8 +3960,16 @@ static os_error *cache_op_rename(cache_pending *op, os_error *err,
             }
 
             // Invalidate the directory entries
-            if (src) src->valid = FALSE;
-            if (dest) dest->valid = FALSE;
+            if (src)
+            {
+                src->valid = FALSE;
+                err = cache_queue_update(src);
+            }
+            if (!err && dest)
+            {
+                dest->valid = FALSE;
+                err = cache_queue_update(dest);
+            }
             *done = FALSE;
         }
         else if (op->state == CACHE_PENDING_STATE_DONE)
@@ -2676,6 +4060,7 @@ static os_error *cache_op_access(cache_pending *op, os_error *err,
         {
             // The attributes should have been changed
             info->valid = FALSE;
+            err = cache_queue_update(info);
         }
         else if (idle)
         {
@@ -2752,6 +4137,7 @@ static os_error *cache_op_stamp(cache_pending *op, os_error *err,
         {
             // The attributes should have been changed
             info->valid = FALSE;
+            err = cache_queue_update(info);
         }
         else if (idle)
         {
@@ -2865,6 +4251,12 @@ static os_error *cache_op_open(cache_pending *op, os_error *err,
                                | fileswitch_ATTR_OWNER_WRITE
                                | fileswitch_ATTR_WORLD_WRITE;
                 handle->sequential = 0;
+                handle->ahead.buffer = NULL;
+                handle->ahead.next = 0;
+                cache_ahead_discard(handle);
+                handle->behind.buffer = NULL;
+                handle->behind.err = NULL;
+                cache_behind_free(handle);
             }
         }
         else handle = op->reply->open.handle;
@@ -3035,6 +4427,7 @@ static os_error *cache_op_open(cache_pending *op, os_error *err,
                     if (!err)
                     {
                         info->valid = FALSE;
+                        err = cache_queue_update(info);
                         *done = FALSE;
                     }
                 }
@@ -3222,15 +4615,23 @@ static os_error *cache_op_close(cache_pending *op, os_error *err,
                     || (handle->info.info & FS_FILE_INFO_WRITE_PERMITTED))
                 {
                     handle->dir->valid = FALSE;
+                    err = cache_queue_update(handle->dir);
                 }
                 handle->dir->open = NULL;
                 handle->dir = NULL;
 
+                // Release any read-ahead or write-behind buffers
+                cache_ahead_free(handle);
+                cache_behind_free(handle);
+
                 // Unlink from the active list
                 if (handle->next) handle->next->prev = handle->prev;
                 if (handle->prev) handle->prev->next = handle->next;
                 else cache_handle_active = handle->next;
 
+                // Report any error from an earlier background flush
+                if (handle->behind.err) err = handle->behind.err;
+
                 // Free the memory
                 MEM_FREE(handle);
 
@@ -3330,11 +4731,20 @@ static os_error *cache_op_read(cache_pending *op, os_error *err,
     else
     {
         fs_handle handle = op->cmd->data.read.handle;
+        bits offset = op->cmd->data.read.offset;
+        bits length = 0;
         bits read = 0;
 
         // Start by assuming that the operation can complete
         *done = TRUE;
 
+        // Limit the read to the extent of the file
+        if (handle->dir && (offset < handle->info.extent))
+        {
+            length = MIN(op->cmd->data.read.length,
+                         handle->info.extent - offset);
+        }
+
         // Take appropriate action
         if (err || !*done)
         {
@@ -3350,22 +4760,28 @@ static os_error *cache_op_read(cache_pending *op, os_error *err,
             // Not open for reading
             err = &err_access;
         }
-        else if ((handle->info.extent <= op->cmd->data.read.offset)
-                 || !op->cmd->data.read.length)
+        else if (!length)
         {
             // No data to read
         }
+        else if ((op->state == CACHE_PENDING_STATE_INITIAL)
+                 && cache_ahead_copy(handle, offset, length,
+                                     op->cmd->data.read.buffer))
+        {
+            // The data was already in the read-ahead buffer
+            read = length;
+        }
         else if (idle)
         {
             // Action depends on the current state
             if (op->state == CACHE_PENDING_STATE_INITIAL)
             {
                 // Set the file pointer if necessary
-                if (op->cmd->data.read.offset != handle->sequential)
+                if (offset != handle->sequential)
                 {
                     cache_next_cmd.op = UNIFIED_SEEK;
                     cache_next_cmd.data.seek.handle = handle->handle;
-                    cache_next_cmd.data.seek.offset = op->cmd->data.read.offset;
+                    cache_next_cmd.data.seek.offset = offset;
                     err = cache_op_back(op);
                     if (!err) *done = FALSE;
                 }
@@ -3376,13 +4792,34 @@ static os_error *cache_op_read(cache_pending *op, os_error *err,
             if (!err && *done && (op->state == CACHE_PENDING_STATE_READ))
             {
                 // Store the current sequential file pointer
-                handle->sequential = op->cmd->data.read.offset;
+                handle->sequential = offset;
+
+                // Read ahead if this continues a sequential access
+                cache_ahead_discard(handle);
+                if ((offset == handle->ahead.next)
+                    && (length < CACHE_AHEAD_SIZE)
+                    && (length < handle->info.extent - offset)
+                    && !handle->ahead.buffer)
+                {
+                    handle->ahead.buffer = (byte *) MEM_MALLOC(CACHE_AHEAD_SIZE);
+                }
 
                 // Read the requested data
                 cache_next_cmd.op = UNIFIED_READ;
                 cache_next_cmd.data.read.handle = handle->handle;
-                cache_next_cmd.data.read.length = MIN(op->cmd->data.read.length, handle->info.extent - op->cmd->data.read.offset);
-                cache_next_cmd.data.read.buffer = op->cmd->data.read.buffer;
+                if ((offset == handle->ahead.next)
+                    && (length < CACHE_AHEAD_SIZE)
+                    && handle->ahead.buffer)
+                {
+                    handle->ahead.offset = offset;
+                    cache_next_cmd.data.read.length = MIN(CACHE_AHEAD_SIZE, handle->info.extent - offset);
+                    cache_next_cmd.data.read.buffer = handle->ahead.buffer;
+                }
+                else
+                {
+                    cache_next_cmd.data.read.length = length;
+                    cache_next_cmd.data.read.buffer = op->cmd->data.read.buffer;
+                }
                 err = cache_op_back(op);
                 if (!err)
                 {
@@ -3395,6 +4832,17 @@ static os_error *cache_op_read(cache_pending *op, os_error *err,
                 // The read has completed
                 read = cache_next_reply.read.length;
                 handle->sequential += read;
+
+                // Copy the data if read into the read-ahead buffer
+                if (handle->ahead.buffer
+                    && (cache_next_cmd.data.read.buffer == handle->ahead.buffer))
+                {
+                    handle->ahead.used = read;
+                    read = MIN(read, length);
+                    memcpy(op->cmd->data.read.buffer, handle->ahead.buffer,
+                           read);
+                }
+                handle->ahead.next = offset + read;
             }
         }
         else
@@ -3453,6 +4901,13 @@ static os_error *cache_op_write(cache_pending *op, os_error *err,
             // Not open for writing
             err = &err_access;
         }
+        else if ((op->state == CACHE_PENDING_STATE_INITIAL)
+                 && cache_behind_merge(handle, op->cmd->data.write.offset,
+                                       op->cmd->data.write.length,
+                                       op->cmd->data.write.buffer))
+        {
+            // The data has been added to the write-behind buffer
+        }
         else if (idle)
         {
             // Action depends on the current state
@@ -3461,6 +4916,9 @@ static os_error *cache_op_write(cache_pending *op, os_error *err,
                 bits size = op->cmd->data.write.offset
                             + op->cmd->data.write.length;
 
+                // Discard any read-ahead data that may be overwritten
+                cache_ahead_discard(handle);
+
                 // Resize the file if necessary
                 if (handle->info.allocated < size)
                 {
@@ -3578,6 +5036,9 @@ static os_error *cache_op_zero(cache_pending *op, os_error *err,
                 bits size = op->cmd->data.zero.offset
                             + op->cmd->data.zero.length;
 
+                // Discard any read-ahead data that may be overwritten
+                cache_ahead_discard(handle);
+
                 // Resize the file if necessary
                 if (handle->info.allocated < size)
                 {
@@ -3767,6 +5228,9 @@ static os_error *cache_op_extent(cache_pending *op, os_error *err,
         {
             bits size = cache_round_allocated(op->cmd->data.extent.size);
 
+            // Discard any read-ahead data beyond the new extent
+            cache_ahead_discard(handle);
+
             // No action if size is already large enough
             if (handle->info.allocated < size)
             {
@@ -3944,6 +5408,158 @@ static os_error *cache_op_sequential(cache_pending *op, os_error *err,
     return err;
 }
 
+/*
+    Parameters  : op            - The operation to perform.
+                  err           - Any error received with the reply.
+                  reply         - Variable containing whether a reply has been
+                                  received for this operation. This is cleared
+                                  if the reply was for a flush command.
+                  idle          - Can a command be performed immediately.
+                  done          - Variable to receive whether the operation can
+                                  proceed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Flush any write-behind buffer that must be written before
+                  the specified operation can be performed. Operations that
+                  specify an object by name flush every open file in turn,
+                  since the object may be open through another handle; any
+                  error is then reported by the next use of that handle.
+*/
+static os_error *cache_op_behind(cache_pending *op, os_error *err,
+                                 bool *reply, bool idle, bool *done)
+{
+    // Check function parameters
+    if (!op || !reply || !done) err = &err_bad_parms;
+    else
+    {
+        fs_handle handle = FS_NONE;
+        bool required = TRUE;
+        bool path = FALSE;
+
+        // Start by assuming that the operation can proceed
+        *done = TRUE;
+
+        // Check whether this operation uses a file handle
+        switch (op->cmd->op)
+        {
+            case CACHE_READ:
+            case CACHE_ZERO:
+            case CACHE_ALLOCATED:
+            case CACHE_EXTENT:
+            case CACHE_FLUSH:
+            case CACHE_CLOSE:
+                // Any buffered data must be written first
+                handle = op->cmd->data.flush.handle;
+                break;
+
+            case CACHE_WRITE:
+                // Only flush if the data cannot be merged
+                handle = op->cmd->data.write.handle;
+                required = !cache_behind_fits(handle,
+                                              op->cmd->data.write.offset,
+                                              op->cmd->data.write.length);
+                break;
+
+            case CACHE_SEQUENTIAL:
+                // Only flush if moving away from the buffered data
+                handle = op->cmd->data.sequential.handle;
+                required = op->cmd->data.sequential.offset
+                           != handle->behind.offset + handle->behind.used;
+                break;
+
+            case CACHE_NAME:
+            case CACHE_ENUMERATE:
+            case CACHE_INFO:
+            case CACHE_MKDIR:
+            case CACHE_REMOVE:
+            case CACHE_RENAME:
+            case CACHE_ACCESS:
+            case CACHE_STAMP:
+            case CACHE_OPEN:
+                // Buffered data for every open file must be written first
+                path = TRUE;
+                handle = op->state == CACHE_PENDING_STATE_FLUSH
+                         ? cache_pending_behind_handle
+                         : cache_behind_dirty();
+                break;
+
+            default:
+                // Other operations are not affected
+                break;
+        }
+
+        // Handle the reply to any previous flush command
+        if ((handle != FS_NONE) && (op->state == CACHE_PENDING_STATE_FLUSH))
+        {
+            if (!err && *reply) cache_behind_reply(handle);
+            else
+            {
+                handle->behind.used = 0;
+
+                // Allow a close or a path based operation to complete
+                // before reporting the error against the file
+                if (err && ((op->cmd->op == CACHE_CLOSE)
+                            || (path && *reply)))
+                {
+                    if (!handle->behind.err) handle->behind.err = err;
+                    err = NULL;
+                }
+            }
+            *reply = FALSE;
+            op->state = CACHE_PENDING_STATE_INITIAL;
+
+            // Continue with any other open file for a path based operation
+            if (path) handle = cache_behind_dirty();
+        }
+        else if ((op->state == CACHE_PENDING_STATE_FLUSH) && path)
+        {
+            // The file was closed while being flushed
+            if (*reply) err = NULL;
+            *reply = FALSE;
+            op->state = CACHE_PENDING_STATE_INITIAL;
+            handle = cache_behind_dirty();
+        }
+
+        // Report any error from an earlier background flush (a close
+        // reports it after the file has been closed)
+        if (!err && (handle != FS_NONE) && handle->behind.err
+            && (op->cmd->op != CACHE_CLOSE) && !path)
+        {
+            err = handle->behind.err;
+            handle->behind.err = NULL;
+        }
+
+        // Flush the buffer if necessary
+        if (err || (handle == FS_NONE) || !handle->dir || !required
+            || (op->state != CACHE_PENDING_STATE_INITIAL))
+        {
+            // No flush required
+        }
+        else if (idle)
+        {
+            // Start the next flush command
+            if (cache_behind_cmd(handle))
+            {
+                err = cache_op_back(op);
+                if (!err)
+                {
+                    op->state = CACHE_PENDING_STATE_FLUSH;
+                    cache_pending_behind_handle = handle;
+                    *done = FALSE;
+                }
+            }
+        }
+        else if (handle->behind.used)
+        {
+            // Waiting for the link to become idle
+            *done = FALSE;
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : op            - The operation data.
                   err           - Any error to return.
@@ -4027,8 +5643,19 @@ static os_error *cache_process(void)
             cache_pending_err = NULL;
             cache_pending_reply = FALSE;
 
+            // Flush any buffered writes that would be affected
+            if (!cache_pending_cmd)
+            {
+                err = cache_op_behind(cache_pending_head, err, &reply,
+                                      !cache_next_active, &done);
+            }
+
             // Can only perform an operation if active
             if (cache_pending_cmd) done = FALSE;
+            else if (!done)
+            {
+                // Waiting for buffered writes to be flushed
+            }
             else
             {
                 // Perform an appropriate action
@@ -4510,7 +6137,12 @@ os_error *cache_recache(const char *path)
         if (!err && dir)
         {
             dir->required = TRUE;
-            if (dir->parent) dir->parent->required = TRUE;
+            err = cache_queue_update(dir);
+            if (!err && dir->parent)
+            {
+                dir->parent->required = TRUE;
+                err = cache_queue_update(dir->parent);
+            }
         }
     }
 
@@ -4608,6 +6240,9 @@ os_error *cache_end(bool now)
         // End higher levels
         err = cache_disconnect(now);
 
+        // Save the directory details, ignoring any error
+        if (!err) cache_store_save();
+
         // Invalidate all details
         if (!err) err = cache_invalidate_all();
 
@@ -4622,6 +6257,9 @@ os_error *cache_end(bool now)
 
         // Deallocate any buffer
         if (!err) err = cache_buffer_free();
+
+        // Discard the update queue
+        if (!err) cache_queue_free();
     }
 
     // Return any error produced
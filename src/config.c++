@@ -81,6 +81,7 @@ const char config_tag_clipboard_poll_content[] = "ClipboardPollContent";
 const char config_tag_idle_link[] = "IdleDisconnectRemoteLink";
 const char config_tag_idle_printer[] = "IdleDisconnectPrinterMirror";
 const char config_tag_idle_background[] = "IdleBackgroundThrottle";
+const char config_tag_link_window[] = "RemoteLinkWindow";
 const char config_tag_print_auto_print[] = "PrintJobAutoPrint";
 const char config_tag_print_auto_preview[] = "PrintJobAutoPreview";
 const char config_tag_print_preview_scale[] = "PrintJobPreviewScale";
@@ -186,6 +187,9 @@ void config_store::read()
     set_num(config_tag_idle_link, psifsget_idle_disconnect_link());
     set_num(config_tag_idle_printer, psifsget_idle_disconnect_printer());
     set_bool(config_tag_idle_background, psifsget_idle_background_throttle());
+
+    // Read the remote link transmit window
+    set_num(config_tag_link_window, psifsget_link_window());
 }
 
 /*
@@ -214,6 +218,7 @@ void config_store::write(bool report) const
     if (!err && exist(config_tag_idle_link)) err = xpsifsset_idle_disconnect_link(get_num(config_tag_idle_link));
     if (!err && exist(config_tag_idle_printer)) err = xpsifsset_idle_disconnect_printer(get_num(config_tag_idle_printer));
     if (!err && exist(config_tag_idle_background)) err = xpsifsset_idle_background_throttle(get_bool(config_tag_idle_background));
+    if (!err && exist(config_tag_link_window)) err = xpsifsset_link_window(get_num(config_tag_link_window));
 
     // Throw an error if required
     if (report && err) os_generate_error(err);
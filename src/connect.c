@@ -26,12 +26,17 @@
 
 // Include clib header files
 #include <stdio.h>
+#include <string.h>
+
+// Include oslib header files
+#include "oslib/macros.h"
 
 // Include project header files
 #include "debug.h"
 #include "err.h"
 #include "escape.h"
 #include "link.h"
+#include "mem.h"
 #include "mux.h"
 #include "pollword.h"
 #include "stats.h"
@@ -71,9 +76,25 @@ bool connect_era = FALSE;
 #define CONNECT_TIMEOUT_IDLE (100 * 60)
 #define CONNECT_TIMEOUT_RETRY_BYTES_SCALE (4)
 #define CONNECT_TIMEOUT_RETRY_OFFSET (20)
+#define CONNECT_TIMEOUT_RETRY_MARGIN (2)
+#define CONNECT_TIMEOUT_RETRY_MAX (400)
+#define CONNECT_TIMEOUT_BACKOFF_MAX (4)
 static bool connect_timer;
 static int connect_timeout;
 
+// Round trip time estimation, with the smoothed time scaled by 8 and the
+// mean deviation scaled by 4
+static bool connect_rtt_valid;
+static bool connect_rtt_timing;
+static bits connect_rtt_slot;
+static os_t connect_rtt_start;
+static int connect_rtt_smooth;
+static int connect_rtt_dev;
+static bits connect_rtt_backoff;
+bits connect_rtt = 0;
+bits connect_rtt_var = 0;
+bits connect_rto = 0;
+
 // Retry counter
 #define CONNECT_REQ_RETRIES (4)
 #define CONNECT_DATA_RETRIES (8)
@@ -84,22 +105,155 @@ static bits connect_retries;
 static bits connect_seq_tx;
 static bits connect_seq_rx;
 
-// Pending data and supervisory frames
-#define CONNECT_MAX_WINDOW_ERA (5) // Can be up to (32) if useful
+// Transmit window sizes
 #define CONNECT_MAX_WINDOW_SIBO (1)
-#define CONNECT_MAX_WINDOW (CONNECT_MAX_WINDOW_ERA)
+#define CONNECT_MIN_WINDOW (1)
+#define CONNECT_INITIAL_WINDOW (5)
+bits connect_window = CONNECT_DEFAULT_WINDOW;
+bits connect_window_active = 0;
+static bits connect_window_max;
+static bits connect_window_clean;
+
+// Transmit frame size
+#define CONNECT_LARGE_RETRIES (2)
+static bool connect_tx_large = TRUE;
+static bool connect_tx_acked;
+static bool connect_tx_large_acked;
+static bits connect_tx_large_retries;
+
+// Pending data and supervisory frames
 static bool connect_ctrl_pending;
 static frame_data connect_ctrl_frame;
 static bits connect_tx_data_pending;
 static bits connect_tx_data_head;
 static bits connect_tx_data_tail;
-static frame_data connect_tx_data_frame[CONNECT_MAX_WINDOW + 1];
+static bits connect_tx_data_sent;
+static bits connect_tx_data_size = 0;
+static frame_data *connect_tx_data_frame = NULL;
 static bool connect_rx_data_pending;
 static frame_data connect_rx_data_frame;
 
+// Selective retransmission of data frames
+static bool connect_tx_selective;
+static bool connect_tx_resending;
+static bits connect_tx_resend_span;
+
+// Data frames received out of sequence
+#define CONNECT_RX_BUFFER (4)
+static frame_data connect_rx_buffer[CONNECT_RX_BUFFER];
+static bool connect_rx_buffer_valid[CONNECT_RX_BUFFER];
+
 // Magic number for connection confirm
 static bits connect_magic;
 
+/*
+    Parameters  : window        - The maximum number of unacknowledged frames.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Ensure that the ring of transmitted frames is the correct
+                  size for the specified window. This must only be called
+                  when no frames are queued.
+*/
+static os_error *connect_alloc_tx_window(bits window)
+{
+    os_error *err = NULL;
+
+    // Restrict the window to the supported range
+    if (window < CONNECT_MIN_WINDOW) window = CONNECT_MIN_WINDOW;
+    if (CONNECT_MAX_WINDOW_ERA < window) window = CONNECT_MAX_WINDOW_ERA;
+
+    // Reallocate the ring if the size has changed
+    if (connect_tx_data_size != window + 1)
+    {
+        frame_data *ptr = (frame_data *) MEM_MALLOC((window + 1)
+                                                    * sizeof(frame_data));
+        if (ptr)
+        {
+            if (connect_tx_data_frame) MEM_FREE(connect_tx_data_frame);
+            connect_tx_data_frame = ptr;
+            connect_tx_data_size = window + 1;
+        }
+        else if (!connect_tx_data_frame) err = &err_buffer;
+    }
+
+    // The window is limited by the size of the ring actually available
+    connect_window_max = connect_tx_data_size ? connect_tx_data_size - 1 : 0;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Release the ring of transmitted frames.
+*/
+static void connect_free_tx_ring(void)
+{
+    // Free the ring if allocated
+    if (connect_tx_data_frame) MEM_FREE(connect_tx_data_frame);
+    connect_tx_data_frame = NULL;
+    connect_tx_data_size = 0;
+    connect_window_max = 0;
+    connect_window_active = 0;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Select the initial transmit window for a new connection.
+*/
+static void connect_open_tx_window(void)
+{
+    // SIBO devices only support a single outstanding frame
+    if (!connect_era) connect_window_active = CONNECT_MAX_WINDOW_SIBO;
+    else if (connect_window_max < CONNECT_INITIAL_WINDOW)
+    {
+        connect_window_active = connect_window_max;
+    }
+    else connect_window_active = CONNECT_INITIAL_WINDOW;
+    connect_window_clean = 0;
+}
+
+/*
+    Parameters  : acked         - The number of frames acknowledged.
+    Returns     : void
+    Description : Open the transmit window after a complete window of frames
+                  has been acknowledged without any retries.
+*/
+static void connect_grow_tx_window(bits acked)
+{
+    // No change for SIBO devices
+    if (connect_era)
+    {
+        connect_window_clean += acked;
+        if (connect_window_active <= connect_window_clean)
+        {
+            connect_window_clean = 0;
+            if (connect_window_active < connect_window_max)
+            {
+                connect_window_active++;
+            }
+        }
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Close the transmit window after a frame had to be retried.
+*/
+static void connect_shrink_tx_window(void)
+{
+    // Halve the window, but always allow at least one frame
+    connect_window_active /= 2;
+    if (connect_window_active < CONNECT_MIN_WINDOW)
+    {
+        connect_window_active = CONNECT_MIN_WINDOW;
+    }
+    connect_window_clean = 0;
+}
+
 /*
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -114,6 +268,12 @@ static os_error *connect_mux_connected(void)
     // No action if already connected
     if (!connect_connected)
     {
+        // Select the initial transmit window
+        connect_open_tx_window();
+        connect_tx_acked = FALSE;
+        connect_tx_large_acked = FALSE;
+        connect_tx_large_retries = 0;
+
         // Start by updating any relevant pollwords
         err = pollword_update(psifs_MASK_LINK_STATUS);
 
@@ -156,6 +316,80 @@ static os_error *connect_mux_disconnected(bool now)
     return err;
 }
 
+/*
+    Parameters  : void
+    Returns     : bits          - The maximum size of data frame to transmit.
+    Description : Return the maximum size of data frame that should be passed
+                  to connect_tx. Each connection starts with the standard size.
+                  After a frame has been acknowledged a single larger frame
+                  is tried for EPOC devices, with the full window only used
+                  for larger frames once one has been acknowledged. If larger
+                  frames are seen to cause repeated retries then the standard
+                  size is used until the link is restarted.
+*/
+bits connect_tx_max(void)
+{
+    bool large;
+
+    // Only probe with a larger frame when nothing else is outstanding
+    large = connect_era && !frame_phone && connect_tx_large && connect_tx_acked
+            && (connect_tx_large_acked
+                || (connect_tx_data_tail == connect_tx_data_head));
+
+    // Return the current limit
+    return large ? FRAME_MAX_DATA_TX_ERA : FRAME_MAX_DATA_TX;
+}
+
+/*
+    Parameters  : ptr   - A transmit window pointer.
+    Returns     : bits  - The next transmit window pointer.
+    Description : Increment a transmit window pointer.
+*/
+static bits connect_inc_tx_window(bits ptr)
+{
+    // Return the incremented sequence number
+    return (ptr + 1) % connect_tx_data_size;
+}
+
+/*
+    Parameters  : from  - The transmit window pointer before the first frame
+                          to check.
+                  to    - The transmit window pointer of the last frame to
+                          check.
+    Returns     : bool  - Are any of the frames larger than the standard size.
+    Description : Check whether a range of queued frames includes any larger
+                  frames.
+*/
+static bool connect_tx_large_range(bits from, bits to)
+{
+    bool large = FALSE;
+
+    // Check the size of each frame in the range
+    while (!large && (from != to))
+    {
+        from = connect_inc_tx_window(from);
+        large = FRAME_MAX_DATA_TX < connect_tx_data_frame[from].size;
+    }
+
+    // Return whether any larger frames were found
+    return large;
+}
+
+/*
+    Parameters  : void
+    Returns     : bits  - The size of frame to allow for in retry timeouts.
+    Description : Return the largest size of data frame that may be awaiting
+                  acknowledgement, including any larger frame being probed.
+*/
+static bits connect_tx_timeout_size(void)
+{
+    // Return the largest size that may be outstanding
+    if (frame_phone) return FRAME_MAX_DATA_RX;
+    return connect_tx_large_range(connect_tx_data_tail, connect_tx_data_head)
+           ? FRAME_MAX_DATA_TX_ERA
+           : connect_tx_max();
+}
+
 /*
     Parameters  : void
     Returns     : void
@@ -186,11 +420,34 @@ static void connect_timer_idle(void)
 */
 static void connect_timer_retry(void)
 {
+    int fixed;
     int timeout;
 
+    // Calculate the fixed timeout used without round trip time estimates
+    fixed = CONNECT_TIMEOUT_RETRY_OFFSET;
+    if (connect_connected)
+    {
+        fixed += link_time(connect_tx_timeout_size()
+                           * CONNECT_TIMEOUT_RETRY_BYTES_SCALE);
+    }
+
     // Calculate the required timeout
-    timeout = CONNECT_TIMEOUT_RETRY_OFFSET;
-    if (connect_connected) timeout += link_time((frame_phone ? FRAME_MAX_DATA_RX : FRAME_MAX_DATA_TX) * CONNECT_TIMEOUT_RETRY_BYTES_SCALE);
+    if (connect_connected && connect_rtt_valid)
+    {
+        // Allow for the variation in round trip time, but always leave
+        // time for at least one maximum size frame
+        timeout = (connect_rtt_smooth >> 3)
+                  + MAX(connect_rtt_dev,
+                        link_time(connect_tx_timeout_size())
+                        + CONNECT_TIMEOUT_RETRY_MARGIN);
+
+        // Back off exponentially after consecutive timeouts, but never
+        // limit the timeout to less than the fixed value for slow links
+        timeout = MIN(timeout << connect_rtt_backoff,
+                      MAX(CONNECT_TIMEOUT_RETRY_MAX, fixed));
+    }
+    else timeout = fixed;
+    connect_rto = timeout;
 
     // Start the timer
     connect_timeout = util_time() + timeout;
@@ -254,6 +511,124 @@ static void connect_tx_req_con(bits magic)
     connect_ctrl_pending = TRUE;
 }
 
+/*
+    Parameters  : ptr   - A transmit window pointer.
+    Returns     : bits  - The number of frames after the oldest unacknowledged
+                          frame.
+    Description : Calculate the position of a frame in the transmit window.
+*/
+static bits connect_tx_window_offset(bits ptr)
+{
+    // Return the offset from the tail
+    return (ptr + connect_tx_data_size - connect_tx_data_tail)
+           % connect_tx_data_size;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Reset the round trip time estimates for a new connection.
+*/
+static void connect_rtt_reset(void)
+{
+    // Discard any previous measurements
+    connect_rtt_valid = FALSE;
+    connect_rtt_timing = FALSE;
+    connect_rtt_backoff = 0;
+    connect_rtt = 0;
+    connect_rtt_var = 0;
+}
+
+/*
+    Parameters  : ptr   - The transmit window pointer of the frame being
+                          sent.
+    Returns     : void
+    Description : Record the transmission of a data frame. This starts timing
+                  the round trip for a frame if it has not been sent before
+                  and no other frame is being timed. Frames that are
+                  retransmitted are never timed, since it would not be
+                  possible to tell which transmission was acknowledged, but
+                  are included in the statistics instead.
+*/
+static void connect_tx_sent(bits ptr)
+{
+    // Check whether this is the first transmission of the frame
+    if (connect_tx_window_offset(connect_tx_data_sent)
+        < connect_tx_window_offset(ptr))
+    {
+        connect_tx_data_sent = ptr;
+        if (!connect_rtt_timing)
+        {
+            connect_rtt_timing = TRUE;
+            connect_rtt_slot = ptr;
+            connect_rtt_start = util_time();
+        }
+    }
+    else
+    {
+        stats_tx_resent_frame++;
+        stats_tx_resent_bytes += connect_tx_data_frame[ptr].size;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Update the round trip time estimates if the frame being
+                  timed has been acknowledged. This should be called after
+                  the tail of the transmit window has been advanced.
+*/
+static void connect_rtt_acked(void)
+{
+    bits head = connect_tx_window_offset(connect_tx_data_head);
+
+    // Keep the record of transmitted frames within the window
+    if (head < connect_tx_window_offset(connect_tx_data_sent))
+    {
+        connect_tx_data_sent = connect_tx_data_tail;
+    }
+
+    // Check whether the frame being timed has been acknowledged
+    if (connect_rtt_timing
+        && ((connect_rtt_slot == connect_tx_data_tail)
+            || (head < connect_tx_window_offset(connect_rtt_slot))))
+    {
+        int sample = util_time() - connect_rtt_start;
+
+        // Update the estimates
+        if (connect_rtt_valid)
+        {
+            int delta = sample - (connect_rtt_smooth >> 3);
+
+            connect_rtt_smooth += delta;
+            if (delta < 0) delta = -delta;
+            connect_rtt_dev += delta - (connect_rtt_dev >> 2);
+        }
+        else
+        {
+            connect_rtt_smooth = sample << 3;
+            connect_rtt_dev = sample << 1;
+            connect_rtt_valid = TRUE;
+        }
+        connect_rtt = connect_rtt_smooth >> 3;
+        connect_rtt_var = connect_rtt_dev >> 2;
+        connect_rtt_timing = FALSE;
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Discard any data frames received out of sequence.
+*/
+static void connect_rx_buffer_reset(void)
+{
+    bits i;
+
+    // Mark all of the entries as unused
+    for (i = 0; i < CONNECT_RX_BUFFER; i++) connect_rx_buffer_valid[i] = FALSE;
+}
+
 /*
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -281,7 +656,13 @@ static os_error *connect_reset(void)
     connect_tx_data_pending = 0;
     connect_tx_data_head = 0;
     connect_tx_data_tail = 0;
+    connect_tx_data_sent = 0;
+    connect_tx_selective = TRUE;
+    connect_tx_resending = FALSE;
     connect_rx_data_pending = FALSE;
+    connect_rx_buffer_reset();
+    connect_window_active = 0;
+    connect_rtt_reset();
 
     // Choose a magic number for connections
     connect_magic = util_time();
@@ -289,6 +670,9 @@ static os_error *connect_reset(void)
     // Ensure that the multiplexor is ended
     err = connect_mux_disconnected(TRUE);
 
+    // Size the transmit window for the next connection
+    if (!err) err = connect_alloc_tx_window(connect_window);
+
     // Return any error produced
     return err;
 }
@@ -308,14 +692,29 @@ static bits connect_inc_seq(bits seq)
 }
 
 /*
-    Parameters  : ptr   - A transmit window pointer.
-    Returns     : bits  - The next transmit window pointer.
-    Description : Increment a transmit window pointer.
+    Parameters  : void
+    Returns     : bool  - Is another received frame ready to be processed.
+    Description : Check for a buffered data frame that follows the one just
+                  passed to the multiplexor layer, and make it pending if
+                  found.
 */
-static bits connect_inc_tx_window(bits ptr)
+static bool connect_rx_buffer_next(void)
 {
-    // Return the incremented sequence number
-    return (ptr + 1) % (CONNECT_MAX_WINDOW + 1);
+    bits seq = connect_inc_seq(connect_rx_data_frame.seq);
+    bits index = seq % CONNECT_RX_BUFFER;
+    bool found = connect_rx_buffer_valid[index]
+                 && (connect_rx_buffer[index].seq == seq);
+
+    // Make the frame pending if found
+    if (found)
+    {
+        connect_rx_data_frame = connect_rx_buffer[index];
+        connect_rx_buffer_valid[index] = FALSE;
+        connect_rx_data_pending = TRUE;
+    }
+
+    // Return whether a frame was found
+    return found;
 }
 
 /*
@@ -325,12 +724,17 @@ static bits connect_inc_tx_window(bits ptr)
 */
 static bits connect_free_tx_window(void)
 {
+    bits used;
+
+    // No frames may be queued unless connected
+    if (!connect_connected) return 0;
+
+    // Count the number of unacknowledged frames
+    used = (connect_tx_data_head + connect_tx_data_size - connect_tx_data_tail)
+           % connect_tx_data_size;
+
     // Return the number of free frames
-    return connect_connected
-           ? (connect_era ? CONNECT_MAX_WINDOW_ERA : CONNECT_MAX_WINDOW_SIBO)
-             - ((connect_tx_data_head + CONNECT_MAX_WINDOW + 1
-                 - connect_tx_data_tail) % (CONNECT_MAX_WINDOW + 1))
-           : 0;
+    return used < connect_window_active ? connect_window_active - used : 0;
 }
 
 /*
@@ -363,6 +767,8 @@ static os_error *connect_poll_rx_ack(const frame_data *frame)
             // Acknowledge of a data frame
             {
                 bits tx = connect_tx_data_tail;
+                bits first = connect_tx_data_tail;
+                bits acked = 0;
                 bool pending = FALSE;
 
                 // Find a transmitted frame with a matching sequence number
@@ -372,11 +778,46 @@ static os_error *connect_poll_rx_ack(const frame_data *frame)
                     tx = connect_inc_tx_window(tx);
                     if (frame->seq == connect_tx_data_frame[tx].seq)
                     {
+                        acked += (tx + connect_tx_data_size
+                                  - connect_tx_data_tail)
+                                 % connect_tx_data_size;
                         connect_tx_data_tail = tx;
                         if (pending) connect_tx_data_pending = tx;
                     }
                 }
 
+                // Open the window if frames are being acknowledged cleanly
+                if (acked)
+                {
+                    connect_grow_tx_window(acked);
+                    if (connect_tx_large_range(first, connect_tx_data_tail))
+                    {
+                        connect_tx_large_acked = TRUE;
+                    }
+                    connect_tx_acked = TRUE;
+                    connect_tx_large_retries = 0;
+                    connect_rtt_backoff = 0;
+                    connect_rtt_acked();
+                }
+
+                // Check the result of retransmitting just the oldest frame
+                if (acked && connect_tx_resending)
+                {
+                    connect_tx_resending = FALSE;
+                    if (1 < acked)
+                    {
+                        // Later frames were kept, so were not resent
+                        stats_tx_skipped_frame
+                            += MIN(acked, connect_tx_resend_span) - 1;
+                    }
+                    else if (1 < connect_tx_resend_span)
+                    {
+                        // Later frames were discarded, so resend them all
+                        connect_tx_selective = FALSE;
+                        connect_tx_data_pending = connect_tx_data_tail;
+                    }
+                }
+
                 // Check if all frames have been acknowledged
                 if (connect_tx_data_tail == connect_tx_data_head)
                 {
@@ -610,19 +1051,56 @@ static os_error *connect_poll_rx_data(const frame_data *frame)
             // Data received
             if (frame->seq == connect_inc_seq(connect_seq_rx))
             {
+                bits index;
+
                 // The sequence number matches so data is valid
                 connect_seq_rx = frame->seq;
                 connect_rx_data_frame = *frame;
                 connect_rx_data_pending = TRUE;
+
+                // Include any buffered frames that follow this one
+                index = connect_inc_seq(connect_seq_rx) % CONNECT_RX_BUFFER;
+                while (connect_rx_buffer_valid[index]
+                       && (connect_rx_buffer[index].seq
+                           == connect_inc_seq(connect_seq_rx)))
+                {
+                    connect_seq_rx = connect_inc_seq(connect_seq_rx);
+                    index = connect_inc_seq(connect_seq_rx) % CONNECT_RX_BUFFER;
+                }
+
+                // Acknowledge all of the frames received
                 connect_tx_ack(connect_seq_rx);
                 if (connect_state == CONNECT_DATA) connect_timer_idle();
                 else connect_timer_retry();
             }
             else
             {
-                // Sequence number does not match so not valid
+                bits offset = (frame->seq + CONNECT_SEQ_DATA_PDU_NUM_ERA
+                               - connect_seq_rx)
+                              % CONNECT_SEQ_DATA_PDU_NUM_ERA;
+
+                // Keep a later frame until the missing ones arrive
+                if (connect_era && (2 <= offset)
+                    && (offset <= CONNECT_RX_BUFFER + 1))
+                {
+                    bits index = frame->seq % CONNECT_RX_BUFFER;
+
+                    if (!connect_rx_buffer_valid[index]
+                        || (connect_rx_buffer[index].seq != frame->seq))
+                    {
+                        connect_rx_buffer[index] = *frame;
+                        connect_rx_buffer_valid[index] = TRUE;
+                        stats_rx_buffered_frame++;
+                    }
+                }
+                else
+                {
+                    // Sequence number does not match so not valid
+                    stats_rx_retry_frame++;
+                }
+
+                // Acknowledge the last frame received in sequence
                 connect_tx_ack(connect_seq_rx);
-                stats_rx_retry_frame++;
             }
             break;
 
@@ -716,8 +1194,23 @@ static os_error *connect_poll_tx(void)
     }
     else if (connect_tx_data_pending != connect_tx_data_head)
     {
-        connect_tx_data_pending = connect_inc_tx_window(connect_tx_data_pending);
-        err = frame_send(&connect_tx_data_frame[connect_tx_data_pending]);
+        // Skip frames already sent after the oldest has been retransmitted
+        if (connect_tx_resending
+            && (connect_tx_data_pending != connect_tx_data_tail)
+            && (connect_tx_window_offset(connect_tx_data_pending)
+                < connect_tx_window_offset(connect_tx_data_sent)))
+        {
+            connect_tx_data_pending = connect_tx_data_sent;
+        }
+
+        // Send the next frame if any remain
+        if (connect_tx_data_pending != connect_tx_data_head)
+        {
+            connect_tx_data_pending
+                = connect_inc_tx_window(connect_tx_data_pending);
+            connect_tx_sent(connect_tx_data_pending);
+            err = frame_send(&connect_tx_data_frame[connect_tx_data_pending]);
+        }
     }
 
     // Return any error produced
@@ -791,8 +1284,31 @@ static os_error *connect_poll_timeout(void)
             if (--connect_retries)
             {
                 connect_tx_data_pending = connect_tx_data_tail;
+                connect_tx_resending = connect_era && connect_tx_selective;
+                connect_tx_resend_span
+                    = connect_tx_window_offset(connect_tx_data_sent);
+                connect_rtt_timing = FALSE;
+                if (connect_rtt_backoff < CONNECT_TIMEOUT_BACKOFF_MAX)
+                {
+                    connect_rtt_backoff++;
+                }
                 connect_timer_retry();
+                connect_shrink_tx_window();
                 stats_tx_retry_frame++;
+
+                // Revert to smaller frames if large ones keep failing
+                if (connect_tx_large
+                    && connect_tx_large_range(connect_tx_data_tail,
+                                              connect_tx_data_head)
+                    && (CONNECT_LARGE_RETRIES <= ++connect_tx_large_retries))
+                {
+                    DEBUG_PRINTF(("Reverting to %u byte transmit frames",
+                                  FRAME_MAX_DATA_TX))
+                    connect_tx_large = FALSE;
+
+                    // Allow the queued larger frames a full set of retries
+                    connect_retries = CONNECT_DATA_RETRIES;
+                }
             }
             else
             {
@@ -887,14 +1403,24 @@ os_error *connect_poll(bool active, const frame_data *rx_frame, bool tx_idle)
             // Poll the multiplexor layer if appropriate
             if (!err && connect_connected)
             {
-                // Perform the poll
-                err = mux_poll(connect_rx_data_pending
-                               ? &connect_rx_data_frame
-                               : NULL,
-                               0 < connect_free_tx_window());
-
-                // Clear any pending received frame
-                connect_rx_data_pending = FALSE;
+                bool more;
+
+                do
+                {
+                    // Perform the poll
+                    more = connect_rx_data_pending;
+                    err = mux_poll(connect_rx_data_pending
+                                   ? &connect_rx_data_frame
+                                   : NULL,
+                                   0 < connect_free_tx_window());
+
+                    // Clear any pending received frame
+                    connect_rx_data_pending = FALSE;
+
+                    // Pass on any buffered frames that follow it
+                    more = !err && more && connect_rx_buffer_next();
+                }
+                while (more);
             }
 
             // Handle any data to transmit
@@ -910,6 +1436,38 @@ os_error *connect_poll(bool active, const frame_data *rx_frame, bool tx_idle)
     return err;
 }
 
+/*
+    Parameters  : frame         - Variable to receive a pointer to the frame
+                                  buffer.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Obtain the transmit queue entry that will be used by the
+                  next call to connect_tx. The data can be written directly
+                  into this buffer and then passed to connect_tx to avoid
+                  copying it. An error is returned if either there is no
+                  connection or the transmit queue is full.
+*/
+os_error *connect_tx_buffer(frame_data **frame)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if (!frame) err = &err_bad_parms;
+    else if (!connect_active) err = &err_no_connect;
+    else if (!connect_connected) err = &err_not_connected;
+    else if (!connect_polled) err = &err_not_poll;
+    else if (connect_free_tx_window() == 0) err = &err_connection_busy;
+    else
+    {
+        // Return a pointer to the next queue entry
+        *frame = &connect_tx_data_frame[
+                     connect_inc_tx_window(connect_tx_data_head)];
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : frame         - The data to send.
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -929,10 +1487,17 @@ os_error *connect_tx(const frame_data *frame)
     else if (connect_free_tx_window() == 0) err = &err_connection_busy;
     else
     {
-        // Queue the specified frame
+        frame_data *queued;
+
+        // Queue the specified frame, copying it unless built in place
         connect_seq_tx = connect_inc_seq(connect_seq_tx);
         connect_tx_data_head = connect_inc_tx_window(connect_tx_data_head);
-        connect_tx_data_frame[connect_tx_data_head] = *frame;
+        queued = &connect_tx_data_frame[connect_tx_data_head];
+        if (queued != frame)
+        {
+            queued->size = frame->size;
+            memcpy(queued->data, frame->data, frame->size);
+        }
         connect_tx_data_frame[connect_tx_data_head].cont = CONNECT_CONT_DATA_PDU;
         connect_tx_data_frame[connect_tx_data_head].seq = connect_seq_tx;
         connect_timer_retry();
@@ -1009,6 +1574,9 @@ os_error *connect_start(void)
         // Reset the state machine
         if (!err) err = connect_reset();
 
+        // Try larger transmit frames again
+        connect_tx_large = TRUE;
+
         // Set the active flag and enable connections if successful
         if (!err)
         {
@@ -1052,8 +1620,12 @@ os_error *connect_end(bool now)
         // Perform a disconnect
         if (!now) err = connect_disconnect();
 
-        // Clear the active flag if successful
-        if (!err) connect_active = FALSE;
+        // Clear the active flag and release the window if successful
+        if (!err)
+        {
+            connect_active = FALSE;
+            connect_free_tx_ring();
+        }
     }
 
     // Return any error produced
@@ -1077,6 +1649,15 @@ os_error *connect_status(void)
     if (connect_connected)
     {
         printf("Connected to %s device.\n", connect_era ? "an EPOC" : "a SIBO");
+        printf("Transmit window %u of %u frames.\n",
+               connect_window_active, connect_window_max);
+        printf("Maximum transmit frame %u bytes.\n", connect_tx_max());
+        if (connect_rtt_valid)
+        {
+            printf("Round trip time %ucs, variation %ucs, "
+                   "retry timeout %ucs.\n",
+                   connect_rtt, connect_rtt_var, connect_rto);
+        }
         err = mux_status();
     }
     else if (connect_active)
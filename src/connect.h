@@ -33,6 +33,17 @@ extern bool connect_active;
 extern bool connect_connected;
 extern bool connect_era;
 
+// The maximum and current transmit window sizes
+#define CONNECT_DEFAULT_WINDOW (16)
+#define CONNECT_MAX_WINDOW_ERA (32)
+extern bits connect_window;
+extern bits connect_window_active;
+
+// Round trip time estimates and the current retry timeout in centiseconds
+extern bits connect_rtt;
+extern bits connect_rtt_var;
+extern bits connect_rto;
+
 #ifdef __cplusplus
     extern "C" {
 #endif
@@ -49,6 +60,32 @@ extern bool connect_era;
 */
 os_error *connect_poll(bool active, const frame_data *rx_frame, bool tx_idle);
 
+/*
+    Parameters  : void
+    Returns     : bits          - The maximum size of data frame to transmit.
+    Description : Return the maximum size of data frame that should be passed
+                  to connect_tx. Each connection starts with the standard size,
+                  with larger frames tried for EPOC devices once a frame has
+                  been acknowledged. Only a single larger frame is outstanding
+                  until one has been acknowledged. If larger frames are seen to
+                  cause repeated retries then the standard size is used until
+                  the link is restarted.
+*/
+bits connect_tx_max(void);
+
+/*
+    Parameters  : frame         - Variable to receive a pointer to the frame
+                                  buffer.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Obtain the transmit queue entry that will be used by the
+                  next call to connect_tx. The data can be written directly
+                  into this buffer and then passed to connect_tx to avoid
+                  copying it. An error is returned if either there is no
+                  connection or the transmit queue is full.
+*/
+os_error *connect_tx_buffer(frame_data **frame);
+
 /*
     Parameters  : frame         - The data to send.
     Returns     : os_error *    - Pointer to a corresponding error block, or
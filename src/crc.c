@@ -25,8 +25,9 @@
 // Include header file for this module
 #include "crc.h"
 
-// Table of values to calculate CRC efficiently
-static bits crc_table[256];
+// Tables of values to calculate CRC efficiently, four bytes at a time
+#define CRC_SLICES (4)
+static bits crc_table[CRC_SLICES][256];
 static bool crc_table_init = FALSE;
 
 // Polynomial X^16 + X^12 + X^5 + 1
@@ -48,13 +49,26 @@ void crc_reset(crc_state *crc)
         bits i;
 
         // Initialise the table
-        crc_table[0] = 0;
+        crc_table[0][0] = 0;
         for (i = 0; i < 128; i++)
         {
-            bool carry = crc_table[i] & 0x8000;
-            bits t = (crc_table[i] << 1) & 0xffff;
-            crc_table[i * 2 + (carry ? 0 : 1)] = t ^ crc_polynomial;
-            crc_table[i * 2 + (carry ? 1 : 0)] = t;
+            bool carry = crc_table[0][i] & 0x8000;
+            bits t = (crc_table[0][i] << 1) & 0xffff;
+            crc_table[0][i * 2 + (carry ? 0 : 1)] = t ^ crc_polynomial;
+            crc_table[0][i * 2 + (carry ? 1 : 0)] = t;
+        }
+
+        // Extend the table for each additional byte processed in parallel
+        for (i = 0; i < 256; i++)
+        {
+            bits j;
+
+            for (j = 1; j < CRC_SLICES; j++)
+            {
+                bits t = crc_table[j - 1][i];
+                crc_table[j][i] = ((t << 8) & 0xffff)
+                                  ^ crc_table[0][(t >> 8) & 0xff];
+            }
         }
 
         // Set the initialised flag
@@ -70,7 +84,42 @@ void crc_reset(crc_state *crc)
 void crc_update(crc_state *crc, byte value)
 {
     // Update the CRC with this value
-    *crc = (*crc << 8) ^ crc_table[((*crc >> 8) ^ value) & 0xff];
+    *crc = (*crc << 8) ^ crc_table[0][((*crc >> 8) ^ value) & 0xff];
+}
+
+/*
+    Parameters  : crc   - The CRC state to update.
+                  data  - Pointer to the values to add.
+                  size  - Number of values to add.
+    Returns     : void
+    Description : Update the specified CRC state with a block of values. This
+                  is equivalent to calling crc_update for each value in turn,
+                  but processes four bytes per iteration.
+*/
+void crc_update_block(crc_state *crc, const byte *data, bits size)
+{
+    bits value = *crc & 0xffff;
+
+    // Process four bytes at a time
+    while (CRC_SLICES <= size)
+    {
+        value = crc_table[3][((value >> 8) ^ data[0]) & 0xff]
+                ^ crc_table[2][(value ^ data[1]) & 0xff]
+                ^ crc_table[1][data[2]]
+                ^ crc_table[0][data[3]];
+        data += CRC_SLICES;
+        size -= CRC_SLICES;
+    }
+
+    // Process any remaining bytes individually
+    while (size--)
+    {
+        value = ((value << 8) & 0xffff)
+                ^ crc_table[0][((value >> 8) ^ *data++) & 0xff];
+    }
+
+    // Store the updated value
+    *crc = value;
 }
 
 /*
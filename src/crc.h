@@ -50,6 +50,17 @@ void crc_reset(crc_state *crc);
 */
 void crc_update(crc_state *crc, byte value);
 
+/*
+    Parameters  : crc   - The CRC state to update.
+                  data  - Pointer to the values to add.
+                  size  - Number of values to add.
+    Returns     : void
+    Description : Update the specified CRC state with a block of values. This
+                  is equivalent to calling crc_update for each value in turn,
+                  but processes four bytes per iteration.
+*/
+void crc_update_block(crc_state *crc, const byte *data, bits size);
+
 /*
     Parameters  : crc   - The CRC state to process
     Returns     : byte  - The low byte of the CRC value.
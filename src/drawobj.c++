@@ -57,6 +57,10 @@ static const double drawobj_ellipse_factor = 4.0 * (sqrt(2.0) - 1.0) / 3.0;
 // Length of program and group name fields
 #define DRAWOBJ_NAME_LENGTH (12)
 
+// Spatial index of group objects
+#define DRAWOBJ_INDEX_MIN (32)
+#define DRAWOBJ_INDEX_FANOUT (8)
+
 // Corrected options object structure
 struct drawobj_options_struct
 {
@@ -575,6 +579,9 @@ drawobj_group::drawobj_group() : drawobj_base(drawfile_TYPE_GROUP)
 {
     // Body is empty initially
     body_size = 0;
+
+    // No spatial index initially
+    indexed = FALSE;
 }
 
 /*
@@ -604,6 +611,7 @@ void drawobj_group::add(drawobj_base *obj)
     {
         // Add to the end of the list
         objects.push_back(obj);
+        indexed = FALSE;
 
         // Update the size of the group object
         body_size += obj->get_size();
@@ -631,11 +639,122 @@ os_error *drawobj_group::paint(render_control &info) const
     // No action unless the clip region overlaps the bounding box
     if (overlap(get_box(), info.clip))
     {
-        // Paint all of the nested objects
-        list_const_iterator<drawobj_base *> i;
-        for (i = objects.begin(); !err && (i != objects.end()); i++)
+        if (objects.size() < DRAWOBJ_INDEX_MIN)
+        {
+            // Paint all of the nested objects
+            list_const_iterator<drawobj_base *> i;
+            for (i = objects.begin(); !err && (i != objects.end()); i++)
+            {
+                err = (*i)->paint(info);
+            }
+        }
+        else
+        {
+            // Build the spatial index if objects have been added
+            if (!indexed) ((drawobj_group *) this)->build_index();
+
+            // Paint only the blocks that overlap the clip region
+            int top = index_levels.size() - 1;
+            int blocks = index_boxes.size() - index_levels[top];
+            for (int i = 0; !err && (i < blocks); i++)
+            {
+                err = paint_index(info, top, i);
+            }
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Build a hierarchy of bounding boxes over consecutive
+                  blocks of the nested objects, preserving the painting
+                  order.
+*/
+void drawobj_group::build_index()
+{
+    // Discard any previous index
+    index_objects = vector<drawobj_base *>();
+    index_boxes = vector<os_box>();
+    index_levels = vector<int>();
+
+    // Copy the nested objects to allow random access
+    index_objects.reserve(objects.size());
+    list_const_iterator<drawobj_base *> i;
+    for (i = objects.begin(); i != objects.end(); i++)
+    {
+        index_objects.push_back(*i);
+    }
+
+    // The lowest level bounds blocks of the nested objects
+    int count = index_objects.size();
+    index_levels.push_back(0);
+    for (int block = 0; block < count; block += DRAWOBJ_INDEX_FANOUT)
+    {
+        os_box box = {0, 0, 0, 0};
+        for (int j = block;
+             (j < block + DRAWOBJ_INDEX_FANOUT) && (j < count); j++)
+        {
+            box = combine(box, index_objects[j]->get_box());
+        }
+        index_boxes.push_back(box);
+    }
+
+    // Each higher level bounds blocks of the level below
+    while (DRAWOBJ_INDEX_FANOUT < index_boxes.size() - index_levels.back())
+    {
+        int first = index_levels.back();
+        int last = index_boxes.size();
+        index_levels.push_back(last);
+        for (int block = first; block < last; block += DRAWOBJ_INDEX_FANOUT)
+        {
+            os_box box = {0, 0, 0, 0};
+            for (int j = block;
+                 (j < block + DRAWOBJ_INDEX_FANOUT) && (j < last); j++)
+            {
+                box = combine(box, index_boxes[j]);
+            }
+            index_boxes.push_back(box);
+        }
+    }
+
+    // The index is now up to date
+    indexed = TRUE;
+}
+
+/*
+    Parameters  : info          - Information required for rendering.
+                  level         - The level of the block within the index.
+                  block         - The block number within that level.
+    Returns     : os_error *    - Pointer to a corresponding error
+                                  block, or NULL if no error.
+    Description : Render the nested objects within a block of the index if
+                  it overlaps the clip region.
+*/
+os_error *drawobj_group::paint_index(render_control &info, int level,
+                                     int block) const
+{
+    os_error *err = NULL;
+
+    // No action unless the clip region overlaps the block
+    if (overlap(index_boxes[index_levels[level] + block], info.clip))
+    {
+        // Find the range of entries within the block
+        int first = block * DRAWOBJ_INDEX_FANOUT;
+        int last = first + DRAWOBJ_INDEX_FANOUT;
+        int count = level
+                    ? index_levels[level] - index_levels[level - 1]
+                    : index_objects.size();
+        if (count < last) last = count;
+
+        // Paint the overlapping blocks or nested objects in order
+        for (int i = first; !err && (i < last); i++)
         {
-            err = (*i)->paint(info);
+            err = level ? paint_index(info, level - 1, i)
+                        : index_objects[i]->paint(info);
         }
     }
 
@@ -1458,6 +1577,10 @@ void drawobj_text::save(ostream &s, const transform &trfm) const
 drawobj_sprite::drawobj_sprite(int bpp, int width, int height)
 : drawobj_base(drawfile_TYPE_SPRITE)
 {
+    // Create the sprite data
+    ref = new ref_class;
+    vector<byte> &sprite = ref->sprite;
+
     // Choose the size of the palette and bitmap data
     int palette_entries = bpp <= 8 ? 1 << bpp : 0;
     int palette_size = palette_entries * sizeof(os_colour_pair);
@@ -1513,7 +1636,71 @@ drawobj_sprite::drawobj_sprite(int bpp, int width, int height)
 */
 drawobj_sprite::~drawobj_sprite()
 {
-    // No action required
+    // Decrement the reference count
+    ref->dec();
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Increment the reference count.
+*/
+void drawobj_sprite::ref_class::inc()
+{
+    // Just increment the reference count
+    count++;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Decrement the reference count.
+*/
+void drawobj_sprite::ref_class::dec()
+{
+    // Decrease the reference count and delete if appropriate
+    if (!--count) delete this;
+}
+
+/*
+    Parameters  : sprite        - The sprite to copy.
+    Returns     : -
+    Description : Constructor. The sprite data is shared rather than copied,
+                  so the palette and pixel data should be set before any
+                  copies are made.
+*/
+drawobj_sprite::drawobj_sprite(const drawobj_sprite &sprite)
+: drawobj_base(sprite)
+{
+    // Increase the reference count of the sprite data being shared
+    sprite.ref->inc();
+
+    // Copy the pointer to the reference counted details
+    ref = sprite.ref;
+}
+
+/*
+    Parameters  : sprite        - The sprite to copy.
+    Returns     : drawobj_sprite - A reference to this sprite.
+    Description : Sprite assignment. The sprite data is shared rather than
+                  copied.
+*/
+drawobj_sprite &drawobj_sprite::operator=(const drawobj_sprite &sprite)
+{
+    // Copy the base object details
+    drawobj_base::operator=(sprite);
+
+    // Increase the reference count of the sprite data being shared
+    sprite.ref->inc();
+
+    // Reduce the reference count of the previous sprite data
+    ref->dec();
+
+    // Copy the pointer to the reference counted details
+    ref = sprite.ref;
+
+    // Return a pointer to this sprite
+    return *this;
 }
 
 /*
@@ -1533,6 +1720,7 @@ void drawobj_sprite::set_box(const os_box &box)
 */
 void drawobj_sprite::set_palette(const vector<os_colour> &palette)
 {
+    vector<byte> &sprite = ref->sprite;
     osspriteop_header &header = *(osspriteop_header *) &sprite[0];
 
     // Get the size of the palette
@@ -1554,16 +1742,27 @@ void drawobj_sprite::set_palette(const vector<os_colour> &palette)
     Returns     : void
     Description : Set the pixel data for this sprite.
 */
-void drawobj_sprite::set_bitmap(const vector<byte> &bitmap)
+void drawobj_sprite::set_bitmap(const byte *bitmap, size_t size)
 {
+    vector<byte> &sprite = ref->sprite;
     osspriteop_header &header = *(osspriteop_header *) &sprite[0];
 
     // Choose the length of bitmap data to copy
-    int size = sprite.size() - header.image;
-    if (bitmap.size() < size) size = bitmap.size();
+    int available = sprite.size() - header.image;
+    if (available < size) size = available;
 
     // Copy the bitmap data
-    memcpy(&sprite[header.image], &bitmap[0], size);
+    if (size) memcpy(&sprite[header.image], bitmap, size);
+}
+
+/*
+    Parameters  : void
+    Returns     : bool          - Is this the only reference.
+    Description : Check whether the sprite data is shared.
+*/
+bool drawobj_sprite::unique() const
+{
+    return ref->count == 1;
 }
 
 /*
@@ -1579,7 +1778,7 @@ os_error *drawobj_sprite::paint(render_control &info) const
     // No action unless the clip region overlaps the bounding box
     if (overlap(get_box(), info.clip))
     {
-        osspriteop_header &header = *(osspriteop_header *) &sprite[0];
+        const vector<byte> &sprite = ref->sprite;
 
         // Transform the bounding box
         os_box box = info.trfm.to_internal()(get_box());
@@ -1620,7 +1819,7 @@ void drawobj_sprite::save(ostream &s, const transform &trfm) const
     save_header(s, trfm);
 
     // Write the bitmap data
-    s.write((const char *) &sprite[0], sprite.size());
+    s.write((const char *) &ref->sprite[0], ref->sprite.size());
 }
 
 /*
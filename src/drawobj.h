@@ -340,10 +340,35 @@ private:
 
     int body_size;                      // Size of this object's body
     list<drawobj_base *> objects;       // List of nested draw file objects
+    bool indexed;                       // Is the spatial index up to date
+    vector<drawobj_base *> index_objects; // Objects in painting order
+    vector<os_box> index_boxes;         // Bounding boxes of blocks of objects
+    vector<int> index_levels;           // Start of each level of blocks
 
     // Copying is not supported
     drawobj_group(const drawobj_group &obj);
     operator=(const drawobj_group &obj);
+
+    /*
+        Parameters  : void
+        Returns     : void
+        Description : Build a hierarchy of bounding boxes over consecutive
+                      blocks of the nested objects, preserving the painting
+                      order.
+    */
+    void build_index();
+
+    /*
+        Parameters  : info          - Information required for rendering.
+                      level         - The level of the block within the
+                                      index.
+                      block         - The block number within that level.
+        Returns     : os_error *    - Pointer to a corresponding error
+                                      block, or NULL if no error.
+        Description : Render the nested objects within a block of the index
+                      if it overlaps the clip region.
+    */
+    os_error *paint_index(render_control &info, int level, int block) const;
 };
 
 // A draw file clipping object
@@ -707,6 +732,35 @@ private:
 // A draw file bitmap object
 class drawobj_sprite : public drawobj_base
 {
+    // Reference counted details
+    struct ref_class
+    {
+        vector<byte> sprite;            // The sprite data
+        int count;                      // Number of references
+
+        /*
+            Parameters  : void
+            Returns     : -
+            Description : Constructor.
+        */
+        ref_class() : count(1) {}
+
+        /*
+            Parameters  : void
+            Returns     : void
+            Description : Increment the reference count.
+        */
+        void inc();
+
+        /*
+            Parameters  : void
+            Returns     : void
+            Description : Decrement the reference count.
+        */
+        void dec();
+    };
+    ref_class *ref;
+
 public:
 
     /*
@@ -718,6 +772,15 @@ public:
     */
     drawobj_sprite(int bpp, int width, int height);
 
+    /*
+        Parameters  : sprite        - The sprite to copy.
+        Returns     : -
+        Description : Constructor. The sprite data is shared rather than
+                      copied, so the palette and pixel data should be set
+                      before any copies are made.
+    */
+    drawobj_sprite(const drawobj_sprite &sprite);
+
     /*
         Parameters  : -
         Returns     : -
@@ -725,6 +788,14 @@ public:
     */
     ~drawobj_sprite();
 
+    /*
+        Parameters  : sprite        - The sprite to copy.
+        Returns     : drawobj_sprite - A reference to this sprite.
+        Description : Sprite assignment. The sprite data is shared rather
+                      than copied.
+    */
+    drawobj_sprite &operator=(const drawobj_sprite &sprite);
+
     /*
         Parameters  : box           - The bounding box for this object.
         Returns     : void
@@ -741,10 +812,18 @@ public:
 
     /*
         Parameters  : bitmap        - The pixel data.
+                      size          - Size of the pixel data.
         Returns     : void
         Description : Set the pixel data for this sprite.
     */
-    void set_bitmap(const vector<byte> &bitmap);
+    void set_bitmap(const byte *bitmap, size_t size);
+
+    /*
+        Parameters  : void
+        Returns     : bool          - Is this the only reference.
+        Description : Check whether the sprite data is shared.
+    */
+    bool unique() const;
 
     /*
         Parameters  : info          - Information required for rendering.
@@ -762,10 +841,6 @@ public:
         Description : Write this object to the stream.
     */
     virtual void save(ostream &s, const transform &trfm) const;
-
-private:
-
-    vector<byte> sprite;                // The sprite data
 };
 
 // A complete draw file
@@ -26,6 +26,10 @@
 
 // Include clib header files
 #include <stdio.h>
+#include <string.h>
+
+// Include oslib header files
+#include "oslib/macros.h"
 
 // Include project header files
 #include "connect.h"
@@ -80,11 +84,12 @@ static const char frame_phone_start[] = ""; /* Should be "AT*ESYN=1\r" */
 static const char *frame_phone_start_ptr;
 
 // Current transmitter state
+#define FRAME_MAX_ENCODED \
+    (sizeof(frame_phone_start) + 3 + 2 * (2 + FRAME_MAX_DATA) + 4)
 static frame_states frame_tx_state = FRAME_STATE_IDLE;
-static frame_data frame_tx_data;
-static crc_state frame_tx_crc;
-static int frame_tx_ptr;
-static byte frame_tx_stuff;
+static byte frame_tx_buffer[FRAME_MAX_ENCODED];
+static bits frame_tx_size;
+static bits frame_tx_ptr;
 
 // Current receiver state
 static frame_states frame_rx_state = FRAME_STATE_IDLE;
@@ -92,142 +97,150 @@ static frame_data frame_rx_data;
 static crc_state frame_rx_crc;
 
 /*
-    Parameters  : value         - Variable to receive the character to
-                                  transmit.
-    Returns     : os_error *    - Pointer to a corresponding error block, or
-                                  NULL if no error.
-    Description : Generate the next character to transmit, if any.
+    Parameters  : ptr           - Pointer to the buffer to receive the
+                                  stuffed data.
+                  data          - Pointer to the data to stuff.
+                  size          - Number of bytes of data.
+    Returns     : byte *        - Pointer to the end of the stuffed data.
+    Description : Copy data to a transmit buffer, stuffing any characters that
+                  have special meanings.
 */
-static os_error *frame_tx_byte(byte *value)
+static byte *frame_tx_stuff(byte *ptr, const byte *data, bits size)
 {
-    os_error *err = NULL;
-
-    // Action depends on the current transmitter state
-    switch (frame_tx_state)
+    // Copy each character, stuffing if required
+    while (size--)
     {
-        case FRAME_STATE_IDLE:
-            // No frame to send, so send a dummy NULL
-            *value = 0;
-            break;
-
-        case FRAME_STATE_START_SYN:
-            // Send SYN at start of the frame or AT sequence for EPOC phone
-            if (*frame_phone_start_ptr) *value = *frame_phone_start_ptr++;
-            else
-            {
-                *value = frame_phone ? FRAME_ETB : FRAME_SYN;
-                frame_tx_state = FRAME_STATE_START_DLE;
-            }
-            break;
+        byte value = *data++;
 
-        case FRAME_STATE_START_DLE:
-            // Send DLE at start of the frame
-            *value = FRAME_DLE;
-            frame_tx_state = FRAME_STATE_START_STX;
-            break;
-
-        case FRAME_STATE_START_STX:
-            // Send STX at start of the frame
-            *value = FRAME_STX;
-            crc_reset(&frame_tx_crc);
-            frame_tx_ptr = FRAME_PTR_CONT_SEQ;
-            frame_tx_state = FRAME_STATE_DATA;
-            break;
+        // Most characters can be copied without any checks
+        if ((FRAME_DC3 < value) || (value < FRAME_ETX)) *ptr++ = value;
+        else if (value == FRAME_DLE)
+        {
+            *ptr++ = FRAME_DLE;
+            *ptr++ = FRAME_DLE;
+        }
+        else if (connect_era && (value == FRAME_ETX))
+        {
+            *ptr++ = FRAME_DLE;
+            *ptr++ = FRAME_EOT;
+        }
+        else if (frame_phone && (value == FRAME_DC1))
+        {
+            *ptr++ = FRAME_DLE;
+            *ptr++ = FRAME_SPC;
+        }
+        else if (frame_phone && (value == FRAME_DC3))
+        {
+            *ptr++ = FRAME_DLE;
+            *ptr++ = FRAME_PNG;
+        }
+        else *ptr++ = value;
+    }
 
-        case FRAME_STATE_DATA:
-            // Send CONT/SEQ or data byte, or DLE at end of frame
-            if (frame_tx_ptr < frame_tx_data.size)
-            {
-                if (frame_tx_ptr == FRAME_PTR_CONT_SEQ)
-                {
-                    *value = frame_tx_data.cont << 4
-                             | frame_tx_data.seq & 0x07;
-                    if (frame_tx_data.seq < 8) frame_tx_ptr++;
-                    else *value |= 0x08;
-                }
-                else if (frame_tx_ptr == FRAME_PTR_CONT_SEQ_EXT)
-                {
-                    *value = (frame_tx_data.seq & 0x7F8) >> 3;
-                }
-                else *value = frame_tx_data.data[frame_tx_ptr];
-                frame_tx_ptr++;
-                crc_update(&frame_tx_crc, *value);
-                if ((*value == FRAME_DLE)
-                    || (connect_era && (*value == FRAME_ETX))
-                    || (frame_phone && ((*value == FRAME_DC1)
-                                        || (*value == FRAME_DC3))))
-                {
-                    frame_tx_stuff = *value;
-                    *value = FRAME_DLE;
-                    frame_tx_state = FRAME_STATE_DATA_STUFF;
-                }
-            }
-            else
-            {
-                *value = FRAME_DLE;
-                frame_tx_state = FRAME_STATE_END_ETX;
-            }
-            break;
+    // Return the updated pointer
+    return ptr;
+}
 
-        case FRAME_STATE_DATA_STUFF:
-            // Stuff the current CONT/SEQ or data byte
-            if (frame_tx_stuff == FRAME_ETX) *value = FRAME_EOT;
-            else if (frame_tx_stuff == FRAME_DC1) *value = FRAME_SPC;
-            else if (frame_tx_stuff == FRAME_DC3) *value = FRAME_PNG;
-            else *value = frame_tx_stuff;
-            frame_tx_state = FRAME_STATE_DATA;
-            break;
+/*
+    Parameters  : frame         - The frame to encode.
+    Returns     : void
+    Description : Encode a complete frame, including the start and end
+                  sequences, CRC and any stuffing, into the transmit buffer.
+*/
+static void frame_tx_encode(const frame_data *frame)
+{
+    byte *ptr = frame_tx_buffer;
+    byte header[2];
+    bits header_size = 0;
+    crc_state crc;
+
+    // Start with any AT sequence for an EPOC phone
+    while (*frame_phone_start_ptr) *ptr++ = *frame_phone_start_ptr++;
+
+    // Send SYN, DLE and STX at the start of the frame
+    *ptr++ = frame_phone ? FRAME_ETB : FRAME_SYN;
+    *ptr++ = FRAME_DLE;
+    *ptr++ = FRAME_STX;
+
+    // Construct the CONT/SEQ bytes
+    header[header_size++] = (frame->cont << 4) | (frame->seq & 0x07)
+                            | (frame->seq < 8 ? 0 : 0x08);
+    if (8 <= frame->seq) header[header_size++] = (frame->seq & 0x7F8) >> 3;
+
+    // Calculate the CRC of the unstuffed CONT/SEQ and data bytes
+    crc_reset(&crc);
+    crc_update_block(&crc, header, header_size);
+    crc_update_block(&crc, frame->data, frame->size);
+
+    // Stuff the CONT/SEQ and data bytes
+    ptr = frame_tx_stuff(ptr, header, header_size);
+    ptr = frame_tx_stuff(ptr, frame->data, frame->size);
+
+    // Send DLE and ETX at the end of the frame, followed by the CRC
+    *ptr++ = FRAME_DLE;
+    *ptr++ = FRAME_ETX;
+    *ptr++ = crc_msb(&crc);
+    *ptr++ = crc_lsb(&crc);
+
+    // Start transmitting the encoded frame
+    frame_tx_size = ptr - frame_tx_buffer;
+    frame_tx_ptr = 0;
+    frame_tx_state = FRAME_STATE_DATA;
+}
 
-        case FRAME_STATE_END_ETX:
-            // Send the ETX at end of the frame
-            *value = FRAME_ETX;
-            frame_tx_state = FRAME_STATE_END_CRC_HIGH;
-            break;
+/*
+    Parameters  : buffer        - Buffer to receive the characters to
+                                  transmit.
+                  size          - Size of the buffer.
+    Returns     : bits          - The number of characters placed in the
+                                  buffer.
+    Description : Copy as much of the encoded frame being transmitted as
+                  possible to the specified buffer.
+*/
+static bits frame_tx_block(byte *buffer, bits size)
+{
+    bits used = 0;
 
-        case FRAME_STATE_END_CRC_HIGH:
-            // Send the high byte of the CRC value
-            *value = crc_msb(&frame_tx_crc);
-            frame_tx_state = FRAME_STATE_END_CRC_LOW;
-            break;
+    // No action unless a frame is being transmitted
+    if (frame_tx_state != FRAME_STATE_IDLE)
+    {
+        // Copy as much of the frame as possible
+        used = MIN(size, frame_tx_size - frame_tx_ptr);
+        memcpy(buffer, &frame_tx_buffer[frame_tx_ptr], used);
+        frame_tx_ptr += used;
 
-        case FRAME_STATE_END_CRC_LOW:
-            // Send the low byte of the CRC value
-            *value = crc_lsb(&frame_tx_crc);
+        // Check whether the frame has been completed
+        if (frame_tx_ptr == frame_tx_size)
+        {
             frame_tx_state = FRAME_STATE_IDLE;
             stats_tx_frame++;
-            break;
-
-        default:
-            // These states should never occur
-            *value = NULL;
-            frame_tx_state = FRAME_STATE_IDLE;
-            err = &err_bad_frame_state;
+        }
     }
 
-    // Return any error produced
-    return err;
+    // Return the number of characters copied
+    return used;
 }
 
 /*
     Parameters  : value - The unstuffed character.
     Returns     : void
     Description : Process a single received byte after any unstuffing has been
-                  performed.
+                  performed. The CRC of the data bytes is calculated when the
+                  end of the frame is reached.
 */
 static void frame_rx_byte_data(byte value)
 {
-    // Update the CRC value with this byte
-    crc_update(&frame_rx_crc, value);
-
     // Decode the CONT/SEQ byte or data
     if (frame_rx_data.size == FRAME_PTR_CONT_SEQ)
     {
+        crc_update(&frame_rx_crc, value);
         frame_rx_data.cont = (value & 0xf0) >> 4;
         frame_rx_data.seq = value & 0x07;
         if (!(value & 0x08)) frame_rx_data.size++;
     }
     else if (frame_rx_data.size == FRAME_PTR_CONT_SEQ_EXT)
     {
+        crc_update(&frame_rx_crc, value);
         frame_rx_data.seq |= value << 3;
     }
     else frame_rx_data.data[frame_rx_data.size] = value;
@@ -320,6 +333,8 @@ static os_error *frame_rx_byte(byte value)
             // Expecting stuffed CONT/SEQ or data byte, or ETX for frame end
             if ((0 <= frame_rx_data.size) && (value == FRAME_ETX))
             {
+                crc_update_block(&frame_rx_crc, frame_rx_data.data,
+                                 frame_rx_data.size);
                 frame_rx_state = FRAME_STATE_END_CRC_HIGH;
             }
             else
@@ -391,6 +406,50 @@ static os_error *frame_rx_byte(byte value)
     return err;
 }
 
+/*
+    Parameters  : data          - Pointer to the received characters.
+                  size          - Number of received characters.
+                  used          - Variable to receive the number of
+                                  characters processed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Update the frame receiver state machine with a block of
+                  received characters. Processing stops after the end of a
+                  complete frame so that it can be handled before the next
+                  frame is started. Runs of data characters that do not
+                  require unstuffing are copied directly.
+*/
+static os_error *frame_rx_block(const byte *data, bits size, bits *used)
+{
+    os_error *err = NULL;
+    bits i = 0;
+
+    // Process characters until a complete frame has been received
+    while (!err && (i < size) && (frame_rx_state != FRAME_STATE_IDLE))
+    {
+        // Copy any run of data characters directly
+        if ((frame_rx_state == FRAME_STATE_DATA) && (0 <= frame_rx_data.size))
+        {
+            bits limit = MIN(size - i, FRAME_MAX_DATA_RX - frame_rx_data.size);
+            bits run = 0;
+
+            while ((run < limit) && (data[i + run] != FRAME_DLE)) run++;
+            memcpy(&frame_rx_data.data[frame_rx_data.size], &data[i], run);
+            frame_rx_data.size += run;
+            i += run;
+        }
+
+        // Process the next character individually
+        if (i < size) err = frame_rx_byte(data[i++]);
+    }
+
+    // Return the number of characters processed
+    *used = i;
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : all           - Should all status be reset, or just the
                                   transmit status.
@@ -422,74 +481,129 @@ os_error *frame_reset(bool all)
 
 /*
     Parameters  : active        - Is the remote device present and active.
-                  rx            - The next received character, or negative if
-                                  none.
-                  tx            - Variable to receive a character to transmit,
-                                  or NULL if transmit buffer is full.
+                  rx            - Pointer to the received characters.
+                  rx_size       - Number of received characters.
+                  tx            - Buffer to receive characters to transmit.
+                  tx_size       - On entry the size of the transmit buffer,
+                                  and on exit the number of characters placed
+                                  in it.
                   idle          - Should idle polling of higher layers be
                                   performed.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Perform any polled actions required. This must only be called
-                  when a block driver is active and usable.
+    Description : Perform any polled actions required for a block of received
+                  characters, and generate as many characters to transmit as
+                  will fit in the buffer. All of the received characters are
+                  processed. This must only be called when a block driver is
+                  active and usable.
 */
-os_error *frame_poll(bool active, int rx, int *tx, bool idle)
+os_error *frame_poll_block(bool active, const byte *rx, bits rx_size,
+                           byte *tx, bits *tx_size, bool idle)
 {
     os_error *err = NULL;
+    bits tx_used = 0;
 
     // No action unless active
     if (frame_active)
     {
         static bool prev_tx_ready = FALSE;
-        bool tx_ready;
-        bool rx_ready;
+        bits rx_used = 0;
+        bool more = TRUE;
 
         // Set the polled status
         frame_polled = TRUE;
 
-        // Special case if not active
-        if (!active)
+        // Keep processing until all characters handled
+        while (!err && more)
         {
-            // Reset the state machines
-            err = frame_reset(TRUE);
-        }
-        else
-        {
-            // Handle any received character
-            if (0 <= rx) err = frame_rx_byte(rx);
+            bool tx_ready;
+            bool rx_ready;
 
-            // Transmit a pending character if possible
-            if (!err && tx && (frame_tx_state != FRAME_STATE_IDLE))
+            // Special case if not active
+            if (!active)
+            {
+                // Reset the state machines
+                err = frame_reset(TRUE);
+                rx_used = rx_size;
+            }
+            else
             {
-                byte value;
+                bits used;
+
+                // Handle any received characters
+                err = frame_rx_block(&rx[rx_used], rx_size - rx_used, &used);
+                rx_used += used;
 
-                err = frame_tx_byte(&value);
-                if (!err) *tx = value;
+                // Transmit pending characters if possible
+                if (!err)
+                {
+                    tx_used += frame_tx_block(&tx[tx_used], *tx_size - tx_used);
+                }
             }
-        }
 
-        // Check the transmit and receive status
-        tx_ready = active && (frame_tx_state == FRAME_STATE_IDLE);
-        rx_ready = frame_rx_state == FRAME_STATE_IDLE;
+            // Check the transmit and receive status
+            tx_ready = active && (frame_tx_state == FRAME_STATE_IDLE);
+            rx_ready = frame_rx_state == FRAME_STATE_IDLE;
 
-        // Poll the connection manager
-        if (!err && (rx_ready || (tx_ready && !prev_tx_ready) || idle))
-        {
-            // Perform the poll
-            err = connect_poll(active, rx_ready ? &frame_rx_data : NULL,
-                               tx_ready);
+            // Poll the connection manager
+            if (!err && (rx_ready || (tx_ready && !prev_tx_ready) || idle))
+            {
+                // Perform the poll
+                err = connect_poll(active, rx_ready ? &frame_rx_data : NULL,
+                                   tx_ready);
 
-            // Re-enable the receiver if necessary
-            if (rx_ready) frame_rx_state = FRAME_STATE_START_SYN;
+                // Re-enable the receiver if necessary
+                if (rx_ready) frame_rx_state = FRAME_STATE_START_SYN;
+
+                // Remember the transmitter status (which may have changed)
+                prev_tx_ready = active && (frame_tx_state == FRAME_STATE_IDLE);
+            }
 
-            // Remember the transmitter status (which may have changed)
-            prev_tx_ready = active && (frame_tx_state == FRAME_STATE_IDLE);
+            // Only perform idle polling once
+            idle = FALSE;
+
+            // Continue while there are characters to receive or transmit
+            more = (rx_used < rx_size)
+                   || (active && (tx_used < *tx_size)
+                       && (frame_tx_state != FRAME_STATE_IDLE));
         }
 
         // Clear the polled status
         frame_polled = FALSE;
     }
 
+    // Return the number of characters to transmit
+    *tx_size = tx_used;
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : active        - Is the remote device present and active.
+                  rx            - The next received character, or negative if
+                                  none.
+                  tx            - Variable to receive a character to transmit,
+                                  or NULL if transmit buffer is full.
+                  idle          - Should idle polling of higher layers be
+                                  performed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform any polled actions required. This must only be called
+                  when a block driver is active and usable.
+*/
+os_error *frame_poll(bool active, int rx, int *tx, bool idle)
+{
+    os_error *err = NULL;
+    byte rx_value = rx;
+    byte tx_value;
+    bits tx_size = tx ? 1 : 0;
+
+    // Process the single character as a block
+    err = frame_poll_block(active, &rx_value, 0 <= rx ? 1 : 0,
+                           &tx_value, &tx_size, idle);
+    if (!err && tx_size) *tx = tx_value;
+
     // Return any error produced
     return err;
 }
@@ -499,8 +613,8 @@ os_error *frame_poll(bool active, int rx, int *tx, bool idle)
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Abort transmission of any active frame, and transmit the
-                  specified message. The message is copied, so the original
-                  may be modified or transient.
+                  specified message. The message is encoded immediately, so the
+                  original may be modified or transient.
 */
 os_error *frame_send(const frame_data *frame)
 {
@@ -526,11 +640,8 @@ os_error *frame_send(const frame_data *frame)
         }
 #endif
 
-        // Copy the message data
-        frame_tx_data = *frame;
-
-        // Start the state machine
-        frame_tx_state = FRAME_STATE_START_SYN;
+        // Encode the message ready for transmission
+        frame_tx_encode(frame);
     }
 
     // Return any error produced
@@ -654,6 +765,10 @@ os_error *frame_status(void)
     {
         printf(", including %u retries", stats_rx_retry_frame);
     }
+    if (stats_rx_buffered_frame)
+    {
+        printf(", %u out of sequence", stats_rx_buffered_frame);
+    }
     printf(".\n");
     printf("%u frames transmitted", stats_tx_frame);
     if (stats_tx_retry_frame)
@@ -661,6 +776,12 @@ os_error *frame_status(void)
         printf(", including %u retries", stats_tx_retry_frame);
     }
     printf(".\n");
+    if (stats_tx_resent_frame || stats_tx_skipped_frame)
+    {
+        printf("%u data frames (%u bytes) resent and %u not resent.\n",
+               stats_tx_resent_frame, stats_tx_resent_bytes,
+               stats_tx_skipped_frame);
+    }
 
     // Just pass to the connection handler
     err = connect_status();
@@ -31,6 +31,7 @@
 // Frame sizes
 #define FRAME_MAX_DATA_RX (2048)
 #define FRAME_MAX_DATA_TX (300)
+#define FRAME_MAX_DATA_TX_ERA (FRAME_MAX_DATA_RX)
 #define FRAME_MAX_DATA (FRAME_MAX_DATA_RX)
 
 // Status of connection to EPOC mobile phone
@@ -75,6 +76,27 @@ os_error *frame_reset(bool all);
 */
 os_error *frame_poll(bool active, int rx, int *tx, bool idle);
 
+/*
+    Parameters  : active        - Is the remote device present and active.
+                  rx            - Pointer to the received characters.
+                  rx_size       - Number of received characters.
+                  tx            - Buffer to receive characters to transmit.
+                  tx_size       - On entry the size of the transmit buffer,
+                                  and on exit the number of characters placed
+                                  in it.
+                  idle          - Should idle polling of higher layers be
+                                  performed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform any polled actions required for a block of received
+                  characters, and generate as many characters to transmit as
+                  will fit in the buffer. All of the received characters are
+                  processed. This must only be called when a block driver is
+                  active and usable.
+*/
+os_error *frame_poll_block(bool active, const byte *rx, bits rx_size,
+                           byte *tx, bits *tx_size, bool idle);
+
 /*
     Parameters  : frame         - The message to send.
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -100,6 +100,13 @@ INSTANTIATE_LIST(printprwin_win *)
 #include "hvector.c++"
 INSTANTIATE_VECTOR(convobj_obj *)
 
+// Instantiate a vector of draw file objects
+INSTANTIATE_VECTOR(drawobj_base *)
+
+// Instantiate a vector of bounding boxes
+inline void destroy(os_box *) {}
+INSTANTIATE_VECTOR(os_box);
+
 // Instantiate a vector of coordinates
 inline void destroy(os_coord *) {}
 INSTANTIATE_VECTOR(os_coord);
@@ -107,6 +114,13 @@ INSTANTIATE_VECTOR(os_coord);
 // Instantiate a vector of print job page objects
 INSTANTIATE_DESTROY_VECTOR(printpgobj_obj)
 
+// Instantiate vectors of print job page display list details
+inline void destroy(printpgobj_list::cmd_class *) {}
+INSTANTIATE_VECTOR(printpgobj_list::cmd_class);
+INSTANTIATE_DESTROY_VECTOR(printrend_base::font_class)
+INSTANTIATE_DESTROY_VECTOR(printrend_base::bitmap_class)
+INSTANTIATE_DESTROY_VECTOR(printrend_base::text_class)
+
 // Instantiate a map of strings to strings
 #include "hmap.c++"
 INSTANTIATE_MAP(string, string, less<string> )
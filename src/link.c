@@ -27,6 +27,9 @@
 #include <limits.h>
 #include <stdio.h>
 
+// Include oslib header files
+#include "oslib/macros.h"
+
 // Include project header files
 #include "async.h"
 #include "baud.h"
@@ -82,6 +85,9 @@
 // Timeout in centisecond for polled operations
 #define LINK_TIMEOUT_POLL (20)
 
+// Buffer size for drivers that support block operations
+#define LINK_BLOCK_SIZE (512)
+
 // The current configuration
 char *link_driver_name = NULL;
 bits link_driver_port = 0;
@@ -654,41 +660,74 @@ os_error *link_poll(bool escape)
         // Keep polling until no more actions
         while (!err && link_active && more && ((util_time() - timeout) < 0))
         {
-            byte value;
-            int rx = -1;
-            int tx = -1;
+            bool dsr;
 
             // Start by assuming no more actions
             more = FALSE;
 
             // Poll the block driver
             blockdrive_poll(link_driver);
+            dsr = blockdrive_modem_read(link_driver) & BLOCKDRIVE_MODEM_DSR;
 
-            // Check the receive buffer
-            if (blockdrive_get_byte(link_driver, &value))
+            // Transfer whole blocks if supported by the driver
+            if (link_driver->flags & BLOCKDRIVE_FLAGS_BLOCK_OPERATIONS)
             {
-                rx = value;
-                stats_rx_bytes++;
-                more = TRUE;
+                static byte rx[LINK_BLOCK_SIZE];
+                static byte tx[LINK_BLOCK_SIZE];
+                bits rx_size;
+                bits tx_size;
+
+                // Read any received bytes
+                rx_size = blockdrive_get_block(link_driver, rx, sizeof(rx));
+                stats_rx_bytes += rx_size;
+
+                // Poll the user of the block driver
+                tx_size = MIN(blockdrive_check_tx(link_driver), sizeof(tx));
+                err = user_poll_block(dsr, rx, rx_size, tx, &tx_size, first);
+                first = FALSE;
+
+                // Transmit any returned bytes
+                if (!err && tx_size)
+                {
+                    if (blockdrive_put_block(link_driver, tx, tx_size)
+                        != tx_size)
+                    {
+                        err = &err_driver_full;
+                    }
+                    stats_tx_bytes += tx_size;
+                }
+                more = rx_size || tx_size;
             }
+            else
+            {
+                byte value;
+                int rx = -1;
+                int tx = -1;
 
-            // Poll the user of the block driver
-            err = user_poll(blockdrive_modem_read(link_driver)
-                            & BLOCKDRIVE_MODEM_DSR,
-                            rx,
-                            blockdrive_check_tx(link_driver) ? &tx : NULL,
-                            first);
-            first = FALSE;
+                // Check the receive buffer
+                if (blockdrive_get_byte(link_driver, &value))
+                {
+                    rx = value;
+                    stats_rx_bytes++;
+                    more = TRUE;
+                }
 
-            // Transmit any returned character
-            if (!err && (0 <= tx))
-            {
-                if (!blockdrive_put_byte(link_driver, tx))
+                // Poll the user of the block driver
+                err = user_poll(dsr, rx,
+                                blockdrive_check_tx(link_driver) ? &tx : NULL,
+                                first);
+                first = FALSE;
+
+                // Transmit any returned character
+                if (!err && (0 <= tx))
                 {
-                    err = &err_driver_full;
+                    if (!blockdrive_put_byte(link_driver, tx))
+                    {
+                        err = &err_driver_full;
+                    }
+                    stats_tx_bytes++;
+                    more = TRUE;
                 }
-                stats_tx_bytes++;
-                more = TRUE;
             }
 
             // Update any relevant pollwords
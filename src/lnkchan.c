@@ -88,13 +88,14 @@ os_error *lnkchan_register(const lnkchan_cmd cmd, lnkchan_reply reply,
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Function to start an operation.
 */
-static os_error *lnkchan_send(const void *cmd, void *reply)
+static os_error *lnkchan_send(void *user, const void *cmd, void *reply)
 {
     os_error *err = NULL;
     byte buffer[18];
@@ -155,7 +156,8 @@ static os_error *lnkchan_validate(const char *server)
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
                   data          - Pointer to the received data, or NULL if
                                   none.
@@ -164,7 +166,7 @@ static os_error *lnkchan_validate(const char *server)
                                   NULL if no error.
     Description : Function to end an operation.
 */
-static os_error *lnkchan_receive(const void *cmd, void *reply,
+static os_error *lnkchan_receive(void *user, const void *cmd, void *reply,
                                  const byte *data, bits size)
 {
     os_error *err = NULL;
@@ -217,7 +219,8 @@ static os_error *lnkchan_receive(const void *cmd, void *reply,
 }
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - User defined handle for this channel.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -225,7 +228,8 @@ static os_error *lnkchan_receive(const void *cmd, void *reply,
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-static os_error *lnkchan_poll(mux_events event, const byte *data, bits size)
+static os_error *lnkchan_poll(void *user, mux_events event,
+                              const byte *data, bits size)
 {
     os_error *err = NULL;
 
@@ -235,7 +239,7 @@ static os_error *lnkchan_poll(mux_events event, const byte *data, bits size)
         case MUX_EVENT_SERVER_CONNECTED:
             // Connected to remote server
             err = share_create(&lnkchan_share_handle,
-                               lnkchan_send, lnkchan_receive);
+                               lnkchan_send, lnkchan_receive, NULL);
             break;
 
         case MUX_EVENT_SERVER_DISCONNECTED:
@@ -292,7 +296,8 @@ os_error *lnkchan_start(void)
     if (!lnkchan_active)
     {
         err = mux_chan_create(LNKCHAN_CHANNEL_NAME, LNKCHAN_CHANNEL,
-                              TRUE, TRUE, lnkchan_poll, LNKCHAN_MAX_FRAME,
+                              TRUE, TRUE, lnkchan_poll, NULL,
+                              LNKCHAN_MAX_FRAME, MUX_CLASS_INTERACTIVE,
                               &lnkchan_channel);
 
         // Set the active flag if successful
@@ -90,6 +90,7 @@ typedef struct
     bits size;
     bits used;
     bits offset;
+    os_t queued;
 } mux_data_frame;
 
 // The local channels
@@ -100,17 +101,36 @@ typedef struct mux_channel_status
     bool client;
     bool server;
     mux_channel_poll poll;
+    void *user;
+    mux_class priority;
     byte client_chan;
     byte server_chan;
     mux_data_frame client_rx;
     mux_data_frame server_rx;
     mux_data_frame client_tx;
     mux_data_frame server_tx;
+    bits messages;
+    bits delay_total;
+    bits delay_max;
     mux_channel prev;
     mux_channel next;
 } mux_channel_status;
 static mux_channel mux_channel_list = NULL;
-static mux_channel mux_channel_last = NULL;
+
+// The transmit priority classes
+typedef struct
+{
+    const char *name;
+    bits cost;
+    bits pass;
+    mux_channel last;
+} mux_class_status;
+static mux_class_status mux_class_list[MUX_CLASSES] =
+{
+    {"interactive", 1, 0, NULL},
+    {"normal", 2, 0, NULL},
+    {"bulk", 4, 0, NULL}
+};
 
 // The remote channels
 static bool mux_blocked[MUX_CHANNEL_MAX];
@@ -186,8 +206,13 @@ static mux_channel mux_chan_find(byte chan)
                   client        - Is this a client.
                   server        - Is this a server.
                   poll          - Poll function to call for this function.
+                  user          - User defined handle passed to the poll
+                                  function.
                   size          - The maximum frame size. Frames larger than
                                   this value will be discarded.
+                  priority      - The transmit priority class. Pending data
+                                  is shared between the classes in proportion
+                                  to their weights.
                   handle        - Variable to receive the handle for this
                                   channel.
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -197,13 +222,13 @@ static mux_channel mux_chan_find(byte chan)
 */
 os_error *mux_chan_create(const char *name, byte chan,
                           bool client, bool server,
-                          mux_channel_poll poll, bits size,
-                          mux_channel *handle)
+                          mux_channel_poll poll, void *user, bits size,
+                          mux_class priority, mux_channel *handle)
 {
     os_error *err = NULL;
 
     // Check parameters
-    if (!name || !handle) err = &err_bad_parms;
+    if (!name || !handle || (MUX_CLASSES <= priority)) err = &err_bad_parms;
     else if (chan && mux_chan_find(chan)) err = &err_chan_exists;
 
     // Create a status record for this channel
@@ -225,10 +250,15 @@ os_error *mux_chan_create(const char *name, byte chan,
         (*handle)->client = client;
         (*handle)->server = server;
         (*handle)->poll = poll;
+        (*handle)->user = user;
+        (*handle)->priority = priority;
 
         // Prepare other details
         (*handle)->client_chan = MUX_CHANNEL_CTRL;
         (*handle)->server_chan = MUX_CHANNEL_CTRL;
+        (*handle)->messages = 0;
+        (*handle)->delay_total = 0;
+        (*handle)->delay_max = 0;
 
         // Allocate buffers
         (*handle)->client_rx.data = server && size
@@ -257,7 +287,7 @@ os_error *mux_chan_create(const char *name, byte chan,
         (*handle)->server_tx.offset = 0;
 
         // Inform the channel handler of its construction
-        if (poll) err = (*poll)(MUX_EVENT_START, NULL, 0);
+        if (poll) err = (*poll)(user, MUX_EVENT_START, NULL, 0);
 
         // Attempt to connect to a server if this is a client
         if (!err && client) err = mux_chan_connect(*handle, NULL);
@@ -300,6 +330,7 @@ os_error *mux_chan_destroy(mux_channel handle, bool now)
     else
     {
         frame_data *frame;
+        mux_class priority;
 
         // Disconnect any remote client
         if (handle->client_chan != MUX_CHANNEL_CTRL)
@@ -315,8 +346,8 @@ os_error *mux_chan_destroy(mux_channel handle, bool now)
             // Inform channel handler
             if (!err && handle->poll)
             {
-                err = (*handle->poll)(MUX_EVENT_CLIENT_DISCONNECTED,
-                                      NULL, 0);
+                err = (*handle->poll)(handle->user,
+                                      MUX_EVENT_CLIENT_DISCONNECTED, NULL, 0);
             }
         }
 
@@ -336,15 +367,15 @@ os_error *mux_chan_destroy(mux_channel handle, bool now)
             // Inform channel handler
             if (!err && handle->poll)
             {
-                err = (*handle->poll)(MUX_EVENT_SERVER_DISCONNECTED,
-                                      NULL, 0);
+                err = (*handle->poll)(handle->user,
+                                      MUX_EVENT_SERVER_DISCONNECTED, NULL, 0);
             }
         }
 
         // Inform the channel handler of the imminent destruction
         if (!err && handle->poll)
         {
-            err = (*handle->poll)(MUX_EVENT_END, NULL, 0);
+            err = (*handle->poll)(handle->user, MUX_EVENT_END, NULL, 0);
         }
 
         // Destroy this channel
@@ -355,8 +386,14 @@ os_error *mux_chan_destroy(mux_channel handle, bool now)
             else mux_channel_list = handle->next;
             if (handle->next) handle->next->prev = handle->prev;
 
-            // Check any pointers
-            if (mux_channel_last == handle) mux_channel_last = handle->next;
+            // Check any pointers, which may be in any class
+            for (priority = 0; priority < MUX_CLASSES; priority++)
+            {
+                if (mux_class_list[priority].last == handle)
+                {
+                    mux_class_list[priority].last = handle->next;
+                }
+            }
 
             // Deallocate the memory used by the channel status
             if (handle->client_rx.data) MEM_FREE(handle->client_rx.data);
@@ -424,6 +461,49 @@ os_error *mux_chan_tx_client(mux_channel handle, const byte *data, bits size)
         memcpy(handle->client_tx.data, data, size);
         handle->client_tx.used = size;
         handle->client_tx.offset = 0;
+        handle->client_tx.queued = util_time();
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : handle        - The handle of the channel to send from.
+                  data          - Variable to receive a pointer to the
+                                  transmit buffer.
+                  size          - Variable to receive the size of the buffer.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Obtain the buffer used for data frames sent to this channel's
+                  server. A frame can be constructed directly in this buffer
+                  and then passed to mux_chan_tx_server without being copied.
+                  Any previous frame that has not started transmission is
+                  discarded, and an error is returned if one is partially
+                  transmitted.
+*/
+os_error *mux_chan_tx_server_buffer(mux_channel handle, byte **data,
+                                    bits *size)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if (!handle || !data || !size || !handle->server_tx.data)
+    {
+        err = &err_bad_parms;
+    }
+    else if (handle->server_tx.used && handle->server_tx.offset)
+    {
+        err = &err_connection_busy;
+    }
+    else
+    {
+        // Discard any previous frame that has not started transmission
+        handle->server_tx.used = 0;
+
+        // Return the buffer details
+        *data = handle->server_tx.data;
+        *size = handle->server_tx.size;
     }
 
     // Return any error produced
@@ -450,10 +530,14 @@ os_error *mux_chan_tx_server(mux_channel handle, const byte *data, bits size)
     }
     else
     {
-        // Store the data
-        memcpy(handle->server_tx.data, data, size);
+        // Store the data unless it was written in place
+        if (data != handle->server_tx.data)
+        {
+            memcpy(handle->server_tx.data, data, size);
+        }
         handle->server_tx.used = size;
         handle->server_tx.offset = 0;
+        handle->server_tx.queued = util_time();
     }
 
     // Return any error produced
@@ -531,7 +615,7 @@ static os_error *mux_poll_rx_connect_to_server(byte chan, const char *name)
         // Inform the channel handler
         if (ptr->poll)
         {
-            err = (*ptr->poll)(MUX_EVENT_CLIENT_CONNECTED, NULL, 0);
+            err = (*ptr->poll)(ptr->user, MUX_EVENT_CLIENT_CONNECTED, NULL, 0);
         }
     }
 
@@ -578,7 +662,8 @@ static os_error *mux_poll_rx_connect_response(byte client, byte server,
             // Inform the channel handler
             if (ptr->poll)
             {
-                err = (*ptr->poll)(MUX_EVENT_SERVER_CONNECTED, NULL, 0);
+                err = (*ptr->poll)(ptr->user,
+                                   MUX_EVENT_SERVER_CONNECTED, NULL, 0);
             }
         }
         else
@@ -586,7 +671,7 @@ static os_error *mux_poll_rx_connect_response(byte client, byte server,
             // Inform the channel handler
             if (ptr->poll)
             {
-                err = (*ptr->poll)(MUX_EVENT_SERVER_FAILED, NULL, 0);
+                err = (*ptr->poll)(ptr->user, MUX_EVENT_SERVER_FAILED, NULL, 0);
             }
         }
     }
@@ -620,7 +705,8 @@ static os_error *mux_poll_rx_channel_closed(byte chan)
         // Inform the channel handler
         if (ptr->poll)
         {
-            err = (*ptr->poll)(MUX_EVENT_CLIENT_DISCONNECTED, NULL, 0);
+            err = (*ptr->poll)(ptr->user,
+                               MUX_EVENT_CLIENT_DISCONNECTED, NULL, 0);
         }
     }
 
@@ -692,7 +778,8 @@ static os_error *mux_poll_rx_channel_disconnect(byte client, byte server)
         // Inform the channel handler
         if (ptr->poll)
         {
-            err = (*ptr->poll)(MUX_EVENT_SERVER_DISCONNECTED, NULL, 0);
+            err = (*ptr->poll)(ptr->user,
+                               MUX_EVENT_SERVER_DISCONNECTED, NULL, 0);
         }
     }
 
@@ -727,7 +814,8 @@ static os_error *mux_poll_rx_ncp_end(void)
             // Inform channel handler
             if (ptr->poll)
             {
-                err = (*ptr->poll)(MUX_EVENT_CLIENT_DISCONNECTED, NULL, 0);
+                err = (*ptr->poll)(ptr->user,
+                                   MUX_EVENT_CLIENT_DISCONNECTED, NULL, 0);
             }
         }
         if (!err && (ptr->server_chan != MUX_CHANNEL_CTRL))
@@ -740,7 +828,8 @@ static os_error *mux_poll_rx_ncp_end(void)
             // Inform channel handler
             if (ptr->poll)
             {
-                err = (*ptr->poll)(MUX_EVENT_SERVER_DISCONNECTED, NULL, 0);
+                err = (*ptr->poll)(ptr->user,
+                                   MUX_EVENT_SERVER_DISCONNECTED, NULL, 0);
             }
         }
 
@@ -917,7 +1006,7 @@ os_error *mux_poll_rx_data_decoded(byte src, byte dest, bool complete,
         // Call the channel poll function
         if (ptr->poll && frame->used && (frame->used <= frame->size))
         {
-            err = (*ptr->poll)(event, frame->data, frame->used);
+            err = (*ptr->poll)(ptr->user, event, frame->data, frame->used);
         }
 
         // Clear the received message
@@ -986,37 +1075,131 @@ static os_error *mux_poll_rx_data(const frame_data *frame)
 os_error *mux_poll_tx_data(byte src, byte dest, mux_data_frame *data)
 {
     os_error *err = NULL;
-    static frame_data frame;
-    bits size;
+    frame_data *frame;
 
-    // Calculate the frame size
-    frame.size = MIN(FRAME_MAX_DATA_TX,
-                     data->used - data->offset + MUX_OFFSET_DATA);
-    size = frame.size - MUX_OFFSET_DATA;
+    // Build the frame directly in the transmit queue
+    err = connect_tx_buffer(&frame);
+    if (!err)
+    {
+        bits size;
 
-    // Copy the data
-    memcpy(&frame.data[MUX_OFFSET_DATA], &data->data[data->offset], size);
-    data->offset += size;
+        // Calculate the frame size
+        frame->size = MIN(connect_tx_max(),
+                          data->used - data->offset + MUX_OFFSET_DATA);
+        size = frame->size - MUX_OFFSET_DATA;
 
-    // Is this a complete write
-    if (data->offset == data->used)
-    {
-        frame.data[MUX_OFFSET_TYPE] = MUX_MSG_WRITECOMPLETE;
-        data->used = 0;
-    }
-    else frame.data[MUX_OFFSET_TYPE] = MUX_MSG_WRITEPARTIAL;
+        // Copy the data
+        memcpy(&frame->data[MUX_OFFSET_DATA], &data->data[data->offset],
+               size);
+        data->offset += size;
 
-    // Complete the frame header
-    frame.data[MUX_OFFSET_DEST] = dest;
-    frame.data[MUX_OFFSET_SRC] = src;
+        // Is this a complete write
+        if (data->offset == data->used)
+        {
+            frame->data[MUX_OFFSET_TYPE] = MUX_MSG_WRITECOMPLETE;
+            data->used = 0;
+        }
+        else frame->data[MUX_OFFSET_TYPE] = MUX_MSG_WRITEPARTIAL;
 
-    // Send this frame
-    err = connect_tx(&frame);
+        // Complete the frame header
+        frame->data[MUX_OFFSET_DEST] = dest;
+        frame->data[MUX_OFFSET_SRC] = src;
+
+        // Send this frame
+        err = connect_tx(frame);
+    }
 
     // Return any error produced
     return err;
 }
 
+/*
+    Parameters  : chan          - The channel to check.
+    Returns     : bool          - Does the channel have data that can be
+                                  transmitted.
+    Description : Check whether a channel is ready to transmit.
+*/
+static bool mux_poll_tx_ready(mux_channel chan)
+{
+    return (chan->client_tx.used && !mux_blocked[chan->client_chan])
+           || (chan->server_tx.used && !mux_blocked[chan->server_chan]);
+}
+
+/*
+    Parameters  : priority      - The priority class to check.
+    Returns     : mux_channel   - The next channel in the class with data
+                                  ready to transmit, or NULL if none.
+    Description : Find the next channel to service within a priority class.
+                  Channels of the same class are served in rotation.
+*/
+static mux_channel mux_poll_tx_next(mux_class priority)
+{
+    mux_channel start = mux_class_list[priority].last;
+    mux_channel ptr = start;
+
+    // Check each channel once, starting after the last one served
+    do
+    {
+        // Advance to the next channel to check
+        ptr = ptr && ptr->next ? ptr->next : mux_channel_list;
+    }
+    while (ptr && ((ptr->priority != priority) || !mux_poll_tx_ready(ptr))
+           && (ptr != start) && (start || ptr->next));
+
+    // Return the channel if it is suitable
+    return ptr && (ptr->priority == priority) && mux_poll_tx_ready(ptr)
+           ? ptr
+           : NULL;
+}
+
+/*
+    Parameters  : void
+    Returns     : mux_channel   - The channel to transmit from next, or NULL
+                                  if none have data ready.
+    Description : Choose the next channel to transmit from. Each priority
+                  class has a virtual pass value that advances by the cost of
+                  each byte it sends, and the ready class with the lowest pass
+                  is chosen. This shares the link between the classes in
+                  proportion to their weights without starving any of them.
+*/
+static mux_channel mux_poll_tx_choose(void)
+{
+    mux_channel ready[MUX_CLASSES];
+    mux_class best = MUX_CLASSES;
+    mux_class priority;
+
+    // Find the ready class with the lowest pass value
+    for (priority = 0; priority < MUX_CLASSES; priority++)
+    {
+        ready[priority] = mux_poll_tx_next(priority);
+        if (ready[priority]
+            && ((best == MUX_CLASSES)
+                || ((int) (mux_class_list[priority].pass
+                           - mux_class_list[best].pass) < 0)))
+        {
+            best = priority;
+        }
+    }
+
+    // Prevent idle classes from building up credit
+    if (best != MUX_CLASSES)
+    {
+        for (priority = 0; priority < MUX_CLASSES; priority++)
+        {
+            if (!ready[priority]
+                && ((int) (mux_class_list[priority].pass
+                           - mux_class_list[best].pass) < 0))
+            {
+                mux_class_list[priority].pass = mux_class_list[best].pass;
+            }
+        }
+        mux_class_list[best].last = ready[best];
+    }
+
+    // Return the chosen channel
+    return best == MUX_CLASSES ? NULL : ready[best];
+}
+
 /*
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -1036,36 +1219,48 @@ static os_error *mux_poll_tx(void)
     }
     else
     {
-        // Find the next channel with pending data
-        do
-        {
-            // Advance to the next channel to check
-            if (mux_channel_last) mux_channel_last = mux_channel_last->next;
-            else mux_channel_last = mux_channel_list;
-        }
-        while (mux_channel_last
-               && (!mux_channel_last->client_tx.used
-                   || mux_blocked[mux_channel_last->client_chan])
-               && (!mux_channel_last->server_tx.used
-                   || mux_blocked[mux_channel_last->server_chan]));
+        mux_channel chan = mux_poll_tx_choose();
 
         // Transmit any pending data
-        if (mux_channel_last)
+        if (chan)
         {
+            bool server = chan->server_tx.used
+                          && !mux_blocked[chan->server_chan];
+            bool client = chan->client_tx.used
+                          && !mux_blocked[chan->client_chan];
+            mux_data_frame *data;
+            byte dest;
+            bits offset;
+
             // Choose the data to transmit
-            if (mux_channel_last->server_tx.used
-                && !(mux_channel_last->client_tx.used
-                     && mux_channel_last->client_tx.offset))
+            if (server && !(client && chan->client_tx.offset))
             {
-                err = mux_poll_tx_data(mux_channel_last->chan,
-                                       mux_channel_last->server_chan,
-                                       &mux_channel_last->server_tx);
+                data = &chan->server_tx;
+                dest = chan->server_chan;
             }
-            else if (mux_channel_last->client_tx.used)
+            else
             {
-                err = mux_poll_tx_data(mux_channel_last->chan,
-                                       mux_channel_last->client_chan,
-                                       &mux_channel_last->client_tx);
+                data = &chan->client_tx;
+                dest = chan->client_chan;
+            }
+
+            // Transmit the next fragment
+            offset = data->offset;
+            err = mux_poll_tx_data(chan->chan, dest, data);
+
+            // Charge the priority class for the data sent
+            mux_class_list[chan->priority].pass
+                += (data->offset - offset + MUX_OFFSET_DATA)
+                   * mux_class_list[chan->priority].cost;
+
+            // Update the queueing delay statistics for completed messages
+            if (!err && !data->used)
+            {
+                bits delay = util_time() - data->queued;
+
+                chan->messages++;
+                chan->delay_total += delay;
+                if (chan->delay_max < delay) chan->delay_max = delay;
             }
         }
     }
@@ -1116,7 +1311,7 @@ os_error *mux_poll(const frame_data *rx_frame, bool tx_idle)
                     || (ptr->server_chan != MUX_CHANNEL_CTRL))
                 && !ptr->client_tx.used && !ptr->server_tx.used)
             {
-                err = (*ptr->poll)(MUX_EVENT_IDLE, NULL, 0);
+                err = (*ptr->poll)(ptr->user, MUX_EVENT_IDLE, NULL, 0);
             }
 
             // Try the next channel
@@ -1338,6 +1533,16 @@ os_error *mux_status(void)
         }
         printf(".\n");
 
+        // Display the transmit statistics
+        printf("    %s priority, ", mux_class_list[ptr->priority].name);
+        if (ptr->messages)
+        {
+            printf("%u messages sent with mean queueing delay %ucs and maximum %ucs.\n",
+                   ptr->messages, ptr->delay_total / ptr->messages,
+                   ptr->delay_max);
+        }
+        else printf("no messages sent.\n");
+
         // Advance to the next channel
         ptr = ptr->next;
     }
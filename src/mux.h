@@ -46,6 +46,15 @@ typedef enum
     MUX_EVENT_IDLE
 } mux_events;
 
+// Transmit priority classes
+typedef enum
+{
+    MUX_CLASS_INTERACTIVE,
+    MUX_CLASS_NORMAL,
+    MUX_CLASS_BULK
+} mux_class;
+#define MUX_CLASSES (3)
+
 // Opaque type for a channel
 typedef struct mux_channel_status *mux_channel;
 
@@ -54,7 +63,8 @@ typedef struct mux_channel_status *mux_channel;
 #endif
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - User defined handle for this channel.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -62,8 +72,8 @@ typedef struct mux_channel_status *mux_channel;
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-typedef os_error *(* mux_channel_poll)(mux_events event, const byte *data,
-                                       bits size);
+typedef os_error *(* mux_channel_poll)(void *user, mux_events event,
+                                       const byte *data, bits size);
 
 /*
     Parameters  : name          - The name of the server. This is not copied,
@@ -73,8 +83,13 @@ typedef os_error *(* mux_channel_poll)(mux_events event, const byte *data,
                   client        - Is this a client.
                   server        - Is this a server.
                   poll          - Poll function to call for this function.
+                  user          - User defined handle passed to the poll
+                                  function.
                   size          - The maximum frame size. Frames larger than
                                   this value will be discarded.
+                  priority      - The transmit priority class. Pending data
+                                  is shared between the classes in proportion
+                                  to their weights.
                   handle        - Variable to receive the handle for this
                                   channel.
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -84,8 +99,8 @@ typedef os_error *(* mux_channel_poll)(mux_events event, const byte *data,
 */
 os_error *mux_chan_create(const char *name, byte chan,
                           bool client, bool server,
-                          mux_channel_poll poll, bits size,
-                          mux_channel *handle);
+                          mux_channel_poll poll, void *user, bits size,
+                          mux_class priority, mux_channel *handle);
 
 /*
     Parameters  : handle        - The handle of the channel to destroy.
@@ -117,6 +132,23 @@ os_error *mux_chan_connect(mux_channel handle, const char *name);
 */
 os_error *mux_chan_tx_client(mux_channel handle, const byte *data, bits size);
 
+/*
+    Parameters  : handle        - The handle of the channel to send from.
+                  data          - Variable to receive a pointer to the
+                                  transmit buffer.
+                  size          - Variable to receive the size of the buffer.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Obtain the buffer used for data frames sent to this channel's
+                  server. A frame can be constructed directly in this buffer
+                  and then passed to mux_chan_tx_server without being copied.
+                  Any previous frame that has not started transmission is
+                  discarded, and an error is returned if one is partially
+                  transmitted.
+*/
+os_error *mux_chan_tx_server_buffer(mux_channel handle, byte **data,
+                                    bits *size);
+
 /*
     Parameters  : handle        - The handle of the channel to send from.
                   data          - Pointer to the data.
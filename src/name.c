@@ -127,7 +127,7 @@ static os_error *name_leaf_riscos_to_sibo(const char *src, char *dest,
         }
 
         // Ensure that the name is terminated
-        if (!err) *dest = NULL;
+        if (!err) *dest = '\0';
     }
 
     // Return any error produced
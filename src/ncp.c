@@ -111,13 +111,14 @@ os_error *ncp_back(const ncp_cmd *cmd, ncp_reply *reply,
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Function to start an operation.
 */
-static os_error *ncp_send(const void *cmd, void *reply)
+static os_error *ncp_send(void *user, const void *cmd, void *reply)
 {
     os_error *err = NULL;
     static byte buffer[NCP_MAX_FRAME];
@@ -384,7 +385,8 @@ static os_error *ncp_get_app(ncp_app *app)
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
                   data          - Pointer to the received data, or NULL if
                                   none.
@@ -393,7 +395,7 @@ static os_error *ncp_get_app(ncp_app *app)
                                   NULL if no error.
     Description : Function to end an operation.
 */
-static os_error *ncp_receive(const void *cmd, void *reply,
+static os_error *ncp_receive(void *user, const void *cmd, void *reply,
                              const byte *data, bits size)
 {
     os_error *err = NULL;
@@ -677,7 +679,8 @@ static os_error *ncp_lnkchan_callback(void *user, os_error *err,
 }
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - User defined handle for this channel.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -685,7 +688,8 @@ static os_error *ncp_lnkchan_callback(void *user, os_error *err,
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-static os_error *ncp_poll(mux_events event, const byte *data, bits size)
+static os_error *ncp_poll(void *user, mux_events event,
+                          const byte *data, bits size)
 {
     os_error *err = NULL;
 
@@ -701,7 +705,7 @@ static os_error *ncp_poll(mux_events event, const byte *data, bits size)
         case MUX_EVENT_SERVER_CONNECTED:
             // Connected to remote server
             err = share_create(&ncp_share_handle,
-                               ncp_send, ncp_receive);
+                               ncp_send, ncp_receive, NULL);
             break;
 
         case MUX_EVENT_SERVER_DISCONNECTED:
@@ -760,8 +764,9 @@ os_error *ncp_start(void)
         ncp_retry = FALSE;
 
         // Create the channel
-        err = mux_chan_create(NCP_CHANNEL_NAME, 0, TRUE, FALSE, ncp_poll,
-                              NCP_MAX_FRAME, &ncp_channel);
+        err = mux_chan_create(NCP_CHANNEL_NAME, 0, TRUE, FALSE, ncp_poll, NULL,
+                              NCP_MAX_FRAME, MUX_CLASS_INTERACTIVE,
+                              &ncp_channel);
 
         // Set the active flag if successful
         if (!err) ncp_active = TRUE;
@@ -27,15 +27,13 @@
 #include <stdio.h>
 
 // Include oslib header files
+#include "oslib/osfile.h"
 #include "oslib/osfscontrol.h"
 
-// Include cathlibcpp header files
-#include "fstream.h"
-#include "vector.h"
-
 // Inlcude project header files
 #include "config.h"
 #include "filer.h"
+#include "rle.h"
 #include "scrap.h"
 
 // Macros for debugging primitives
@@ -98,6 +96,9 @@
 #define PRINTPGOBJ_START_FOOTER1 (0x02)
 #define PRINTPGOBJ_START_FOOTER2 (0x03)
 
+// Total size of display lists to cache
+#define PRINTPGOBJ_LIST_BUDGET (0x200000)
+
 // Font style bits
 #define PRINTPGOBJ_FONT_POSTURE (1 << 0)
 #define PRINTPGOBJ_FONT_POSTURE_SHIFT (0)
@@ -107,14 +108,21 @@
 #define PRINTPGOBJ_FONT_POSITION_SHIFT (2)
 #define PRINTPGOBJ_FONT_RESERVED (0xfffffff0)
 
+// Least recently used list of cached display lists
+printpgobj_obj::ref_class *printpgobj_obj::lru_head = NULL;
+printpgobj_obj::ref_class *printpgobj_obj::lru_tail = NULL;
+size_t printpgobj_obj::lru_size = 0;
+
 /*
-    Parameters  : s                 - The stream containing the page data.
+    Parameters  : data              - Pointer to the page data.
+                  size              - Size of the page data.
                   rend              - The object to perform the rendering.
     Returns     : -
     Description : Constructor.
 */
-printpgobj_rend::printpgobj_rend(istream &s, printrend_base &rend)
-: s(s), rend(rend)
+printpgobj_rend::printpgobj_rend(const byte *data, size_t size,
+                                 printrend_base &rend)
+: data(data), ptr(data), end(data + size), fail(FALSE), rend(rend)
 {
     // Check whether debug messages should be logged
     log_debug = config_current.get_bool(config_tag_print_log_debug);
@@ -143,7 +151,7 @@ void printpgobj_rend::render()
 
     // Process the whole page
     bool done = FALSE;
-    while (!done && s && rend)
+    while (!done && !fail && rend)
     {
         // Obtain the tag for the next primitive
         bits primitive = get1();
@@ -239,8 +247,8 @@ void printpgobj_rend::render()
     }
 
     // Check that the whole page was processed
-    if (s.eof()) error("PrnEFEf", TRUE);
-    else if (s.peek() != EOF) error("PrnEFIn", TRUE);
+    if (fail) error("PrnEFEf", TRUE);
+    else if (ptr != end) error("PrnEFIn", TRUE);
 }
 
 /*
@@ -750,7 +758,7 @@ void printpgobj_rend::error(const char *token, bool fatal)
 {
     // Construct the error message
     char str[10];
-    sprintf(str, "%x", s.tellg());
+    sprintf(str, "%x", ptr - data);
     string error = filer_msgtrans("PrnTxAt",
                                   filer_msgtrans(token).c_str(), str);
 
@@ -775,11 +783,31 @@ void printpgobj_rend::debug(const string &debug, bool important)
     {
         // Log the message with the current location prefixed
         char str[13];
-        sprintf(str, "@%x: ", s.tellg());
+        sprintf(str, "@%x: ", ptr - data);
         rend.rend_debug(str + debug, important);
     }
 }
 
+/*
+    Parameters  : size              - The number of bytes required.
+    Returns     : bool              - Are the bytes available.
+    Description : Check that the specified number of bytes of page data
+                  remain. If not then the remaining data is skipped and the
+                  failure is recorded.
+*/
+bool printpgobj_rend::check(size_t size)
+{
+    // Check the remaining data
+    if (size_t(end - ptr) < size)
+    {
+        ptr = end;
+        fail = TRUE;
+    }
+
+    // Return whether the data is available
+    return !fail;
+}
+
 /*
     Parameters  : void
     Returns     : bits              - The value read from the page data.
@@ -787,9 +815,7 @@ void printpgobj_rend::debug(const string &debug, bool important)
 */
 bits printpgobj_rend::get1()
 {
-    char c;
-    s.read(&c, 1);
-    return byte(c);
+    return check(1) ? *ptr++ : 0;
 }
 
 /*
@@ -799,10 +825,13 @@ bits printpgobj_rend::get1()
 */
 bits printpgobj_rend::get2()
 {
-    bits value;
-    value = get1();
-    value += get1() << 8;
-    return int(value);
+    bits value = 0;
+    if (check(2))
+    {
+        value = ptr[0] | (ptr[1] << 8);
+        ptr += 2;
+    }
+    return value;
 }
 
 /*
@@ -812,12 +841,13 @@ bits printpgobj_rend::get2()
 */
 bits printpgobj_rend::get4()
 {
-    bits value;
-    value = get1();
-    value += get1() << 8;
-    value += get1() << 16;
-    value += get1() << 24;
-    return int(value);
+    bits value = 0;
+    if (check(4))
+    {
+        value = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (ptr[3] << 24);
+        ptr += 4;
+    }
+    return value;
 }
 
 /*
@@ -827,10 +857,13 @@ bits printpgobj_rend::get4()
 */
 os_colour printpgobj_rend::get_colour()
 {
-    bits red = get1();
-    bits green = get1();
-    bits blue = get1();
-    return (red << 8) | (green << 16) | (blue << 24);
+    os_colour colour = 0;
+    if (check(3))
+    {
+        colour = (ptr[0] << 8) | (ptr[1] << 16) | (ptr[2] << 24);
+        ptr += 3;
+    }
+    return colour;
 }
 
 /*
@@ -861,11 +894,15 @@ string printpgobj_rend::get_string()
     if (((value >> (value & 0x01 ? 1 : 0)) & 0x03) != 0x02) error("PrnELnB");
 
     // Get the string data
-    vector<char> buf(length);
-    s.read(&buf[0], length);
+    string str;
+    if (check(length))
+    {
+        str = string((const char *) ptr, length);
+        ptr += length;
+    }
 
     // Return the resulting string
-    return string(&buf[0], length);
+    return str;
 }
 
 /*
@@ -876,7 +913,7 @@ string printpgobj_rend::get_string()
 void printpgobj_rend::get_bitmap(printrend_base::bitmap_class &bitmap)
 {
     // Remember the start position
-    int start = s.tellg();
+    const byte *start = ptr;
 
     // Decode the bitmap header
     bits length = get4();
@@ -886,51 +923,651 @@ void printpgobj_rend::get_bitmap(printrend_base::bitmap_class &bitmap)
     bitmap.width = get4();
     bitmap.height = get4();
     bitmap.mode = (printrend_base::display_mode) get4();
-    if (bitmap.mode != printrend_base::display_mode_grey2) error("PrnEBiD");
+    if (!printrend_base::get_bitmap_supported(bitmap.mode)) error("PrnEBiD");
     if (get4() != 0) error("PrnEBiP");
     if (get4() != 0) error("PrnEBiP");
     bits encoding = get4();
 
-    // Advance to the start of the pixel data if required
-    if (offset != 0x28) s.seekg(start + offset);
+    // Find the end of the bitmap and the start of the pixel data
+    const byte *stop = end;
+    if (length <= size_t(end - start)) stop = start + length;
+    else fail = TRUE;
+    if (offset != 0x28)
+    {
+        ptr = offset <= size_t(stop - start) ? start + offset : stop;
+    }
+
+    // Allocate the exact size of the decoded pixel data, but without
+    // trusting the header further than the encoded data could expand
+    size_t size = printrend_base::get_bitmap_size(bitmap);
+    size_t available = ptr < stop ? stop - ptr : 0;
+    size_t limit = encoding == PRINTPGOBJ_BITMAP_RLE
+                   ? available * RLE_MAX_EXPANSION : available;
+    if (limit < size) size = limit;
+    byte *pixels = bitmap.pixels.alloc(size);
 
     // Decode the pixel data
-    bitmap.pixels.resize(0, 0);
     switch (encoding)
     {
         case PRINTPGOBJ_BITMAP_UNCOMPRESSED:
             // Raw pixel data
-            bitmap.pixels.resize(length - offset, 0);
-            s.read((char *) &bitmap.pixels[0], length - offset);
+            if (size) memcpy(pixels, ptr, size);
             break;
 
         case PRINTPGOBJ_BITMAP_RLE:
-            // Run length encoded pixel data (assume 1bbp for reserved size)
-            bitmap.pixels.reserve((((bitmap.columns + 7) / 8 + 3) & ~3) * bitmap.rows);
-            while (s.tellg() < (start + length))
-            {
-                bits marker = get1();
-                if (marker < 0x80)
-                {
-                    bitmap.pixels.insert(bitmap.pixels.end(), marker + 1,
-                                         get1());
-                }
-                else
-                {
-                    bits raw = 0x100 - marker;
-                    bits at = bitmap.pixels.size();
-                    bitmap.pixels.resize(at + raw, 0);
-                    s.read((char *) &bitmap.pixels[at], raw);
-                }
-            }
+            // Run length encoded pixel data
+            if (!rle_decode(&ptr, stop, pixels, size)) fail = TRUE;
             break;
 
         default:
             // Unsupported encoding
             error("PrnEBiE");
-            s.seekg(start + length);
             break;
     }
+
+    // Continue after the bitmap
+    ptr = stop;
+}
+
+/*
+    Parameters  : -
+    Returns     : -
+    Description : Constructor.
+*/
+printpgobj_list::printpgobj_list() : size(sizeof(printpgobj_list))
+{
+    // No action required
+}
+
+/*
+    Parameters  : -
+    Returns     : -
+    Description : Destructor.
+*/
+printpgobj_list::~printpgobj_list()
+{
+    // No action required
+}
+
+/*
+    Parameters  : rend              - The object to perform the rendering.
+    Returns     : void
+    Description : Replay the recorded primitives using the specified
+                  object.
+*/
+void printpgobj_list::replay(printrend_base &rend) const
+{
+    // Process the recorded primitives until complete or a fatal error
+    for (size_t i = 0; (i < cmds.size()) && rend; i++)
+    {
+        const cmd_class &cmd = cmds[i];
+        os_coord pos;
+        os_coord end;
+        pos.x = cmd.box.x0;
+        pos.y = cmd.box.y0;
+        end.x = cmd.box.x1;
+        end.y = cmd.box.y1;
+        switch (cmd.type)
+        {
+            case cmd_start:
+            {
+                start_class start;
+                start.page = cmd.value;
+                start.section = section_type(cmd.index);
+                rend.rend_start(start);
+                break;
+            }
+
+            case cmd_set_draw_mode:
+                rend.rend_set_draw_mode(draw_mode(cmd.value));
+                break;
+
+            case cmd_set_clipping_rect:
+                rend.rend_set_clipping_rect(cmd.box);
+                break;
+
+            case cmd_cancel_clipping_rect:
+                rend.rend_cancel_clipping_rect();
+                break;
+
+            case cmd_use_font:
+                rend.rend_use_font(fonts[cmd.index]);
+                break;
+
+            case cmd_discard_font:
+                rend.rend_discard_font();
+                break;
+
+            case cmd_set_underline_style:
+                rend.rend_set_underline_style(font_underline(cmd.value));
+                break;
+
+            case cmd_set_strikethrough_style:
+                rend.rend_set_strikethrough_style(
+                    font_strikethrough(cmd.value));
+                break;
+
+            case cmd_line_feed:
+                rend.rend_line_feed();
+                break;
+
+            case cmd_carriage_return:
+                rend.rend_carriage_return();
+                break;
+
+            case cmd_set_pen_colour:
+                rend.rend_set_pen_colour(cmd.value);
+                break;
+
+            case cmd_set_pen_style:
+                rend.rend_set_pen_style(pen_style(cmd.value));
+                break;
+
+            case cmd_set_pen_size:
+                rend.rend_set_pen_size(pos);
+                break;
+
+            case cmd_set_brush_colour:
+                rend.rend_set_brush_colour(cmd.value);
+                break;
+
+            case cmd_set_brush_style:
+                rend.rend_set_brush_style(brush_style(cmd.value));
+                break;
+
+            case cmd_draw_line:
+                rend.rend_draw_line(pos, end);
+                break;
+
+            case cmd_draw_ellipse:
+                rend.rend_draw_ellipse(cmd.box);
+                break;
+
+            case cmd_draw_rect:
+                rend.rend_draw_rect(cmd.box);
+                break;
+
+            case cmd_draw_polygon:
+            {
+                vector<os_coord> polygon;
+                polygon.reserve(cmd.count);
+                for (size_t j = 0; j < cmd.count; j++)
+                {
+                    polygon.push_back(vertices[cmd.index + j]);
+                }
+                rend.rend_draw_polygon(polygon, fill_rule(cmd.value));
+                break;
+            }
+
+            case cmd_draw_bitmap_rect:
+                rend.rend_draw_bitmap_rect(cmd.box, bitmaps[cmd.index]);
+                break;
+
+            case cmd_draw_bitmap_src:
+                rend.rend_draw_bitmap_src(cmd.src, cmd.box,
+                                          bitmaps[cmd.index]);
+                break;
+
+            case cmd_draw_text:
+                rend.rend_draw_text(strings[cmd.index], pos);
+                break;
+
+            case cmd_draw_text_justified:
+                rend.rend_draw_text_justified(texts[cmd.index]);
+                break;
+
+            case cmd_error:
+                rend.rend_error(strings[cmd.index], cmd.value);
+                break;
+
+            case cmd_debug:
+                rend.rend_debug(strings[cmd.index], cmd.value);
+                break;
+        }
+    }
+}
+
+/*
+    Parameters  : void
+    Returns     : size_t            - Approximate memory used in bytes.
+    Description : Estimate the memory used by this display list.
+*/
+size_t printpgobj_list::get_size() const
+{
+    return size;
+}
+
+/*
+    Parameters  : start             - The start parameters.
+    Returns     : void
+    Description : Record a start primitive.
+*/
+void printpgobj_list::rend_start(const start_class &start)
+{
+    // Pass on to the base class
+    printrend_base::rend_start(start);
+
+    // Record the primitive
+    add(cmd_start, start.page).index = start.section;
+}
+
+/*
+    Parameters  : mode              - The draw mode parameters.
+    Returns     : void
+    Description : Record a set draw mode primitive.
+*/
+void printpgobj_list::rend_set_draw_mode(draw_mode mode)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_draw_mode(mode);
+
+    // Record the primitive
+    add(cmd_set_draw_mode, mode);
+}
+
+/*
+    Parameters  : clip              - The set clipping rectangle parameters.
+    Returns     : void
+    Description : Record a set clipping rectangle primitive.
+*/
+void printpgobj_list::rend_set_clipping_rect(const os_box &clip)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_clipping_rect(clip);
+
+    // Record the primitive
+    add(cmd_set_clipping_rect).box = clip;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Record a cancel clipping rectangle primitive.
+*/
+void printpgobj_list::rend_cancel_clipping_rect()
+{
+    // Pass on to the base class
+    printrend_base::rend_cancel_clipping_rect();
+
+    // Record the primitive
+    add(cmd_cancel_clipping_rect);
+}
+
+/*
+    Parameters  : font              - The use font parameters.
+    Returns     : void
+    Description : Record a use font primitive.
+*/
+void printpgobj_list::rend_use_font(const font_class &font)
+{
+    // Pass on to the base class
+    printrend_base::rend_use_font(font);
+
+    // Record the primitive
+    add(cmd_use_font).index = fonts.size();
+    fonts.push_back(font);
+    size += sizeof(font_class) + font.face.size();
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Record a discard font primitive.
+*/
+void printpgobj_list::rend_discard_font()
+{
+    // Pass on to the base class
+    printrend_base::rend_discard_font();
+
+    // Record the primitive
+    add(cmd_discard_font);
+}
+
+/*
+    Parameters  : style             - The set underline style parameters.
+    Returns     : void
+    Description : Record a set underline style primitive.
+*/
+void printpgobj_list::rend_set_underline_style(font_underline style)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_underline_style(style);
+
+    // Record the primitive
+    add(cmd_set_underline_style, style);
+}
+
+/*
+    Parameters  : style             - The set strikethrough parameters.
+    Returns     : void
+    Description : Record a set strikethrough style primitive.
+*/
+void printpgobj_list::rend_set_strikethrough_style(font_strikethrough style)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_strikethrough_style(style);
+
+    // Record the primitive
+    add(cmd_set_strikethrough_style, style);
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Record a line feed primitive.
+*/
+void printpgobj_list::rend_line_feed()
+{
+    // Pass on to the base class
+    printrend_base::rend_line_feed();
+
+    // Record the primitive
+    add(cmd_line_feed);
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Record a carriage return primitive.
+*/
+void printpgobj_list::rend_carriage_return()
+{
+    // Pass on to the base class
+    printrend_base::rend_carriage_return();
+
+    // Record the primitive
+    add(cmd_carriage_return);
+}
+
+/*
+    Parameters  : colour            - The set pen colour parameters.
+    Returns     : void
+    Description : Record a set pen colour primitive.
+*/
+void printpgobj_list::rend_set_pen_colour(os_colour colour)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_pen_colour(colour);
+
+    // Record the primitive
+    add(cmd_set_pen_colour, colour);
+}
+
+/*
+    Parameters  : style             - The set pen style parameters.
+    Returns     : void
+    Description : Record a set pen style primitive.
+*/
+void printpgobj_list::rend_set_pen_style(pen_style style)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_pen_style(style);
+
+    // Record the primitive
+    add(cmd_set_pen_style, style);
+}
+
+/*
+    Parameters  : size              - The set pen size parameters.
+    Returns     : void
+    Description : Record a set pen size primitive.
+*/
+void printpgobj_list::rend_set_pen_size(const os_coord &size)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_pen_size(size);
+
+    // Record the primitive
+    cmd_class &cmd = add(cmd_set_pen_size);
+    cmd.box.x0 = size.x;
+    cmd.box.y0 = size.y;
+}
+
+/*
+    Parameters  : colour            - The set brush colour parameters.
+    Returns     : void
+    Description : Record a set brush colour primitive.
+*/
+void printpgobj_list::rend_set_brush_colour(os_colour colour)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_brush_colour(colour);
+
+    // Record the primitive
+    add(cmd_set_brush_colour, colour);
+}
+
+/*
+    Parameters  : style             - The set brush style parameters.
+    Returns     : void
+    Description : Record a set brush style primitive.
+*/
+void printpgobj_list::rend_set_brush_style(brush_style style)
+{
+    // Pass on to the base class
+    printrend_base::rend_set_brush_style(style);
+
+    // Record the primitive
+    add(cmd_set_brush_style, style);
+}
+
+/*
+    Parameters  : start             - The draw line start parameter.
+                  end               - The draw line end parameter.
+    Returns     : void
+    Description : Record a draw line primitive.
+*/
+void printpgobj_list::rend_draw_line(const os_coord &start,
+                                     const os_coord &end)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_line(start, end);
+
+    // Record the primitive
+    cmd_class &cmd = add(cmd_draw_line);
+    cmd.box.x0 = start.x;
+    cmd.box.y0 = start.y;
+    cmd.box.x1 = end.x;
+    cmd.box.y1 = end.y;
+}
+
+/*
+    Parameters  : ellipse           - The draw ellipse parameters.
+    Returns     : void
+    Description : Record a draw ellipse primitive.
+*/
+void printpgobj_list::rend_draw_ellipse(const os_box &ellipse)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_ellipse(ellipse);
+
+    // Record the primitive
+    add(cmd_draw_ellipse).box = ellipse;
+}
+
+/*
+    Parameters  : rectangle         - The draw rectangle parameters.
+    Returns     : void
+    Description : Record a draw rectangle primitive.
+*/
+void printpgobj_list::rend_draw_rect(const os_box &rectangle)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_rect(rectangle);
+
+    // Record the primitive
+    add(cmd_draw_rect).box = rectangle;
+}
+
+/*
+    Parameters  : vertices          - The draw polygon parameters.
+                  fill              - The winding rule parameter.
+    Returns     : void
+    Description : Record a draw polygon primitive.
+*/
+void printpgobj_list::rend_draw_polygon(const vector<os_coord> &vertices,
+                                        fill_rule fill)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_polygon(vertices, fill);
+
+    // Record the primitive
+    cmd_class &cmd = add(cmd_draw_polygon, fill);
+    cmd.index = this->vertices.size();
+    cmd.count = vertices.size();
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        this->vertices.push_back(vertices[i]);
+    }
+    size += sizeof(os_coord) * vertices.size();
+}
+
+/*
+    Parameters  : dest              - The destination rectangle parameter.
+                  bitmap            - The draw bitmap parameter.
+    Returns     : void
+    Description : Record a draw bitmap rectangle primitive.
+*/
+void printpgobj_list::rend_draw_bitmap_rect(const os_box &dest,
+                                            const bitmap_class &bitmap)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_bitmap_rect(dest, bitmap);
+
+    // Record the primitive
+    cmd_class &cmd = add(cmd_draw_bitmap_rect);
+    cmd.box = dest;
+    cmd.index = bitmaps.size();
+    bitmaps.push_back(bitmap);
+    size += sizeof(bitmap_class) + bitmap.pixels.size();
+}
+
+/*
+    Parameters  : src               - The source rectangle parameter.
+                  dest              - The destination rectangle parameter.
+                  bitmap            - The draw bitmap parameter.
+    Returns     : void
+    Description : Record a draw bitmap source primitive.
+*/
+void printpgobj_list::rend_draw_bitmap_src(const os_box &src,
+                                           const os_box &dest,
+                                           const bitmap_class &bitmap)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_bitmap_src(src, dest, bitmap);
+
+    // Record the primitive
+    cmd_class &cmd = add(cmd_draw_bitmap_src);
+    cmd.src = src;
+    cmd.box = dest;
+    cmd.index = bitmaps.size();
+    bitmaps.push_back(bitmap);
+    size += sizeof(bitmap_class) + bitmap.pixels.size();
+}
+
+/*
+    Parameters  : text              - The draw text parameter.
+                  pos               - The position parameter.
+    Returns     : void
+    Description : Record a draw text primitive.
+*/
+void printpgobj_list::rend_draw_text(const string &text, const os_coord &pos)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_text(text, pos);
+
+    // Record the primitive
+    cmd_class &cmd = add(cmd_draw_text);
+    cmd.box.x0 = pos.x;
+    cmd.box.y0 = pos.y;
+    cmd.index = add_string(text);
+}
+
+/*
+    Parameters  : text              - The draw text parameters.
+    Returns     : void
+    Description : Record a draw text justified primitive.
+*/
+void printpgobj_list::rend_draw_text_justified(const text_class &text)
+{
+    // Pass on to the base class
+    printrend_base::rend_draw_text_justified(text);
+
+    // Record the primitive
+    add(cmd_draw_text_justified).index = texts.size();
+    texts.push_back(text);
+    size += sizeof(text_class) + text.text.size();
+}
+
+/*
+    Parameters  : error             - The problem that was encountered.
+                  fatal             - Is the problem fatal.
+    Returns     : void
+    Description : Record an error.
+*/
+void printpgobj_list::rend_error(const string &error, bool fatal)
+{
+    // Pass on to the base class to stop decoding after a fatal error
+    printrend_base::rend_error(error, fatal);
+
+    // Record the error
+    add(cmd_error, fatal).index = add_string(error);
+}
+
+/*
+    Parameters  : debug             - The debug message.
+                  important         - Is the message important.
+    Returns     : void
+    Description : Record a debug message.
+*/
+void printpgobj_list::rend_debug(const string &debug, bool important)
+{
+    // Pass on to the base class
+    printrend_base::rend_debug(debug, important);
+
+    // Record the message
+    add(cmd_debug, important).index = add_string(debug);
+}
+
+/*
+    Parameters  : type              - The primitive.
+                  value             - Enumerated or colour parameter.
+    Returns     : cmd_class         - The new primitive.
+    Description : Append a primitive to the display list.
+*/
+printpgobj_list::cmd_class &printpgobj_list::add(cmd_type type, bits value)
+{
+    cmd_class cmd;
+
+    // Construct the primitive with any unused parameters cleared
+    cmd.type = type;
+    cmd.value = value;
+    cmd.box.x0 = cmd.box.y0 = cmd.box.x1 = cmd.box.y1 = 0;
+    cmd.src = cmd.box;
+    cmd.index = 0;
+    cmd.count = 0;
+
+    // Append to the display list
+    cmds.push_back(cmd);
+    size += sizeof(cmd_class);
+
+    // Return a reference to the new primitive
+    return cmds.back();
+}
+
+/*
+    Parameters  : str               - The string to store.
+    Returns     : size_t            - Index of the stored string.
+    Description : Store a string parameter.
+*/
+size_t printpgobj_list::add_string(const string &str)
+{
+    // Store the string
+    strings.push_back(str);
+    size += sizeof(string) + str.size();
+
+    // Return its index
+    return strings.size() - 1;
 }
 
 /*
@@ -940,6 +1577,9 @@ void printpgobj_rend::get_bitmap(printrend_base::bitmap_class &bitmap)
 */
 printpgobj_obj::ref_class::~ref_class()
 {
+    // Discard any cached display list
+    discard();
+
     // Delete the page data if the reference count has reached zero
     if (!count) xosfscontrol_wipe(name.c_str(), osfscontrol_WIPE_RECURSE | osfscontrol_WIPE_FORCE, 0, 0, 0, 0);
 }
@@ -966,6 +1606,105 @@ void printpgobj_obj::ref_class::dec()
     if (!--count) delete this;
 }
 
+/*
+    Parameters  : data      - Variable to receive the page data.
+    Returns     : bool      - Was the page data read successfully.
+    Description : Read the page data into memory.
+*/
+bool printpgobj_obj::ref_class::load(vector<byte> &data) const
+{
+    fileswitch_object_type type;
+    int size;
+    bool loaded = FALSE;
+
+    // Read the whole file in a single operation
+    if (!xosfile_read_stamped_no_path(name.c_str(), &type,
+                                      NULL, NULL, &size, NULL, NULL)
+        && (type == fileswitch_IS_FILE))
+    {
+        data.resize(size, 0);
+        loaded = !size
+                 || !xosfile_load_stamped_no_path(name.c_str(), &data[0],
+                                                  NULL, NULL, NULL, NULL);
+    }
+
+    // Return whether the data is available
+    return loaded;
+}
+
+/*
+    Parameters  : void
+    Returns     : bool      - Is the display list available.
+    Description : Decode the page data into a display list if not already
+                  cached, and mark it as the most recently used.
+*/
+bool printpgobj_obj::ref_class::build()
+{
+    // Decode the page if not already cached
+    if (!list)
+    {
+        // The raw page data is only required while decoding
+        vector<byte> data;
+        if (!load(data)) return FALSE;
+
+        // Record the decoded primitives
+        list = new printpgobj_list;
+        list->rend_begin();
+        printpgobj_rend(data.empty() ? NULL : &data[0], data.size(),
+                        *list).render();
+        list->rend_end();
+        lru_size += list->get_size();
+    }
+    else if (lru_head != this)
+    {
+        // Unlink from the current position in the LRU list
+        if (prev) prev->next = next;
+        if (next) next->prev = prev;
+        else lru_tail = prev;
+    }
+    else return TRUE;
+
+    // Link at the head of the LRU list
+    prev = NULL;
+    next = lru_head;
+    if (lru_head) lru_head->prev = this;
+    else lru_tail = this;
+    lru_head = this;
+
+    // Discard the least recently used display lists if over budget
+    while ((PRINTPGOBJ_LIST_BUDGET < lru_size) && (lru_tail != this))
+    {
+        lru_tail->discard();
+    }
+
+    // The display list is available
+    return TRUE;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Discard the display list, if any.
+*/
+void printpgobj_obj::ref_class::discard()
+{
+    // No action unless a display list is cached
+    if (list)
+    {
+        // Unlink from the LRU list
+        if (prev) prev->next = next;
+        else lru_head = next;
+        if (next) next->prev = prev;
+        else lru_tail = prev;
+        prev = next = NULL;
+
+        // Delete the display list
+        lru_size -= list->get_size();
+        delete list;
+        list = NULL;
+    }
+}
+
 /*
     Parameters  : name              - Name of the file containing the page
                                       data.
@@ -1046,11 +1785,8 @@ void printpgobj_obj::render(printrend_base &rend)
         // Prepare to render this page
         rend.rend_begin();
 
-        // Open a stream on the page data
-        ifstream page(ref->name.c_str(), ios_base::in | ios_base::binary);
-
-        // Render the page
-        if (page) printpgobj_rend(page, rend).render();
+        // Render the page from its cached display list
+        if (ref->build()) ref->list->replay(rend);
         else rend.rend_error(filer_msgtrans("PrnEFOp", ref->name.c_str()), TRUE);
 
         // End rendering this page
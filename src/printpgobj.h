@@ -26,7 +26,7 @@
 
 // Include cathlibcpp header files
 #include "string.h"
-#include "istream.h"
+#include "vector.h"
 
 // Include project header files
 #include "printrend.h"
@@ -37,12 +37,13 @@ class printpgobj_rend
 public:
 
     /*
-        Parameters  : s                 - The stream containing the page data.
+        Parameters  : data              - Pointer to the page data.
+                      size              - Size of the page data.
                       rend              - The object to perform the rendering.
         Returns     : -
         Description : Constructor.
     */
-    printpgobj_rend(istream &s, printrend_base &rend);
+    printpgobj_rend(const byte *data, size_t size, printrend_base &rend);
 
     /*
         Parameters  : -
@@ -60,7 +61,10 @@ public:
 
 private:
 
-    istream &s;                         // Stream used to read the page data
+    const byte *data;                   // Start of the page data
+    const byte *ptr;                    // Next byte of page data to decode
+    const byte *end;                    // End of the page data
+    bool fail;                          // Has the end of the data been passed
     printrend_base &rend;               // Object to perform the rendering
     bool log_debug;                     // Should debug messages be logged
 
@@ -263,6 +267,15 @@ private:
     */
     void debug(const string &debug, bool important = FALSE);
 
+    /*
+        Parameters  : size              - The number of bytes required.
+        Returns     : bool              - Are the bytes available.
+        Description : Check that the specified number of bytes of page data
+                      remain. If not then the remaining data is skipped and
+                      the failure is recorded.
+    */
+    bool check(size_t size);
+
     /*
         Parameters  : void
         Returns     : bits              - The value read from the page data.
@@ -313,6 +326,293 @@ private:
     void get_bitmap(printrend_base::bitmap_class &bitmap);
 };
 
+// Decoded print job page display list class
+class printpgobj_list : public printrend_base
+{
+public:
+
+    // Recorded primitives
+    enum cmd_type
+    {
+        cmd_start,
+        cmd_set_draw_mode,
+        cmd_set_clipping_rect,
+        cmd_cancel_clipping_rect,
+        cmd_use_font,
+        cmd_discard_font,
+        cmd_set_underline_style,
+        cmd_set_strikethrough_style,
+        cmd_line_feed,
+        cmd_carriage_return,
+        cmd_set_pen_colour,
+        cmd_set_pen_style,
+        cmd_set_pen_size,
+        cmd_set_brush_colour,
+        cmd_set_brush_style,
+        cmd_draw_line,
+        cmd_draw_ellipse,
+        cmd_draw_rect,
+        cmd_draw_polygon,
+        cmd_draw_bitmap_rect,
+        cmd_draw_bitmap_src,
+        cmd_draw_text,
+        cmd_draw_text_justified,
+        cmd_error,
+        cmd_debug
+    };
+
+    // Details of a single recorded primitive
+    struct cmd_class
+    {
+        cmd_type type;                  // The primitive
+        bits value;                     // Enumerated or colour parameter
+        os_box box;                     // Coordinate parameters
+        os_box src;                     // Bitmap source rectangle
+        size_t index;                   // Index of other parameters
+        size_t count;                   // Number of polygon vertices
+    };
+
+    /*
+        Parameters  : -
+        Returns     : -
+        Description : Constructor.
+    */
+    printpgobj_list();
+
+    /*
+        Parameters  : -
+        Returns     : -
+        Description : Destructor.
+    */
+    virtual ~printpgobj_list();
+
+    /*
+        Parameters  : rend              - The object to perform the rendering.
+        Returns     : void
+        Description : Replay the recorded primitives using the specified
+                      object.
+    */
+    void replay(printrend_base &rend) const;
+
+    /*
+        Parameters  : void
+        Returns     : size_t            - Approximate memory used in bytes.
+        Description : Estimate the memory used by this display list.
+    */
+    size_t get_size() const;
+
+    /*
+        Parameters  : start             - The start parameters.
+        Returns     : void
+        Description : Record a start primitive.
+    */
+    virtual void rend_start(const start_class &start);
+
+    /*
+        Parameters  : mode              - The draw mode parameters.
+        Returns     : void
+        Description : Record a set draw mode primitive.
+    */
+    virtual void rend_set_draw_mode(draw_mode mode);
+
+    /*
+        Parameters  : clip              - The set clipping rectangle parameters.
+        Returns     : void
+        Description : Record a set clipping rectangle primitive.
+    */
+    virtual void rend_set_clipping_rect(const os_box &clip);
+
+    /*
+        Parameters  : void
+        Returns     : void
+        Description : Record a cancel clipping rectangle primitive.
+    */
+    virtual void rend_cancel_clipping_rect();
+
+    /*
+        Parameters  : font              - The use font parameters.
+        Returns     : void
+        Description : Record a use font primitive.
+    */
+    virtual void rend_use_font(const font_class &font);
+
+    /*
+        Parameters  : void
+        Returns     : void
+        Description : Record a discard font primitive.
+    */
+    virtual void rend_discard_font();
+
+    /*
+        Parameters  : style             - The set underline style parameters.
+        Returns     : void
+        Description : Record a set underline style primitive.
+    */
+    virtual void rend_set_underline_style(font_underline style);
+
+    /*
+        Parameters  : style             - The set strikethrough parameters.
+        Returns     : void
+        Description : Record a set strikethrough style primitive.
+    */
+    virtual void rend_set_strikethrough_style(font_strikethrough style);
+
+    /*
+        Parameters  : void
+        Returns     : void
+        Description : Record a line feed primitive.
+    */
+    virtual void rend_line_feed();
+
+    /*
+        Parameters  : void
+        Returns     : void
+        Description : Record a carriage return primitive.
+    */
+    virtual void rend_carriage_return();
+
+    /*
+        Parameters  : colour            - The set pen colour parameters.
+        Returns     : void
+        Description : Record a set pen colour primitive.
+    */
+    virtual void rend_set_pen_colour(os_colour colour);
+
+    /*
+        Parameters  : style             - The set pen style parameters.
+        Returns     : void
+        Description : Record a set pen style primitive.
+    */
+    virtual void rend_set_pen_style(pen_style style);
+
+    /*
+        Parameters  : size              - The set pen size parameters.
+        Returns     : void
+        Description : Record a set pen size primitive.
+    */
+    virtual void rend_set_pen_size(const os_coord &size);
+
+    /*
+        Parameters  : colour            - The set brush colour parameters.
+        Returns     : void
+        Description : Record a set brush colour primitive.
+    */
+    virtual void rend_set_brush_colour(os_colour colour);
+
+    /*
+        Parameters  : style             - The set brush style parameters.
+        Returns     : void
+        Description : Record a set brush style primitive.
+    */
+    virtual void rend_set_brush_style(brush_style style);
+
+    /*
+        Parameters  : start             - The draw line start parameter.
+                      end               - The draw line end parameter.
+        Returns     : void
+        Description : Record a draw line primitive.
+    */
+    virtual void rend_draw_line(const os_coord &start, const os_coord &end);
+
+    /*
+        Parameters  : ellipse           - The draw ellipse parameters.
+        Returns     : void
+        Description : Record a draw ellipse primitive.
+    */
+    virtual void rend_draw_ellipse(const os_box &ellipse);
+
+    /*
+        Parameters  : rectangle         - The draw rectangle parameters.
+        Returns     : void
+        Description : Record a draw rectangle primitive.
+    */
+    virtual void rend_draw_rect(const os_box &rectangle);
+
+    /*
+        Parameters  : vertices          - The draw polygon parameters.
+                      fill              - The winding rule parameter.
+        Returns     : void
+        Description : Record a draw polygon primitive.
+    */
+    virtual void rend_draw_polygon(const vector<os_coord> &vertices,
+                                   fill_rule fill);
+
+    /*
+        Parameters  : dest              - The destination rectangle parameter.
+                      bitmap            - The draw bitmap parameter.
+        Returns     : void
+        Description : Record a draw bitmap rectangle primitive.
+    */
+    virtual void rend_draw_bitmap_rect(const os_box &dest,
+                                       const bitmap_class &bitmap);
+
+    /*
+        Parameters  : src               - The source rectangle parameter.
+                      dest              - The destination rectangle parameter.
+                      bitmap            - The draw bitmap parameter.
+        Returns     : void
+        Description : Record a draw bitmap source primitive.
+    */
+    virtual void rend_draw_bitmap_src(const os_box &src, const os_box &dest,
+                                      const bitmap_class &bitmap);
+
+    /*
+        Parameters  : text              - The draw text parameter.
+                      pos               - The position parameter.
+        Returns     : void
+        Description : Record a draw text primitive.
+    */
+    virtual void rend_draw_text(const string &text, const os_coord &pos);
+
+    /*
+        Parameters  : text              - The draw text parameters.
+        Returns     : void
+        Description : Record a draw text justified primitive.
+    */
+    virtual void rend_draw_text_justified(const text_class &text);
+
+    /*
+        Parameters  : error             - The problem that was encountered.
+                      fatal             - Is the problem fatal.
+        Returns     : void
+        Description : Record an error.
+    */
+    virtual void rend_error(const string &error, bool fatal = FALSE);
+
+    /*
+        Parameters  : debug             - The debug message.
+                      important         - Is the message important.
+        Returns     : void
+        Description : Record a debug message.
+    */
+    virtual void rend_debug(const string &debug, bool important = FALSE);
+
+private:
+
+    vector<cmd_class> cmds;             // The recorded primitives
+    vector<string> strings;             // Text, error and debug messages
+    vector<font_class> fonts;           // Font details
+    vector<bitmap_class> bitmaps;       // Bitmap details
+    vector<text_class> texts;           // Justified text details
+    vector<os_coord> vertices;          // Polygon vertices
+    size_t size;                        // Approximate memory used
+
+    /*
+        Parameters  : type              - The primitive.
+                      value             - Enumerated or colour parameter.
+        Returns     : cmd_class         - The new primitive.
+        Description : Append a primitive to the display list.
+    */
+    cmd_class &add(cmd_type type, bits value = 0);
+
+    /*
+        Parameters  : str               - The string to store.
+        Returns     : size_t            - Index of the stored string.
+        Description : Store a string parameter.
+    */
+    size_t add_string(const string &str);
+};
+
 // Print job page object class
 class printpgobj_obj
 {
@@ -321,13 +621,16 @@ class printpgobj_obj
     {
         string name;                    // Name of file containing page data
         int count;                      // Number of references
+        printpgobj_list *list;          // Decoded display list
+        ref_class *prev;                // Previous more recently used list
+        ref_class *next;                // Next less recently used list
 
         /*
             Parameters  : void
             Returns     : -
             Description : Constructor.
         */
-        ref_class() : count(1) {}
+        ref_class() : count(1), list(NULL), prev(NULL), next(NULL) {}
 
         /*
             Parameters  : void
@@ -349,9 +652,36 @@ class printpgobj_obj
             Description : Decrement the reference count.
         */
         void dec();
+
+        /*
+            Parameters  : data      - Variable to receive the page data.
+            Returns     : bool      - Was the page data read successfully.
+            Description : Read the page data into memory.
+        */
+        bool load(vector<byte> &data) const;
+
+        /*
+            Parameters  : void
+            Returns     : bool      - Is the display list available.
+            Description : Decode the page data into a display list if not
+                          already cached, and mark it as the most recently
+                          used.
+        */
+        bool build();
+
+        /*
+            Parameters  : void
+            Returns     : void
+            Description : Discard the display list, if any.
+        */
+        void discard();
     };
     ref_class *ref;
 
+    static ref_class *lru_head;         // Most recently used display list
+    static ref_class *lru_tail;         // Least recently used display list
+    static size_t lru_size;             // Total size of cached display lists
+
 public:
 
     /*
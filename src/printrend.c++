@@ -388,6 +388,63 @@ const deque<string> &printrend_base::get_errors() const
     return errors;
 }
 
+/*
+    Parameters  : mode              - The display mode.
+    Returns     : bits              - Number of bits used to store each
+                                      pixel, or 0 if not supported.
+    Description : Find the pixel size for a bitmap display mode.
+*/
+bits printrend_base::get_bpp(display_mode mode)
+{
+    bits bpp;
+
+    // Choose the storage size for the display mode
+    switch (mode)
+    {
+        case display_mode_grey2:        bpp = 1;    break;
+        case display_mode_grey4:        bpp = 2;    break;
+        case display_mode_grey16:       bpp = 4;    break;
+        case display_mode_grey256:      bpp = 8;    break;
+        case display_mode_colour16:     bpp = 4;    break;
+        case display_mode_colour256:    bpp = 8;    break;
+        case display_mode_colour64k:    bpp = 16;   break;
+        case display_mode_colour16m:    bpp = 24;   break;
+        case display_mode_rgb:          bpp = 32;   break;
+        case display_mode_color4k:      bpp = 16;   break;
+        default:                        bpp = 0;    break;
+    }
+
+    // Return the number of bits per pixel
+    return bpp;
+}
+
+/*
+    Parameters  : mode              - The display mode.
+    Returns     : bool              - Can bitmaps using this mode be
+                                      displayed.
+    Description : Check whether a bitmap display mode can be displayed
+                  without conversion. Only the grey scale modes are
+                  supported, since these match the sprite palette.
+*/
+bool printrend_base::get_bitmap_supported(display_mode mode)
+{
+    // Only grey scale modes are supported
+    return (mode == display_mode_grey2) || (mode == display_mode_grey4)
+           || (mode == display_mode_grey16) || (mode == display_mode_grey256);
+}
+
+/*
+    Parameters  : bitmap            - The bitmap details.
+    Returns     : size_t            - Size of the pixel data in bytes.
+    Description : Calculate the size of the pixel data for a bitmap,
+                  with each row padded to a whole number of words.
+*/
+size_t printrend_base::get_bitmap_size(const bitmap_class &bitmap)
+{
+    return ((bitmap.columns * get_bpp(bitmap.mode) + 31) / 32) * 4
+           * bitmap.rows;
+}
+
 /*
     Parameters  : void
     Returns     : start_enum        - The current start block.
@@ -525,3 +582,182 @@ void printrend_base::reset()
     brush.colour = os_COLOUR_WHITE;
     brush.style = brush_style_null;
 }
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Increment the reference count.
+*/
+void printrend_base::pixels_class::ref_class::inc()
+{
+    // Just increment the reference count
+    count++;
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Decrement the reference count.
+*/
+void printrend_base::pixels_class::ref_class::dec()
+{
+    // Decrease the reference count and delete if appropriate
+    if (!--count) delete this;
+}
+
+/*
+    Parameters  : pixels        - The pixel data to share.
+    Returns     : -
+    Description : Constructor.
+*/
+printrend_base::pixels_class::pixels_class(const pixels_class &pixels)
+{
+    // Increase the reference count of the pixel data being shared
+    if (pixels.ref) pixels.ref->inc();
+
+    // Copy the pointer to the reference counted details
+    ref = pixels.ref;
+}
+
+/*
+    Parameters  : -
+    Returns     : -
+    Description : Destructor.
+*/
+printrend_base::pixels_class::~pixels_class()
+{
+    // Decrement the reference count
+    if (ref) ref->dec();
+}
+
+/*
+    Parameters  : pixels        - The pixel data to share.
+    Returns     : pixels_class  - A reference to this object.
+    Description : Pixel data assignment. The data itself is shared rather
+                  than copied.
+*/
+printrend_base::pixels_class &
+printrend_base::pixels_class::operator=(const pixels_class &pixels)
+{
+    // Increase the reference count of the pixel data being shared
+    if (pixels.ref) pixels.ref->inc();
+
+    // Reduce the reference count of the previous pixel data
+    if (ref) ref->dec();
+
+    // Copy the pointer to the reference counted details
+    ref = pixels.ref;
+
+    // Return a pointer to this object
+    return *this;
+}
+
+/*
+    Parameters  : size          - The number of bytes required.
+    Returns     : byte          - Pointer to the zero filled buffer, or NULL
+                                  if the size is zero.
+    Description : Replace the pixel data by a new unshared buffer.
+*/
+byte *printrend_base::pixels_class::alloc(size_t size)
+{
+    // Release any previous pixel data
+    if (ref) ref->dec();
+    ref = NULL;
+
+    // Allocate the new buffer
+    if (size)
+    {
+        ref = new ref_class;
+        ref->data.resize(size, 0);
+    }
+
+    // Return a pointer to the buffer
+    return ref ? &ref->data[0] : NULL;
+}
+
+/*
+    Parameters  : void
+    Returns     : byte          - Pointer to the pixel data, or NULL if there
+                                  is none.
+    Description : Read the pixel data.
+*/
+const byte *printrend_base::pixels_class::data() const
+{
+    return ref ? &ref->data[0] : NULL;
+}
+
+/*
+    Parameters  : void
+    Returns     : size_t        - Size of the pixel data.
+    Description : Read the size of the pixel data.
+*/
+size_t printrend_base::pixels_class::size() const
+{
+    return ref ? ref->data.size() : 0;
+}
+
+/*
+    Parameters  : void
+    Returns     : bits          - Hash of the pixel data.
+    Description : Calculate a hash of the pixel data. The result is
+                  remembered for subsequent calls.
+*/
+bits printrend_base::pixels_class::hash() const
+{
+    bits value = 0;
+
+    // No hash if there is no pixel data
+    if (ref)
+    {
+        // Calculate a FNV-1a hash if not already known
+        if (!ref->hashed)
+        {
+            bits hash = 0x811c9dc5;
+            const byte *ptr = &ref->data[0];
+            for (size_t i = ref->data.size(); i; i--)
+            {
+                hash = (hash ^ *ptr++) * 0x01000193;
+            }
+            ref->hash = hash;
+            ref->hashed = TRUE;
+        }
+        value = ref->hash;
+    }
+
+    // Return the hash
+    return value;
+}
+
+/*
+    Parameters  : pixels        - The pixel data to compare.
+    Returns     : bool          - Is the buffer shared.
+    Description : Check whether both objects refer to the same buffer.
+*/
+bool printrend_base::pixels_class::same(const pixels_class &pixels) const
+{
+    return ref == pixels.ref;
+}
+
+/*
+    Parameters  : void
+    Returns     : bool          - Is this the only reference.
+    Description : Check whether the pixel data is shared.
+*/
+bool printrend_base::pixels_class::unique() const
+{
+    return !ref || (ref->count == 1);
+}
+
+/*
+    Parameters  : lhs           - The first pixel data to compare.
+                  rhs           - The second pixel data to compare.
+    Returns     : bool          - Are the contents the same.
+    Description : Compare two sets of pixel data.
+*/
+bool operator==(const printrend_base::pixels_class &lhs,
+                const printrend_base::pixels_class &rhs)
+{
+    return lhs.same(rhs)
+           || ((lhs.size() == rhs.size()) && (lhs.hash() == rhs.hash())
+               && !memcmp(lhs.data(), rhs.data(), lhs.size()));
+}
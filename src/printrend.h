@@ -43,17 +43,17 @@ public:
     // Display modes
     enum display_mode
     {
-        // display_mode_none,
-        display_mode_grey2 = 1,
-        // display_mode_grey4,
-        // display_mode_grey16,
-        // display_mode_grey256,
-        // display_mode_colour16,
-        // display_mode_colour256,
-        // display_mode_colour64k,
-        // display_mode_colour16m,
-        // display_mode_rgb,
-        // display_mode_color4k
+        display_mode_none,
+        display_mode_grey2,
+        display_mode_grey4,
+        display_mode_grey16,
+        display_mode_grey256,
+        display_mode_colour16,
+        display_mode_colour256,
+        display_mode_colour64k,
+        display_mode_colour16m,
+        display_mode_rgb,
+        display_mode_color4k
     };
 
     // Font posture
@@ -196,6 +196,127 @@ public:
         int baseline;
     };
 
+    // Reference counted bitmap pixel data
+    class pixels_class
+    {
+        // Reference counted details
+        struct ref_class
+        {
+            vector<byte> data;          // The pixel data
+            int count;                  // Number of references
+            bool hashed;                // Has the hash been calculated
+            bits hash;                  // Hash of the pixel data
+
+            /*
+                Parameters  : void
+                Returns     : -
+                Description : Constructor.
+            */
+            ref_class() : count(1), hashed(FALSE), hash(0) {}
+
+            /*
+                Parameters  : void
+                Returns     : void
+                Description : Increment the reference count.
+            */
+            void inc();
+
+            /*
+                Parameters  : void
+                Returns     : void
+                Description : Decrement the reference count.
+            */
+            void dec();
+        };
+        ref_class *ref;
+
+    public:
+
+        /*
+            Parameters  : -
+            Returns     : -
+            Description : Constructor.
+        */
+        pixels_class() : ref(NULL) {}
+
+        /*
+            Parameters  : pixels        - The pixel data to share.
+            Returns     : -
+            Description : Constructor.
+        */
+        pixels_class(const pixels_class &pixels);
+
+        /*
+            Parameters  : -
+            Returns     : -
+            Description : Destructor.
+        */
+        ~pixels_class();
+
+        /*
+            Parameters  : pixels        - The pixel data to share.
+            Returns     : pixels_class  - A reference to this object.
+            Description : Pixel data assignment. The data itself is shared
+                          rather than copied.
+        */
+        pixels_class &operator=(const pixels_class &pixels);
+
+        /*
+            Parameters  : size          - The number of bytes required.
+            Returns     : byte          - Pointer to the zero filled buffer,
+                                          or NULL if the size is zero.
+            Description : Replace the pixel data by a new unshared buffer.
+        */
+        byte *alloc(size_t size);
+
+        /*
+            Parameters  : void
+            Returns     : byte          - Pointer to the pixel data, or NULL
+                                          if there is none.
+            Description : Read the pixel data.
+        */
+        const byte *data() const;
+
+        /*
+            Parameters  : void
+            Returns     : size_t        - Size of the pixel data.
+            Description : Read the size of the pixel data.
+        */
+        size_t size() const;
+
+        /*
+            Parameters  : void
+            Returns     : bits          - Hash of the pixel data.
+            Description : Calculate a hash of the pixel data. The result is
+                          remembered for subsequent calls.
+        */
+        bits hash() const;
+
+        /*
+            Parameters  : pixels        - The pixel data to compare.
+            Returns     : bool          - Is the buffer shared.
+            Description : Check whether both objects refer to the same
+                          buffer.
+        */
+        bool same(const pixels_class &pixels) const;
+
+        /*
+            Parameters  : void
+            Returns     : bool          - Is this the only reference.
+            Description : Check whether the pixel data is shared.
+        */
+        bool unique() const;
+
+        /*
+            Parameters  : lhs           - The first pixel data to compare.
+                          rhs           - The second pixel data to compare.
+            Returns     : bool          - Are the contents the same.
+            Description : Compare two sets of pixel data.
+        */
+        friend bool operator==(const pixels_class &lhs,
+                               const pixels_class &rhs);
+    };
+
     // Bitmap details
     struct bitmap_class
     {
@@ -204,7 +325,7 @@ public:
         bits width;
         bits height;
         display_mode mode;
-        vector<byte> pixels;
+        pixels_class pixels;
     };
 
     // Text details
@@ -454,6 +575,32 @@ public:
     */
     virtual const deque<string> &get_errors() const;
 
+    /*
+        Parameters  : mode              - The display mode.
+        Returns     : bits              - Number of bits used to store each
+                                          pixel, or 0 if not supported.
+        Description : Find the pixel size for a bitmap display mode.
+    */
+    static bits get_bpp(display_mode mode);
+
+    /*
+        Parameters  : mode              - The display mode.
+        Returns     : bool              - Can bitmaps using this mode be
+                                          displayed.
+        Description : Check whether a bitmap display mode can be displayed
+                      without conversion. Only the grey scale modes are
+                      supported, since these match the sprite palette.
+    */
+    static bool get_bitmap_supported(display_mode mode);
+
+    /*
+        Parameters  : bitmap            - The bitmap details.
+        Returns     : size_t            - Size of the pixel data in bytes.
+        Description : Calculate the size of the pixel data for a bitmap,
+                      with each row padded to a whole number of words.
+    */
+    static size_t get_bitmap_size(const bitmap_class &bitmap);
+
 protected:
 
     /*
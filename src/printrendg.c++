@@ -43,6 +43,18 @@ static const int printrendg_dot = 1;
 static const int printrendg_dash = printrendg_thickness * 3;
 static const int printrendg_gap = printrendg_thickness * 3;
 
+// Sprites that may be shared by identical bitmaps
+struct printrendg_sprite
+{
+    printrend_base::pixels_class pixels; // The original pixel data
+    bits bpp;                           // Number of bits per pixel
+    bits columns;                       // Width in pixels
+    bits rows;                          // Height in pixels
+    drawobj_sprite *sprite;             // Sprite to share the data of
+    printrendg_sprite *next;            // The next cached sprite
+};
+static printrendg_sprite *printrendg_sprites = NULL;
+
 // Settings for debug messages
 static const char printrendg_debug_font[] = "Corpus.Medium";
 static const int printrendg_debug_size = transform_to_point16.inverse(4 * 16);
@@ -78,6 +90,10 @@ printrendg_graph::~printrendg_graph()
 {
     // Delete any clipping object that may still exist
     delete(clip_obj);
+
+    // Release this page's sprites and discard any cached sprites now unused
+    draw = drawobj_file();
+    flush_sprites();
 }
 
 /*
@@ -192,8 +208,6 @@ void printrendg_graph::rend_draw_polygon(const vector<os_coord> &vertices,
 void printrendg_graph::rend_draw_bitmap_rect(const os_box &dest,
                                              const bitmap_class &bitmap)
 {
-    // ... Should decode bpp properly
-
     // Pass on to the base class
     printrend_base::rend_draw_bitmap_rect(dest, bitmap);
 
@@ -201,13 +215,13 @@ void printrendg_graph::rend_draw_bitmap_rect(const os_box &dest,
     os_box pos = from_twips(dest);
 
     // Construct the sprite object
-    drawobj_sprite *obj = new drawobj_sprite(1/*bitmap.bpp*/, bitmap.columns,
-                                             bitmap.rows);
-    obj->set_box(pos);
-    obj->set_bitmap(bitmap.pixels);
-
-    // Add to the draw file
-    add(obj);
+    drawobj_sprite *obj = make_sprite(bitmap);
+    if (obj)
+    {
+        // Add to the draw file
+        obj->set_box(pos);
+        add(obj);
+    }
 }
 
 /*
@@ -221,7 +235,6 @@ void printrendg_graph::rend_draw_bitmap_src(const os_box &src,
                                             const os_box &dest,
                                             const bitmap_class &bitmap)
 {
-    // ... Should decode bpp properly
     // ... Should use the source rectangle
 
     // Pass on to the base class
@@ -231,13 +244,13 @@ void printrendg_graph::rend_draw_bitmap_src(const os_box &src,
     os_box pos = from_twips(dest);
 
     // Construct the sprite object
-    drawobj_sprite *obj = new drawobj_sprite(1/*bitmap.bpp*/, bitmap.columns,
-                                             bitmap.rows);
-    obj->set_box(pos);
-    obj->set_bitmap(bitmap.pixels);
-
-    // Add to the draw file
-    add(obj);
+    drawobj_sprite *obj = make_sprite(bitmap);
+    if (obj)
+    {
+        // Add to the draw file
+        obj->set_box(pos);
+        add(obj);
+    }
 }
 
 /*
@@ -558,6 +571,74 @@ drawobj_path *printrendg_graph::make_text_lines(const fontobj_obj &justify)
     return obj;
 }
 
+/*
+    Parameters  : bitmap            - The bitmap details.
+    Returns     : drawobj_sprite    - The sprite object, or NULL if the
+                                      display mode is not supported.
+    Description : Create a sprite object for a bitmap. The sprite data is
+                  shared with any previous sprite for an identical bitmap,
+                  such as a logo repeated on every page.
+*/
+drawobj_sprite *printrendg_graph::make_sprite(const bitmap_class &bitmap)
+{
+    // No sprite for modes that cannot be displayed (already reported)
+    if (!get_bitmap_supported(bitmap.mode)) return NULL;
+    bits bpp = get_bpp(bitmap.mode);
+
+    // Discard any sprites that are no longer used
+    flush_sprites();
+
+    // Search for a sprite with identical pixel data
+    printrendg_sprite *found = printrendg_sprites;
+    while (found && ((found->bpp != bpp)
+                     || (found->columns != bitmap.columns)
+                     || (found->rows != bitmap.rows)
+                     || !(found->pixels == bitmap.pixels)))
+    {
+        found = found->next;
+    }
+
+    // Create a new sprite if no match found
+    if (!found)
+    {
+        found = new printrendg_sprite;
+        found->pixels = bitmap.pixels;
+        found->bpp = bpp;
+        found->columns = bitmap.columns;
+        found->rows = bitmap.rows;
+        found->sprite = new drawobj_sprite(bpp, bitmap.columns, bitmap.rows);
+        found->sprite->set_bitmap(bitmap.pixels.data(), bitmap.pixels.size());
+        found->next = printrendg_sprites;
+        printrendg_sprites = found;
+    }
+
+    // Return a new object sharing the sprite data
+    return new drawobj_sprite(*found->sprite);
+}
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Discard any cached sprites that are no longer used by
+                  any bitmap or draw file.
+*/
+void printrendg_graph::flush_sprites()
+{
+    printrendg_sprite **ptr = &printrendg_sprites;
+    while (*ptr)
+    {
+        printrendg_sprite *cached = *ptr;
+        if (cached->pixels.unique() && cached->sprite->unique())
+        {
+            // Discard sprites that are no longer used by any bitmap or page
+            *ptr = cached->next;
+            delete cached->sprite;
+            delete cached;
+        }
+        else ptr = &cached->next;
+    }
+}
+
 /*
     Parameters  : obj               - The draw object to add.
     Returns     : void
@@ -189,6 +189,24 @@ private:
     */
     drawobj_path *make_text_lines(const fontobj_obj &justify);
 
+    /*
+        Parameters  : bitmap            - The bitmap details.
+        Returns     : drawobj_sprite    - The sprite object, or NULL if the
+                                          display mode is not supported.
+        Description : Create a sprite object for a bitmap. The sprite data is
+                      shared with any previous sprite for an identical
+                      bitmap, such as a logo repeated on every page.
+    */
+    drawobj_sprite *make_sprite(const bitmap_class &bitmap);
+
+    /*
+        Parameters  : void
+        Returns     : void
+        Description : Discard any cached sprites that are no longer used by
+                      any bitmap or draw file.
+    */
+    static void flush_sprites();
+
     /*
         Parameters  : obj               - The draw object to add.
         Returns     : void
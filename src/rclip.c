@@ -279,7 +279,8 @@ static os_error *rclip_lnkchan_callback(void *user, os_error *err,
 }
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - User defined handle for this channel.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -287,7 +288,8 @@ static os_error *rclip_lnkchan_callback(void *user, os_error *err,
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-static os_error *rclip_poll(mux_events event, const byte *data, bits size)
+static os_error *rclip_poll(void *user, mux_events event,
+                            const byte *data, bits size)
 {
     os_error *err = NULL;
 
@@ -363,7 +365,8 @@ os_error *rclip_start(void)
 
         // Create the channel
         err = mux_chan_create(RCLIP_CHANNEL_NAME, 0, TRUE, FALSE, rclip_poll,
-                              RCLIP_MAX_FRAME, &rclip_channel);
+                              NULL, RCLIP_MAX_FRAME, MUX_CLASS_INTERACTIVE,
+                              &rclip_channel);
 
         // Set the active flag if successful
         if (!err) rclip_active = TRUE;
@@ -107,13 +107,14 @@ os_error *rfsv16_back(const rfsv16_cmd *cmd, rfsv16_reply *reply,
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Function to start an operation.
 */
-static os_error *rfsv16_send(const void *cmd, void *reply)
+static os_error *rfsv16_send(void *user, const void *cmd, void *reply)
 {
     os_error *err = NULL;
     static byte buffer[RFSV16_MAX_FRAME];
@@ -389,7 +390,8 @@ static os_error *rfsv16_get_p_dinfo(epoc16_p_dinfo *entry)
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
                   data          - Pointer to the received data, or NULL if
                                   none.
@@ -398,7 +400,7 @@ static os_error *rfsv16_get_p_dinfo(epoc16_p_dinfo *entry)
                                   NULL if no error.
     Description : Function to end an operation.
 */
-static os_error *rfsv16_receive(const void *cmd, void *reply,
+static os_error *rfsv16_receive(void *user, const void *cmd, void *reply,
                                 const byte *data, bits size)
 {
     os_error *err = NULL;
@@ -573,7 +575,8 @@ static os_error *rfsv16_lnkchan_callback(void *user, os_error *err,
 }
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - User defined handle for this channel.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -581,7 +584,8 @@ static os_error *rfsv16_lnkchan_callback(void *user, os_error *err,
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-static os_error *rfsv16_poll(mux_events event, const byte *data, bits size)
+static os_error *rfsv16_poll(void *user, mux_events event,
+                             const byte *data, bits size)
 {
     os_error *err = NULL;
 
@@ -597,7 +601,7 @@ static os_error *rfsv16_poll(mux_events event, const byte *data, bits size)
         case MUX_EVENT_SERVER_CONNECTED:
             // Connected to remote server
             err = share_create(&rfsv16_share_handle,
-                               rfsv16_send, rfsv16_receive);
+                               rfsv16_send, rfsv16_receive, NULL);
             break;
 
         case MUX_EVENT_SERVER_DISCONNECTED:
@@ -654,7 +658,8 @@ os_error *rfsv16_start(void)
     {
         // Create the channel
         err = mux_chan_create(RFSV16_CHANNEL_NAME, 0, TRUE, FALSE, rfsv16_poll,
-                              RFSV16_MAX_FRAME, &rfsv16_channel);
+                              NULL, RFSV16_MAX_FRAME, MUX_CLASS_NORMAL,
+                              &rfsv16_channel);
 
         // Set the active flag if successful
         if (!err) rfsv16_active = TRUE;
@@ -38,22 +38,30 @@
 
 // The channel details
 #define RFSV32_CHANNEL_NAME "SYS$RFSV.*"
-static mux_channel rfsv32_channel;
 
 // Link details for this channel
 #define RFSV32_LNKCHAN_NAME "SYS$RFSV"
-static lnkchan_reply rfsv32_lnkchan_reply;
 
-// Is the channel active
+// Maximum operation ID
+#define RFSV32_MAX_ID (0xffff)
+
+// Details for each server session
+typedef struct
+{
+    bool active;
+    mux_channel channel;
+    lnkchan_reply lnkchan_reply;
+    share_handle share;
+    bits id;
+} rfsv32_session;
+static rfsv32_session rfsv32_session_list[RFSV32_SESSIONS];
+
+// Are the channels active
 static bool rfsv32_active = FALSE;
 
-// Shared access handler
+// Shared access handler for the primary session
 share_handle rfsv32_share_handle = SHARE_NONE;
 
-// Current operation ID
-#define RFSV32_MAX_ID (0xffff)
-static bits rfsv32_id = 0;
-
 // Mask for sting lengths
 #define RFSV32_LEN_MASK_WORD (0x8000)
 #define RFSV32_LEN_MASK_BITS (0xf0000000)
@@ -114,6 +122,54 @@ os_error *rfsv32_back(const rfsv32_cmd *cmd, rfsv32_reply *reply,
     return err;
 }
 
+/*
+    Parameters  : session       - The server session to use.
+                  cmd           - The data for the command to perform.
+                  reply         - Pointer to block to receive response data.
+                  user          - User defined handle for this operation.
+                  callback      - Callback function to call when the operation
+                                  has completed (both for success and failure).
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform the specified operation when the specified RFSV
+                  session becomes idle. This is otherwise identical to
+                  rfsv32_back. Any file handles are only valid for the session
+                  that opened them.
+*/
+os_error *rfsv32_back_session(bits session, const rfsv32_cmd *cmd,
+                              rfsv32_reply *reply, void *user,
+                              share_callback callback)
+{
+    os_error *err = NULL;
+
+    // Check parameters
+    if ((RFSV32_SESSIONS <= session) || !cmd || !reply || !callback)
+    {
+        err = &err_bad_parms;
+    }
+    else
+    {
+        // Perform the operation
+        err = share_back(rfsv32_session_list[session].share,
+                         cmd, reply, user, callback);
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : session       - The server session to check.
+    Returns     : bool          - Is the session connected.
+    Description : Check whether the specified server session is connected.
+*/
+bool rfsv32_connected(bits session)
+{
+    // Return the status of the session
+    return (session < RFSV32_SESSIONS)
+           && (rfsv32_session_list[session].share != SHARE_NONE);
+}
+
 /*
     Parameters  : value         - The string value to append.
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -140,32 +196,38 @@ static os_error *rfsv32_put_des(const char *value)
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - The server session.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Function to start an operation.
 */
-static os_error *rfsv32_send(const void *cmd, void *reply)
+static os_error *rfsv32_send(void *user, const void *cmd, void *reply)
 {
     os_error *err = NULL;
-    static byte buffer[RFSV32_MAX_FRAME];
+    rfsv32_session *session = (rfsv32_session *) user;
     rfsv32_cmd *in = (rfsv32_cmd *) cmd;
+    byte *buffer;
+    bits size;
 
     // Check parameters
-    if (!cmd || !reply) err = &err_bad_parms;
-    else
+    if (!session || !cmd || !reply) err = &err_bad_parms;
+
+    // Build the command directly in the channel's transmit buffer
+    if (!err) err = mux_chan_tx_server_buffer(session->channel, &buffer, &size);
+    if (!err)
     {
         bits offset = 0;
 
         // Choose a new operation ID
-        if (rfsv32_id < RFSV32_MAX_ID) rfsv32_id++;
-        else rfsv32_id = 0;
+        if (session->id < RFSV32_MAX_ID) session->id++;
+        else session->id = 0;
 
         // Write the standard header
-        err = parse_put_start(buffer, RFSV32_MAX_FRAME, &offset);
+        err = parse_put_start(buffer, size, &offset);
         if (!err) err = parse_put_word(in->op);
-        if (!err) err = parse_put_word(rfsv32_id);
+        if (!err) err = parse_put_word(session->id);
 
         // Add any command specific data
         switch (in->op)
@@ -217,15 +279,11 @@ static os_error *rfsv32_send(const void *cmd, void *reply)
 
             case RFSV32_REQ_WRITE_FILE:
                 // Write to a remote file
+                if (!err) err = parse_put_bits(in->data.req_write_file.handle);
+                if (!err && in->data.req_write_file.length)
                 {
-                    bits i;
-                    const byte *ptr = (const byte *) in->data.req_write_file.buffer;
-
-                    if (!err) err = parse_put_bits(in->data.req_write_file.handle);
-                    for (i = 0; !err && (i < in->data.req_write_file.length); i++)
-                    {
-                        err = parse_put_byte(*ptr++);
-                    }
+                    err = parse_put_bytes(in->data.req_write_file.length,
+                                          in->data.req_write_file.buffer);
                 }
                 break;
 
@@ -378,7 +436,10 @@ static os_error *rfsv32_send(const void *cmd, void *reply)
         }
 
         // Send the command
-        if (!err) err = mux_chan_tx_server(rfsv32_channel, buffer, offset);
+        if (!err)
+        {
+            err = mux_chan_tx_server(session->channel, buffer, offset);
+        }
     }
 
     // Return any error produced
@@ -505,7 +566,8 @@ static os_error *rfsv32_get_volume_info(epoc32_volume_info *volume)
 }
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - The server session.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
                   data          - Pointer to the received data, or NULL if
                                   none.
@@ -514,15 +576,16 @@ static os_error *rfsv32_get_volume_info(epoc32_volume_info *volume)
                                   NULL if no error.
     Description : Function to end an operation.
 */
-static os_error *rfsv32_receive(const void *cmd, void *reply,
+static os_error *rfsv32_receive(void *user, const void *cmd, void *reply,
                                 const byte *data, bits size)
 {
     os_error *err = NULL;
+    rfsv32_session *session = (rfsv32_session *) user;
     rfsv32_cmd *in = (rfsv32_cmd *) cmd;
     rfsv32_reply *out = (rfsv32_reply *) reply;
 
     // Check parameters
-    if (!cmd || !reply || !data) err = &err_bad_parms;
+    if (!session || !cmd || !reply || !data) err = &err_bad_parms;
     else
     {
         bits offset = 0;
@@ -534,7 +597,7 @@ static os_error *rfsv32_receive(const void *cmd, void *reply,
         if (!err) err = parse_get_word(&value);
         if (!err && (value != RFSV32_RESPONSE)) err = &err_not_rfsv_reply;
         if (!err) err = parse_get_word(&value);
-        if (!err && (value != rfsv32_id)) err = &err_bad_rfsv_reply;
+        if (!err && (value != session->id)) err = &err_bad_rfsv_reply;
         if (!err) err = parse_get_bits(&status);
         if (!err)
         {
@@ -703,7 +766,32 @@ static os_error *rfsv32_receive(const void *cmd, void *reply,
 }
 
 /*
-    Parameters  : user          - User specified handle for this operation.
+    Parameters  : session       - The server session to end.
+                  now           - Should the link usage terminate immediately.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Destroy the channel for a single server session.
+*/
+static os_error *rfsv32_end_session(rfsv32_session *session, bool now)
+{
+    os_error *err = NULL;
+
+    // No action unless active
+    if (session->active)
+    {
+        // Destroy the channel
+        err = mux_chan_destroy(session->channel, now);
+
+        // Clear the active flag if successful
+        if (!err) session->active = FALSE;
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : user          - The server session.
                   err           - Any error produced by the operation.
                   reply         - The reply data block passed when the
                                   operation was queued, filled with any
@@ -715,16 +803,22 @@ static os_error *rfsv32_receive(const void *cmd, void *reply,
 static os_error *rfsv32_lnkchan_callback(void *user, os_error *err,
                                          const void *reply)
 {
+    rfsv32_session *session = (rfsv32_session *) user;
+
     // Check if an error was produced
     if (err)
     {
-        // Close this channel
-        err = rfsv32_end(FALSE);
+        // Close this channel, or all channels for the primary session
+        if (session == &rfsv32_session_list[RFSV32_SESSION_PRIMARY])
+        {
+            err = rfsv32_end(FALSE);
+        }
+        else err = rfsv32_end_session(session, FALSE);
     }
     else
     {
         // Retry the connection
-        err = mux_chan_connect(rfsv32_channel, reply);
+        err = mux_chan_connect(session->channel, reply);
     }
 
     // Return any error produced
@@ -732,7 +826,8 @@ static os_error *rfsv32_lnkchan_callback(void *user, os_error *err,
 }
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - The server session.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -740,40 +835,42 @@ static os_error *rfsv32_lnkchan_callback(void *user, os_error *err,
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-static os_error *rfsv32_poll(mux_events event, const byte *data, bits size)
+static os_error *rfsv32_poll(void *user, mux_events event,
+                             const byte *data, bits size)
 {
     os_error *err = NULL;
+    rfsv32_session *session = (rfsv32_session *) user;
 
     // Action depends on the event
     switch (event)
     {
         case MUX_EVENT_SERVER_FAILED:
             // Failed to connect to remote server
-            err = lnkchan_register(RFSV32_LNKCHAN_NAME, rfsv32_lnkchan_reply,
-                                   NULL, rfsv32_lnkchan_callback);
+            err = lnkchan_register(RFSV32_LNKCHAN_NAME, session->lnkchan_reply,
+                                   session, rfsv32_lnkchan_callback);
             break;
 
         case MUX_EVENT_SERVER_CONNECTED:
             // Connected to remote server
-            err = share_create(&rfsv32_share_handle,
-                               rfsv32_send, rfsv32_receive);
+            err = share_create(&session->share,
+                               rfsv32_send, rfsv32_receive, session);
             break;
 
         case MUX_EVENT_SERVER_DISCONNECTED:
             // Disconnected from remote server
-            err = share_destroy(&rfsv32_share_handle);
+            err = share_destroy(&session->share);
             break;
 
         case MUX_EVENT_SERVER_DATA:
             // Data received from remote server
-            err = share_poll_data(rfsv32_share_handle, data, size);
+            err = share_poll_data(session->share, data, size);
             break;
 
         case MUX_EVENT_IDLE:
             // Multiplexor is idle for this channel
-            if (rfsv32_share_handle != SHARE_NONE)
+            if (session->share != SHARE_NONE)
             {
-                err = share_poll_idle(rfsv32_share_handle);
+                err = share_poll_idle(session->share);
             }
             break;
 
@@ -792,6 +889,12 @@ static os_error *rfsv32_poll(mux_events event, const byte *data, bits size)
             break;
     }
 
+    // The primary session is also used to check the connection status
+    if (session == &rfsv32_session_list[RFSV32_SESSION_PRIMARY])
+    {
+        rfsv32_share_handle = session->share;
+    }
+
     // Return any error produced
     return err;
 }
@@ -800,7 +903,7 @@ static os_error *rfsv32_poll(mux_events event, const byte *data, bits size)
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Create a client channel for the remote file services.
+    Description : Create the client channels for the remote file services.
 */
 os_error *rfsv32_start(void)
 {
@@ -811,12 +914,32 @@ os_error *rfsv32_start(void)
     // No action if already active
     if (!rfsv32_active)
     {
-        // Create the channel
-        err = mux_chan_create(RFSV32_CHANNEL_NAME, 0, TRUE, FALSE, rfsv32_poll,
-                              RFSV32_MAX_FRAME, &rfsv32_channel);
+        bits index;
+
+        // Create a channel for each session
+        for (index = 0; !err && (index < RFSV32_SESSIONS); index++)
+        {
+            rfsv32_session *session = &rfsv32_session_list[index];
+
+            session->share = SHARE_NONE;
+            session->id = 0;
+            err = mux_chan_create(RFSV32_CHANNEL_NAME, 0, TRUE, FALSE,
+                                  rfsv32_poll, session, RFSV32_MAX_FRAME,
+                                  index ? MUX_CLASS_BULK : MUX_CLASS_NORMAL,
+                                  &session->channel);
+            session->active = !err;
+        }
 
         // Set the active flag if successful
         if (!err) rfsv32_active = TRUE;
+        else
+        {
+            // Tidy up any sessions that were created
+            for (index = 0; index < RFSV32_SESSIONS; index++)
+            {
+                rfsv32_end_session(&rfsv32_session_list[index], TRUE);
+            }
+        }
     }
 
     // Return any error produced
@@ -827,7 +950,7 @@ os_error *rfsv32_start(void)
     Parameters  : now           - Should the link usage terminate immediately.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Destroy the remote file services client channel.
+    Description : Destroy the remote file services client channels.
 */
 os_error *rfsv32_end(bool now)
 {
@@ -838,8 +961,13 @@ os_error *rfsv32_end(bool now)
     // No action unless active
     if (rfsv32_active)
     {
-        // Destroy the channel
-        if (!err) err = mux_chan_destroy(rfsv32_channel, now);
+        bits index;
+
+        // Destroy the channels, secondary sessions first
+        for (index = RFSV32_SESSIONS; !err && index--;)
+        {
+            err = rfsv32_end_session(&rfsv32_session_list[index], now);
+        }
 
         // Clear the active flag if successful
         if (!err) rfsv32_active = FALSE;
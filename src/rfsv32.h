@@ -315,7 +315,11 @@ typedef union
     } req_drive_name;
 } rfsv32_reply;
 
-// Shared access handler
+// Number of concurrent server sessions
+#define RFSV32_SESSIONS (3)
+#define RFSV32_SESSION_PRIMARY (0)
+
+// Shared access handler for the primary session
 extern share_handle rfsv32_share_handle;
 
 #ifdef __cplusplus
@@ -350,6 +354,31 @@ os_error *rfsv32_fore(const rfsv32_cmd *cmd, rfsv32_reply *reply, bool escape);
 os_error *rfsv32_back(const rfsv32_cmd *cmd, rfsv32_reply *reply,
                       void *user, share_callback callback);
 
+/*
+    Parameters  : session       - The server session to use.
+                  cmd           - The data for the command to perform.
+                  reply         - Pointer to block to receive response data.
+                  user          - User defined handle for this operation.
+                  callback      - Callback function to call when the operation
+                                  has completed (both for success and failure).
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform the specified operation when the specified RFSV
+                  session becomes idle. This is otherwise identical to
+                  rfsv32_back. Any file handles are only valid for the session
+                  that opened them.
+*/
+os_error *rfsv32_back_session(bits session, const rfsv32_cmd *cmd,
+                              rfsv32_reply *reply, void *user,
+                              share_callback callback);
+
+/*
+    Parameters  : session       - The server session to check.
+    Returns     : bool          - Is the session connected.
+    Description : Check whether the specified server session is connected.
+*/
+bool rfsv32_connected(bits session);
+
 /*
     Parameters  : void
     Returns     : os_error *    - Pointer to a corresponding error block, or
@@ -0,0 +1,88 @@
+/*
+    File        : rle.c
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Decoding of the run length encoded bitmap data used in
+                  EPOC print jobs.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Include header file for this module
+#include "rle.h"
+
+// Include clib header files
+#include <string.h>
+
+// Run markers
+#define RLE_LITERAL (0x80)
+
+/*
+    Parameters  : src   - Variable containing a pointer to the encoded data.
+                          This is updated to point after the data processed.
+                  stop  - End of the encoded data.
+                  dest  - Buffer to receive the decoded data.
+                  size  - Size of the buffer.
+    Returns     : bool  - Was the encoded data complete.
+    Description : Decode run length encoded data directly into a
+                  preallocated buffer. Any decoded data beyond the end of the
+                  buffer is discarded.
+*/
+bool rle_decode(const byte **src, const byte *stop, byte *dest, size_t size)
+{
+    bool complete = TRUE;
+    const byte *ptr = *src;
+
+    // Process all of the runs
+    while (ptr < stop)
+    {
+        bits marker = *ptr++;
+        if (marker < RLE_LITERAL)
+        {
+            // A single byte repeated
+            if (ptr == stop) complete = FALSE;
+            else
+            {
+                size_t run = marker + 1;
+                if (size < run) run = size;
+                if (run) memset(dest, *ptr, run);
+                ptr++;
+                dest += run;
+                size -= run;
+            }
+        }
+        else
+        {
+            // A sequence of literal bytes
+            size_t raw = 0x100 - marker;
+            size_t run;
+            if ((size_t) (stop - ptr) < raw)
+            {
+                complete = FALSE;
+                raw = stop - ptr;
+            }
+            run = size < raw ? size : raw;
+            if (run) memcpy(dest, ptr, run);
+            dest += run;
+            size -= run;
+            ptr += raw;
+        }
+    }
+
+    // Return the updated pointer and status
+    *src = ptr;
+    return complete;
+}
@@ -0,0 +1,58 @@
+/*
+    File        : rle.h
+    Date        : 16-Oct-26
+    Author      : © A.Thoukydides, 2026
+    Description : Decoding of the run length encoded bitmap data used in
+                  EPOC print jobs.
+
+    License     : PsiFS is free software: you can redistribute it and/or
+                  modify it under the terms of the GNU General Public License
+                  as published by the Free Software Foundation, either
+                  version 3 of the License, or (at your option) any later
+                  version.
+
+                  PsiFS is distributed in the hope that it will be useful,
+                  but WITHOUT ANY WARRANTY; without even the implied warranty
+                  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+                  the GNU General Public License for more details.
+
+                  You should have received a copy of the GNU General Public
+                  License along with PsiFS. If not, see
+                  <http://www.gnu.org/licenses/>.
+*/
+
+// Only include header file once
+#ifndef RLE_H
+#define RLE_H
+
+// Include clib header files
+#include <stddef.h>
+
+// Include oslib header files
+#include "oslib/types.h"
+
+// Maximum expansion of run length encoded data
+#define RLE_MAX_EXPANSION (0x40)
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/*
+    Parameters  : src   - Variable containing a pointer to the encoded data.
+                          This is updated to point after the data processed.
+                  stop  - End of the encoded data.
+                  dest  - Buffer to receive the decoded data.
+                  size  - Size of the buffer.
+    Returns     : bool  - Was the encoded data complete.
+    Description : Decode run length encoded data directly into a
+                  preallocated buffer. Any decoded data beyond the end of the
+                  buffer is discarded.
+*/
+bool rle_decode(const byte **src, const byte *stop, byte *dest, size_t size);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
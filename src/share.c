@@ -49,6 +49,7 @@ struct share_handle
 {
     share_send send;
     share_receive receive;
+    void *user;
     share_op *free;
     share_op *active;
     share_op *pending;
@@ -204,7 +205,8 @@ os_error *share_poll_idle(share_handle handle)
             handle->timeout_started = FALSE;
 
             // Attempt to start the next operation
-            err = (*handle->send)(handle->active->cmd, handle->active->reply);
+            err = (*handle->send)(handle->user, handle->active->cmd,
+                                  handle->active->reply);
 
             // Handle failure to start the operation
             if (err)
@@ -244,8 +246,8 @@ os_error *share_poll_data(share_handle handle, const byte *data, bits size)
         if (handle->active)
         {
             // Call the data handler
-            err = (*handle->receive)(handle->active->cmd, handle->active->reply,
-                                     data, size);
+            err = (*handle->receive)(handle->user, handle->active->cmd,
+                                     handle->active->reply, data, size);
 
             // Call the callback function
             err = share_call_callback(handle, err, handle->active->reply);
@@ -432,13 +434,15 @@ os_error *share_back(share_handle handle, const void *cmd, void *reply,
     Parameters  : handle        - Variable to receive the shared channel handle.
                   send          - Function to send a message.
                   receive       - Function to handle a reply.
+                  user          - User defined handle for this channel, passed
+                                  to the send and receive functions.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Create a new shared channel. This allocates a unique handle
                   for a connected server channel.
 */
 os_error *share_create(share_handle *handle, share_send send,
-                       share_receive receive)
+                       share_receive receive, void *user)
 {
     os_error *err = NULL;
 
@@ -455,6 +459,7 @@ os_error *share_create(share_handle *handle, share_send send,
         {
             (*handle)->send = send;
             (*handle)->receive = receive;
+            (*handle)->user = user;
             (*handle)->free = NULL;
             (*handle)->active = NULL;
             (*handle)->pending = NULL;
@@ -53,16 +53,18 @@ typedef os_error *(* share_callback)(void *user, os_error *err,
                                      const void *reply);
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Function to start an operation.
 */
-typedef os_error *(* share_send)(const void *cmd, void *reply);
+typedef os_error *(* share_send)(void *user, const void *cmd, void *reply);
 
 /*
-    Parameters  : cmd           - The data for the command to perform.
+    Parameters  : user          - User specified handle for this channel.
+                  cmd           - The data for the command to perform.
                   reply         - Pointer to block to receive response data.
                   data          - Pointer to the received data, or NULL if
                                   none.
@@ -71,7 +73,7 @@ typedef os_error *(* share_send)(const void *cmd, void *reply);
                                   NULL if no error.
     Description : Function to end an operation.
 */
-typedef os_error *(* share_receive)(const void *cmd, void *reply,
+typedef os_error *(* share_receive)(void *user, const void *cmd, void *reply,
                                     const byte *data, bits size);
 
 /*
@@ -129,13 +131,15 @@ os_error *share_back(share_handle handle, const void *cmd, void *reply,
     Parameters  : handle        - Variable to receive the shared channel handle.
                   send          - Function to send a message.
                   receive       - Function to handle a reply.
+                  user          - User defined handle for this channel, passed
+                                  to the send and receive functions.
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
     Description : Create a new shared channel. This allocates a unique handle
                   for a connected server channel.
 */
 os_error *share_create(share_handle *handle, share_send send,
-                       share_receive receive);
+                       share_receive receive, void *user);
 
 /*
     Parameters  : handle        - Variable containing the shared channel handle.
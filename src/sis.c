@@ -51,6 +51,9 @@ typedef struct
 {
     bits reference;
     os_fw file;
+    byte *window;
+    bits window_start;
+    bits window_used;
 } sis_common;
 
 // SIS file version information
@@ -205,8 +208,8 @@ struct sis_handle
 // Offsets to fields within component record
 #define SIS_COMPONENT_OFFSET (0x04)
 
-// Size of buffer for copying between files
-#define SIS_BUFFER_SIZE (1024)
+// Size of the window used to buffer reads from SIS files
+#define SIS_WINDOW_SIZE (8192)
 
 // Directory for residual SIS files
 #define SIS_RESIDUAL_DIR ":C.$.System.Install."
@@ -298,6 +301,80 @@ static os_error *sis_put_bits(os_fw handle, bits offset, bits value)
     return err;
 }
 
+/*
+    Parameters  : handle        - Handle of the SIS file to read from.
+                  offset        - Offset from the start of the file at which to
+                                  read.
+                  data          - Variable to receive a pointer to the
+                                  buffered data.
+                  size          - Variable to receive the number of bytes
+                                  available at the pointer.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Ensure that the read window contains the specified offset,
+                  refilling it with an aligned block from the SIS file if
+                  required. The returned data remains valid until the next
+                  read from any handle for the same SIS file.
+*/
+static os_error *sis_get_window(sis_handle handle, bits offset,
+                                const byte **data, bits *size)
+{
+    os_error *err = NULL;
+
+    // Check function parameters
+    if (!handle || !data || !size) err = &err_bad_parms;
+    else
+    {
+        sis_common *common = handle->common;
+        bits ptr = handle->start + offset;
+
+        // Check the file pointer
+        if (handle->end <= ptr) err = &err_sis_read_outside;
+
+        // Allocate the window when first used
+        if (!err && !common->window)
+        {
+            common->window = (byte *) MEM_MALLOC(SIS_WINDOW_SIZE);
+            if (!common->window) err = &err_buffer;
+            common->window_used = 0;
+        }
+
+        // Refill the window if the offset is not already buffered
+        if (!err && ((ptr < common->window_start)
+                     || (common->window_start + common->window_used <= ptr)))
+        {
+            int unread;
+
+            common->window_start = ptr - ptr % SIS_WINDOW_SIZE;
+            common->window_used = 0;
+            err = xosgbpb_read_atw(common->file, common->window,
+                                   SIS_WINDOW_SIZE, common->window_start,
+                                   &unread);
+            if (!err) common->window_used = SIS_WINDOW_SIZE - unread;
+            if (!err && (common->window_start + common->window_used <= ptr))
+            {
+                err = &err_sis_read_outside;
+            }
+        }
+
+        // Return the buffered data, limited to the end of this handle
+        if (!err)
+        {
+            *data = common->window + (ptr - common->window_start);
+            *size = MIN(common->window_start + common->window_used,
+                        handle->end) - ptr;
+        }
+        else
+        {
+            *data = NULL;
+            *size = 0;
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : handle        - Handle of the SIS file to read from.
                   offset        - Offset from the start of the file at which to
@@ -324,14 +401,25 @@ static os_error *sis_get(sis_handle handle, bits offset, void *value, bits size,
         // Check the file pointer
         if (handle->end < ptr + size) err = &err_sis_read_outside;
 
-        // Attempt to read the value
-        if (!err && size)
+        // Copy the value from the read window
+        if (!err)
         {
-            int unread;
+            byte *dest = (byte *) value;
+            bits done = 0;
 
-            err = xosgbpb_read_atw(handle->common->file, (byte *) value, size,
-                                   ptr, &unread);
-            if (!err && unread) err = &err_sis_read_outside;
+            while (!err && (done < size))
+            {
+                const byte *data;
+                bits length;
+
+                err = sis_get_window(handle, offset + done, &data, &length);
+                if (!err)
+                {
+                    length = MIN(length, size - done);
+                    memcpy(dest + done, data, length);
+                    done += length;
+                }
+            }
         }
 
         // Update the residual file size
@@ -558,30 +646,25 @@ static os_error *sis_get_copy(sis_handle handle, bits offset, bits size,
         // Loop until all copied
         while (!err && size)
         {
-            static byte buffer[SIS_BUFFER_SIZE];
-            int length;
-            int unread;
+            const byte *data;
+            bits length;
             int unwritten;
 
-            // Choose the number of bytes to copy
-            length = MIN(SIS_BUFFER_SIZE, size);
-
-            // Read from the SIS file
-            err = xosgbpb_read_atw(handle->common->file, buffer, length, ptr,
-                                   &unread);
-            if (!err && unread) err = &err_sis_read_outside;
+            // Obtain the next block of data from the read window
+            err = sis_get_window(handle, offset, &data, &length);
+            if (!err) length = MIN(length, size);
 
             // Write to the destination file
             if (!err)
             {
-                err = xosgbpb_writew(file, buffer, length, &unwritten);
+                err = xosgbpb_writew(file, data, length, &unwritten);
                 if (!err && unwritten) err = &err_sis_write_outside;
             }
 
             // Update the status
             if (!err)
             {
-                ptr += length;
+                offset += length;
                 size -= length;
             }
         }
@@ -616,7 +699,13 @@ static os_error *sis_common_new(const char *name, sis_common **common)
         if (!ptr) err = &err_buffer;
 
         // Set the initial values
-        if (!err) ptr->reference = 1;
+        if (!err)
+        {
+            ptr->reference = 1;
+            ptr->window = NULL;
+            ptr->window_start = 0;
+            ptr->window_used = 0;
+        }
 
         // Attempt to open the file
         if (!err)
@@ -663,6 +752,7 @@ static os_error *sis_common_delete(sis_common **common)
             xosfind_closew((*common)->file);
 
             // Free the memory
+            if ((*common)->window) MEM_FREE((*common)->window);
             MEM_FREE(*common);
         }
 
@@ -721,26 +811,40 @@ static os_error *sis_checksum(sis_handle handle, bits *checksum)
     else
     {
         crc_state crc;
-        bits offset;
+        bits offset = 0;
+        bits size = handle->end - handle->start;
 
         // Reset the CRC state
         crc_reset(&crc);
 
         // Calculate the CRC over the whole file excluding the checksum field
-        for (offset = 0;
-             !err && (offset < (handle->end - handle->start));
-             offset++)
+        while (!err && (offset < size))
         {
-            // Exclude the checksum field
-            if ((offset < SIS_HEADER_CHECKSUM)
-                || (SIS_HEADER_LANGUAGES <= offset))
+            const byte *data;
+            bits length;
+
+            // Obtain the next block of data from the read window
+            err = sis_get_window(handle, offset, &data, &length);
+
+            // Update the CRC, excluding the checksum field
+            while (!err && length--)
             {
-                bits buffer;
-                err = sis_get_byte(handle, offset, &buffer);
-                if (!err) crc_update(&crc, buffer);
+                if ((offset < SIS_HEADER_CHECKSUM)
+                    || (SIS_HEADER_LANGUAGES <= offset))
+                {
+                    crc_update(&crc, *data);
+                }
+                data++;
+                offset++;
             }
         }
 
+        // The whole file has been read
+        if (!err && (handle->residual->size < size))
+        {
+            handle->residual->size = size;
+        }
+
         // Return the resulting checksum
         *checksum = err ? 0 : (((bits) crc_msb(&crc)) << 8) | ((bits) crc_lsb(&crc));
     }
@@ -31,8 +31,12 @@ bits stats_tx_bytes = 0;
 bits stats_rx_frame = 0;
 bits stats_rx_err_frame = 0;
 bits stats_rx_retry_frame = 0;
+bits stats_rx_buffered_frame = 0;
 bits stats_tx_frame = 0;
 bits stats_tx_retry_frame = 0;
+bits stats_tx_resent_frame = 0;
+bits stats_tx_resent_bytes = 0;
+bits stats_tx_skipped_frame = 0;
 
 /*
     Parameters  : void
@@ -47,6 +51,10 @@ void stats_reset(void)
     stats_rx_frame = 0;
     stats_rx_err_frame = 0;
     stats_rx_retry_frame = 0;
+    stats_rx_buffered_frame = 0;
     stats_tx_frame = 0;
     stats_tx_retry_frame = 0;
+    stats_tx_resent_frame = 0;
+    stats_tx_resent_bytes = 0;
+    stats_tx_skipped_frame = 0;
 }
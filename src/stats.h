@@ -35,8 +35,12 @@ extern bits stats_tx_bytes;
 extern bits stats_rx_frame;
 extern bits stats_rx_err_frame;
 extern bits stats_rx_retry_frame;
+extern bits stats_rx_buffered_frame;
 extern bits stats_tx_frame;
 extern bits stats_tx_retry_frame;
+extern bits stats_tx_resent_frame;
+extern bits stats_tx_resent_bytes;
+extern bits stats_tx_skipped_frame;
 
 #ifdef __cplusplus
     extern "C" {
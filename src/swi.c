@@ -542,6 +542,17 @@ static os_error *swi_set(swi_set_params *params)
                 idle_background_throttle = params->in_numeric.value;
                 break;
 
+            case psifs_SELECT_LINK_WINDOW:
+                // Set the maximum remote link transmit window
+                DEBUG_PRINTF(("SWI PsiFS_Set remote link transmit window = %u", params->in_numeric.value))
+                if (params->in_numeric.value
+                    && (params->in_numeric.value <= CONNECT_MAX_WINDOW_ERA))
+                {
+                    connect_window = params->in_numeric.value;
+                }
+                else err = &err_bad_parms;
+                break;
+
             default:
                 // Unrecognised reason code
                 err = &err_bad_parms;
@@ -741,6 +752,18 @@ static os_error *swi_get(swi_get_params *params)
                 params->out_numeric.value = idle_background_throttle;
                 break;
 
+            case psifs_SELECT_LINK_WINDOW:
+                // Get the maximum remote link transmit window
+                DEBUG_PRINTF(("SWI PsiFS_Get remote link transmit window"))
+                params->out_numeric.value = connect_window;
+                break;
+
+            case psifs_SELECT_LINK_ACTIVE_WINDOW:
+                // Get the current remote link transmit window
+                DEBUG_PRINTF(("SWI PsiFS_Get current remote link transmit window"))
+                params->out_numeric.value = connect_window_active;
+                break;
+
             case psifs_SELECT_STATISTICS_RECEIVED_BYTES:
                 // Get the number of bytes of serial data received
                 DEBUG_PRINTF(("SWI PsiFS_Get number of bytes of serial data received"))
@@ -771,6 +794,12 @@ static os_error *swi_get(swi_get_params *params)
                 params->out_numeric.value = stats_rx_retry_frame;
                 break;
 
+            case psifs_SELECT_STATISTICS_RECEIVED_BUFFERED_FRAMES:
+                // Get the number of protocol frames received out of sequence
+                DEBUG_PRINTF(("SWI PsiFS_Get number of protocol frames received out of sequence"))
+                params->out_numeric.value = stats_rx_buffered_frame;
+                break;
+
             case psifs_SELECT_STATISTICS_TRANSMITTED_FRAMES:
                 // Get the number of protocol frames transmitted
                 DEBUG_PRINTF(("SWI PsiFS_Get number of protocol frames transmitted"))
@@ -783,6 +812,42 @@ static os_error *swi_get(swi_get_params *params)
                 params->out_numeric.value = stats_tx_retry_frame;
                 break;
 
+            case psifs_SELECT_STATISTICS_ROUND_TRIP_TIME:
+                // Get the smoothed remote link round trip time
+                DEBUG_PRINTF(("SWI PsiFS_Get smoothed remote link round trip time"))
+                params->out_numeric.value = connect_rtt;
+                break;
+
+            case psifs_SELECT_STATISTICS_ROUND_TRIP_VARIATION:
+                // Get the remote link round trip time variation
+                DEBUG_PRINTF(("SWI PsiFS_Get remote link round trip time variation"))
+                params->out_numeric.value = connect_rtt_var;
+                break;
+
+            case psifs_SELECT_STATISTICS_RETRY_TIMEOUT:
+                // Get the remote link retry timeout
+                DEBUG_PRINTF(("SWI PsiFS_Get remote link retry timeout"))
+                params->out_numeric.value = connect_rto;
+                break;
+
+            case psifs_SELECT_STATISTICS_TRANSMITTED_RESENT_FRAMES:
+                // Get the number of protocol frames retransmitted
+                DEBUG_PRINTF(("SWI PsiFS_Get number of protocol frames retransmitted"))
+                params->out_numeric.value = stats_tx_resent_frame;
+                break;
+
+            case psifs_SELECT_STATISTICS_TRANSMITTED_RESENT_BYTES:
+                // Get the number of bytes of protocol frames retransmitted
+                DEBUG_PRINTF(("SWI PsiFS_Get number of bytes of protocol frames retransmitted"))
+                params->out_numeric.value = stats_tx_resent_bytes;
+                break;
+
+            case psifs_SELECT_STATISTICS_TRANSMITTED_SKIPPED_FRAMES:
+                // Get the number of protocol frames not retransmitted
+                DEBUG_PRINTF(("SWI PsiFS_Get number of protocol frames not retransmitted"))
+                params->out_numeric.value = stats_tx_skipped_frame;
+                break;
+
             case psifs_SELECT_LINK_STATUS:
                 // Get the remote link status
                 DEBUG_PRINTF(("SWI PsiFS_Get remote link status"))
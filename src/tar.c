@@ -26,6 +26,7 @@
 // Include system header files
 #include <stdio.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 // Include oslib header files
@@ -43,6 +44,7 @@
 #include "mem.h"
 #include "name.h"
 #include "util.h"
+#include "wildcard.h"
 
 // Filetype of a tar file
 #define TAR_TYPE (0xc46)
@@ -103,11 +105,41 @@ typedef struct
     } ext;
 } tar_header;
 
+// An index entry, locating a single file within the archive
+typedef struct
+{
+    char name[100];
+    bits offset;
+    bits size;
+    bits load_addr;
+    bits exec_addr;
+    bits attr;
+    bits obj_type;
+    bits reserved;
+} tar_index_entry;
+#define TAR_INDEX_ENTRIES (TAR_BLOCK / sizeof(tar_index_entry))
+
+// The final block of an indexed archive
+typedef struct
+{
+    char magic[8];
+    bits version;
+    bits count;
+    bits end;
+} tar_index_trailer;
+#define TAR_INDEX_MAGIC "PsiFSIdx"
+#define TAR_INDEX_VERSION (1)
+
+// Number of index entries to allocate at a time
+#define TAR_INDEX_ALLOC (16 * TAR_INDEX_ENTRIES)
+
 // A generic block
 typedef union
 {
     byte data[TAR_BLOCK];
     tar_header header;
+    tar_index_entry index[TAR_INDEX_ENTRIES];
+    tar_index_trailer trailer;
 } tar_block;
 
 // An operation
@@ -132,6 +164,11 @@ struct tar_handle
     bits done;
     bits remain;
     tar_handle partner;
+    bool indexed;
+    tar_index_entry *index;
+    bits index_used;
+    bits index_alloc;
+    bits end;
 };
 
 /*
@@ -529,6 +566,223 @@ static os_error *tar_decode_header(const tar_block *block, fs_info *info)
     return err;
 }
 
+/*
+    Parameters  : entry1        - The first index entry.
+                  entry2        - The second index entry.
+    Returns     : int           - The result of the comparison:
+                                    < 0 if entry1 < entry2
+                                     0  if entry1 == entry2
+                                    > 0 if entry1 > entry2
+    Description : Compare two index entries. Entries are ordered by name,
+                  with multiple copies of the same file in archive order.
+*/
+static int tar_index_cmp(const void *entry1, const void *entry2)
+{
+    const tar_index_entry *ptr1 = (const tar_index_entry *) entry1;
+    const tar_index_entry *ptr2 = (const tar_index_entry *) entry2;
+    int result;
+
+    // Compare the names first and then the offsets
+    result = wildcard_cmp(ptr1->name, ptr2->name);
+    if (!result)
+    {
+        result = ptr1->offset < ptr2->offset
+                 ? -1
+                 : (ptr1->offset > ptr2->offset ? 1 : 0);
+    }
+
+    // Return the result
+    return result;
+}
+
+/*
+    Parameters  : handle        - Handle of the tar file being written.
+                  offset        - Offset of the header block for the file.
+                  info          - The file information.
+    Returns     : void
+    Description : Add an index entry for a file that has just been written.
+                  The index is optional, so it is abandoned rather than
+                  returning an error if the file cannot be indexed.
+*/
+static void tar_index_add(tar_handle handle, int offset, const fs_info *info)
+{
+    // No action unless a complete index is being maintained
+    if (handle && info && handle->indexed)
+    {
+        tar_index_entry *entry;
+
+        // Ensure that the index is large enough
+        if (handle->index_alloc <= handle->index_used)
+        {
+            bits alloc = handle->index_alloc + TAR_INDEX_ALLOC;
+            void *ptr = MEM_REALLOC(handle->index,
+                                    alloc * sizeof(tar_index_entry));
+            if (ptr)
+            {
+                handle->index = (tar_index_entry *) ptr;
+                handle->index_alloc = alloc;
+            }
+            else handle->indexed = FALSE;
+        }
+
+        // Abandon the index if the name is too long to store
+        if (sizeof(entry->name) <= strlen(info->name)) handle->indexed = FALSE;
+
+        // Fill in the index entry
+        if (handle->indexed)
+        {
+            entry = &handle->index[handle->index_used++];
+            memset(entry, 0, sizeof(tar_index_entry));
+            strcpy(entry->name, info->name);
+            entry->offset = offset;
+            entry->size = info->size;
+            entry->load_addr = info->load_addr;
+            entry->exec_addr = info->exec_addr;
+            entry->attr = info->attr;
+            entry->obj_type = info->obj_type;
+        }
+    }
+}
+
+/*
+    Parameters  : handle        - Handle of the tar file being written.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Write an index after the end of file block. A second blank
+                  block is written first so that other tar utilities stop
+                  cleanly before reaching the index.
+*/
+static os_error *tar_index_write(tar_handle handle)
+{
+    os_error *err = NULL;
+
+    // Check function parameters
+    if (!handle) err = &err_bad_parms;
+    else if (handle->indexed && handle->index_used)
+    {
+        int ptr;
+        bits blocks = (handle->index_used + TAR_INDEX_ENTRIES - 1)
+                      / TAR_INDEX_ENTRIES;
+
+        DEBUG_PRINTF(("Tar index write %p %u entries", handle, handle->index_used))
+
+        // The end of file block has just been written
+        err = xosargs_read_ptrw(handle->file, &ptr);
+
+        // Add a second blank block
+        if (!err)
+        {
+            memset(handle->block[0].data, 0, TAR_BLOCK);
+            err = tar_write_block(handle, handle->block, 1);
+        }
+
+        // Sort and pad the index entries
+        if (!err)
+        {
+            qsort(handle->index, handle->index_used,
+                  sizeof(tar_index_entry), tar_index_cmp);
+            memset(handle->index + handle->index_used, 0,
+                   (blocks * TAR_INDEX_ENTRIES - handle->index_used)
+                   * sizeof(tar_index_entry));
+        }
+
+        // Write the index entries
+        if (!err)
+        {
+            err = tar_write_block(handle, (const tar_block *) handle->index,
+                                  blocks);
+        }
+
+        // Finish with the trailer
+        if (!err)
+        {
+            memset(handle->block[0].data, 0, TAR_BLOCK);
+            memcpy(handle->block[0].trailer.magic, TAR_INDEX_MAGIC,
+                   sizeof(handle->block[0].trailer.magic));
+            handle->block[0].trailer.version = TAR_INDEX_VERSION;
+            handle->block[0].trailer.count = handle->index_used;
+            handle->block[0].trailer.end = ptr - TAR_BLOCK;
+            err = tar_write_block(handle, handle->block, 1);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : handle        - Handle of the tar file to read.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Read any index from the end of the tar file. If a valid
+                  index is found then the end field of the handle is set to
+                  the offset of the end of file block. The file pointer is
+                  left in an undefined position.
+*/
+static os_error *tar_index_read(tar_handle handle)
+{
+    os_error *err = NULL;
+
+    // Check function parameters
+    if (!handle) err = &err_bad_parms;
+    else
+    {
+        int ext;
+
+        // Read the final block if there is room for an index
+        handle->indexed = FALSE;
+        err = xosargs_read_extw(handle->file, &ext);
+        if (!err && !(ext % TAR_BLOCK) && (TAR_BLOCK * 4 <= ext))
+        {
+            err = xosargs_set_ptrw(handle->file, ext - TAR_BLOCK);
+            if (!err) err = tar_read_block(handle, handle->block, 1);
+            if (!err)
+            {
+                const tar_index_trailer *trailer = &handle->block[0].trailer;
+                bits blocks = (trailer->count + TAR_INDEX_ENTRIES - 1)
+                              / TAR_INDEX_ENTRIES;
+
+                // Check that the trailer is consistent with the file
+                if (!strncmp(trailer->magic, TAR_INDEX_MAGIC,
+                             sizeof(trailer->magic))
+                    && (trailer->version == TAR_INDEX_VERSION)
+                    && blocks && !(trailer->end % TAR_BLOCK)
+                    && (trailer->end + (blocks + 3) * TAR_BLOCK == ext))
+                {
+                    bits alloc = blocks * TAR_INDEX_ENTRIES;
+
+                    DEBUG_PRINTF(("Tar index read %p %u entries", handle, trailer->count))
+
+                    // Allocate memory for the index
+                    handle->index = (tar_index_entry *)
+                                    MEM_MALLOC(alloc
+                                               * sizeof(tar_index_entry));
+                    if (handle->index)
+                    {
+                        handle->index_used = trailer->count;
+                        handle->index_alloc = alloc;
+                        handle->end = trailer->end;
+
+                        // Read the index entries
+                        err = xosargs_set_ptrw(handle->file,
+                                               handle->end + 2 * TAR_BLOCK);
+                        if (!err)
+                        {
+                            err = tar_read_block(handle,
+                                                 (tar_block *) handle->index,
+                                                 blocks);
+                        }
+                        if (!err) handle->indexed = TRUE;
+                    }
+                }
+            }
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : handle        - Handle of the tar file to read.
     Returns     : os_error *    - NULL for success, or pointer to a standard
@@ -594,6 +848,10 @@ os_error *tar_open_in(const char *name, tar_handle *handle)
             ptr->write = FALSE;
             ptr->op = TAR_IDLE;
             ptr->op_file = 0;
+            ptr->indexed = FALSE;
+            ptr->index = NULL;
+            ptr->index_used = 0;
+            ptr->index_alloc = 0;
         }
 
         // Store the filename
@@ -610,6 +868,10 @@ os_error *tar_open_in(const char *name, tar_handle *handle)
         }
         if (!err && !ptr->file) err = &err_not_found;
 
+        // Read any index and then return to the start of the file
+        if (!err) err = tar_index_read(ptr);
+        if (!err) err = xosargs_set_ptrw(ptr->file, 0);
+
         // Read the details of the first file
         if (!err) err = tar_next(ptr);
 
@@ -621,6 +883,7 @@ os_error *tar_open_in(const char *name, tar_handle *handle)
         }
 
         // Free the memory if an error
+        if (err && ptr && ptr->index) MEM_FREE(ptr->index);
         if (err && ptr) MEM_FREE(ptr);
 
         // Set the return value
@@ -664,6 +927,10 @@ os_error *tar_open_out(const char *name, tar_handle *handle, bool append)
             ptr->file = 0;
             ptr->op = TAR_IDLE;
             ptr->op_file = 0;
+            ptr->indexed = TRUE;
+            ptr->index = NULL;
+            ptr->index_used = 0;
+            ptr->index_alloc = 0;
         }
 
         // Store the filename
@@ -690,6 +957,11 @@ os_error *tar_open_out(const char *name, tar_handle *handle, bool append)
             // Read the current length of the file
             err = xosargs_read_extw(ptr->file, &length);
 
+            // Keep any existing index, discarding it from the file
+            if (!err) err = tar_index_read(ptr);
+            if (!err && ptr->indexed) length = ptr->end + TAR_BLOCK;
+            else ptr->indexed = length <= TAR_BLOCK;
+
             // Assume file ends with an end of file marker
             if (!err && ((length % TAR_BLOCK) || (length < TAR_BLOCK)))
             {
@@ -722,6 +994,7 @@ os_error *tar_open_out(const char *name, tar_handle *handle, bool append)
         if (err && ptr && ptr->file) xosfind_closew(ptr->file);
 
         // Free the memory if an error
+        if (err && ptr && ptr->index) MEM_FREE(ptr->index);
         if (err && ptr) MEM_FREE(ptr);
 
         // Set the return value
@@ -792,6 +1065,9 @@ os_error *tar_close(tar_handle *handle)
                 err = tar_write_block(*handle, (*handle)->block, 1);
             }
 
+            // Follow it with an index of the files written
+            if (!err && (*handle)->write) err = tar_index_write(*handle);
+
             // Close the file
             xosfind_closew((*handle)->file);
 
@@ -802,6 +1078,7 @@ os_error *tar_close(tar_handle *handle)
             }
 
             // Free the memory
+            if (!err && (*handle)->index) MEM_FREE((*handle)->index);
             if (!err) MEM_FREE(*handle);
         }
 
@@ -843,6 +1120,96 @@ os_error *tar_info(tar_handle handle, const fs_info **info)
     return err;
 }
 
+/*
+    Parameters  : handle        - Handle of the tar file to read.
+                  name          - The name of the file to find.
+                  info          - Variable to receive a pointer to the details
+                                  of the file, or NULL if not found.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Position the tar file at the specified file, ready for it to
+                  be extracted or skipped. If the file was stored more than
+                  once then the last copy is found. The index is used if the
+                  tar file has one, otherwise all of the headers are scanned.
+*/
+os_error *tar_find(tar_handle handle, const char *name, const fs_info **info)
+{
+    os_error *err = NULL;
+
+    // Check function parameters
+    if (!handle || !name || !info || handle->write) err = &err_bad_parms;
+    else
+    {
+        int offset = -1;
+
+        DEBUG_PRINTF(("Tar find %p '%s'", handle, name))
+
+        // Ensure that any outstanding operation has been completed
+        err = tar_complete(handle);
+
+        // Locate the header of the file
+        if (!err && handle->indexed)
+        {
+            int low = 0;
+            int high = handle->index_used - 1;
+
+            // Binary search for the last index entry with a matching name
+            while (low <= high)
+            {
+                int mid = (low + high) / 2;
+                int cmp = wildcard_cmp(name, handle->index[mid].name);
+                if (cmp < 0) high = mid - 1;
+                else
+                {
+                    if (!cmp) offset = handle->index[mid].offset;
+                    low = mid + 1;
+                }
+            }
+
+            // Leave the file at the end of file block if not found
+            if (offset < 0) err = xosargs_set_ptrw(handle->file, handle->end);
+        }
+        else if (!err)
+        {
+            int ptr;
+
+            // Scan all of the headers from the start of the file
+            err = xosargs_set_ptrw(handle->file, 0);
+            if (!err) err = xosargs_read_ptrw(handle->file, &ptr);
+            if (!err) err = tar_next(handle);
+            while (!err && (handle->info.obj_type != fileswitch_NOT_FOUND))
+            {
+                // Remember the position of any match
+                if (!wildcard_cmp(name, handle->info.name)) offset = ptr;
+
+                // Skip to the next header
+                err = tar_skip_block(handle, handle->remain);
+                if (!err) err = xosargs_read_ptrw(handle->file, &ptr);
+                if (!err) err = tar_next(handle);
+            }
+        }
+
+        // Read the header of the file
+        if (!err && (0 <= offset))
+        {
+            err = xosargs_set_ptrw(handle->file, offset);
+            if (!err) err = tar_next(handle);
+        }
+        else if (!err)
+        {
+            handle->info.obj_type = fileswitch_NOT_FOUND;
+            handle->remain = 0;
+        }
+
+        // Set the return value
+        *info = err || (handle->info.obj_type == fileswitch_NOT_FOUND)
+                ? NULL : &handle->info;
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : perc  - The percentage of the default step size to use.
                   max   - Maximum acceptable step size.
@@ -926,6 +1293,8 @@ os_error *tar_add(const char *src, const char *name, tar_handle dest)
     if (!src || !name || !dest) err = &err_bad_parms;
     else
     {
+        int offset;
+
         DEBUG_PRINTF(("Tar add '%s' to %p as '%s'", src, dest, name))
 
         // Ensure that any outstanding operation has been completed
@@ -970,7 +1339,9 @@ os_error *tar_add(const char *src, const char *name, tar_handle dest)
         if (!err) err = tar_build_header(&dest->info, dest->block);
 
         // Write the file header to the destination file
+        if (!err) err = xosargs_read_ptrw(dest->file, &offset);
         if (!err) err = tar_write_block(dest, dest->block, 1);
+        if (!err) tar_index_add(dest, offset, &dest->info);
 
         // Set the operation details or close the source file
         if (!err) dest->op = TAR_ADD;
@@ -1280,13 +1651,17 @@ os_error *tar_copy(tar_handle src, tar_handle dest)
     if (!src || !dest) err = &err_bad_parms;
     else
     {
+        int offset;
+
         DEBUG_PRINTF(("Tar copy %p to %p", src, dest))
 
         // Ensure that any outstanding operation has been completed
         err = tar_complete(src);
 
         // Write the file header to the destination file
+        if (!err) err = xosargs_read_ptrw(dest->file, &offset);
         if (!err) err = tar_write_block(dest, src->block, 1);
+        if (!err) tar_index_add(dest, offset, &src->info);
 
         // Set the operation details
         if (!err)
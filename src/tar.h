@@ -88,6 +88,20 @@ os_error *tar_close(tar_handle *handle);
 */
 os_error *tar_info(tar_handle handle, const fs_info **info);
 
+/*
+    Parameters  : handle        - Handle of the tar file to read.
+                  name          - The name of the file to find.
+                  info          - Variable to receive a pointer to the details
+                                  of the file, or NULL if not found.
+    Returns     : os_error *    - NULL for success, or pointer to a standard
+                                  error block.
+    Description : Position the tar file at the specified file, ready for it to
+                  be extracted or skipped. If the file was stored more than
+                  once then the last copy is found. The index is used if the
+                  tar file has one, otherwise all of the headers are scanned.
+*/
+os_error *tar_find(tar_handle handle, const char *name, const fs_info **info);
+
 /*
     Parameters  : src           - The name of the source file.
                   name          - The name to store for the file.
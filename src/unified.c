@@ -59,6 +59,7 @@ typedef struct unified_private
     void *user;
     share_callback callback;
     bool era;
+    bits session;
     os_error *err;
     bits length;
     bits index;
@@ -100,6 +101,21 @@ typedef struct unified_buffer_record
 static unified_buffer_record *unified_buffer_head;
 static void *unified_buffer = NULL;
 
+// File handles opened on the remote file server sessions
+#define UNIFIED_SESSION_NONE (RFSV32_SESSIONS)
+typedef struct unified_handle_record
+{
+    struct unified_handle_record *next;
+    unified_handle handle;
+    bits session;
+    epoc32_handle remote;
+} unified_handle_record;
+static unified_handle_record *unified_handle_list = NULL;
+static unified_handle unified_handle_next = 0;
+
+// Number of operations using each remote file server session
+static bits unified_session_ops[RFSV32_SESSIONS];
+
 // Status for foreground operations
 static bool unified_fore_done;
 static os_error *unified_fore_err;
@@ -123,6 +139,9 @@ static bool unified_era = FALSE;
 #define UNIFIED_STOP_DELAY (50)
 #define UNIFIED_START_DELAY (500)
 
+// Function prototypes
+static os_error *unified_callback(void *user, os_error *err, const void *reply);
+
 /*
     Parameters  : src           - The source string.
                   dest          - Variable to hold the result.
@@ -200,6 +219,17 @@ static os_error *unified_disconnect(bool now)
     err = cache_end(now);
     if (!err) err = upload_end(now);
 
+    // Any remaining file handles are no longer valid
+    if (!err)
+    {
+        while (unified_handle_list)
+        {
+            unified_handle_record *ptr = unified_handle_list;
+            unified_handle_list = ptr->next;
+            MEM_FREE(ptr);
+        }
+    }
+
     // Return any error produced
     return err;
 }
@@ -378,6 +408,159 @@ os_error *unified_load_exec(bits type, const date_riscos *date,
     return err;
 }
 
+/*
+    Parameters  : op            - The operation data.
+                  session       - The remote file server session to use, or
+                                  UNIFIED_SESSION_NONE to choose a session
+                                  based on the type of operation.
+    Returns     : void
+    Description : Associate an operation with a remote file server session.
+                  Once chosen, the session is used for all subsequent
+                  commands that form part of the operation. Path, listing
+                  and information requests use the primary session, which
+                  has the normal priority class, so that they remain
+                  responsive during transfers. Files are opened on the
+                  least busy bulk session, and all later operations on the
+                  handle use the same session.
+*/
+static void unified_session_bind(unified_private *op, bits session)
+{
+    // No action if a session has already been chosen
+    if (op->session == UNIFIED_SESSION_NONE)
+    {
+        // Choose a session if not specified
+        if (session == UNIFIED_SESSION_NONE)
+        {
+            // Start by assuming that the primary session will be used
+            session = RFSV32_SESSION_PRIMARY;
+
+            // Open files using the connected bulk session with the fewest
+            // operations
+            if (op->cmd->op == UNIFIED_OPEN)
+            {
+                bits index;
+                bits bulk = UNIFIED_SESSION_NONE;
+
+                for (index = 0; index < RFSV32_SESSIONS; index++)
+                {
+                    if ((index != RFSV32_SESSION_PRIMARY)
+                        && rfsv32_connected(index)
+                        && ((bulk == UNIFIED_SESSION_NONE)
+                            || (unified_session_ops[index]
+                                < unified_session_ops[bulk])))
+                    {
+                        bulk = index;
+                    }
+                }
+                if (bulk != UNIFIED_SESSION_NONE) session = bulk;
+            }
+        }
+
+        // Use the selected session
+        op->session = session;
+        unified_session_ops[session]++;
+    }
+}
+
+/*
+    Parameters  : op            - The operation data.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Start the next remote file server command for an operation.
+*/
+static os_error *unified_rfsv32_back(unified_private *op)
+{
+    // Choose a session if not already bound
+    unified_session_bind(op, UNIFIED_SESSION_NONE);
+
+    // Queue the command for the selected session
+    return rfsv32_back_session(op->session, &op->data.rfsv32.cmd,
+                               &op->data.rfsv32.reply, op, unified_callback);
+}
+
+/*
+    Parameters  : op            - The operation data.
+                  handle        - The unified file handle.
+                  remote        - Variable to receive the remote file handle.
+                  close         - Should the handle be released.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Find the remote file handle and session corresponding to a
+                  unified file handle, and bind the operation to the session
+                  that opened the file.
+*/
+static os_error *unified_handle_find(unified_private *op, unified_handle handle,
+                                     epoc32_handle *remote, bool close)
+{
+    os_error *err = NULL;
+    unified_handle_record **ptr = &unified_handle_list;
+
+    // Find the matching record
+    while (*ptr && ((*ptr)->handle != handle)) ptr = &(*ptr)->next;
+    if (!*ptr) err = &err_svr_closed;
+    else
+    {
+        unified_handle_record *rec = *ptr;
+
+        // Use the session that opened the file
+        *remote = rec->remote;
+        unified_session_bind(op, rec->session);
+
+        // Release the record if the file is being closed
+        if (close)
+        {
+            *ptr = rec->next;
+            MEM_FREE(rec);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : op            - The operation data.
+                  remote        - The remote file handle.
+                  handle        - Variable to receive the unified file handle.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Allocate a unified file handle for a file opened using the
+                  session bound to the operation.
+*/
+static os_error *unified_handle_add(unified_private *op, epoc32_handle remote,
+                                    unified_handle *handle)
+{
+    os_error *err = NULL;
+    unified_handle_record *rec;
+
+    // Allocate a new record
+    rec = (unified_handle_record *) MEM_MALLOC(sizeof(unified_handle_record));
+    if (!rec) err = &err_buffer;
+    else
+    {
+        const unified_handle_record *ptr;
+
+        // Choose an unused handle
+        do
+        {
+            if (!++unified_handle_next) unified_handle_next++;
+            ptr = unified_handle_list;
+            while (ptr && (ptr->handle != unified_handle_next)) ptr = ptr->next;
+        } while (ptr);
+
+        // Complete and link in the record
+        rec->handle = unified_handle_next;
+        rec->session = op->session;
+        rec->remote = remote;
+        rec->next = unified_handle_list;
+        unified_handle_list = rec;
+        *handle = rec->handle;
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : era           - The ERA format structure.
                   riscos        - Variable to receive the RISC OS equivalent.
@@ -487,6 +670,13 @@ static os_error *unified_done(unified_private *op, os_error *err)
     if (!op) err = &err_bad_parms;
     else
     {
+        // Release any remote file server session
+        if (op->session != UNIFIED_SESSION_NONE)
+        {
+            unified_session_ops[op->session]--;
+            op->session = UNIFIED_SESSION_NONE;
+        }
+
         // Unlink from the active list
         if (op->next) op->next->prev = op->prev;
         if (op->prev) op->prev->next = op->next;
@@ -613,7 +803,7 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
                         cmd32->data.req_read_dir.handle = op->data.rfsv32.handle;
                         cmd32->data.req_read_dir.buffer = (epoc32_remote_entry *) unified_buffer;
                         cmd32->data.req_read_dir.size = op->cmd->data.list.size;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        err = unified_rfsv32_back(op);
                     }
                     else if (cmd32->op == RFSV32_REQ_READ_DIR)
                     {
@@ -638,7 +828,7 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
                             // Read the next block of entries
                             done = FALSE;
                             cmd32->data.req_read_dir.size = op->reply->list.remain;
-                            err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                            err = unified_rfsv32_back(op);
                         }
                         else
                         {
@@ -648,7 +838,7 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
                                       ? err : NULL;
                             cmd32->op = RFSV32_REQ_CLOSE_HANDLE;
                             cmd32->data.req_close_handle.handle = op->data.rfsv32.handle;
-                            err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                            err = unified_rfsv32_back(op);
                         }
                     }
                     else if (!err && (cmd32->op == RFSV32_REQ_CLOSE_HANDLE))
@@ -751,12 +941,30 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
 
             case UNIFIED_OPEN:
                 // Open a file
-                if (!err)
+                if (op->era)
                 {
-                    op->reply->open.handle = op->era
-                                             ? reply32->req_open_file.handle
-                                             : reply16->rf_fopen.handle;
+                    // Action depends on the last operation
+                    if (cmd32->op == RFSV32_REQ_CLOSE_HANDLE)
+                    {
+                        // Restore the allocation error
+                        err = op->err;
+                    }
+                    else if (!err)
+                    {
+                        // Allocate a unified handle for the remote file
+                        err = unified_handle_add(op, reply32->req_open_file.handle, &op->reply->open.handle);
+                        if (err)
+                        {
+                            // Close the remote file to avoid leaking it
+                            done = FALSE;
+                            op->err = err;
+                            cmd32->op = RFSV32_REQ_CLOSE_HANDLE;
+                            cmd32->data.req_close_handle.handle = reply32->req_open_file.handle;
+                            err = unified_rfsv32_back(op);
+                        }
+                    }
                 }
+                else if (!err) op->reply->open.handle = reply16->rf_fopen.handle;
                 break;
 
             case UNIFIED_READ:
@@ -772,7 +980,7 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
                             done = FALSE;
                             cmd32->data.req_read_file.length = MIN(RFSV32_MAX_READ, op->cmd->data.read.length - op->length);
                             cmd32->data.req_read_file.buffer = (byte *) op->cmd->data.read.buffer + op->length;
-                            err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                            err = unified_rfsv32_back(op);
                         }
                         else op->reply->read.length = op->length;
                     }
@@ -804,7 +1012,7 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
                             done = FALSE;
                             cmd32->data.req_write_file.length = MIN(RFSV32_MAX_WRITE, op->cmd->data.write.length - op->length);
                             cmd32->data.req_write_file.buffer = (byte *) op->cmd->data.write.buffer + op->length;
-                            err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                            err = unified_rfsv32_back(op);
                         }
                     }
                     else
@@ -832,7 +1040,7 @@ static os_error *unified_callback(void *user, os_error *err, const void *reply)
                         {
                             done = FALSE;
                             cmd32->data.req_write_file.length = MIN(RFSV32_MAX_WRITE, op->cmd->data.write.length - op->length);
-                            err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                            err = unified_rfsv32_back(op);
                         }
                     }
                     else
@@ -1140,7 +1348,6 @@ static os_error *unified_begin(unified_private *op)
         rfsv32_cmd *cmd32 = &op->data.rfsv32.cmd;
         rfsv16_cmd *cmd16 = &op->data.rfsv16.cmd;
         ncp_cmd *cmdncp = &op->data.ncp.cmd;
-        rfsv32_reply *reply32 = &op->data.rfsv32.reply;
         rfsv16_reply *reply16 = &op->data.rfsv16.reply;
         ncp_reply *replyncp = &op->data.ncp.reply;
 
@@ -1161,7 +1368,7 @@ static os_error *unified_begin(unified_private *op)
                         op->index = 0;
                         cmd32->op = RFSV32_REQ_VOLUME;
                         cmd32->data.req_volume.drive = toupper(op->cmd->data.drive.drive) - 'A';
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1189,7 +1396,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_set_volume_label.name,
                                                  sizeof(cmd32->data.req_set_volume_label.name));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1240,7 +1447,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_open_dir.match,
                                                  sizeof(cmd32->data.req_open_dir.match));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1288,7 +1495,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_remote_entry.name,
                                                  sizeof(cmd32->data.req_remote_entry.name));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1325,7 +1532,7 @@ static os_error *unified_begin(unified_private *op)
                         *ptr++ = NAME_CHAR_SEPARATOR;
                         *ptr = '\0';
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1351,7 +1558,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_delete.name,
                                                  sizeof(cmd32->data.req_delete.name));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1388,7 +1595,7 @@ static os_error *unified_begin(unified_private *op)
                         *ptr++ = NAME_CHAR_SEPARATOR;
                         *ptr = '\0';
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1420,7 +1627,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_rename.dest,
                                                  sizeof(cmd32->data.req_rename.dest));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1454,7 +1661,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_set_att.name,
                                                  sizeof(cmd32->data.req_set_att.name));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1483,7 +1690,7 @@ static os_error *unified_begin(unified_private *op)
                                                  cmd32->data.req_set_modified.name,
                                                  sizeof(cmd32->data.req_set_modified.name));
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1531,7 +1738,7 @@ static os_error *unified_begin(unified_private *op)
                         }
                         else err = &err_bad_parms;
                     }
-                    if (!err) err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                    if (!err) err = unified_rfsv32_back(op);
                 }
                 else
                 {
@@ -1560,8 +1767,8 @@ static os_error *unified_begin(unified_private *op)
                     if (!err)
                     {
                         cmd32->op = RFSV32_REQ_CLOSE_HANDLE;
-                        cmd32->data.req_close_handle.handle = op->cmd->data.close.handle;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        err = unified_handle_find(op, op->cmd->data.close.handle, &cmd32->data.req_close_handle.handle, TRUE);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1582,10 +1789,10 @@ static os_error *unified_begin(unified_private *op)
                     if (!err)
                     {
                         cmd32->op = RFSV32_REQ_SEEK_FILE;
-                        cmd32->data.req_seek_file.handle = op->cmd->data.seek.handle;
+                        err = unified_handle_find(op, op->cmd->data.seek.handle, &cmd32->data.req_seek_file.handle, FALSE);
                         cmd32->data.req_seek_file.offset = op->cmd->data.seek.offset;
                         cmd32->data.req_seek_file.sense = EPOC32_SENSE_ABSOLUTE;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1609,10 +1816,10 @@ static os_error *unified_begin(unified_private *op)
                     if (!err)
                     {
                         cmd32->op = RFSV32_REQ_READ_FILE;
-                        cmd32->data.req_read_file.handle = op->cmd->data.read.handle;
+                        err = unified_handle_find(op, op->cmd->data.read.handle, &cmd32->data.req_read_file.handle, FALSE);
                         cmd32->data.req_read_file.length = MIN(RFSV32_MAX_READ, op->cmd->data.read.length);
                         cmd32->data.req_read_file.buffer = op->cmd->data.read.buffer;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1636,10 +1843,10 @@ static os_error *unified_begin(unified_private *op)
                     if (!err)
                     {
                         cmd32->op = RFSV32_REQ_WRITE_FILE;
-                        cmd32->data.req_write_file.handle = op->cmd->data.write.handle;
+                        err = unified_handle_find(op, op->cmd->data.write.handle, &cmd32->data.req_write_file.handle, FALSE);
                         cmd32->data.req_write_file.length = MIN(RFSV32_MAX_WRITE, op->cmd->data.write.length);
                         cmd32->data.req_write_file.buffer = op->cmd->data.write.buffer;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1666,10 +1873,10 @@ static os_error *unified_begin(unified_private *op)
                     {
                         memset(buffer, 0, sizeof(buffer));
                         cmd32->op = RFSV32_REQ_WRITE_FILE;
-                        cmd32->data.req_write_file.handle = op->cmd->data.write.handle;
+                        err = unified_handle_find(op, op->cmd->data.write.handle, &cmd32->data.req_write_file.handle, FALSE);
                         cmd32->data.req_write_file.length = MIN(RFSV32_MAX_WRITE, op->cmd->data.write.length);
                         cmd32->data.req_write_file.buffer = buffer;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1695,9 +1902,9 @@ static os_error *unified_begin(unified_private *op)
                     if (!err)
                     {
                         cmd32->op = RFSV32_REQ_SET_SIZE;
-                        cmd32->data.req_set_size.handle = op->cmd->data.size.handle;
+                        err = unified_handle_find(op, op->cmd->data.size.handle, &cmd32->data.req_set_size.handle, FALSE);
                         cmd32->data.req_set_size.size = op->cmd->data.size.size;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -1719,8 +1926,8 @@ static os_error *unified_begin(unified_private *op)
                     if (!err)
                     {
                         cmd32->op = RFSV32_REQ_FLUSH;
-                        cmd32->data.req_flush.handle = op->cmd->data.flush.handle;
-                        err = rfsv32_back(cmd32, reply32, op, unified_callback);
+                        err = unified_handle_find(op, op->cmd->data.flush.handle, &cmd32->data.req_flush.handle, FALSE);
+                        if (!err) err = unified_rfsv32_back(op);
                     }
                 }
                 else
@@ -2015,6 +2222,7 @@ os_error *unified_back(const unified_cmd *cmd, unified_reply *reply,
             ptr->reply = reply;
             ptr->user = user;
             ptr->callback = callback;
+            ptr->session = UNIFIED_SESSION_NONE;
 
             // Start the operation
             err = unified_begin(ptr);
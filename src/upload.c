@@ -37,6 +37,7 @@
 // Private data for each operation
 typedef enum
 {
+    UPLOAD_STATE_CHECK,
     UPLOAD_STATE_INITIAL,
     UPLOAD_STATE_CREATED
 } upload_state;
@@ -60,6 +61,9 @@ static upload_private *upload_active_list = NULL;
 static bool upload_era = FALSE;
 static bool upload_active = FALSE;
 
+// Function prototypes
+static os_error *upload_callback(void *user, os_error *err, const void *reply);
+
 /*
     Parameters  : op            - The operation data.
                   err           - Any error to return.
@@ -95,6 +99,57 @@ static os_error *upload_done(upload_private *op, os_error *err)
     return err;
 }
 
+/*
+    Parameters  : op            - The operation data.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Start copying a file by making any existing copy writable.
+*/
+static os_error *upload_copy(upload_private *op)
+{
+    os_error *err = NULL;
+
+    // Check function parameters
+    if (!op) err = &err_bad_parms;
+    else
+    {
+        // Ensure that any existing file can be deleted
+        op->state = UPLOAD_STATE_INITIAL;
+        op->uni_cmd.op = UNIFIED_ACCESS;
+        op->uni_cmd.data.access.attr = fileswitch_ATTR_OWNER_READ
+                                       | fileswitch_ATTR_OWNER_WRITE;
+        if (sizeof(op->uni_cmd.data.access.path) <= strlen(op->cmd->data.copy.path)) err = &err_bad_name;
+        if (!err)
+        {
+            strcpy(op->uni_cmd.data.access.path, op->cmd->data.copy.path);
+            err = unified_back(&op->uni_cmd, &op->uni_reply, op, upload_callback);
+        }
+    }
+
+    // Return any error produced
+    return err;
+}
+
+/*
+    Parameters  : op            - The operation data.
+    Returns     : bool          - Does the existing file match the one to be
+                                  copied.
+    Description : Check whether the details read for an existing file match
+                  the size and date stamp of the file to be copied. The
+                  contents are not compared; the date stamps of uploaded files
+                  identify their versions.
+*/
+static bool upload_match(const upload_private *op)
+{
+    const fs_info *info = &op->uni_reply.info.info;
+
+    // Compare the details
+    return (info->obj_type == fileswitch_IS_FILE)
+           && (info->size == op->cmd->data.copy.size)
+           && ((info->load_addr & 0xff) == op->cmd->data.copy.date.words.high)
+           && (info->exec_addr == op->cmd->data.copy.date.words.low);
+}
+
 /*
     Parameters  : user          - User specified handle for this operation.
                   err           - Any error produced by the operation.
@@ -119,7 +174,21 @@ static os_error *upload_callback(void *user, os_error *err, const void *reply)
         {
             case UPLOAD_COPY:
                 // Copy the specified file
-                if (!err && (op->uni_cmd.op == UNIFIED_ACCESS)
+                if (op->state == UPLOAD_STATE_CHECK)
+                {
+                    // No action if an identical file already exists
+                    if (!err && upload_match(op))
+                    {
+                        DEBUG_PRINTF(("Upload of '%s' skipped", op->cmd->data.copy.path))
+                    }
+                    else
+                    {
+                        // Ignore any error and copy the file
+                        done = FALSE;
+                        err = upload_copy(op);
+                    }
+                }
+                else if (!err && (op->uni_cmd.op == UNIFIED_ACCESS)
                     && (op->state == UPLOAD_STATE_INITIAL))
                 {
                     done = FALSE;
@@ -253,14 +322,12 @@ static os_error *upload_begin(upload_private *op)
         switch (op->cmd->op)
         {
             case UPLOAD_COPY:
-                // Copy the specified file
-                op->uni_cmd.op = UNIFIED_ACCESS;
-                op->uni_cmd.data.access.attr = fileswitch_ATTR_OWNER_READ
-                                               | fileswitch_ATTR_OWNER_WRITE;
-                if (sizeof(op->uni_cmd.data.access.path) <= strlen(op->cmd->data.copy.path)) err = &err_bad_name;
+                // Start by reading the details of any existing file
+                op->uni_cmd.op = UNIFIED_INFO;
+                if (sizeof(op->uni_cmd.data.info.path) <= strlen(op->cmd->data.copy.path)) err = &err_bad_name;
                 if (!err)
                 {
-                    strcpy(op->uni_cmd.data.access.path, op->cmd->data.copy.path);
+                    strcpy(op->uni_cmd.data.info.path, op->cmd->data.copy.path);
                     err = unified_back(&op->uni_cmd, &op->uni_reply, op, upload_callback);
                 }
                 break;
@@ -287,7 +354,9 @@ static os_error *upload_begin(upload_private *op)
                                   has completed (both for success and failure).
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Trigger a background remote file upload operation.
+    Description : Trigger a background remote file upload operation. The
+                  upload is skipped if a file with the same size and date
+                  stamp already exists.
 */
 os_error *upload_file(const upload_cmd *cmd, void *user,
                       share_callback callback)
@@ -329,8 +398,8 @@ os_error *upload_file(const upload_cmd *cmd, void *user,
             ptr->user = user;
             ptr->callback = callback;
 
-            // Always start in the initial state
-            ptr->state = UPLOAD_STATE_INITIAL;
+            // Always start by checking for an existing copy
+            ptr->state = UPLOAD_STATE_CHECK;
 
             // Start the operation
             err = upload_begin(ptr);
@@ -63,7 +63,9 @@ typedef struct
                                   has completed (both for success and failure).
     Returns     : os_error *    - Pointer to a corresponding error block, or
                                   NULL if no error.
-    Description : Trigger a background remote file upload operation.
+    Description : Trigger a background remote file upload operation. The
+                  upload is skipped if a file with the same size and date
+                  stamp already exists.
 */
 os_error *upload_file(const upload_cmd *cmd, void *user,
                       share_callback callback);
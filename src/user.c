@@ -78,6 +78,59 @@ os_error *user_poll(bool active, int rx, int *tx, bool idle)
     return err;
 }
 
+/*
+    Parameters  : active        - Is the remote device present and active.
+                  rx            - Pointer to the received characters.
+                  rx_size       - Number of received characters.
+                  tx            - Buffer to receive characters to transmit.
+                  tx_size       - On entry the size of the transmit buffer,
+                                  and on exit the number of characters placed
+                                  in it.
+                  idle          - Should idle polling of higher layers be
+                                  performed.
+    Returns     : os_error *    - Pointer to a corresponding error block, or
+                                  NULL if no error.
+    Description : Perform any polled actions required for a block of received
+                  characters, and generate as many characters to transmit as
+                  will fit in the buffer. All of the received characters are
+                  processed. This must only be called when a block driver is
+                  active and usable.
+*/
+os_error *user_poll_block(bool active, const byte *rx, bits rx_size,
+                          byte *tx, bits *tx_size, bool idle)
+{
+    os_error *err = NULL;
+
+    // Action depends on the current user
+    if (user_mode == psifs_MODE_LINK)
+    {
+        // The remote link handles blocks directly
+        err = frame_poll_block(active, rx, rx_size, tx, tx_size, idle);
+    }
+    else
+    {
+        bits rx_used = 0;
+        bits tx_used = 0;
+        bool more = TRUE;
+
+        // Process one character at a time
+        while (!err && more)
+        {
+            int value = -1;
+
+            err = user_poll(active, rx_used < rx_size ? rx[rx_used++] : -1,
+                            tx_used < *tx_size ? &value : NULL, idle);
+            if (!err && (0 <= value)) tx[tx_used++] = value;
+            idle = FALSE;
+            more = (rx_used < rx_size) || (0 <= value);
+        }
+        *tx_size = tx_used;
+    }
+
+    // Return any error produced
+    return err;
+}
+
 /*
     Parameters  : void
     Returns     : bool  - Should a disconnection be performed.
@@ -326,15 +326,24 @@ os_error *util_read_tar(const char *src, const char *pattern, const char *dest,
         if (!err)
         {
             const fs_info *info;
+            wildcard_pattern match;
+            bool single;
+
+            // Prepare the pattern to match
+            wildcard_compile(pattern, &match);
+            single = !match.wild;
+
+            // Go straight to the file if the pattern is not wildcarded
+            if (single) err = tar_find(handle, pattern, &info);
+            else err = tar_info(handle, &info);
 
             // Loop through all of the files
-            err = tar_info(handle, &info);
             while (!err && info)
             {
                 bool done = FALSE;
 
                 // Check if the file matches
-                if (!wildcard_cmp(pattern, info->name))
+                if (wildcard_match(&match, info->name))
                 {
                     // Display the file details
                     if (verbose) printf("%s\n", info->name);
@@ -377,7 +386,8 @@ os_error *util_read_tar(const char *src, const char *pattern, const char *dest,
                 if (!err) err = tar_complete(handle);
 
                 // Read the details of the next file
-                if (!err) err = tar_info(handle, &info);
+                if (!err && single) info = NULL;
+                else if (!err) err = tar_info(handle, &info);
             }
 
             // Close the tar file, ignoring any error produced
@@ -29,6 +29,79 @@
 // Include project header files
 #include "fs.h"
 
+// Case folding table, initialised from the current locale on first use
+static unsigned char wildcard_fold[256];
+static bool wildcard_fold_init = FALSE;
+#define WILDCARD_FOLD(c) (wildcard_fold[(unsigned char) (c)])
+
+/*
+    Parameters  : void
+    Returns     : void
+    Description : Initialise the case folding table if not already done.
+*/
+static void wildcard_init(void)
+{
+    // No action if already initialised
+    if (!wildcard_fold_init)
+    {
+        bits i;
+
+        // Fold every character to upper case
+        for (i = 0; i < sizeof(wildcard_fold); i++)
+        {
+            wildcard_fold[i] = toupper(i);
+        }
+        wildcard_fold_init = TRUE;
+    }
+}
+
+/*
+    Parameters  : pattern   - The wildcarded pattern to match.
+                  str       - The string to compare to.
+    Returns     : bool      - Does the string match the pattern.
+    Description : Perform a wildcarded, case-insensitive match. This is not
+                  recursive; after a mismatch it only returns to the most
+                  recent multiple character wildcard, so the time taken is
+                  at most proportional to the product of the lengths.
+*/
+static bool wildcard_match_raw(const char *pattern, const char *str)
+{
+    const char *star = NULL;
+    const char *resume = NULL;
+
+    // Match characters in sequence
+    while (*str)
+    {
+        if (*pattern == FS_CHAR_WILD_ANY)
+        {
+            // Initially try matching no characters
+            star = ++pattern;
+            resume = str;
+        }
+        else if (*pattern && ((*pattern == FS_CHAR_WILD_SINGLE)
+                              || (WILDCARD_FOLD(*pattern)
+                                  == WILDCARD_FOLD(*str))))
+        {
+            // Single character matched
+            pattern++;
+            str++;
+        }
+        else if (star)
+        {
+            // Extend the multiple character wildcard by one character
+            pattern = star;
+            str = ++resume;
+        }
+        else return FALSE;
+    }
+
+    // Any remaining multiple character wildcards can match nothing
+    while (*pattern == FS_CHAR_WILD_ANY) pattern++;
+
+    // Return the result
+    return !*pattern;
+}
+
 /*
     Parameters  : pattern   - The wildcarded pattern to match.
                   str       - The string to compare to.
@@ -37,37 +110,114 @@
                                  0  if pattern == str
                                 > 0 if pattern > str
     Description : Perform a wildcarded, case-insensitive comparison of the two
-                  strings.
+                  strings. The ordering is only meaningful if the pattern does
+                  not contain any wildcards. Case folding uses the locale in
+                  effect when any of these functions is first called; the
+                  table is not rebuilt if the territory changes later, so
+                  that previously calculated hashes remain valid.
 */
 int wildcard_cmp(const char *pattern, const char *str)
 {
     int result = 0;
 
-    // Compare characters in sequence
-    while (!result && (*pattern || *str))
+    // Ensure that the case folding table is ready
+    wildcard_init();
+
+    // Compare characters in sequence until a wildcard is reached
+    while (!result && (*pattern || *str)
+           && (*pattern != FS_CHAR_WILD_ANY)
+           && (*pattern != FS_CHAR_WILD_SINGLE))
     {
-        // Check for special conditions
-        if (*pattern == FS_CHAR_WILD_SINGLE)
-        {
-            // Single character wildcard does not match the terminator
-            pattern++;
-            if (*str++ == '\0') result = 1;
-        }
-        else if (*pattern == FS_CHAR_WILD_ANY)
+        result = WILDCARD_FOLD(*pattern++) - WILDCARD_FOLD(*str++);
+    }
+
+    // Match the remainder if a wildcard was reached
+    if (!result && *pattern && !wildcard_match_raw(pattern, str)) result = 1;
+
+    // Return the result
+    return result;
+}
+
+/*
+    Parameters  : pattern   - The wildcarded pattern to match.
+                  compiled  - Variable to receive the compiled pattern.
+    Returns     : void
+    Description : Prepare a pattern for repeated use with wildcard_match. The
+                  pattern string must remain valid while the compiled pattern
+                  is being used.
+*/
+void wildcard_compile(const char *pattern, wildcard_pattern *compiled)
+{
+    const char *ptr;
+
+    // Ensure that the case folding table is ready
+    wildcard_init();
+
+    // Find the literal prefix
+    compiled->pattern = pattern;
+    for (ptr = pattern; *ptr && (*ptr != FS_CHAR_WILD_ANY)
+                        && (*ptr != FS_CHAR_WILD_SINGLE); ptr++);
+    compiled->literal = ptr - pattern;
+    compiled->wild = *ptr != '\0';
+
+    // Check whether every string will match
+    while (*ptr == FS_CHAR_WILD_ANY) ptr++;
+    compiled->any = compiled->wild && !compiled->literal && !*ptr;
+}
+
+/*
+    Parameters  : compiled  - The compiled pattern.
+                  str       - The string to compare to.
+    Returns     : bool      - Does the string match the pattern.
+    Description : Perform a wildcarded, case-insensitive match using a pattern
+                  previously prepared by wildcard_compile.
+*/
+bool wildcard_match(const wildcard_pattern *compiled, const char *str)
+{
+    bool match;
+
+    // Special case if the pattern matches everything
+    if (compiled->any) match = TRUE;
+    else
+    {
+        const char *pattern = compiled->pattern;
+        bits i;
+
+        // Compare the literal prefix
+        for (i = 0; (i < compiled->literal)
+                    && (WILDCARD_FOLD(pattern[i]) == WILDCARD_FOLD(str[i]));
+             i++);
+        match = i == compiled->literal;
+
+        // Match the remainder
+        if (match && compiled->wild)
         {
-            // Try all string lengths for multiple character wildcard
-            pattern++;
-            result = wildcard_cmp(pattern, str);
-            while (*str)
-            {
-                str++;
-                if (result) result = wildcard_cmp(pattern, str);
-            }
-            pattern = str;
+            match = wildcard_match_raw(pattern + i, str + i);
         }
-        else result = toupper(*pattern++) - toupper(*str++);
+        else if (match) match = !str[i];
     }
 
     // Return the result
-    return result;
+    return match;
+}
+
+/*
+    Parameters  : str       - The string to hash.
+    Returns     : bits      - The hash value.
+    Description : Calculate a case-insensitive hash of a string without any
+                  wildcards. Strings that compare equal using wildcard_cmp
+                  always produce the same hash value.
+*/
+bits wildcard_hash(const char *str)
+{
+    bits hash = 0;
+
+    // Ensure that the case folding table is ready
+    wildcard_init();
+
+    // Include every character of the string
+    while (*str) hash = hash * 31 + WILDCARD_FOLD(*str++);
+
+    // Return the result
+    return hash;
 }
@@ -24,6 +24,18 @@
 #ifndef WILDCARD_H
 #define WILDCARD_H
 
+// Include oslib header files
+#include "oslib/types.h"
+
+// A compiled pattern
+typedef struct
+{
+    const char *pattern;
+    bits literal;
+    bool wild;
+    bool any;
+} wildcard_pattern;
+
 #ifdef __cplusplus
     extern "C" {
 #endif
@@ -40,6 +52,34 @@
 */
 int wildcard_cmp(const char *pattern, const char *str);
 
+/*
+    Parameters  : pattern   - The wildcarded pattern to match.
+                  compiled  - Variable to receive the compiled pattern.
+    Returns     : void
+    Description : Prepare a pattern for repeated use with wildcard_match. The
+                  pattern string must remain valid while the compiled pattern
+                  is being used.
+*/
+void wildcard_compile(const char *pattern, wildcard_pattern *compiled);
+
+/*
+    Parameters  : compiled  - The compiled pattern.
+                  str       - The string to compare to.
+    Returns     : bool      - Does the string match the pattern.
+    Description : Perform a wildcarded, case-insensitive match using a pattern
+                  previously prepared by wildcard_compile.
+*/
+bool wildcard_match(const wildcard_pattern *compiled, const char *str);
+
+/*
+    Parameters  : str       - The string to hash.
+    Returns     : bits      - The hash value.
+    Description : Calculate a case-insensitive hash of a string without any
+                  wildcards. Strings that compare equal using wildcard_cmp
+                  always produce the same hash value.
+*/
+bits wildcard_hash(const char *str);
+
 #ifdef __cplusplus
     }
 #endif
@@ -344,7 +344,8 @@ static os_error *wprt_lnkchan_callback(void *user, os_error *err,
 }
 
 /*
-    Parameters  : event         - The event to process.
+    Parameters  : user          - User defined handle for this channel.
+                  event         - The event to process.
                   data          - Pointer to the received data, or NULL if
                                   none.
                   size          - Size of received data.
@@ -352,7 +353,8 @@ static os_error *wprt_lnkchan_callback(void *user, os_error *err,
                                   NULL if no error.
     Description : Poll routine for an individual channel.
 */
-static os_error *wprt_poll(mux_events event, const byte *data, bits size)
+static os_error *wprt_poll(void *user, mux_events event,
+                           const byte *data, bits size)
 {
     os_error *err = NULL;
 
@@ -429,7 +431,8 @@ os_error *wprt_start(void)
     {
         // Create the channel
         err = mux_chan_create(WPRT_CHANNEL_NAME, 0, TRUE, FALSE, wprt_poll,
-                              WPRT_MAX_FRAME, &wprt_channel);
+                              NULL, WPRT_MAX_FRAME, MUX_CLASS_NORMAL,
+                              &wprt_channel);
 
         // Set the active flag if successful
         if (!err) wprt_active = TRUE;